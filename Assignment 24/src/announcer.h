@@ -0,0 +1,105 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include "config.h"
+#include "text_to_speech.h"
+#include "text_translator.h"
+#include "translation_cache.h"
+
+// Separates the fragments of an announcement. Each fragment is translated
+// on its own so the translation cache can reuse it in other announcements.
+#define FRAGMENT_SEPARATOR '|'
+#define ANNOUNCEMENT_QUEUE_SIZE 4
+
+// Translates and says announcements one after another. Each fragment is
+// translated, then the whole announcement is spoken, with poll() moving
+// on to the next step whenever the last one has finished.
+class Announcer {
+public:
+    Announcer() {
+        _first = 0;
+        _count = 0;
+        _start = 0;
+        _waiting = false;
+    }
+
+    void say(const String &message) {
+        if (_count == ANNOUNCEMENT_QUEUE_SIZE) {
+            Serial.println("Too many announcements waiting, dropping this one");
+            return;
+        }
+
+        _messages[(_first + _count) % ANNOUNCEMENT_QUEUE_SIZE] = message;
+        _count++;
+    }
+
+    // Call from loop() while nothing is being recorded. Moves on once
+    // speechPlayer has said the last announcement.
+    void poll() {
+        if (_waiting || _count == 0) {
+            return;
+        }
+
+        const String &message = _messages[_first];
+
+        if (_start <= (int)message.length()) {
+            int end = message.indexOf(FRAGMENT_SEPARATOR, _start);
+            if (end < 0) end = message.length();
+
+            // Set first, a cached translation comes straight back
+            _waiting = true;
+            if (textTranslator.translateText(message.substring(_start, end), LANGUAGE, SERVER_LANGUAGE,
+                                             translated, this)) {
+                _start = end + 1;
+            } else {
+                _waiting = false;
+            }
+            return;
+        }
+
+        // Tried again on the next poll, such as while there is no voice yet
+        _waiting = true;
+        if (!textToSpeech.convertTextToSpeech(_text, spoken, this)) {
+            _waiting = false;
+            return;
+        }
+
+        translationCache.printStats();
+
+        Serial.print("Saying: ");
+        Serial.println(_text);
+    }
+
+private:
+    String _messages[ANNOUNCEMENT_QUEUE_SIZE];
+    size_t _first;
+    size_t _count;
+
+    // Where the next fragment of the first message starts, and what has
+    // been translated so far
+    int _start;
+    String _text;
+    bool _waiting;
+
+    static void translated(const String &translated_text, void *context) {
+        Announcer *self = (Announcer *)context;
+        if (self->_text.length() > 0) self->_text += " ";
+        self->_text += translated_text;
+        self->_waiting = false;
+    }
+
+    static void spoken(void *context) {
+        Announcer *self = (Announcer *)context;
+        self->_messages[self->_first] = "";
+        self->_first = (self->_first + 1) % ANNOUNCEMENT_QUEUE_SIZE;
+        self->_count--;
+
+        self->_start = 0;
+        self->_text = "";
+        self->_waiting = false;
+    }
+};
+
+// Global instance
+Announcer announcer;
@@ -0,0 +1,572 @@
+#pragma once
+
+#include <Arduino.h>
+#include <Client.h>
+#include <HTTPClient.h>
+
+#include "bulk_stream.h"
+#include "config.h"
+#include "json_response.h"
+#include "url.h"
+
+// The body is sent this much at a time, so one poll() never holds loop()
+// up for long
+#define ASYNC_HTTP_SEND_CHUNK 1024
+// Responses are kept up to this size, anything after that is read and
+// dropped and the request marked truncated(). Big enough for an access
+// token.
+#define ASYNC_HTTP_BODY_SIZE 2048
+#define ASYNC_HTTP_LINE_SIZE 128
+#define ASYNC_HTTP_MAX_REQUESTS 6
+
+enum AsyncHttpState {
+    ASYNC_HTTP_IDLE,
+    ASYNC_HTTP_CONNECTING,
+    ASYNC_HTTP_SENDING,
+    ASYNC_HTTP_AWAITING_HEADERS,
+    ASYNC_HTTP_READING_BODY,
+    ASYNC_HTTP_DONE
+};
+
+// A response body already in memory
+class BufferStream : public BulkStream {
+public:
+    BufferStream(const uint8_t *data = NULL, size_t length = 0) {
+        _data = data;
+        _length = length;
+        _position = 0;
+
+        // Everything is already here, so never wait for more
+        setTimeout(0);
+    }
+
+    virtual int available() override {
+        return _length - _position;
+    }
+
+    virtual int read() override {
+        return _position < _length ? _data[_position++] : -1;
+    }
+
+    virtual int peek() override {
+        return _position < _length ? _data[_position] : -1;
+    }
+
+    virtual size_t write(uint8_t val) override {
+        return 0;
+    }
+
+    virtual size_t readBytes(char *buffer, size_t length) override {
+        length = min(length, _length - _position);
+        memcpy(buffer, _data + _position, length);
+        _position += length;
+        return length;
+    }
+
+    using BulkStream::readBytes;
+
+private:
+    const uint8_t *_data;
+    size_t _length;
+    size_t _position;
+};
+
+class AsyncHttpRequest;
+
+// Called once a request has finished. body can only be read during the
+// call, and is empty if the request never got a response.
+typedef void (*AsyncHttpCallback)(AsyncHttpRequest &request, Stream &body, void *context);
+
+// One HTTP request, run as a state machine: connect, send, wait for the
+// headers, read the body. Each call to poll() moves it on as far as it can
+// without waiting on the network, and it fails with HTTPC_ERROR_READ_TIMEOUT
+// if it hasn't finished within its timeout.
+//
+// Set a request up with begin(), then the other setters, then hand it to
+// asyncHttp.start(). A request can be started again from its own callback.
+class AsyncHttpRequest {
+public:
+    AsyncHttpRequest() {
+        _state = ASYNC_HTTP_IDLE;
+        _client = NULL;
+        _status = 0;
+        _response_length = 0;
+        _truncated = false;
+        begin();
+    }
+
+    // Sets up a request to url over client, which is connected when the
+    // request starts unless it already is. Returns false if the URL can't
+    // be used.
+    bool begin(Client &client, const char *url, const char *method = "POST") {
+        if (busy()) {
+            return false;
+        }
+
+        begin();
+        _client = &client;
+        _method = method;
+        _send_request = true;
+
+        Url parts;
+        bool valid = parseUrl(url, parts);
+        _host = parts.host;
+        _port = parts.port;
+        _path = parts.path;
+
+        return valid;
+    }
+
+    // Sets up a request that has already been written to client by hand,
+    // so only the response is read
+    bool beginResponse(Client &client) {
+        if (busy()) {
+            return false;
+        }
+
+        begin();
+        _client = &client;
+        _send_request = false;
+        return true;
+    }
+
+    void addHeader(const char *name, const String &value) {
+        _headers += name;
+        _headers += ": ";
+        _headers += value;
+        _headers += "\r\n";
+    }
+
+    void setBody(const String &body) {
+        _body = body;
+        _source = NULL;
+        _body_length = body.length();
+    }
+
+    // The body is pulled from source as it is sent, so source has to last
+    // until the request finishes
+    void setBody(BulkStream &source, size_t length) {
+        _body = "";
+        _source = &source;
+        _body_length = length;
+    }
+
+    // Asks to keep the connection open for the next request
+    void setReuse(bool reuse) {
+        _reuse = reuse;
+    }
+
+    void setTimeout(unsigned long timeout_ms) {
+        _timeout_ms = timeout_ms;
+    }
+
+    // Finishes as soon as the headers are in, handing the callback the
+    // body straight off the connection rather than a copy, for bodies too
+    // big to keep. Whoever reads it closes the connection afterwards.
+    void setStreamBody(bool stream_body) {
+        _stream_body = stream_body;
+    }
+
+    void onComplete(AsyncHttpCallback callback, void *context) {
+        _callback = callback;
+        _context = context;
+    }
+
+    bool busy() {
+        return _state != ASYNC_HTTP_IDLE;
+    }
+
+    // The HTTP status, or one of the negative HTTPC_ERROR codes if there
+    // was no response
+    int status() {
+        return _status;
+    }
+
+    // True if the body was longer than ASYNC_HTTP_BODY_SIZE, so the
+    // callback only has the start of it
+    bool truncated() {
+        return _truncated;
+    }
+
+    // True if the connection was left open for another request
+    bool keepAlive() {
+        return _keep_alive;
+    }
+
+    unsigned long elapsed() {
+        return millis() - _started;
+    }
+
+    // For a streamed body, the body still on the connection. Unlike the
+    // one the callback is handed it can be kept and read after the
+    // callback returns, until the connection is closed.
+    HttpBodyStream streamedBody() {
+        return HttpBodyStream(*_client, _content_length, _chunked);
+    }
+
+    // Called by AsyncHttp
+    void open() {
+        _started = millis();
+        _status = 0;
+        _keep_alive = false;
+        _response_length = 0;
+        _truncated = false;
+        _state = _send_request ? ASYNC_HTTP_CONNECTING : ASYNC_HTTP_AWAITING_HEADERS;
+        startResponse();
+    }
+
+    // Moves the request on as far as it can without waiting. connect is
+    // false to leave a request that still has to connect where it is.
+    // Returns true once it has finished, one way or another.
+    bool poll(bool connect) {
+        if (_state != ASYNC_HTTP_DONE && millis() - _started > _timeout_ms) {
+            fail(HTTPC_ERROR_READ_TIMEOUT);
+        }
+
+        if (_state == ASYNC_HTTP_CONNECTING && connect) {
+            connectAndSendHeaders();
+        }
+        if (_state == ASYNC_HTTP_SENDING) {
+            sendBody();
+        }
+        if (_state == ASYNC_HTTP_AWAITING_HEADERS) {
+            readHeaders();
+        }
+        if (_state == ASYNC_HTTP_READING_BODY) {
+            readBody();
+        }
+
+        return _state == ASYNC_HTTP_DONE;
+    }
+
+    // Called by AsyncHttp once poll() has returned true
+    void complete() {
+        // Idle first, so the callback can start the request again
+        _state = ASYNC_HTTP_IDLE;
+        if (_callback == NULL) {
+            return;
+        }
+
+        if (_stream_body && _status > 0) {
+            HttpBodyStream body = streamedBody();
+            _callback(*this, body, _context);
+        } else {
+            BufferStream body(_response, _response_length);
+            _callback(*this, body, _context);
+        }
+    }
+
+private:
+    enum BodyPart {
+        BODY_DATA,
+        BODY_CHUNK_SIZE,
+        BODY_CHUNK_END,
+        BODY_TRAILER
+    };
+
+    AsyncHttpState _state;
+    Client *_client;
+    AsyncHttpCallback _callback;
+    void *_context;
+
+    String _method;
+    String _host;
+    uint16_t _port;
+    String _path;
+    String _headers;
+    String _body;
+    BulkStream *_source;
+    size_t _body_length;
+    size_t _sent;
+    bool _send_request;
+    bool _reuse;
+    bool _stream_body;
+    unsigned long _timeout_ms;
+    unsigned long _started;
+
+    int _status;
+    long _content_length;
+    bool _chunked;
+    bool _close;
+    bool _keep_alive;
+    BodyPart _body_part;
+    long _remaining;
+    char _line[ASYNC_HTTP_LINE_SIZE];
+    size_t _line_length;
+    uint8_t _response[ASYNC_HTTP_BODY_SIZE];
+    size_t _response_length;
+    bool _truncated;
+
+    // Back to the defaults
+    void begin() {
+        _callback = NULL;
+        _context = NULL;
+        _headers = "";
+        _body = "";
+        _source = NULL;
+        _body_length = 0;
+        _reuse = false;
+        _stream_body = false;
+        _timeout_ms = ASYNC_HTTP_TIMEOUT_MS;
+    }
+
+    void startResponse() {
+        _content_length = -1;
+        _chunked = false;
+        _close = false;
+        _line_length = 0;
+    }
+
+    // rpcWiFi has no way to connect without waiting, so this one step
+    // blocks for the TCP (and TLS) handshake
+    void connectAndSendHeaders() {
+        if (!_client->connected() && !_client->connect(_host.c_str(), _port)) {
+            fail(HTTPC_ERROR_CONNECTION_REFUSED);
+            return;
+        }
+
+        String head = _method + " " + _path + " HTTP/1.1\r\n" +
+                      "Host: " + _host + "\r\n" +
+                      _headers +
+                      "Content-Length: " + String(_body_length) + "\r\n" +
+                      "Connection: " + (_reuse ? "keep-alive" : "close") + "\r\n\r\n";
+
+        if (_client->print(head) != head.length()) {
+            fail(HTTPC_ERROR_SEND_HEADER_FAILED);
+            return;
+        }
+
+        _sent = 0;
+        _state = ASYNC_HTTP_SENDING;
+    }
+
+    void sendBody() {
+        if (_sent == _body_length) {
+            _state = ASYNC_HTTP_AWAITING_HEADERS;
+            return;
+        }
+
+        size_t len = min((size_t)ASYNC_HTTP_SEND_CHUNK, _body_length - _sent);
+        size_t written;
+
+        if (_source != NULL) {
+            uint8_t chunk[ASYNC_HTTP_SEND_CHUNK];
+            len = _source->readBytes(chunk, len);
+            written = (len > 0) ? _client->write(chunk, len) : 0;
+        } else {
+            written = _client->write((const uint8_t *)_body.c_str() + _sent, len);
+        }
+
+        if (len == 0 || written != len) {
+            fail(HTTPC_ERROR_SEND_PAYLOAD_FAILED);
+            return;
+        }
+
+        _sent += len;
+    }
+
+    void readHeaders() {
+        while (_state == ASYNC_HTTP_AWAITING_HEADERS && _client->available() > 0) {
+            if (!readLine()) {
+                continue;
+            }
+
+            if (_status == 0) {
+                if (strncmp(_line, "HTTP/", 5) != 0 || strlen(_line) < 12) {
+                    fail(HTTPC_ERROR_NO_HTTP_SERVER);
+                    return;
+                }
+
+                _status = atoi(_line + 9);
+                _close = strncmp(_line, "HTTP/1.0", 8) == 0;
+            } else if (_line[0] == 0) {
+                startBody();
+            } else {
+                for (char *c = _line; *c != 0; c++) {
+                    *c = tolower(*c);
+                }
+
+                if (strncmp(_line, "content-length:", 15) == 0) {
+                    _content_length = atol(_line + 15);
+                } else if (strncmp(_line, "transfer-encoding:", 18) == 0 && strstr(_line, "chunked") != NULL) {
+                    _chunked = true;
+                } else if (strncmp(_line, "connection:", 11) == 0 && strstr(_line, "close") != NULL) {
+                    _close = true;
+                }
+            }
+        }
+
+        if (_state == ASYNC_HTTP_AWAITING_HEADERS && !_client->connected() && _client->available() == 0) {
+            fail(HTTPC_ERROR_CONNECTION_LOST);
+        }
+    }
+
+    void startBody() {
+        if (_stream_body) {
+            _state = ASYNC_HTTP_DONE;
+            return;
+        }
+
+        _body_part = _chunked ? BODY_CHUNK_SIZE : BODY_DATA;
+        _remaining = _chunked ? 0 : _content_length;
+        _state = ASYNC_HTTP_READING_BODY;
+
+        if (!_chunked && _content_length == 0) {
+            finish(true);
+        }
+    }
+
+    void readBody() {
+        while (_state == ASYNC_HTTP_READING_BODY && _client->available() > 0) {
+            if (_body_part == BODY_DATA) {
+                readData();
+                continue;
+            }
+
+            if (!readLine()) {
+                continue;
+            }
+
+            if (_body_part == BODY_CHUNK_END) {
+                _body_part = BODY_CHUNK_SIZE;
+            } else if (_body_part == BODY_CHUNK_SIZE) {
+                _remaining = strtol(_line, NULL, 16);
+                _body_part = (_remaining > 0) ? BODY_DATA : BODY_TRAILER;
+            } else if (_line[0] == 0) {
+                finish(true);
+            }
+        }
+
+        if (_state == ASYNC_HTTP_READING_BODY && !_client->connected() && _client->available() == 0) {
+            // A body with no length and no chunks runs until the server closes
+            if (!_chunked && _content_length < 0) {
+                finish(false);
+            } else {
+                fail(HTTPC_ERROR_CONNECTION_LOST);
+            }
+        }
+    }
+
+    // Reads what has arrived of the body, keeping what fits
+    void readData() {
+        uint8_t dropped[64];
+        uint8_t *into = _response + _response_length;
+        size_t room = ASYNC_HTTP_BODY_SIZE - _response_length;
+        if (room == 0) {
+            into = dropped;
+            room = sizeof(dropped);
+        }
+
+        size_t want = min((size_t)_client->available(), room);
+        if (_remaining > 0) {
+            want = min(want, (size_t)_remaining);
+        }
+
+        int count = _client->read(into, want);
+        if (count <= 0) {
+            return;
+        }
+
+        if (into != dropped) {
+            _response_length += count;
+        } else {
+            _truncated = true;
+        }
+
+        if (_remaining > 0) {
+            _remaining -= count;
+            if (_remaining == 0) {
+                if (_chunked) {
+                    _body_part = BODY_CHUNK_END;
+                } else {
+                    finish(true);
+                }
+            }
+        }
+    }
+
+    // Adds a byte to the current line. Returns true when the line is
+    // complete, in _line without its line break.
+    bool readLine() {
+        int c = _client->read();
+        if (c < 0 || c == '\r') {
+            return false;
+        }
+
+        if (c == '\n') {
+            _line[_line_length] = 0;
+            _line_length = 0;
+            return true;
+        }
+
+        // Long lines are cut short, nothing needed is that far along
+        if (_line_length < ASYNC_HTTP_LINE_SIZE - 1) {
+            _line[_line_length++] = c;
+        }
+        return false;
+    }
+
+    // clean is true if the body ended where the headers said it would
+    void finish(bool clean) {
+        _keep_alive = clean && _reuse && !_close;
+        if (!_keep_alive) {
+            _client->stop();
+        }
+
+        _state = ASYNC_HTTP_DONE;
+    }
+
+    void fail(int code) {
+        _status = code;
+        _client->stop();
+        _state = ASYNC_HTTP_DONE;
+    }
+};
+
+// Runs the requests that have been started, a step at a time, from loop()
+class AsyncHttp {
+public:
+    AsyncHttp() {
+        for (int i = 0; i < ASYNC_HTTP_MAX_REQUESTS; i++) {
+            _requests[i] = NULL;
+        }
+    }
+
+    // Returns false if request is already running or too many are. The
+    // callback always comes from a later poll(), never from here.
+    bool start(AsyncHttpRequest &request) {
+        if (request.busy()) {
+            return false;
+        }
+
+        for (int i = 0; i < ASYNC_HTTP_MAX_REQUESTS; i++) {
+            if (_requests[i] == NULL) {
+                _requests[i] = &request;
+                request.open();
+                return true;
+            }
+        }
+
+        Serial.println("Too many HTTP requests at once");
+        return false;
+    }
+
+    // Moves every request on, calling back those that have finished. Pass
+    // connect as false while recording, connecting is the one step that
+    // can stall loop() for long enough to drop audio.
+    void poll(bool connect = true) {
+        for (int i = 0; i < ASYNC_HTTP_MAX_REQUESTS; i++) {
+            AsyncHttpRequest *request = _requests[i];
+            if (request != NULL && request->poll(connect)) {
+                _requests[i] = NULL;
+                request->complete();
+            }
+        }
+    }
+
+private:
+    AsyncHttpRequest *_requests[ASYNC_HTTP_MAX_REQUESTS];
+};
+
+// Global instance
+AsyncHttp asyncHttp;
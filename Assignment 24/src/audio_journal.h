@@ -0,0 +1,350 @@
+#pragma once
+
+#include <Arduino.h>
+#include <sfud.h>
+
+#include "codec.h"
+#include "config.h"
+#include "flash_writer.h"
+#include "hash.h"
+
+#define JOURNAL_MAGIC 0x4C4A5541 // "AUJL"
+#define JOURNAL_HEADER_SIZE SFUD_PAGE_SIZE
+#define JOURNAL_MAX_PENDING 8
+
+// Each recording is checked in blocks, so a bad block can be pinned down
+#define JOURNAL_CRC_BLOCK 4096
+#define JOURNAL_MAX_BLOCKS ((JOURNAL_HEADER_SIZE - 32) / sizeof(uint32_t))
+
+static_assert(BUFFER_SIZE + WAV_MAX_HEADER_SIZE <= JOURNAL_MAX_BLOCKS * JOURNAL_CRC_BLOCK,
+              "A recording has more CRC blocks than fit in its header");
+
+struct JournalRecord
+{
+    uint32_t address; // Start of the WAV file, just after the record header
+    uint32_t length;
+    uint32_t sequence;
+};
+
+// Log-structured store of recordings in external flash. Each recording
+// starts on a fresh sector with a one-page header, and recordings are laid
+// out one after another around the journal region, so erases are spread
+// over the whole region instead of always hitting the first sectors.
+// Sealed recordings stay pending until they are marked as uploaded, and
+// survive a reboot. A recording only counts as sealed once its length is
+// written, which happens after its block CRCs, so one cut off mid-seal
+// is never uploaded.
+class AudioJournal
+{
+public:
+    void init()
+    {
+        _flash = sfud_get_device_table() + 0;
+        _sectorSize = _flash->chip.erase_gran;
+        _maxSpan = alignUp(JOURNAL_HEADER_SIZE + BUFFER_SIZE + WAV_MAX_HEADER_SIZE);
+
+        scan();
+    }
+
+    // Erases the first sector at the head of the journal, writes an open
+    // record header and returns the address the WAV file should go to.
+    size_t beginRecord()
+    {
+        if (_head + _maxSpan > JOURNAL_FLASH_OFFSET + JOURNAL_FLASH_SIZE)
+        {
+            _head = JOURNAL_FLASH_OFFSET;
+        }
+
+        dropOverwritten(_head, _head + _maxSpan);
+
+        sfud_erase(_flash, _head, _sectorSize);
+
+        RecordHeader header;
+        memset(&header, 0xFF, sizeof(header));
+        header.magic = JOURNAL_MAGIC;
+        header.sequence = _sequence;
+        header.sample_rate = RATE;
+        header.codec = AUDIO_CODEC;
+        sfud_write(_flash, _head, sizeof(header), (byte *)&header);
+
+        return _head + JOURNAL_HEADER_SIZE;
+    }
+
+    // Address of the WAV file of the open record
+    size_t recordAddress()
+    {
+        return _head + JOURNAL_HEADER_SIZE;
+    }
+
+    // Most the WAV file of a record can take up, the space beginRecord()
+    // clears of older recordings
+    size_t recordCapacity()
+    {
+        return _maxSpan - JOURNAL_HEADER_SIZE;
+    }
+
+    // Closes the open record once length bytes of WAV file have been
+    // flushed to flash, and queues it for upload
+    JournalRecord seal(size_t length)
+    {
+        JournalRecord record;
+        record.address = _head + JOURNAL_HEADER_SIZE;
+        record.length = length;
+        record.sequence = _sequence;
+
+        uint32_t blockCrcs[JOURNAL_MAX_BLOCKS];
+        size_t blocks = blockCount(length);
+        for (size_t i = 0; i < blocks; i++)
+        {
+            blockCrcs[i] = flashCrc32(record.address + i * JOURNAL_CRC_BLOCK, blockLength(length, i));
+        }
+        uint32_t crc = crc32(blockCrcs, blocks * sizeof(uint32_t));
+
+        sfud_write(_flash, _head + offsetof(RecordHeader, block_crcs), blocks * sizeof(uint32_t), (byte *)blockCrcs);
+        sfud_write(_flash, _head + offsetof(RecordHeader, crc), sizeof(crc), (byte *)&crc);
+        sfud_write(_flash, _head + offsetof(RecordHeader, length), sizeof(uint32_t), (byte *)&record.length);
+
+        addPending(record);
+
+        _head = alignUp(record.address + length);
+        _sequence++;
+
+        return record;
+    }
+
+    uint8_t pendingCount()
+    {
+        return _pendingCount;
+    }
+
+    bool oldestPending(JournalRecord &record)
+    {
+        if (_pendingCount == 0)
+        {
+            return false;
+        }
+
+        record = _pending[0];
+        return true;
+    }
+
+    void markUploaded(const JournalRecord &record)
+    {
+        uint32_t uploaded = 0;
+        sfud_write(_flash, headerAddress(record) + offsetof(RecordHeader, uploaded), sizeof(uploaded), (byte *)&uploaded);
+
+        removePending(record.sequence);
+    }
+
+    // Checks every block of the recording in flash still matches the CRC
+    // it was sealed with
+    bool verify(const JournalRecord &record)
+    {
+        // A length from a torn header can claim more blocks than the header
+        // has CRCs for, so it is turned away before any CRC is looked at
+        size_t blocks = blockCount(record.length);
+        if (blocks > JOURNAL_MAX_BLOCKS)
+        {
+            Serial.println("Journal record is longer than a recording can be");
+            return false;
+        }
+
+        RecordHeader header;
+        sfud_read(_flash, headerAddress(record), sizeof(header), (byte *)&header);
+
+        if (header.magic != JOURNAL_MAGIC ||
+            header.sequence != record.sequence ||
+            header.length != record.length ||
+            header.crc != crc32(header.block_crcs, blocks * sizeof(uint32_t)))
+        {
+            Serial.println("Journal record header is damaged");
+            return false;
+        }
+
+        for (size_t i = 0; i < blocks; i++)
+        {
+            if (header.block_crcs[i] != flashCrc32(record.address + i * JOURNAL_CRC_BLOCK, blockLength(record.length, i)))
+            {
+                Serial.print("Journal record fails its CRC at block ");
+                Serial.println(i);
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+private:
+    struct RecordHeader
+    {
+        uint32_t magic;
+        uint32_t sequence;
+        uint32_t length; // 0xFFFFFFFF until sealed
+        uint32_t sample_rate;
+        uint8_t codec;
+        uint8_t reserved[3];
+        uint32_t crc;      // CRC-32 of block_crcs
+        uint32_t uploaded; // 0xFFFFFFFF until uploaded, then 0
+        uint32_t block_crcs[JOURNAL_MAX_BLOCKS]; // CRC-32 of each JOURNAL_CRC_BLOCK of the WAV file
+    };
+
+    static_assert(sizeof(RecordHeader) <= JOURNAL_HEADER_SIZE, "The record header must fit in one page");
+
+    const sfud_flash *_flash;
+    size_t _sectorSize;
+    size_t _maxSpan;
+
+    size_t _head;
+    uint32_t _sequence;
+
+    JournalRecord _pending[JOURNAL_MAX_PENDING];
+    uint8_t _pendingCount;
+
+    size_t alignUp(size_t address)
+    {
+        return ((address + _sectorSize - 1) / _sectorSize) * _sectorSize;
+    }
+
+    size_t headerAddress(const JournalRecord &record)
+    {
+        return record.address - JOURNAL_HEADER_SIZE;
+    }
+
+    static size_t blockCount(size_t length)
+    {
+        return (length + JOURNAL_CRC_BLOCK - 1) / JOURNAL_CRC_BLOCK;
+    }
+
+    static size_t blockLength(size_t length, size_t block)
+    {
+        return min((size_t)JOURNAL_CRC_BLOCK, length - block * JOURNAL_CRC_BLOCK);
+    }
+
+    // Rebuilds the pending queue and the head from the record headers
+    void scan()
+    {
+        _head = JOURNAL_FLASH_OFFSET;
+        _sequence = 0;
+        _pendingCount = 0;
+
+        bool found = false;
+        size_t pos = JOURNAL_FLASH_OFFSET;
+        size_t end = JOURNAL_FLASH_OFFSET + JOURNAL_FLASH_SIZE;
+
+        while (pos < end)
+        {
+            RecordHeader header;
+            sfud_read(_flash, pos, sizeof(header), (byte *)&header);
+
+            bool sealed = header.magic == JOURNAL_MAGIC &&
+                          header.length != 0xFFFFFFFF &&
+                          pos + JOURNAL_HEADER_SIZE + header.length <= end;
+
+            if (!sealed)
+            {
+                pos += _sectorSize;
+                continue;
+            }
+
+            JournalRecord record;
+            record.address = pos + JOURNAL_HEADER_SIZE;
+            record.length = header.length;
+            record.sequence = header.sequence;
+
+            if (header.uploaded != 0)
+            {
+                addPending(record);
+            }
+
+            if (!found || header.sequence >= _sequence)
+            {
+                found = true;
+                _sequence = header.sequence + 1;
+                _head = alignUp(record.address + record.length);
+            }
+
+            pos = alignUp(record.address + record.length);
+        }
+
+        Serial.print("Journal has ");
+        Serial.print(_pendingCount);
+        Serial.println(" recordings waiting to upload");
+    }
+
+    // Keeps the queue sorted by sequence, dropping the oldest when full
+    void addPending(const JournalRecord &record)
+    {
+        if (_pendingCount == JOURNAL_MAX_PENDING)
+        {
+            if (record.sequence < _pending[0].sequence)
+            {
+                return;
+            }
+
+            Serial.println("Journal queue full, dropping the oldest recording");
+            removePending(_pending[0].sequence);
+        }
+
+        uint8_t i = _pendingCount;
+        while (i > 0 && _pending[i - 1].sequence > record.sequence)
+        {
+            _pending[i] = _pending[i - 1];
+            i--;
+        }
+
+        _pending[i] = record;
+        _pendingCount++;
+    }
+
+    void removePending(uint32_t sequence)
+    {
+        for (uint8_t i = 0; i < _pendingCount; i++)
+        {
+            if (_pending[i].sequence == sequence)
+            {
+                memmove(&_pending[i], &_pending[i + 1], (_pendingCount - i - 1) * sizeof(JournalRecord));
+                _pendingCount--;
+                return;
+            }
+        }
+    }
+
+    // The ring has caught up with recordings that were never uploaded
+    void dropOverwritten(size_t start, size_t end)
+    {
+        for (uint8_t i = 0; i < _pendingCount;)
+        {
+            size_t record_start = headerAddress(_pending[i]);
+            size_t record_end = _pending[i].address + _pending[i].length;
+
+            if (record_start < end && record_end > start)
+            {
+                Serial.println("Journal full, overwriting a recording that was never uploaded");
+                removePending(_pending[i].sequence);
+            }
+            else
+            {
+                i++;
+            }
+        }
+    }
+
+    // CRC-32 of length bytes of flash
+    uint32_t flashCrc32(size_t address, size_t length)
+    {
+        byte buffer[SFUD_PAGE_SIZE];
+        uint32_t crc = CRC32_INIT;
+
+        while (length > 0)
+        {
+            size_t chunk = min(length, sizeof(buffer));
+            sfud_read(_flash, address, chunk, buffer);
+            crc = crc32Update(crc, buffer, chunk);
+
+            address += chunk;
+            length -= chunk;
+        }
+
+        return ~crc;
+    }
+};
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <Arduino.h>
+
+// A Stream that can hand out many bytes in one go. The core's
+// Stream::readBytes() isn't virtual and reads a byte at a time, so code
+// that wants the fast version has to hold a BulkStream, not a Stream.
+class BulkStream : public Stream {
+public:
+    virtual size_t readBytes(char *buffer, size_t length) = 0;
+
+    size_t readBytes(uint8_t *buffer, size_t length) {
+        return readBytes((char *)buffer, length);
+    }
+};
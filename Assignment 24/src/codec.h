@@ -0,0 +1,293 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include "config.h"
+
+#define CODEC_PCM 0
+#define CODEC_MULAW 1
+#define CODEC_IMA_ADPCM 2
+
+#define IMA_ADPCM_BLOCK_ALIGN 256
+#define IMA_ADPCM_SAMPLES_PER_BLOCK ((IMA_ADPCM_BLOCK_ALIGN - 4) * 2 + 1)
+
+// Largest header writeHeader() produces, and the most bytes encode() can
+// produce for len samples
+#define WAV_MAX_HEADER_SIZE 60
+#define ENCODED_MAX_SIZE(len) ((len) * 2 + 8)
+
+// Turns 16-bit PCM blocks into the bytes stored in flash and uploaded,
+// along with the matching WAV header, for the codec picked by AUDIO_CODEC.
+// The speech service only takes PCM, so mu-law and IMA ADPCM are only for
+// recordings that are kept on the device.
+class AudioEncoder
+{
+public:
+    explicit AudioEncoder(uint8_t codec = AUDIO_CODEC) : _codec(codec)
+    {
+        reset();
+    }
+
+    void reset()
+    {
+        _predictor = 0;
+        _index = 0;
+        _blockPos = 0;
+        _hasPendingNibble = false;
+    }
+
+    // Content-Type for uploading to the speech service, up to the sample
+    // rate. Only PCM has one, the other codecs are for local storage and
+    // get NULL.
+    static const char *contentType(uint8_t codec = AUDIO_CODEC)
+    {
+        if (codec != CODEC_PCM)
+        {
+            return NULL;
+        }
+
+        return "audio/wav; codecs=audio/pcm; samplerate=";
+    }
+
+    // Writes the WAV header and returns its size. The RIFF, data and fact
+    // lengths are left as 0xFFFFFFFF so they can be programmed over once
+    // the recording is finished.
+    size_t writeHeader(byte *out)
+    {
+        uint16_t format_tag = 1;
+        uint16_t block_align = 2;
+        uint16_t bits_per_samp = 16;
+        uint32_t bytes_per_sec = RATE * 2;
+
+        if (_codec == CODEC_MULAW)
+        {
+            format_tag = 7;
+            block_align = 1;
+            bits_per_samp = 8;
+            bytes_per_sec = RATE;
+        }
+        else if (_codec == CODEC_IMA_ADPCM)
+        {
+            format_tag = 0x11;
+            block_align = IMA_ADPCM_BLOCK_ALIGN;
+            bits_per_samp = 4;
+            bytes_per_sec = (uint32_t)RATE * IMA_ADPCM_BLOCK_ALIGN / IMA_ADPCM_SAMPLES_PER_BLOCK;
+        }
+
+        size_t pos = 0;
+        pos = putTag(out, pos, "RIFF");
+        pos = put32(out, pos, 0xFFFFFFFF);
+        pos = putTag(out, pos, "WAVE");
+
+        pos = putTag(out, pos, "fmt ");
+        pos = put32(out, pos, _codec == CODEC_IMA_ADPCM ? 20 : 16);
+        pos = put16(out, pos, format_tag);
+        pos = put16(out, pos, 1);
+        pos = put32(out, pos, RATE);
+        pos = put32(out, pos, bytes_per_sec);
+        pos = put16(out, pos, block_align);
+        pos = put16(out, pos, bits_per_samp);
+
+        _factOffset = 0;
+        if (_codec == CODEC_IMA_ADPCM)
+        {
+            pos = put16(out, pos, 2);
+            pos = put16(out, pos, IMA_ADPCM_SAMPLES_PER_BLOCK);
+
+            pos = putTag(out, pos, "fact");
+            pos = put32(out, pos, 4);
+            _factOffset = pos;
+            pos = put32(out, pos, 0xFFFFFFFF);
+        }
+
+        pos = putTag(out, pos, "data");
+        _dataLengthOffset = pos;
+        pos = put32(out, pos, 0xFFFFFFFF);
+
+        return pos;
+    }
+
+    size_t riffLengthOffset()
+    {
+        return 4;
+    }
+
+    size_t dataLengthOffset()
+    {
+        return _dataLengthOffset;
+    }
+
+    // Offset of the fact chunk's sample count, or 0 if the format has none
+    size_t factOffset()
+    {
+        return _factOffset;
+    }
+
+    // Encodes len samples into out and returns the number of bytes written.
+    // out must hold ENCODED_MAX_SIZE(len) bytes.
+    size_t encode(const int16_t *pcm, size_t len, byte *out)
+    {
+        switch (_codec)
+        {
+        case CODEC_MULAW:
+            for (size_t i = 0; i < len; i++)
+            {
+                out[i] = encodeMulaw(pcm[i]);
+            }
+            return len;
+
+        case CODEC_IMA_ADPCM:
+            return encodeImaAdpcm(pcm, len, out);
+
+        default:
+            memcpy(out, pcm, len * sizeof(int16_t));
+            return len * sizeof(int16_t);
+        }
+    }
+
+    // Writes out any half-filled ADPCM byte at the end of a recording
+    size_t flush(byte *out)
+    {
+        if (_hasPendingNibble)
+        {
+            out[0] = _pendingNibble;
+            _hasPendingNibble = false;
+            return 1;
+        }
+
+        return 0;
+    }
+
+private:
+    uint8_t _codec;
+    int32_t _predictor;
+    int8_t _index;
+    uint16_t _blockPos;
+    bool _hasPendingNibble;
+    byte _pendingNibble;
+
+    size_t _dataLengthOffset;
+    size_t _factOffset;
+
+    static size_t put16(byte *out, size_t pos, uint16_t value)
+    {
+        out[pos] = value & 0xFF;
+        out[pos + 1] = value >> 8;
+        return pos + 2;
+    }
+
+    static size_t put32(byte *out, size_t pos, uint32_t value)
+    {
+        pos = put16(out, pos, value & 0xFFFF);
+        return put16(out, pos, value >> 16);
+    }
+
+    static size_t putTag(byte *out, size_t pos, const char *tag)
+    {
+        memcpy(out + pos, tag, 4);
+        return pos + 4;
+    }
+
+    // G.711 mu-law
+    static byte encodeMulaw(int16_t sample)
+    {
+        int32_t value = sample;
+        byte sign = 0;
+
+        if (value < 0)
+        {
+            sign = 0x80;
+            value = -value;
+        }
+
+        value = min(value, (int32_t)32635) + 0x84;
+
+        byte exponent = (31 - __builtin_clz(value)) - 7;
+        byte mantissa = (value >> (exponent + 3)) & 0x0F;
+
+        return ~(sign | (exponent << 4) | mantissa);
+    }
+
+    size_t encodeImaAdpcm(const int16_t *pcm, size_t len, byte *out)
+    {
+        static const int16_t stepTable[89] = {
+            7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31,
+            34, 37, 41, 45, 50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130, 143,
+            157, 173, 190, 209, 230, 253, 279, 307, 337, 371, 408, 449, 494, 544, 598, 658,
+            724, 796, 876, 963, 1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066, 2272, 2499, 2749, 3024,
+            3327, 3660, 4026, 4428, 4871, 5358, 5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487, 12635, 13899,
+            15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767};
+        static const int8_t indexTable[8] = {-1, -1, -1, -1, 2, 4, 6, 8};
+
+        size_t pos = 0;
+
+        for (size_t i = 0; i < len; i++)
+        {
+            int32_t sample = pcm[i];
+
+            // Each block opens with the raw first sample and the step index
+            if (_blockPos == 0)
+            {
+                _predictor = sample;
+                pos = put16(out, pos, (uint16_t)sample);
+                out[pos++] = _index;
+                out[pos++] = 0;
+                _blockPos = 1;
+                continue;
+            }
+
+            int32_t step = stepTable[_index];
+            int32_t diff = sample - _predictor;
+            byte nibble = 0;
+
+            if (diff < 0)
+            {
+                nibble = 8;
+                diff = -diff;
+            }
+
+            int32_t delta = step >> 3;
+            if (diff >= step)
+            {
+                nibble |= 4;
+                diff -= step;
+                delta += step;
+            }
+            step >>= 1;
+            if (diff >= step)
+            {
+                nibble |= 2;
+                diff -= step;
+                delta += step;
+            }
+            step >>= 1;
+            if (diff >= step)
+            {
+                nibble |= 1;
+                delta += step;
+            }
+
+            _predictor += (nibble & 8) ? -delta : delta;
+            _predictor = constrain(_predictor, -32768, 32767);
+            _index = constrain(_index + indexTable[nibble & 7], 0, 88);
+
+            if (_hasPendingNibble)
+            {
+                out[pos++] = _pendingNibble | (nibble << 4);
+                _hasPendingNibble = false;
+            }
+            else
+            {
+                _pendingNibble = nibble;
+                _hasPendingNibble = true;
+            }
+
+            if (++_blockPos == IMA_ADPCM_SAMPLES_PER_BLOCK)
+            {
+                _blockPos = 0;
+            }
+        }
+
+        return pos;
+    }
+};
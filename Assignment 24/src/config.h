@@ -1,10 +1,45 @@
 #pragma once
 
-#define RATE 16000
+#define RATE 16000 // 8000, 11025, 16000 or 22050
 #define SAMPLE_LENGTH_SECONDS 4
-#define SAMPLES RATE * SAMPLE_LENGTH_SECONDS
-#define BUFFER_SIZE (SAMPLES * 2) + 44
+#define SAMPLES (RATE * SAMPLE_LENGTH_SECONDS)
+#define BUFFER_SIZE (SAMPLES * 2 + 44)
 #define ADC_BUF_LEN 1600
+#define ADC_BUF_COUNT 4
+#define VAD_ENABLED true
+#define VAD_ENERGY_THRESHOLD 800
+#define VAD_MAX_ZERO_CROSSING_PERCENT 35
+#define VAD_TRAILING_SILENCE_MS 700
+#define VAD_ONSET_TIMEOUT_MS 5000
+#define STREAM_SPEECH_UPLOAD true
+#define AUDIO_CODEC CODEC_PCM // The speech service only accepts CODEC_PCM
+#define CAPTURE_BACKEND CAPTURE_FLASH
+#define SRAM_CAPTURE_SIZE (48 * 1024)
+#define JOURNAL_FLASH_OFFSET 0
+#define JOURNAL_FLASH_SIZE (3 * 1024 * 1024)
+#define JOURNAL_RETRY_MS 30000
+#define JOURNAL_RETRY_MAX_MS 600000
+#define KEEP_ALIVE_IDLE_MS 60000
+#define TRANSLATION_FLASH_OFFSET (JOURNAL_FLASH_OFFSET + JOURNAL_FLASH_SIZE)
+#define TRANSLATION_FLASH_SIZE (64 * 1024)
+#define TRANSLATION_CACHE_ENTRIES 16
+#define SPEECH_CACHE_MAX_BYTES (8 * 1024 * 1024)
+#define SPEECH_CACHE_MAX_FILES 64
+#define SPEECH_CACHE_SAVE_MS 60000
+#define JITTER_BUFFER_SAMPLES 8192
+#define PLAYBACK_START_MS 200
+#define PLAYBACK_STALL_MS 3000
+#define TOKEN_LIFETIME_MS 600000
+#define TOKEN_REFRESH_MARGIN_MS 60000
+#define TOKEN_RETRY_MS 10000
+#define VOICES_RETRY_MS 10000
+#define SPEECH_MAX_ATTEMPTS 3
+#define LOCAL_TIMER_PARSER true
+#define ASYNC_HTTP_TIMEOUT_MS 15000
+#define PROFILE_AUDIO 0
+#define KWS_ENABLED false
+#define KWS_THRESHOLD_PERCENT 80
+#define KWS_PREROLL_MS 300
 const char *SSID = "<SSID>";
 const char *PASSWORD = "<PASSWORD>";
 const char *TEXT_TO_SPEECH_FUNCTION_URL = "<URL>";
@@ -12,10 +47,11 @@ const char *SPEECH_API_KEY = "<API_KEY>";
 const char *SPEECH_LOCATION = "<LOCATION>";
 const char *TRANSLATOR_API_KEY = "<KEY>";
 const char *TRANSLATOR_LOCATION = "<LOCATION>";
-const char *LANGUAGE = "en-US";
 const char *LANGUAGE = "<user language>";
 const char *SERVER_LANGUAGE = "<server language>";
 const char *TEXT_TO_TIMER_FUNCTION_URL = "<URL>";
+const char *TRANSLATE_FUNCTION_URL = "<URL>";
+const char *GET_VOICES_FUNCTION_URL = "<URL>";
 const char *TOKEN_URL = "https://%s.api.cognitive.microsoft.com/sts/v1.0/issuetoken";
 const char *TOKEN_CERTIFICATE =
     "-----BEGIN CERTIFICATE-----\r\n"
@@ -52,8 +88,7 @@ const char *TOKEN_CERTIFICATE =
     "trpM/3wYxlr473WSPUFZPgP1j519kLpWOJ8z09wxay+Br29irPcBYv0GMXlHqThy\r\n"
     "8y4m/HyTQeI2IMvMrQnwqPpY+rLIXyviI2vLoI+4xKE4Rn38ZZ8m\r\n"
     "-----END CERTIFICATE-----\r\n";
-    const char *SPEECH_CERTIFICATE =
-    const char *TRANSLATE_FUNCTION_URL = "<URL>";
+const char *SPEECH_CERTIFICATE =
     "-----BEGIN CERTIFICATE-----\r\n"
     "MIIF8zCCBNugAwIBAgIQCq+mxcpjxFFB6jvh98dTFzANBgkqhkiG9w0BAQwFADBh\r\n"
     "MQswCQYDVQQGEwJVUzEVMBMGA1UEChMMRGlnaUNlcnQgSW5jMRkwFwYDVQQLExB3\r\n"
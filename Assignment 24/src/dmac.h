@@ -0,0 +1,55 @@
+#pragma once
+
+#include <Arduino.h>
+
+// The DMAC's descriptor layout. uintptr_t is 32 bits on the SAMD51; on the
+// native build it holds the simulated DMAC's host pointers.
+typedef struct
+{
+    uint16_t btctrl;
+    uint16_t btcnt;
+    uintptr_t srcaddr;
+    uintptr_t dstaddr;
+    uintptr_t descaddr;
+} dmacdescriptor;
+
+// The DMAC has one descriptor section and one write-back section for all
+// its channels, so the mic (channel 1) and the speaker (channel 2) both
+// take their first descriptor from here.
+class Dmac
+{
+public:
+    // Safe to call from each user, only the first call sets the DMAC up
+    static void init()
+    {
+        static bool initialized = false;
+        if (initialized)
+        {
+            return;
+        }
+
+        DMAC->BASEADDR.reg = (uintptr_t)sections().descriptors;
+        DMAC->WRBADDR.reg = (uintptr_t)sections().writeback;
+        DMAC->CTRL.reg = DMAC_CTRL_DMAENABLE | DMAC_CTRL_LVLEN(0xf);
+        initialized = true;
+    }
+
+    // The descriptor a channel starts from
+    static dmacdescriptor &descriptor(uint8_t channel)
+    {
+        return sections().descriptors[channel];
+    }
+
+private:
+    struct Sections
+    {
+        volatile dmacdescriptor writeback[DMAC_CH_NUM] __attribute__((aligned(16)));
+        dmacdescriptor descriptors[DMAC_CH_NUM] __attribute__((aligned(16)));
+    };
+
+    static Sections &sections()
+    {
+        static Sections sections __attribute__((aligned(16)));
+        return sections;
+    }
+};
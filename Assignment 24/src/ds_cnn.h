@@ -0,0 +1,224 @@
+#pragma once
+
+#include <Arduino.h>
+
+#define DSCNN_CONV 0
+#define DSCNN_DEPTHWISE 1
+#define DSCNN_AVERAGE_POOL 2
+#define DSCNN_FULLY_CONNECTED 3
+
+// One layer of an int8 model, quantized the way TensorFlow Lite does it.
+// Tensors are HWC. Weights are [out_c][kernel_h][kernel_w][in_c] for
+// convolutions, [kernel_h][kernel_w][c] for depthwise convolutions and
+// [out_c][in] for fully connected layers. tools/export_kws_model.py
+// writes these tables from a .tflite file.
+struct DsCnnLayer
+{
+    uint8_t type;
+    uint8_t kernel_h, kernel_w;
+    uint8_t stride_h, stride_w;
+    uint8_t pad_h, pad_w; // Top and left padding
+    uint16_t in_h, in_w, in_c;
+    uint16_t out_h, out_w, out_c;
+    int32_t input_offset; // Minus the input zero point
+    int32_t output_offset; // The output zero point
+    int8_t act_min, act_max;
+    const int8_t *weights;
+    const int32_t *bias;
+    const int32_t *multiplier; // Per output channel, Q31
+    const int8_t *shift;       // Per output channel, positive is left
+};
+
+// Runs a depthwise-separable CNN (or any stack of the layers above) on
+// int8 input, bouncing between two activation buffers
+class DsCnn
+{
+public:
+    // Each buffer must hold the largest layer output. Returns the buffer
+    // holding the output of the last layer.
+    static const int8_t *run(const DsCnnLayer *layers, size_t count, const int8_t *input, int8_t *buffer0, int8_t *buffer1)
+    {
+        const int8_t *in = input;
+        int8_t *buffers[2] = {buffer0, buffer1};
+
+        for (size_t i = 0; i < count; i++)
+        {
+            int8_t *out = buffers[i % 2];
+
+            switch (layers[i].type)
+            {
+            case DSCNN_CONV:
+                conv(layers[i], in, out);
+                break;
+            case DSCNN_DEPTHWISE:
+                depthwise(layers[i], in, out);
+                break;
+            case DSCNN_AVERAGE_POOL:
+                averagePool(layers[i], in, out);
+                break;
+            case DSCNN_FULLY_CONNECTED:
+                fullyConnected(layers[i], in, out);
+                break;
+            }
+
+            in = out;
+        }
+
+        return in;
+    }
+
+private:
+    static void conv(const DsCnnLayer &layer, const int8_t *in, int8_t *out)
+    {
+        for (int oy = 0; oy < layer.out_h; oy++)
+        {
+            for (int ox = 0; ox < layer.out_w; ox++)
+            {
+                for (int oc = 0; oc < layer.out_c; oc++)
+                {
+                    const int8_t *weights = layer.weights + oc * layer.kernel_h * layer.kernel_w * layer.in_c;
+                    int32_t acc = layer.bias[oc];
+
+                    for (int ky = 0; ky < layer.kernel_h; ky++)
+                    {
+                        int iy = oy * layer.stride_h - layer.pad_h + ky;
+                        if (iy < 0 || iy >= layer.in_h)
+                        {
+                            continue;
+                        }
+
+                        for (int kx = 0; kx < layer.kernel_w; kx++)
+                        {
+                            int ix = ox * layer.stride_w - layer.pad_w + kx;
+                            if (ix < 0 || ix >= layer.in_w)
+                            {
+                                continue;
+                            }
+
+                            const int8_t *pixel = in + (iy * layer.in_w + ix) * layer.in_c;
+                            const int8_t *kernel = weights + (ky * layer.kernel_w + kx) * layer.in_c;
+                            for (int ic = 0; ic < layer.in_c; ic++)
+                            {
+                                acc += (pixel[ic] + layer.input_offset) * kernel[ic];
+                            }
+                        }
+                    }
+
+                    out[(oy * layer.out_w + ox) * layer.out_c + oc] = requantize(layer, oc, acc);
+                }
+            }
+        }
+    }
+
+    static void depthwise(const DsCnnLayer &layer, const int8_t *in, int8_t *out)
+    {
+        for (int oy = 0; oy < layer.out_h; oy++)
+        {
+            for (int ox = 0; ox < layer.out_w; ox++)
+            {
+                for (int c = 0; c < layer.out_c; c++)
+                {
+                    int32_t acc = layer.bias[c];
+
+                    for (int ky = 0; ky < layer.kernel_h; ky++)
+                    {
+                        int iy = oy * layer.stride_h - layer.pad_h + ky;
+                        if (iy < 0 || iy >= layer.in_h)
+                        {
+                            continue;
+                        }
+
+                        for (int kx = 0; kx < layer.kernel_w; kx++)
+                        {
+                            int ix = ox * layer.stride_w - layer.pad_w + kx;
+                            if (ix < 0 || ix >= layer.in_w)
+                            {
+                                continue;
+                            }
+
+                            int8_t value = in[(iy * layer.in_w + ix) * layer.in_c + c];
+                            acc += (value + layer.input_offset) * layer.weights[(ky * layer.kernel_w + kx) * layer.out_c + c];
+                        }
+                    }
+
+                    out[(oy * layer.out_w + ox) * layer.out_c + c] = requantize(layer, c, acc);
+                }
+            }
+        }
+    }
+
+    // Input and output share a scale and zero point, so no requantizing
+    static void averagePool(const DsCnnLayer &layer, const int8_t *in, int8_t *out)
+    {
+        for (int oy = 0; oy < layer.out_h; oy++)
+        {
+            for (int ox = 0; ox < layer.out_w; ox++)
+            {
+                for (int c = 0; c < layer.out_c; c++)
+                {
+                    int32_t sum = 0;
+                    int32_t count = 0;
+
+                    for (int ky = 0; ky < layer.kernel_h; ky++)
+                    {
+                        int iy = oy * layer.stride_h - layer.pad_h + ky;
+                        for (int kx = 0; kx < layer.kernel_w; kx++)
+                        {
+                            int ix = ox * layer.stride_w - layer.pad_w + kx;
+                            if (iy >= 0 && iy < layer.in_h && ix >= 0 && ix < layer.in_w)
+                            {
+                                sum += in[(iy * layer.in_w + ix) * layer.in_c + c];
+                                count++;
+                            }
+                        }
+                    }
+
+                    int32_t average = sum > 0 ? (sum + count / 2) / count : (sum - count / 2) / count;
+                    out[(oy * layer.out_w + ox) * layer.out_c + c] = constrain(average, layer.act_min, layer.act_max);
+                }
+            }
+        }
+    }
+
+    static void fullyConnected(const DsCnnLayer &layer, const int8_t *in, int8_t *out)
+    {
+        size_t inputs = layer.in_h * layer.in_w * layer.in_c;
+
+        for (int o = 0; o < layer.out_c; o++)
+        {
+            const int8_t *weights = layer.weights + o * inputs;
+            int32_t acc = layer.bias[o];
+
+            for (size_t i = 0; i < inputs; i++)
+            {
+                acc += (in[i] + layer.input_offset) * weights[i];
+            }
+
+            out[o] = requantize(layer, o, acc);
+        }
+    }
+
+    // TensorFlow Lite's MultiplyByQuantizedMultiplier, then the output
+    // zero point and the fused activation
+    static int8_t requantize(const DsCnnLayer &layer, int channel, int32_t acc)
+    {
+        int shift = layer.shift[channel];
+        int64_t value = (int64_t)acc * (1LL << max(shift, 0));
+        value = constrain(value, (int64_t)INT32_MIN, (int64_t)INT32_MAX);
+
+        int64_t product = value * layer.multiplier[channel];
+        int64_t nudge = product >= 0 ? (1LL << 30) : 1 - (1LL << 30);
+        int32_t high = (int32_t)((product + nudge) / (1LL << 31));
+
+        int right = max(-shift, 0);
+        if (right > 0)
+        {
+            int32_t mask = (1 << right) - 1;
+            int32_t remainder = high & mask;
+            int32_t threshold = (mask >> 1) + (high < 0 ? 1 : 0);
+            high = (high >> right) + (remainder > threshold ? 1 : 0);
+        }
+
+        return constrain(high + layer.output_offset, (int32_t)layer.act_min, (int32_t)layer.act_max);
+    }
+};
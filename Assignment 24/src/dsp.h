@@ -0,0 +1,498 @@
+#pragma once
+
+#include <Arduino.h>
+
+// Fixed-point signal processing for the 16-bit PCM Mic produces, read as
+// Q15 (-1.0 to 1.0). Every table is built at compile time, so nothing
+// here costs RAM or start-up time.
+typedef int16_t q15_t;
+typedef int32_t q31_t;
+
+// constexpr maths for the tables. Only meant for compile time.
+constexpr double DSP_PI = 3.14159265358979323846;
+constexpr double DSP_LN2 = 0.69314718055994530942;
+
+constexpr double dspSin(double x)
+{
+    while (x > DSP_PI)
+    {
+        x -= 2 * DSP_PI;
+    }
+    while (x < -DSP_PI)
+    {
+        x += 2 * DSP_PI;
+    }
+
+    double term = x;
+    double sum = x;
+    for (int n = 1; n < 14; n++)
+    {
+        term *= -x * x / ((2 * n) * (2 * n + 1));
+        sum += term;
+    }
+    return sum;
+}
+
+constexpr double dspCos(double x)
+{
+    return dspSin(x + DSP_PI / 2);
+}
+
+// ln(x) = k ln(2) + 2 atanh((m - 1) / (m + 1)) for x = m 2^k
+constexpr double dspLog(double x)
+{
+    int k = 0;
+    while (x >= 2)
+    {
+        x /= 2;
+        k++;
+    }
+    while (x < 1)
+    {
+        x *= 2;
+        k--;
+    }
+
+    double y = (x - 1) / (x + 1);
+    double term = y;
+    double sum = 0;
+    for (int n = 1; n < 40; n += 2)
+    {
+        sum += term / n;
+        term *= y * y;
+    }
+    return 2 * sum + k * DSP_LN2;
+}
+
+constexpr double dspSqrt(double x)
+{
+    double root = x > 1 ? x : 1;
+    for (int i = 0; i < 40; i++)
+    {
+        root = (root + x / root) / 2;
+    }
+    return root;
+}
+
+constexpr q15_t toQ15(double value)
+{
+    double scaled = value * 32768.0;
+    scaled += scaled >= 0 ? 0.5 : -0.5;
+    return scaled >= 32767 ? 32767 : scaled <= -32768 ? -32768 : (q15_t)scaled;
+}
+
+constexpr bool isPowerOfTwo(size_t n)
+{
+    return n != 0 && (n & (n - 1)) == 0;
+}
+
+constexpr size_t log2Of(size_t n)
+{
+    return n <= 1 ? 0 : 1 + log2Of(n / 2);
+}
+
+// Integer square root, rounded down
+inline uint32_t dspIntSqrt(uint64_t value)
+{
+    uint64_t result = 0;
+    uint64_t bit = 1ULL << 62;
+
+    while (bit > value)
+    {
+        bit >>= 2;
+    }
+
+    while (bit != 0)
+    {
+        if (value >= result + bit)
+        {
+            value -= result + bit;
+            result = (result >> 1) + bit;
+        }
+        else
+        {
+            result >>= 1;
+        }
+        bit >>= 2;
+    }
+
+    return (uint32_t)result;
+}
+
+// log2 in Q16. log2(1 + f) ~ f + 0.3466 f (1 - f), within 0.005.
+inline q31_t dspLog2Q16(uint32_t value)
+{
+    int exponent = 31 - __builtin_clz(value);
+    uint32_t fraction = exponent >= 16 ? (value >> (exponent - 16)) & 0xFFFF : (value << (16 - exponent)) & 0xFFFF;
+    uint32_t correction = (fraction * (65536 - fraction)) >> 16;
+
+    return (exponent << 16) + fraction + ((correction * 22713) >> 16);
+}
+
+// Natural log in Q10
+inline q31_t dspLnQ10(uint32_t value)
+{
+    return (q31_t)(((int64_t)dspLog2Q16(value) * 45426) >> 22); // * ln(2), Q16 to Q10
+}
+
+// Shift that scales samples up to just under 2^14, the headroom RealFft
+// needs, without clipping any of them
+inline int dspHeadroom(const q15_t *samples, size_t len)
+{
+    int32_t peak = 1;
+    for (size_t i = 0; i < len; i++)
+    {
+        peak = max(peak, (int32_t)abs(samples[i]));
+    }
+    return max(0, __builtin_clz(peak) - 18);
+}
+
+// Periodic Hann window, as used for spectrograms
+template <size_t N>
+class HannWindow
+{
+public:
+    // out[i] = (in[i] << shift) * w[i]. in and out may be the same.
+    static void apply(const q15_t *in, q15_t *out, int shift = 0)
+    {
+        for (size_t i = 0; i < N; i++)
+        {
+            out[i] = ((in[i] << shift) * _table.values[i]) >> 15;
+        }
+    }
+
+private:
+    struct Table
+    {
+        q15_t values[N];
+
+        constexpr Table() : values()
+        {
+            for (size_t i = 0; i < N; i++)
+            {
+                values[i] = toQ15(0.5 - 0.5 * dspCos(2 * DSP_PI * i / N));
+            }
+        }
+    };
+
+    static constexpr Table _table{};
+};
+
+template <size_t N>
+constexpr typename HannWindow<N>::Table HannWindow<N>::_table;
+
+// Forward FFT of N real Q15 samples, computed as an N/2-point complex FFT
+// of the even/odd sample pairs. The complex FFT is radix-4, with one
+// radix-2 stage first when log2(N/2) is odd. Each stage scales its output
+// down so nothing can overflow, so the result is X[k] / N. The last stage
+// keeps two more fractional bits, giving Q17 in a q31_t.
+template <size_t N>
+class RealFft
+{
+    static_assert(isPowerOfTwo(N) && N >= 8, "RealFft needs a power of two of at least 8 points");
+
+public:
+    static const size_t BINS = N / 2 + 1;
+
+    // in holds N samples below 2^14 in magnitude (see dspHeadroom). out
+    // gets BINS interleaved re/im pairs. scratch holds N values.
+    static void forward(const q15_t *in, q31_t *out, q15_t *scratch)
+    {
+        memcpy(scratch, in, N * sizeof(q15_t));
+        complexFft(scratch);
+
+        for (size_t k = 0; k <= M / 2; k++)
+        {
+            const q15_t *z = scratch + 2 * _tables.order[k];
+            const q15_t *zc = scratch + 2 * _tables.order[(M - k) % M];
+
+            // Split the even and odd sample spectra back apart
+            int32_t evenRe = z[0] + zc[0];
+            int32_t evenIm = z[1] - zc[1];
+            int32_t oddRe = z[1] + zc[1];
+            int32_t oddIm = zc[0] - z[0];
+
+            int32_t wr = _tables.cos[k];
+            int32_t wi = _tables.cos[k + N / 4];
+
+            int32_t tr = (oddRe * wr - oddIm * wi + (1 << 14)) >> 15;
+            int32_t ti = (oddRe * wi + oddIm * wr + (1 << 14)) >> 15;
+
+            out[2 * k] = evenRe + tr;
+            out[2 * k + 1] = evenIm + ti;
+
+            // X[M - k] is the conjugate mirror of the same pair
+            if (k != 0 && k != M / 2)
+            {
+                out[2 * (M - k)] = evenRe - tr;
+                out[2 * (M - k) + 1] = ti - evenIm;
+            }
+        }
+
+        // Nyquist, from the k = 0 pair
+        out[2 * M] = (scratch[0] - scratch[1]) * 2;
+        out[2 * M + 1] = 0;
+    }
+
+private:
+    static const size_t M = N / 2;
+    static const bool RADIX2_FIRST = log2Of(M) % 2 == 1;
+    static const size_t RADIX4_LEN = RADIX2_FIRST ? M / 2 : M;
+
+    struct Tables
+    {
+        q15_t cos[N];      // cos(2 pi i / N); -sin is cos[i + N / 4]
+        uint16_t order[M]; // Where the complex FFT leaves frequency f
+
+        constexpr Tables() : cos(), order()
+        {
+            for (size_t i = 0; i < N; i++)
+            {
+                cos[i] = toQ15(dspCos(2 * DSP_PI * i / N));
+            }
+
+            for (size_t f = 0; f < M; f++)
+            {
+                size_t half = RADIX2_FIRST ? f % 2 : 0;
+                size_t digits = RADIX2_FIRST ? f / 2 : f;
+
+                size_t reversed = 0;
+                for (size_t len = RADIX4_LEN; len > 1; len /= 4)
+                {
+                    reversed = reversed * 4 + digits % 4;
+                    digits /= 4;
+                }
+
+                order[f] = half * RADIX4_LEN + reversed;
+            }
+        }
+    };
+
+    static constexpr Tables _tables{};
+
+    // W_M^i, with the M-point twiddles taken from the N-point table
+    static void twiddle(int32_t &re, int32_t &im, size_t i)
+    {
+        int32_t wr = _tables.cos[2 * i];
+        int32_t wi = _tables.cos[2 * i + N / 4];
+
+        int32_t r = (re * wr - im * wi + (1 << 14)) >> 15;
+        im = (re * wi + im * wr + (1 << 14)) >> 15;
+        re = r;
+    }
+
+    // In-place decimation-in-frequency FFT of M interleaved complex values,
+    // leaving the output in the order given by _tables.order
+    static void complexFft(q15_t *data)
+    {
+        if (RADIX2_FIRST)
+        {
+            for (size_t k = 0; k < M / 2; k++)
+            {
+                q15_t *a = data + 2 * k;
+                q15_t *b = data + 2 * (k + M / 2);
+
+                int32_t re = (a[0] - b[0]) >> 1;
+                int32_t im = (a[1] - b[1]) >> 1;
+                a[0] = (a[0] + b[0]) >> 1;
+                a[1] = (a[1] + b[1]) >> 1;
+
+                twiddle(re, im, k);
+                b[0] = re;
+                b[1] = im;
+            }
+        }
+
+        for (size_t len = RADIX4_LEN, step = M / RADIX4_LEN; len >= 4; len /= 4, step *= 4)
+        {
+            size_t quarter = len / 4;
+
+            for (size_t start = 0; start < M; start += len)
+            {
+                for (size_t k = 0; k < quarter; k++)
+                {
+                    q15_t *a = data + 2 * (start + k);
+                    q15_t *b = a + 2 * quarter;
+                    q15_t *c = b + 2 * quarter;
+                    q15_t *d = c + 2 * quarter;
+
+                    int32_t sumAcRe = a[0] + c[0], sumAcIm = a[1] + c[1];
+                    int32_t difAcRe = a[0] - c[0], difAcIm = a[1] - c[1];
+                    int32_t sumBdRe = b[0] + d[0], sumBdIm = b[1] + d[1];
+                    int32_t difBdRe = b[0] - d[0], difBdIm = b[1] - d[1];
+
+                    // y1 = (a - c) - j(b - d), y3 = (a - c) + j(b - d), all
+                    // rounded down by 4
+                    int32_t y0Re = (sumAcRe + sumBdRe + 2) >> 2, y0Im = (sumAcIm + sumBdIm + 2) >> 2;
+                    int32_t y1Re = (difAcRe + difBdIm + 2) >> 2, y1Im = (difAcIm - difBdRe + 2) >> 2;
+                    int32_t y2Re = (sumAcRe - sumBdRe + 2) >> 2, y2Im = (sumAcIm - sumBdIm + 2) >> 2;
+                    int32_t y3Re = (difAcRe - difBdIm + 2) >> 2, y3Im = (difAcIm + difBdRe + 2) >> 2;
+
+                    twiddle(y1Re, y1Im, k * step);
+                    twiddle(y2Re, y2Im, 2 * k * step);
+                    twiddle(y3Re, y3Im, 3 * k * step);
+
+                    a[0] = y0Re;
+                    a[1] = y0Im;
+                    b[0] = y1Re;
+                    b[1] = y1Im;
+                    c[0] = y2Re;
+                    c[1] = y2Im;
+                    d[0] = y3Re;
+                    d[1] = y3Im;
+                }
+            }
+        }
+    }
+};
+
+template <size_t N>
+constexpr typename RealFft<N>::Tables RealFft<N>::_tables;
+
+// Magnitudes of the interleaved re/im bins RealFft produces, in the same
+// Q format
+inline void dspMagnitudes(const q31_t *spectrum, uint32_t *magnitudes, size_t bins)
+{
+    for (size_t i = 0; i < bins; i++)
+    {
+        int64_t re = spectrum[2 * i];
+        int64_t im = spectrum[2 * i + 1];
+        magnitudes[i] = dspIntSqrt((uint64_t)(re * re + im * im));
+    }
+}
+
+// Triangular mel filterbank over the bins of a FftLen-point spectrum,
+// built the same way as TensorFlow's mfcc op: each bin between two band
+// centres feeds the lower band with its weight and the upper band with
+// the rest.
+template <size_t FftLen, size_t Bands, uint32_t SampleRate, uint32_t LowerHz, uint32_t UpperHz>
+class MelFilterbank
+{
+    static_assert(Bands < 128, "Band indexes are stored as int8_t");
+
+public:
+    static const size_t BINS = FftLen / 2 + 1;
+
+    static void apply(const uint32_t *magnitudes, uint32_t *mel)
+    {
+        memset(mel, 0, Bands * sizeof(uint32_t));
+
+        for (size_t i = _tables.start; i <= _tables.end; i++)
+        {
+            uint32_t weighted = ((uint64_t)magnitudes[i] * _tables.weight[i]) >> 15;
+            int8_t band = _tables.band[i];
+
+            if (band >= 0)
+            {
+                mel[band] += weighted;
+            }
+            if (band + 1 < (int)Bands)
+            {
+                mel[band + 1] += magnitudes[i] - weighted;
+            }
+        }
+    }
+
+private:
+    static constexpr double melOf(double freq)
+    {
+        return 1127.0 * dspLog(1.0 + freq / 700.0);
+    }
+
+    struct Tables
+    {
+        size_t start;
+        size_t end;
+        int8_t band[BINS];
+        uint16_t weight[BINS]; // Q15
+
+        constexpr Tables() : start(), end(), band(), weight()
+        {
+            double hzPerBin = (double)SampleRate / FftLen;
+            double melLow = melOf(LowerHz);
+            double melHigh = melOf(UpperHz);
+
+            double centres[Bands + 1] = {};
+            for (size_t i = 0; i <= Bands; i++)
+            {
+                centres[i] = melLow + (melHigh - melLow) * (i + 1) / (Bands + 1);
+            }
+
+            start = (size_t)(1.5 + LowerHz / hzPerBin);
+            end = (size_t)(UpperHz / hzPerBin);
+            end = end < BINS - 1 ? end : BINS - 1;
+
+            size_t next = 0;
+            for (size_t i = 0; i < BINS; i++)
+            {
+                band[i] = -2;
+                if (i < start || i > end)
+                {
+                    continue;
+                }
+
+                double mel = melOf(i * hzPerBin);
+                while (next < Bands && centres[next] < mel)
+                {
+                    next++;
+                }
+
+                band[i] = (int8_t)next - 1;
+                if (next > 0)
+                {
+                    weight[i] = (uint16_t)((centres[next] - mel) / (centres[next] - centres[next - 1]) * 32767.0);
+                }
+            }
+        }
+    };
+
+    static constexpr Tables _tables{};
+};
+
+template <size_t FftLen, size_t Bands, uint32_t SampleRate, uint32_t LowerHz, uint32_t UpperHz>
+constexpr typename MelFilterbank<FftLen, Bands, SampleRate, LowerHz, UpperHz>::Tables
+    MelFilterbank<FftLen, Bands, SampleRate, LowerHz, UpperHz>::_tables;
+
+// DCT-II keeping the first Outputs coefficients, with every row scaled by
+// sqrt(2 / Inputs) as TensorFlow's mfcc op does. That isn't orthonormal:
+// coefficient 0 comes out sqrt(2) too large. The output is in the same Q
+// format as the input.
+template <size_t Inputs, size_t Outputs>
+class Dct
+{
+public:
+    static void apply(const q31_t *in, q31_t *out)
+    {
+        for (size_t i = 0; i < Outputs; i++)
+        {
+            int64_t sum = 0;
+            for (size_t j = 0; j < Inputs; j++)
+            {
+                sum += (int64_t)in[j] * _table.values[i][j];
+            }
+            out[i] = (q31_t)(sum >> 15);
+        }
+    }
+
+private:
+    struct Table
+    {
+        q15_t values[Outputs][Inputs];
+
+        constexpr Table() : values()
+        {
+            for (size_t i = 0; i < Outputs; i++)
+            {
+                for (size_t j = 0; j < Inputs; j++)
+                {
+                    values[i][j] = toQ15(dspSqrt(2.0 / Inputs) * dspCos(DSP_PI / Inputs * (j + 0.5) * i));
+                }
+            }
+        }
+    };
+
+    static constexpr Table _table{};
+};
+
+template <size_t Inputs, size_t Outputs>
+constexpr typename Dct<Inputs, Outputs>::Table Dct<Inputs, Outputs>::_table;
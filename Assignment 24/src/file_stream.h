@@ -0,0 +1,44 @@
+#pragma once
+
+#include <Arduino.h>
+#include <Seeed_FS.h>
+
+#include "bulk_stream.h"
+
+// A file on the SD card as a BulkStream, so code that also reads from the
+// network gets File::read()'s block reads rather than a byte at a time.
+// The file stays open and owned by whoever opened it.
+class FileStream : public BulkStream {
+public:
+    FileStream(File *file = NULL) {
+        _file = file;
+
+        // What isn't in the file yet never will be
+        setTimeout(0);
+    }
+
+    virtual int available() override {
+        return _file != NULL ? _file->available() : 0;
+    }
+
+    virtual int read() override {
+        return _file != NULL ? _file->read() : -1;
+    }
+
+    virtual int peek() override {
+        return _file != NULL ? _file->peek() : -1;
+    }
+
+    virtual size_t write(uint8_t val) override {
+        return 0;
+    }
+
+    virtual size_t readBytes(char *buffer, size_t length) override {
+        return _file != NULL ? _file->read((uint8_t *)buffer, length) : 0;
+    }
+
+    using BulkStream::readBytes;
+
+private:
+    File *_file;
+};
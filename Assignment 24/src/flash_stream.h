@@ -4,16 +4,19 @@
 #include <HTTPClient.h>
 #include <sfud.h>
 
+#include "bulk_stream.h"
 #include "config.h"
 
-class FlashStream : public Stream {
+class FlashStream : public BulkStream {
 public:
-    FlashStream() {
-        _pos = 0;
-        _flash_address = 0;
+    FlashStream(size_t length = BUFFER_SIZE, size_t address = 0) {
+        _length = length;
+        _consumed = 0;
+        _flash_address = address;
         _flash = sfud_get_device_table() + 0;
 
-        populateBuffer();
+        _buffer_pos = 0;
+        _buffer_len = 0;
     }
 
     virtual size_t write(uint8_t val) override {
@@ -21,36 +24,75 @@ public:
     }
 
     virtual int available() override {
-        int remaining = BUFFER_SIZE - ((_flash_address - HTTP_TCP_BUFFER_SIZE) + _pos);
+        int remaining = _length - _consumed;
         int bytes_available = min(HTTP_TCP_BUFFER_SIZE, remaining);
 
         return (bytes_available == 0) ? -1 : bytes_available;
     }
 
     virtual int read() override {
-        int retVal = _buffer[_pos++];
-
-        if (_pos == HTTP_TCP_BUFFER_SIZE) {
-            populateBuffer();
+        if (!fillBuffer()) {
+            return -1;
         }
 
-        return retVal;
+        _consumed++;
+        return _buffer[_buffer_pos++];
     }
 
     virtual int peek() override {
-        return _buffer[_pos];
+        if (!fillBuffer()) {
+            return -1;
+        }
+
+        return _buffer[_buffer_pos];
     }
 
+    // HTTPClient pulls the body a chunk at a time. Anything still buffered
+    // from read()/peek() is handed out first, the rest is read from flash
+    // straight into the caller's buffer in a single sfud_read.
+    virtual size_t readBytes(char *buffer, size_t length) override {
+        length = min(length, _length - _consumed);
+
+        size_t copied = min(length, _buffer_len - _buffer_pos);
+        memcpy(buffer, _buffer + _buffer_pos, copied);
+        _buffer_pos += copied;
+
+        if (copied < length) {
+            sfud_read(_flash, _flash_address, length - copied, (uint8_t *)buffer + copied);
+            _flash_address += length - copied;
+        }
+
+        _consumed += length;
+        return length;
+    }
+
+    using BulkStream::readBytes;
+
 private:
-    size_t _pos;
+    size_t _length;
+    size_t _consumed;
     size_t _flash_address;
     const sfud_flash* _flash;
 
     byte _buffer[HTTP_TCP_BUFFER_SIZE];
+    size_t _buffer_pos;
+    size_t _buffer_len;
+
+    bool fillBuffer() {
+        if (_buffer_pos < _buffer_len) {
+            return true;
+        }
+
+        size_t remaining = _length - _consumed;
+        if (remaining == 0) {
+            return false;
+        }
+
+        _buffer_len = min((size_t)HTTP_TCP_BUFFER_SIZE, remaining);
+        sfud_read(_flash, _flash_address, _buffer_len, _buffer);
+        _flash_address += _buffer_len;
+        _buffer_pos = 0;
 
-    void populateBuffer() {
-        sfud_read(_flash, _flash_address, HTTP_TCP_BUFFER_SIZE, _buffer);
-        _flash_address += HTTP_TCP_BUFFER_SIZE;
-        _pos = 0;
+        return true;
     }
 };
@@ -3,51 +3,146 @@
 #include <Arduino.h>
 #include <sfud.h>
 
+#include "profiler.h"
+
+#define SFUD_PAGE_SIZE 256
+
 class FlashWriter
 {
 public:
 void init()
 {
     _flash = sfud_get_device_table() + 0;
-    _sfudBufferSize = _flash->chip.erase_gran;
-    _sfudBuffer = new byte[_sfudBufferSize];
+    _sfudSectorSize = _flash->chip.erase_gran;
+    reset();
+}
+
+// Starts writing at address, with size bytes from there to use, by
+// default the rest of the chip. All addresses the writer takes or reports
+// are relative to address. If it is not sector aligned, the rest of its
+// sector must already be erased.
+void reset(size_t address = 0, size_t size = SIZE_MAX)
+{
+    _sfudBase = address;
+    _sfudEnd = address + min(size, _flash->chip.capacity - address);
     _sfudBufferPos = 0;
-    _sfudBufferWritePos = 0;
-void writeSfudBuffer(byte b)
+    _sfudBufferWritePos = address;
+    _sfudErasedPos = ((address + _sfudSectorSize - 1) / _sfudSectorSize) * _sfudSectorSize;
+}
+
+// Erases the next sector if fewer than ahead bytes past the write position
+// are erased, so pages can be programmed without waiting on an erase. One
+// sector at a time, so a call never takes longer than one erase. Returns
+// true if it erased.
+bool eraseAhead(size_t ahead)
 {
-    _sfudBuffer[_sfudBufferPos++] = b;
-    if (_sfudBufferPos == _sfudBufferSize)
+    size_t end = min(_sfudBufferWritePos + _sfudBufferPos + ahead, _sfudBase + capacity());
+    if (_sfudErasedPos >= end)
     {
-        sfud_erase_write(_flash, _sfudBufferWritePos, _sfudBufferSize, _sfudBuffer);
-        _sfudBufferWritePos += _sfudBufferSize;
-        _sfudBufferPos = 0;
+        return false;
     }
+
+    PROFILE_START(erase);
+    sfud_erase(_flash, _sfudErasedPos, _sfudSectorSize);
+    PROFILE_END(erase, PROFILE_FLASH_ERASE);
+    _sfudErasedPos += _sfudSectorSize;
+    return true;
+}
+
+size_t capacity()
+{
+    return _sfudEnd - _sfudBase;
+}
+
+// The flash isn't memory mapped, readers have to go through sfud_read
+const byte *data()
+{
+    return NULL;
+}
+
+size_t writtenBytes()
+{
+    return _sfudBufferWritePos - _sfudBase;
 }
 
-void writeSfudBuffer(byte *b, size_t len)
+size_t erasedBytes()
 {
-    for (size_t i = 0; i < len; ++i)
+    return _sfudErasedPos - _sfudBase;
+}
+
+void write(byte b)
+{
+    write(&b, 1);
+}
+
+// Copies whole blocks into the page buffer and programs each full page.
+// Page-aligned runs are programmed straight from the caller's buffer.
+void write(const byte *b, size_t len)
+{
+    while (len > 0)
     {
-        writeSfudBuffer(b[i]);
+        if (_sfudBufferPos == 0 && len >= SFUD_PAGE_SIZE)
+        {
+            programPage(b, SFUD_PAGE_SIZE);
+            b += SFUD_PAGE_SIZE;
+            len -= SFUD_PAGE_SIZE;
+            continue;
+        }
+
+        size_t chunk = min(len, (size_t)(SFUD_PAGE_SIZE - _sfudBufferPos));
+        memcpy(_sfudBuffer + _sfudBufferPos, b, chunk);
+        _sfudBufferPos += chunk;
+        b += chunk;
+        len -= chunk;
+
+        if (_sfudBufferPos == SFUD_PAGE_SIZE)
+        {
+            programPage(_sfudBuffer, SFUD_PAGE_SIZE);
+            _sfudBufferPos = 0;
+        }
     }
 }
 
-void flushSfudBuffer()
+// Programs bytes that were already written as 0xFF, such as a header
+// field that is only known once the data behind it has been flushed.
+void patch(size_t address, const byte *b, size_t len)
+{
+    sfud_write(_flash, _sfudBase + address, len, b);
+}
+
+void flush()
 {
     if (_sfudBufferPos > 0)
     {
-        sfud_erase_write(_flash, _sfudBufferWritePos, _sfudBufferSize, _sfudBuffer);
-        _sfudBufferWritePos += _sfudBufferSize;
+        programPage(_sfudBuffer, _sfudBufferPos);
         _sfudBufferPos = 0;
     }
 }
-}
 
 private:
-byte *_sfudBuffer;
-size_t _sfudBufferSize;
+byte _sfudBuffer[SFUD_PAGE_SIZE];
+size_t _sfudBase;
+size_t _sfudEnd;
 size_t _sfudBufferPos;
 size_t _sfudBufferWritePos;
+size_t _sfudErasedPos;
+size_t _sfudSectorSize;
 
 const sfud_flash *_flash;
-};
\ No newline at end of file
+
+void programPage(const byte *page, size_t len)
+{
+    while (_sfudErasedPos < _sfudBufferWritePos + len)
+    {
+        PROFILE_START(erase);
+        sfud_erase(_flash, _sfudErasedPos, _sfudSectorSize);
+        PROFILE_END(erase, PROFILE_FLASH_ERASE);
+        _sfudErasedPos += _sfudSectorSize;
+    }
+
+    PROFILE_START(program);
+    sfud_write(_flash, _sfudBufferWritePos, len, page);
+    PROFILE_END(program, PROFILE_FLASH_PROGRAM);
+    _sfudBufferWritePos += len;
+}
+};
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <Arduino.h>
+
+#define CRC32_INIT 0xFFFFFFFF
+#define FNV1A_INIT 2166136261UL
+
+// Reflected CRC-32 (the zlib and Ethernet one) carried on over length more
+// bytes. Start from CRC32_INIT and invert the result once all the data is in.
+inline uint32_t crc32Update(uint32_t crc, const void *data, size_t length)
+{
+    const uint8_t *bytes = (const uint8_t *)data;
+
+    for (size_t i = 0; i < length; i++)
+    {
+        crc ^= bytes[i];
+        for (uint8_t bit = 0; bit < 8; bit++)
+        {
+            crc = (crc >> 1) ^ (0xEDB88320 & -(crc & 1));
+        }
+    }
+
+    return crc;
+}
+
+inline uint32_t crc32(const void *data, size_t length)
+{
+    return ~crc32Update(CRC32_INIT, data, length);
+}
+
+// 32-bit FNV-1a carried on over length more bytes, for cache keys. Start
+// from FNV1A_INIT.
+inline uint32_t fnv1aUpdate(uint32_t hash, const void *data, size_t length)
+{
+    const uint8_t *bytes = (const uint8_t *)data;
+
+    for (size_t i = 0; i < length; i++)
+    {
+        hash = (hash ^ bytes[i]) * 16777619UL;
+    }
+
+    return hash;
+}
+
+inline uint32_t fnv1a(const void *data, size_t length)
+{
+    return fnv1aUpdate(FNV1A_INIT, data, length);
+}
@@ -0,0 +1,146 @@
+#pragma once
+
+#include <Arduino.h>
+#include <Seeed_FS.h>
+
+#include "config.h"
+
+// Samples waiting between the network and the speaker. Once the ring is
+// full, new samples go to a spill file on the SD card and come back into
+// the ring as it drains, so a network that outpaces the DAC is never
+// held up. Without a spill file write() only takes what fits.
+class JitterBuffer
+{
+public:
+    void reset(File *spill = NULL)
+    {
+        _head = 0;
+        _tail = 0;
+        _count = 0;
+
+        _spill = spill;
+        _spillRead = 0;
+        _spillWrite = 0;
+        _spilledBytes = 0;
+    }
+
+    // Returns how many samples were taken
+    size_t write(const int16_t *samples, size_t count)
+    {
+        // Once spilling, everything goes behind the spill to keep the order
+        size_t taken = 0;
+        if (_spillRead == _spillWrite)
+        {
+            taken = put(samples, count);
+        }
+
+        if (taken < count && _spill != NULL)
+        {
+            size_t bytes = (count - taken) * sizeof(int16_t);
+            _spill->seek(_spillWrite);
+            bytes = _spill->write((const uint8_t *)(samples + taken), bytes);
+
+            _spillWrite += bytes;
+            _spilledBytes += bytes;
+            taken += bytes / sizeof(int16_t);
+        }
+
+        return taken;
+    }
+
+    // Returns how many samples were read
+    size_t read(int16_t *samples, size_t count)
+    {
+        size_t read = 0;
+        while (read < count && _count > 0)
+        {
+            size_t chunk = min(count - read, min(_count, (size_t)JITTER_BUFFER_SAMPLES - _tail));
+            memcpy(samples + read, _ring + _tail, chunk * sizeof(int16_t));
+
+            _tail = (_tail + chunk) % JITTER_BUFFER_SAMPLES;
+            _count -= chunk;
+            read += chunk;
+        }
+
+        refill();
+        return read;
+    }
+
+    // Samples waiting, spilled ones included
+    size_t available()
+    {
+        return _count + (_spillWrite - _spillRead) / sizeof(int16_t);
+    }
+
+    // Samples write() will take without a spill file
+    size_t space()
+    {
+        return _spillRead == _spillWrite ? JITTER_BUFFER_SAMPLES - _count : 0;
+    }
+
+    uint32_t spilledBytes()
+    {
+        return _spilledBytes;
+    }
+
+private:
+    int16_t _ring[JITTER_BUFFER_SAMPLES];
+    size_t _head;
+    size_t _tail;
+    size_t _count;
+
+    File *_spill;
+    uint32_t _spillRead;
+    uint32_t _spillWrite;
+    uint32_t _spilledBytes;
+
+    size_t put(const int16_t *samples, size_t count)
+    {
+        size_t taken = 0;
+        while (taken < count && _count < JITTER_BUFFER_SAMPLES)
+        {
+            size_t chunk = min(count - taken, min((size_t)JITTER_BUFFER_SAMPLES - _count,
+                                                  (size_t)JITTER_BUFFER_SAMPLES - _head));
+            memcpy(_ring + _head, samples + taken, chunk * sizeof(int16_t));
+
+            _head = (_head + chunk) % JITTER_BUFFER_SAMPLES;
+            _count += chunk;
+            taken += chunk;
+        }
+
+        return taken;
+    }
+
+    // Brings spilled samples back into the ring as it makes room
+    void refill()
+    {
+        if (_spillRead == _spillWrite)
+        {
+            return;
+        }
+
+        int16_t samples[256];
+        _spill->seek(_spillRead);
+
+        while (_spillRead < _spillWrite && _count < JITTER_BUFFER_SAMPLES)
+        {
+            size_t want = min(sizeof(samples) / sizeof(int16_t), (size_t)JITTER_BUFFER_SAMPLES - _count);
+            want = min(want, (size_t)(_spillWrite - _spillRead) / sizeof(int16_t));
+
+            size_t bytes = _spill->read((uint8_t *)samples, want * sizeof(int16_t));
+            if (bytes < sizeof(int16_t))
+            {
+                break;
+            }
+
+            _spillRead += put(samples, bytes / sizeof(int16_t)) * sizeof(int16_t);
+        }
+
+        // Start the file over once it has all been played
+        if (_spillRead == _spillWrite)
+        {
+            _spillRead = 0;
+            _spillWrite = 0;
+        }
+    }
+};
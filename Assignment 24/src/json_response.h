@@ -0,0 +1,256 @@
+#pragma once
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <Client.h>
+
+#include "bulk_stream.h"
+
+// Responses are filtered down to the one field that is used, so these
+// stay small however large the response is
+#define JSON_RESPONSE_SIZE 512
+#define JSON_FILTER_SIZE 64
+
+// Longest chunk-size or trailer line that is kept, the rest is dropped
+#define HTTP_BODY_LINE_SIZE 24
+
+// The body of an HTTP response, read straight off the connection. Undoes
+// chunked transfer encoding and stops at the end of the body, so a
+// kept-alive connection is left ready for the next response.
+// available(), read() and peek() never wait on the network: the chunk
+// framing is taken a byte at a time from what has arrived. Only
+// readBytes() and drain() wait, up to the client's timeout, and only
+// while the body has more to come. A body with no length and no chunks
+// ends when the server closes, never because a read ran out of time.
+class HttpBodyStream : public BulkStream {
+public:
+    // An empty body
+    HttpBodyStream() {
+        _client = NULL;
+        _remaining = 0;
+        _chunked = false;
+        _part = BODY_DATA;
+        _line_length = 0;
+        _done = true;
+        _clean = true;
+    }
+
+    // length is the Content-Length, or negative if there is none, in which
+    // case the body is chunked or runs until the server closes
+    HttpBodyStream(Client &client, long length, bool chunked) {
+        _client = &client;
+        _remaining = chunked ? 0 : length;
+        _chunked = chunked;
+        _part = chunked ? BODY_CHUNK_SIZE : BODY_DATA;
+        _line_length = 0;
+        _done = false;
+        _clean = false;
+        setTimeout(client.getTimeout());
+    }
+
+    // Only counts what has already arrived, so reading that much never
+    // waits on the network
+    virtual int available() override {
+        if (!advance() || _remaining == 0) {
+            return 0;
+        }
+
+        int available = _client->available();
+        return _remaining > 0 ? min((long)available, _remaining) : available;
+    }
+
+    virtual int read() override {
+        if (!advance() || _remaining == 0) {
+            return -1;
+        }
+
+        int c = _client->read();
+        if (c >= 0 && _remaining > 0) {
+            _remaining--;
+        }
+        return c;
+    }
+
+    virtual int peek() override {
+        return (advance() && _remaining != 0) ? _client->peek() : -1;
+    }
+
+    // Takes whatever has arrived straight from the client in one read,
+    // only waiting a byte at a time once that runs out
+    virtual size_t readBytes(char *buffer, size_t length) override {
+        size_t count = 0;
+        while (count < length) {
+            int received = available();
+            if (received > 0) {
+                received = _client->read((uint8_t *)buffer + count, min(length - count, (size_t)received));
+            }
+
+            if (received > 0) {
+                count += received;
+                if (_remaining > 0) {
+                    _remaining -= received;
+                }
+                continue;
+            }
+
+            int c = waitForByte();
+            if (c < 0) {
+                break;
+            }
+            buffer[count++] = (char)c;
+        }
+        return count;
+    }
+
+    using BulkStream::readBytes;
+
+    virtual size_t write(uint8_t val) override {
+        return 0;
+    }
+
+    // Reads whatever is left of the body. Returns true if it ended where
+    // the headers said it would, so the connection can be reused.
+    bool drain() {
+        while (waitForByte() >= 0);
+        return _clean;
+    }
+
+private:
+    enum BodyPart {
+        BODY_DATA,
+        BODY_CHUNK_SIZE,
+        BODY_CHUNK_END,
+        BODY_TRAILER
+    };
+
+    Client *_client;
+    long _remaining; // Negative for a body that runs until the server closes
+    bool _chunked;
+    BodyPart _part;
+    char _line[HTTP_BODY_LINE_SIZE];
+    size_t _line_length;
+    bool _done;
+    bool _clean;
+
+    // Takes in any chunk framing that has arrived and notices the end of
+    // the body. Returns false once the body is over. While it is true,
+    // _remaining is 0 only if the next chunk's size hasn't arrived yet.
+    bool advance() {
+        if (_done) {
+            return false;
+        }
+
+        if (!_chunked) {
+            if (_remaining == 0) {
+                _clean = true;
+                _done = true;
+            } else if (!_client->connected() && _client->available() == 0) {
+                _done = true;
+            }
+            return !_done;
+        }
+
+        while (_remaining == 0) {
+            if (_part == BODY_DATA) {
+                // The line break after the chunk just read
+                _part = BODY_CHUNK_END;
+            }
+
+            if (!readLine()) {
+                if (!_client->connected() && _client->available() == 0) {
+                    _done = true;
+                }
+                return !_done;
+            }
+
+            if (_part == BODY_CHUNK_END) {
+                _part = BODY_CHUNK_SIZE;
+            } else if (_part == BODY_CHUNK_SIZE) {
+                _remaining = max(strtol(_line, NULL, 16), 0L);
+                _part = (_remaining > 0) ? BODY_DATA : BODY_TRAILER;
+            } else if (_line[0] == 0) {
+                // The blank line after the last chunk
+                _clean = true;
+                _done = true;
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    // Builds up the next line from whatever has arrived, without the line
+    // break. Returns true once a whole line is in _line.
+    bool readLine() {
+        int c;
+        while ((c = _client->read()) >= 0) {
+            if (c == '\n') {
+                _line[_line_length] = 0;
+                _line_length = 0;
+                return true;
+            }
+
+            if (c != '\r' && _line_length < HTTP_BODY_LINE_SIZE - 1) {
+                _line[_line_length++] = c;
+            }
+        }
+        return false;
+    }
+
+    // Waits up to the timeout for the next byte of the body, giving up at
+    // once if the body ends
+    int waitForByte() {
+        unsigned long start = millis();
+        while (advance()) {
+            int c = read();
+            if (c >= 0) {
+                return c;
+            }
+
+            if (millis() - start >= _timeout) {
+                break;
+            }
+            delay(1);
+        }
+        return -1;
+    }
+};
+
+// Parses a JSON object from body keeping only field, so the rest of the
+// response never takes up any memory
+inline bool parseJsonField(Stream &body, const char *field, JsonDocument &doc) {
+    StaticJsonDocument<JSON_FILTER_SIZE> filter;
+    filter[field] = true;
+
+    DeserializationError error = deserializeJson(doc, body, DeserializationOption::Filter(filter));
+    if (error) {
+        Serial.print("Failed to parse response - ");
+        Serial.println(error.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+// Parses just the first element of a JSON array from body. ArduinoJson
+// stops reading at the end of a value, so the rest is never parsed.
+inline bool parseFirstJsonElement(Stream &body, JsonDocument &doc) {
+    int c;
+    do {
+        c = body.read();
+    } while (c == ' ' || c == '\t' || c == '\r' || c == '\n');
+
+    if (c != '[') {
+        Serial.println("Failed to parse response - expected an array");
+        return false;
+    }
+
+    DeserializationError error = deserializeJson(doc, body);
+    if (error) {
+        Serial.print("Failed to parse response - ");
+        Serial.println(error.c_str());
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <Arduino.h>
+#include <WiFiClientSecure.h>
+
+#include "config.h"
+
+// A TLS connection that stays open between requests. The handshake is
+// the slowest part of a request on the RTL8720, so requests to the same
+// host reuse the open connection until the server closes it or it has
+// sat idle for KEEP_ALIVE_IDLE_MS, after which it is reopened.
+class KeepAliveClient {
+public:
+    KeepAliveClient(const char *name) {
+        _name = name;
+        _host[0] = 0;
+        _last_used = 0;
+        _reused = false;
+        _requests = 0;
+        _handshakes = 0;
+        _handshake_ms = 0;
+        _last_handshake_ms = 0;
+    }
+
+    void setCACert(const char *certificate) {
+        _client.setCACert(certificate);
+    }
+
+    // Makes sure there is a connection to host, only handshaking when the
+    // open one can't be used
+    bool connect(const char *host, uint16_t port = 443) {
+        _requests++;
+
+        if (_client.connected() && strcmp(host, _host) == 0 &&
+            millis() - _last_used < KEEP_ALIVE_IDLE_MS) {
+            _reused = true;
+            return true;
+        }
+
+        _client.stop();
+        _reused = false;
+
+        unsigned long start = millis();
+        bool connected = _client.connect(host, port);
+        _last_handshake_ms = millis() - start;
+
+        _handshakes++;
+        _handshake_ms += _last_handshake_ms;
+
+        if (!connected) {
+            _host[0] = 0;
+            return false;
+        }
+
+        strncpy(_host, host, sizeof(_host) - 1);
+        _host[sizeof(_host) - 1] = 0;
+        return true;
+    }
+
+    // True if the last connect() went over an already open connection, so
+    // a failure may just mean the server closed it while it was idle
+    bool reused() {
+        return _reused;
+    }
+
+    // Call once a response has been read in full so the idle time counts
+    // from here. HTTPClient closes the connection itself if the server
+    // asked it to.
+    void release() {
+        _last_used = millis();
+    }
+
+    void close() {
+        _client.stop();
+        _host[0] = 0;
+    }
+
+    WiFiClientSecure &client() {
+        return _client;
+    }
+
+    // Prints how the last request connected and the running totals
+    void printStats() {
+        Serial.print(_name);
+        if (_reused) {
+            Serial.print(": reused connection");
+        } else {
+            Serial.print(": TLS handshake took ");
+            Serial.print(_last_handshake_ms);
+            Serial.print(" ms");
+        }
+
+        Serial.print(" (");
+        Serial.print(_handshakes);
+        Serial.print(" handshakes in ");
+        Serial.print(_requests);
+        Serial.print(" requests, ");
+        Serial.print(_handshakes == 0 ? 0 : _handshake_ms / _handshakes);
+        Serial.println(" ms average)");
+    }
+
+private:
+    WiFiClientSecure _client;
+    const char *_name;
+    char _host[64];
+    unsigned long _last_used;
+    bool _reused;
+
+    uint32_t _requests;
+    uint32_t _handshakes;
+    uint32_t _handshake_ms;
+    uint32_t _last_handshake_ms;
+};
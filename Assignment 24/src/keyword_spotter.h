@@ -0,0 +1,187 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include "config.h"
+#include "ds_cnn.h"
+#include "mfcc.h"
+#include "profiler.h"
+
+// Tests build the spotter on a fixture model instead
+#ifdef KWS_MODEL_HEADER
+#include KWS_MODEL_HEADER
+#else
+#include "kws_model.h"
+#endif
+
+#define KWS_FRAMES 49          // 1 s of MFCC frames per inference
+#define KWS_INFERENCE_FRAMES 5 // Run the model every 100 ms
+#define KWS_SMOOTHING 3        // Inferences averaged before deciding
+
+static_assert(!KWS_ENABLED || KWS_MODEL_AVAILABLE,
+              "KWS_ENABLED needs a model, generate kws_model.h with tools/export_kws_model.py");
+static_assert(!KWS_ENABLED || RATE == MFCC_SAMPLE_RATE, "The keyword model is trained on 16 kHz audio");
+
+// Listens for the wake word on the continuous mic stream: MFCC frames go
+// into a 1 s sliding window that an int8 DS-CNN scores every
+// KWS_INFERENCE_FRAMES frames.
+class KeywordSpotter
+{
+public:
+    void init()
+    {
+        reset();
+    }
+
+    // Forgets everything heard so far
+    void reset()
+    {
+        _frameFill = 0;
+        _framesSeen = 0;
+        _framesSinceInference = 0;
+        _scoreIndex = 0;
+        _score = 0;
+
+        memset(_features, KWS_MODEL_INPUT_ZERO_POINT, sizeof(_features));
+        memset(_scores, 0, sizeof(_scores));
+    }
+
+    // Feeds len samples, returns true when the keyword has just been heard
+    bool process(const int16_t *pcm, size_t len)
+    {
+        bool detected = false;
+
+        while (len > 0)
+        {
+            size_t chunk = min(len, (size_t)(MFCC_FRAME_LEN - _frameFill));
+            memcpy(_frame + _frameFill, pcm, chunk * sizeof(int16_t));
+            _frameFill += chunk;
+            pcm += chunk;
+            len -= chunk;
+
+            if (_frameFill < MFCC_FRAME_LEN)
+            {
+                break;
+            }
+
+            addFrame();
+
+            memmove(_frame, _frame + MFCC_FRAME_STRIDE, (MFCC_FRAME_LEN - MFCC_FRAME_STRIDE) * sizeof(int16_t));
+            _frameFill = MFCC_FRAME_LEN - MFCC_FRAME_STRIDE;
+
+            if (_framesSeen >= KWS_FRAMES && ++_framesSinceInference >= KWS_INFERENCE_FRAMES)
+            {
+                _framesSinceInference = 0;
+                detected |= infer();
+            }
+        }
+
+        return detected;
+    }
+
+    // Smoothed keyword probability of the last inference, in percent
+    uint8_t score()
+    {
+        return _score;
+    }
+
+    // Cost of the last MFCC frame and the last model run
+    uint32_t frameMicros()
+    {
+        return _frameMicros;
+    }
+
+    uint32_t inferenceMicros()
+    {
+        return _inferenceMicros;
+    }
+
+private:
+    MfccFrontEnd _mfcc;
+
+    int16_t _frame[MFCC_FRAME_LEN];
+    size_t _frameFill;
+    uint32_t _framesSeen;
+    uint8_t _framesSinceInference;
+
+    int8_t _features[KWS_FRAMES][MFCC_COEFFS];
+    int8_t _activations[2][KWS_MODEL_MAX_ACTIVATIONS];
+
+    uint8_t _scores[KWS_SMOOTHING];
+    uint8_t _scoreIndex;
+    uint8_t _score;
+
+    uint32_t _frameMicros;
+    uint32_t _inferenceMicros;
+
+    // Slides the window on by one frame and quantizes the new MFCCs the
+    // way the model's input expects
+    void addFrame()
+    {
+        uint32_t start = micros();
+        PROFILE_START(frame);
+
+        int32_t mfcc[MFCC_COEFFS];
+        _mfcc.compute(_frame, mfcc);
+
+        memmove(_features[0], _features[1], (KWS_FRAMES - 1) * MFCC_COEFFS);
+
+        const float scale = 1.0f / (1024.0f * KWS_MODEL_INPUT_SCALE);
+        for (size_t i = 0; i < MFCC_COEFFS; i++)
+        {
+            long value = lroundf(mfcc[i] * scale) + KWS_MODEL_INPUT_ZERO_POINT;
+            _features[KWS_FRAMES - 1][i] = constrain(value, -128L, 127L);
+        }
+
+        _framesSeen++;
+
+        PROFILE_END(frame, PROFILE_KWS_FRAME);
+        _frameMicros = micros() - start;
+    }
+
+    bool infer()
+    {
+        uint32_t start = micros();
+        PROFILE_START(inference);
+
+        const int8_t *logits = DsCnn::run(KWS_MODEL_LAYERS, KWS_MODEL_LAYER_COUNT, _features[0],
+                                          _activations[0], _activations[1]);
+
+        // The exported model stops before its softmax
+        int8_t largest = -128;
+        for (size_t i = 0; i < KWS_MODEL_CLASSES; i++)
+        {
+            largest = max(largest, logits[i]);
+        }
+
+        float probabilities[KWS_MODEL_CLASSES];
+        float total = 0;
+        for (size_t i = 0; i < KWS_MODEL_CLASSES; i++)
+        {
+            probabilities[i] = expf((logits[i] - largest) * KWS_MODEL_OUTPUT_SCALE);
+            total += probabilities[i];
+        }
+
+        _scores[_scoreIndex] = (uint8_t)(probabilities[KWS_MODEL_KEYWORD] * 100 / total);
+        _scoreIndex = (_scoreIndex + 1) % KWS_SMOOTHING;
+
+        uint32_t sum = 0;
+        for (size_t i = 0; i < KWS_SMOOTHING; i++)
+        {
+            sum += _scores[i];
+        }
+        _score = sum / KWS_SMOOTHING;
+
+        PROFILE_END(inference, PROFILE_KWS_INFERENCE);
+        _inferenceMicros = micros() - start;
+
+        if (_score < KWS_THRESHOLD_PERCENT)
+        {
+            return false;
+        }
+
+        // Don't fire again on the same utterance
+        memset(_scores, 0, sizeof(_scores));
+        return true;
+    }
+};
@@ -0,0 +1,22 @@
+#pragma once
+
+// Generated by tools/export_kws_model.py from a trained int8 .tflite
+// keyword model. This is the empty placeholder: train a DS-CNN on
+// MFCC_COEFFS x KWS_FRAMES features, export it and set KWS_ENABLED.
+
+#include "ds_cnn.h"
+
+#define KWS_MODEL_AVAILABLE 0
+
+#define KWS_MODEL_CLASSES 2
+#define KWS_MODEL_KEYWORD 1
+#define KWS_MODEL_LAYER_COUNT 0
+#define KWS_MODEL_MAX_ACTIVATIONS 1
+
+#define KWS_MODEL_INPUT_SCALE 1.0f
+#define KWS_MODEL_INPUT_ZERO_POINT 0
+#define KWS_MODEL_OUTPUT_SCALE 1.0f
+#define KWS_MODEL_OUTPUT_ZERO_POINT 0
+
+static const char *const KWS_MODEL_LABELS[KWS_MODEL_CLASSES] = {"_unknown_", "keyword"};
+static const DsCnnLayer *const KWS_MODEL_LAYERS = NULL;
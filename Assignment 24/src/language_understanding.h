@@ -2,48 +2,134 @@
 
 #include <Arduino.h>
 #include <ArduinoJson.h>
-#include <HTTPClient.h>
 #include <WiFiClient.h>
 
+#include "async_http.h"
 #include "config.h"
+#include "json_response.h"
+#include "timer_parser.h"
+
+// Texts waiting for the cloud while it answers about an earlier one
+#define TIMER_QUEUE_SIZE 4
+
+// Called with the number of seconds a text asked for a timer for, 0 if
+// it didn't ask for one
+typedef void (*TimerDurationCallback)(const String &text, int seconds);
 
 class LanguageUnderstanding {
 public:
-    int GetTimerDuration(String text) {
-        // Create JSON payload
-        DynamicJsonDocument doc(1024);
-        doc["text"] = text;
+    LanguageUnderstanding() {
+        _queue_start = 0;
+        _queue_count = 0;
+        _callback = NULL;
+    }
+
+    // Works out how long a timer text asks for and passes it to callback,
+    // straight away if it can be parsed locally, otherwise once the cloud
+    // has answered. Texts are answered in the order they arrive.
+    void GetTimerDuration(const String &text, TimerDurationCallback callback) {
+        _callback = callback;
 
-        String body;
-        serializeJson(doc, body);
+        if (_queue_count == TIMER_QUEUE_SIZE) {
+            Serial.println("Too many texts waiting to be understood, dropping this one");
+            return;
+        }
 
-        // Initialize HTTP client
-        HTTPClient httpClient;
-        httpClient.begin(_client, TEXT_TO_TIMER_FUNCTION_URL);
+        _queue[(_queue_start + _queue_count) % TIMER_QUEUE_SIZE] = text;
+        _queue_count++;
 
-        int httpResponseCode = httpClient.POST(body);
-        int seconds = 0;
+        // Anything already queued is waiting on the request
+        if (_queue_count == 1) {
+            understandNext();
+        }
+    }
+
+private:
+    WiFiClient _client;
+    AsyncHttpRequest _request;
+    TimerDurationCallback _callback;
+
+    String _queue[TIMER_QUEUE_SIZE];
+    size_t _queue_start;
+    size_t _queue_count;
+
+    // Answers queued texts until one has to go to the cloud
+    void understandNext() {
+        while (_queue_count > 0) {
+            const String &text = _queue[_queue_start];
+
+#if LOCAL_TIMER_PARSER
+            // Most requests are simple enough to understand without a round trip
+            unsigned long start = micros();
+            TimerDuration duration = TimerParser::parse(text.c_str());
+            unsigned long elapsed = micros() - start;
+
+            if (duration.confident) {
+                Serial.print("Timer seconds: ");
+                Serial.print(duration.seconds);
+                Serial.print(" (parsed locally in ");
+                Serial.print(elapsed);
+                Serial.println(" us)");
 
-        if (httpResponseCode == 200) {
-            String result = httpClient.getString();
-            Serial.println(result);
+                answered(duration.seconds);
+                continue;
+            }
 
-            DynamicJsonDocument responseDoc(1024);
-            deserializeJson(responseDoc, result.c_str());
+            Serial.println("Timer duration unclear, asking the cloud");
+#endif
 
-            JsonObject obj = responseDoc.as<JsonObject>();
-            seconds = obj["seconds"].as<int>();
+            // Create JSON payload
+            DynamicJsonDocument doc(1024);
+            doc["text"] = text;
+
+            String body;
+            serializeJson(doc, body);
+
+            _request.begin(_client, TEXT_TO_TIMER_FUNCTION_URL);
+            _request.addHeader("Content-Type", "application/json");
+            _request.setBody(body);
+            _request.onComplete(responseReceived, this);
+
+            if (asyncHttp.start(_request)) {
+                return;
+            }
+
+            answered(0);
+        }
+    }
+
+    // Passes the answer for the oldest text on and drops it from the queue
+    void answered(int seconds) {
+        String text = _queue[_queue_start];
+        _queue[_queue_start] = "";
+        _queue_start = (_queue_start + 1) % TIMER_QUEUE_SIZE;
+        _queue_count--;
+
+        _callback(text, seconds);
+    }
+
+    static void responseReceived(AsyncHttpRequest &request, Stream &body, void *context) {
+        LanguageUnderstanding *self = (LanguageUnderstanding *)context;
+        int seconds = 0;
+
+        if (request.status() == 200) {
+            StaticJsonDocument<JSON_RESPONSE_SIZE> responseDoc;
+            if (parseJsonField(body, "seconds", responseDoc)) {
+                seconds = responseDoc["seconds"].as<int>();
+                Serial.print("Timer seconds: ");
+                Serial.print(seconds);
+                Serial.print(" (from the cloud in ");
+                Serial.print(request.elapsed());
+                Serial.println(" ms)");
+            }
         } else {
             Serial.print("Failed to understand text - error ");
-            Serial.println(httpResponseCode);
+            Serial.println(request.status());
         }
 
-        httpClient.end();
-        return seconds;
+        self->answered(seconds);
+        self->understandNext();
     }
-
-private:
-    WiFiClient _client;
 };
 
 // Global instance
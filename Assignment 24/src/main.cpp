@@ -3,17 +3,37 @@
 #include <rpcWiFi.h>
 #include <arduino-timer.h>
 #include "text_to_speech.h"
+#include "audio_journal.h"
 #include "config.h"
 #include "mic.h"
 #include "speech_to_text.h"
 #include "language_understanding.h" 
 #include "text_translator.h"
+#include "upload_manager.h"
+#include "announcer.h"
+#include "async_http.h"
+
+void processText(const String &text);
+
 // Global instances
 Mic mic;
-SpeechToText speechToText;
-LanguageUnderstanding languageUnderstanding;
+AudioJournal journal;
+UploadManager uploads(journal, speechToText, processText);
 auto timer = timer_create_default();
 
+// Set once the finished recording has been handed over for recognition
+bool recordingProcessed = false;
+
+// Mic DMA interrupt
+void DMAC_1_Handler() {
+    mic.dmaHandler();
+}
+
+// Speaker DMA interrupt
+void DMAC_2_Handler() {
+    speechPlayer.dmaHandler();
+}
+
 // Connect to WiFi
 void connectWiFi() {
     while (WiFi.status() != WL_CONNECTED) {
@@ -24,48 +44,85 @@ void connectWiFi() {
     Serial.println("Connected!");
 }
 
-// Text-to-speech simulation
-void say(const String& text) {
-    text = textTranslator.translateText(text, LANGUAGE, SERVER_LANGUAGE);
-    Serial.print("Saying: ");
-    Serial.println(text);
-    textToSpeech.convertTextToSpeech(text);
-}
-
 // Timer callback
 bool timerExpired(void* announcement) {
-    say((char*)announcement);
+    String *message = (String *)announcement;
+    announcer.say(*message);
+    delete message;
     return false;  // Do not repeat
 }
 
-// Process recorded audio and set timer
-void processAudio() {
-    Serial.println("Processing audio...");
-    String text = speechToText.convertSpeechToText();
-    Serial.println("Recognized Text: " + text);
-
-    int total_seconds = languageUnderstanding.GetTimerDuration(text);
+// Set the timer once the duration is known
+void timerDurationReceived(const String &text, int total_seconds) {
     if (total_seconds == 0) return;
 
     int minutes = total_seconds / 60;
     int seconds = total_seconds % 60;
 
+    // The duration fragments are shared by both messages
+    String duration;
+    if (minutes > 0) duration += String(minutes) + " minute" + FRAGMENT_SEPARATOR;
+    if (seconds > 0) duration += String(seconds) + " second" + FRAGMENT_SEPARATOR;
+
     // Build begin message
-    String begin_message;
-    if (minutes > 0) begin_message += String(minutes) + " minute ";
-    if (seconds > 0) begin_message += String(seconds) + " second ";
-    begin_message += "timer started.";
-
-    // Build end message
-    String end_message = "Time's up on your ";
-    if (minutes > 0) end_message += String(minutes) + " minute ";
-    if (seconds > 0) end_message += String(seconds) + " second ";
-    end_message += "timer.";
-
-    say(begin_message);
-    timer.in(total_seconds * 1000, timerExpired, (void*)end_message.c_str());
-    String text = speechToText.convertSpeechToText();
-    text = textTranslator.translateText(text, LANGUAGE, SERVER_LANGUAGE);
+    String begin_message = duration + "timer started.";
+
+    // Build end message, kept until the timer goes off
+    String *end_message = new String(String("Time's up on your") + FRAGMENT_SEPARATOR + duration + "timer.");
+
+    announcer.say(begin_message);
+    timer.in(total_seconds * 1000, timerExpired, (void*)end_message);
+}
+
+// Process recognized speech and set timer
+void processText(const String &text) {
+    // A failed or silent recognition leaves nothing to understand
+    if (text.length() == 0) {
+        Serial.println("Nothing recognized");
+        return;
+    }
+
+    Serial.println("Recognized Text: " + text);
+    languageUnderstanding.GetTimerDuration(text, timerDurationReceived);
+}
+
+// Recognition callback for recordings that aren't journaled
+void recordingRecognized(const String &text, void *) {
+    processText(text);
+}
+
+// Process recorded audio
+void processAudio() {
+    Serial.println("Processing audio...");
+
+    // SRAM recordings aren't journaled, they are uploaded straight away
+    if (mic.recordingData() != NULL) {
+        if (speechToText.isStreaming()) {
+            speechToText.finishStreaming(mic.recordingLength(), recordingRecognized, NULL);
+        } else {
+            speechToText.convertSpeechToText(mic.recordingLength(), mic.recordingData(), 0, recordingRecognized, NULL);
+        }
+        return;
+    }
+
+    JournalRecord record = journal.seal(mic.recordingLength());
+
+    // Someone is waiting on this one, so don't sit out the backoff
+    uploads.retryNow();
+
+    // Otherwise loop() uploads it, after anything older
+    if (speechToText.isStreaming()) {
+        uploads.finishStreaming(record);
+    }
+}
+
+// Where the next recording goes in flash
+size_t nextRecordingAddress() {
+    return (CAPTURE_BACKEND == CAPTURE_FLASH) ? journal.beginRecord() : 0;
+}
+
+size_t recordingCapacity() {
+    return (CAPTURE_BACKEND == CAPTURE_FLASH) ? journal.recordCapacity() : SRAM_CAPTURE_SIZE;
 }
 
 // Setup system
@@ -81,7 +138,13 @@ void setup() {
 
     pinMode(WIO_KEY_C, INPUT_PULLUP);
 
-    mic.init();
+#if PROFILE_AUDIO
+    audioProfiler.init();
+#endif
+
+    journal.init();
+    translationCache.init();
+    mic.init(nextRecordingAddress(), recordingCapacity());
     speechToText.init();
     textToSpeech.init();
 
@@ -90,15 +153,85 @@ void setup() {
 
 // Main loop
 void loop() {
-    if (digitalRead(WIO_KEY_C) == LOW && !mic.isRecording()) {
+    mic.processBuffers();
+
+    asyncHttp.poll(!mic.isRecording());
+
+    // Keeps the speaker fed, a step at a time
+    speechPlayer.poll();
+
+    // Not while speech is playing, or it would end up in the recording
+    if (digitalRead(WIO_KEY_C) == LOW && !mic.isRecording() && !mic.isRecordingReady() && !speechPlayer.busy()) {
+        // Connect first, the handshake would stall the DMA ring mid-recording.
+        // Only stream when nothing older is waiting, to keep commands in order.
+        if (STREAM_SPEECH_UPLOAD && journal.pendingCount() == 0 && !speechToText.busy()) {
+            speechToText.beginStreaming(mic.recordingData(), journal.recordAddress());
+        }
+
         Serial.println("Starting recording...");
-        mic.startRecording();
+        mic.startRecording(VAD_ENABLED);
     }
 
-    if (!mic.isRecording() && mic.isRecordingReady()) {
+#if KWS_ENABLED
+    // The keyword spotter starts the recording itself, from the DMA stream
+    if (mic.keywordDetected()) {
+        KeywordSpotter &kws = mic.keywordSpotter();
+        Serial.print("Keyword detected (");
+        Serial.print(kws.score());
+        Serial.print("%), MFCC ");
+        Serial.print(kws.frameMicros());
+        Serial.print(" us/frame, model ");
+        Serial.print(kws.inferenceMicros());
+        Serial.println(" us");
+    }
+#endif
+
+    if (speechToText.isStreaming()) {
+        if (mic.isRecording()) {
+            speechToText.streamRecording(mic.recordedBytes());
+        } else if (!mic.isRecordingReady()) {
+            speechToText.cancelStreaming();
+        }
+    }
+
+    if (!mic.isRecording() && mic.isRecordingReady() && !recordingProcessed) {
         Serial.println("Finished recording");
+        Serial.print("DMA overruns: ");
+        Serial.print(mic.overruns());
+        Serial.print(", buffer high-water mark: ");
+        Serial.println(mic.highWaterMark());
+#if PROFILE_AUDIO
+        // Decode with tools/decode_profile.py
+        audioProfiler.dump(Serial, mic.overruns());
+        audioProfiler.reset();
+#endif
         processAudio();
-        mic.reset();
+        recordingProcessed = true;
+    }
+
+    // An SRAM recording is uploaded straight out of the mic's buffer, so
+    // the next recording has to wait until that is done
+    if (recordingProcessed && (mic.recordingData() == NULL || !speechToText.busy())) {
+        mic.reset(nextRecordingAddress(), recordingCapacity());
+        recordingProcessed = false;
+    }
+
+    // Keep the access token fresh so uploads aren't turned away
+    if (!mic.isRecording() && WiFi.status() == WL_CONNECTED) {
+        speechToText.updateToken();
+        speechToText.poll();
+    }
+
+    // Upload queued recordings oldest first, one at a time so they keep
+    // their order. A failure backs off before the next try.
+    if (!mic.isRecording() && uploads.isDue() && WiFi.status() == WL_CONNECTED) {
+        uploads.uploadNext();
+    }
+
+    if (!mic.isRecording()) {
+        announcer.poll();
+        speechCache.update();
+        translationCache.update();
     }
 
     timer.tick();  // Handle timer events
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include "dsp.h"
+
+// 40 ms frames every 20 ms of 16 kHz audio, 10 MFCCs from 40 mel bands
+// between 20 Hz and 4 kHz, the features the usual DS-CNN keyword models
+// are trained on.
+#define MFCC_SAMPLE_RATE 16000
+#define MFCC_FRAME_LEN 640
+#define MFCC_FRAME_STRIDE 320
+#define MFCC_FFT_LEN 1024
+#define MFCC_MEL_BANDS 40
+#define MFCC_COEFFS 10
+#define MFCC_LOWER_HZ 20
+#define MFCC_UPPER_HZ 4000
+
+// Fixed-point MFCC front end. Matches the TensorFlow audio_spectrogram +
+// mfcc ops: periodic Hann window, magnitude spectrum, triangular mel
+// filterbank, natural log and TensorFlow's DCT-II (see Dct).
+class MfccFrontEnd
+{
+public:
+    typedef RealFft<MFCC_FFT_LEN> Fft;
+    typedef MelFilterbank<MFCC_FFT_LEN, MFCC_MEL_BANDS, MFCC_SAMPLE_RATE, MFCC_LOWER_HZ, MFCC_UPPER_HZ> Filterbank;
+
+    // Computes the MFCCs of one MFCC_FRAME_LEN frame, in Q10 (1024 = 1.0)
+    void compute(const q15_t *frame, q31_t *mfcc)
+    {
+        // Scale the frame up to use all the headroom the FFT allows, and
+        // take the shift back out after the log
+        int shift = dspHeadroom(frame, MFCC_FRAME_LEN);
+
+        HannWindow<MFCC_FRAME_LEN>::apply(frame, _samples, shift);
+        memset(_samples + MFCC_FRAME_LEN, 0, (MFCC_FFT_LEN - MFCC_FRAME_LEN) * sizeof(q15_t));
+
+        Fft::forward(_samples, _spectrum, _scratch);
+
+        dspMagnitudes(_spectrum, _magnitudes, Fft::BINS);
+
+        uint32_t mel[MFCC_MEL_BANDS];
+        Filterbank::apply(_magnitudes, mel);
+
+        // The spectrum is X / MFCC_FFT_LEN in Q17, so
+        // ln(X) = ln(mel) - (17 - log2(MFCC_FFT_LEN) + shift) ln(2)
+        q31_t offset = (q31_t)(17 - log2Of(MFCC_FFT_LEN) + shift) * 710; // ln(2) in Q10
+        q31_t logMel[MFCC_MEL_BANDS];
+        for (size_t i = 0; i < MFCC_MEL_BANDS; i++)
+        {
+            logMel[i] = mel[i] == 0 ? -28295 : dspLnQ10(mel[i]) - offset; // ln(1e-12) floor
+        }
+
+        Dct<MFCC_MEL_BANDS, MFCC_COEFFS>::apply(logMel, mfcc);
+    }
+
+private:
+    q15_t _samples[MFCC_FFT_LEN];
+    q15_t _scratch[MFCC_FFT_LEN];
+    q31_t _spectrum[Fft::BINS * 2];
+    uint32_t _magnitudes[Fft::BINS];
+};
@@ -1,3 +1,57 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include "codec.h"
+#include "config.h"
+#include "dmac.h"
+#include "flash_writer.h"
+#include "keyword_spotter.h"
+#include "pcm.h"
+#include "profiler.h"
+#include "sram_writer.h"
+#include "vad.h"
+
+static_assert(ADC_BUF_COUNT >= 2, "The DMA ring needs at least two buffers");
+
+#define CAPTURE_FLASH 0
+#define CAPTURE_SRAM 1
+
+#if CAPTURE_BACKEND == CAPTURE_SRAM
+typedef SramWriter CaptureWriter;
+#else
+typedef FlashWriter CaptureWriter;
+#endif
+
+#define ADC_BUF_MS (ADC_BUF_LEN * 1000 / RATE)
+// Flash is erased this far ahead of the recording, a couple of blocks
+#define MIC_ERASE_AHEAD (2 * ADC_BUF_LEN * sizeof(int16_t))
+#define ENCODED_BUF_LEN (AUDIO_CODEC == CODEC_PCM ? 1 : ENCODED_MAX_SIZE(ADC_BUF_LEN))
+#define KWS_PREROLL_BLOCKS ((KWS_PREROLL_MS + ADC_BUF_MS - 1) / ADC_BUF_MS + 1)
+
+// TC5 triggers one DMA transfer per sample. TC5 and ADC1 both run from
+// GCLK1, and the ADC free-runs so a fresh result is always waiting.
+#define MIC_GCLK_HZ 48000000UL
+#define ADC_CLOCKS_PER_CONVERSION 13 // 12-bit result with SAMPLEN 0
+
+static constexpr uint32_t TC5_PERIOD = (MIC_GCLK_HZ + RATE / 2) / RATE;
+static constexpr uint32_t TC5_RATE = MIC_GCLK_HZ / TC5_PERIOD;
+
+// Largest ADC prescaler, as a power of two, that still converts at least
+// once per sample
+constexpr uint8_t adcPrescalerShift(uint8_t shift = 8)
+{
+    return (shift == 1 || (MIC_GCLK_HZ >> shift) / ADC_CLOCKS_PER_CONVERSION >= RATE) ? shift : adcPrescalerShift(shift - 1);
+}
+
+static_assert(RATE == 8000 || RATE == 11025 || RATE == 16000 || RATE == 22050,
+              "RATE must be 8000, 11025, 16000 or 22050");
+static_assert(TC5_PERIOD - 1 <= 0xFFFF, "RATE is too low for the 16-bit TC5 period");
+static_assert((TC5_RATE > RATE ? TC5_RATE - RATE : RATE - TC5_RATE) * 1000 <= RATE,
+              "TC5 can't hit RATE within 0.1%");
+static_assert((MIC_GCLK_HZ >> adcPrescalerShift()) / ADC_CLOCKS_PER_CONVERSION >= RATE,
+              "The ADC can't convert as fast as RATE");
+
 class Mic
 {
 public:
@@ -5,34 +59,92 @@ public:
     {
         _isRecording = false;
         _isRecordingReady = false;
+
+        _dma_index = 0;
+        _ready_head = 0;
+        _ready_tail = 0;
+        _held = false;
+        _overruns = 0;
+        _high_water_mark = 0;
+
+        _pcm_buf = _pcm_bufs[0];
+        _pcm_preroll = _pcm_bufs[1];
+
+#if KWS_ENABLED
+        _kws_preroll_pos = 0;
+        _kws_preroll_count = 0;
+        _keywordDetected = false;
+#endif
     }
 
+    // Runs in the DMAC interrupt: only queues the buffer that just filled.
+    // The PCM conversion and flash writes happen in processBuffers().
     void dmaHandler()
     {
-        static uint8_t count = 0;
+        PROFILE_START(isr);
+        queueFilledBuffer();
+        PROFILE_END(isr, PROFILE_DMA_ISR);
+    }
 
-        if (DMAC->Channel[1].CHINTFLAG.bit.SUSP)
+    // Drains the filled DMA buffers, then erases flash ahead of the
+    // recording, one sector per call. Call from loop().
+    void processBuffers()
+    {
+        while (_ready_tail != _ready_head)
         {
-            DMAC->Channel[1].CHCTRLB.reg = DMAC_CHCTRLB_CMD_RESUME;
-            DMAC->Channel[1].CHINTFLAG.bit.SUSP = 1;
+            uint8_t tail = _ready_tail;
+            __DMB();
 
-            if (count)
-            {
-                audioCallback(_adc_buf_0, ADC_BUF_LEN);
-            }
-            else
+            PROFILE_SINCE(_ready_cycles[tail], PROFILE_BLOCK_LATENCY);
+            PROFILE_START(block);
+            audioCallback(_adc_bufs[_ready[tail]], ADC_BUF_LEN);
+            PROFILE_END(block, PROFILE_BLOCK_PROCESS);
+
+            __DMB();
+            _ready_tail = (tail + 1) % ADC_BUF_COUNT;
+
+            // The channel stays suspended while a buffer is held, so the
+            // ISR can't run until RESUME is written
+            if (_held)
             {
-                audioCallback(_adc_buf_1, ADC_BUF_LEN);
+                _held = false;
+                queueBuffer(_dma_index);
+                _dma_index = (_dma_index + 1) % ADC_BUF_COUNT;
+                __DMB();
+                DMAC->Channel[1].CHCTRLB.reg = DMAC_CHCTRLB_CMD_RESUME;
             }
+        }
 
-            count = (count + 1) % 2;
+        // Past the end of a finished recording may be another recording
+        if (!_isRecordingReady)
+        {
+            _writer.eraseAhead(MIC_ERASE_AHEAD);
         }
     }
 
-    void startRecording()
+    uint32_t overruns()
     {
-        _isRecording = true;
+        return _overruns;
+    }
+
+    uint8_t highWaterMark()
+    {
+        return _high_water_mark;
+    }
+
+    // In voice-activated mode nothing is kept until speech starts, and the
+    // recording stops after VAD_TRAILING_SILENCE_MS of silence. Either way
+    // it is capped at BUFFER_SIZE.
+    void startRecording(bool voiceActivated = false)
+    {
+        _voiceActivated = voiceActivated;
+        _speechStarted = false;
+        _hasPreroll = false;
+        _silentBlocks = 0;
+        _waitedBlocks = 0;
+
         _isRecordingReady = false;
+        _isRecording = true;
     }
 
     bool isRecording()
@@ -45,141 +157,336 @@ public:
         return _isRecordingReady;
     }
 
-    void init()
+    // Bytes of the recording that have reached flash (or SRAM) so far
+    size_t recordedBytes()
+    {
+        return _writer.writtenBytes();
+    }
+
+    // Size of the recorded WAV file, header included
+    size_t recordingLength()
+    {
+        return _length;
+    }
+
+    // The recording in memory when capturing to SRAM, NULL when it is in flash
+    const byte *recordingData()
+    {
+        return _writer.data();
+    }
+
+#if KWS_ENABLED
+    // True once after the keyword spotter has started a recording
+    bool keywordDetected()
+    {
+        bool detected = _keywordDetected;
+        _keywordDetected = false;
+        return detected;
+    }
+
+    KeywordSpotter &keywordSpotter()
+    {
+        return _kws;
+    }
+#endif
+
+    // address is where the next recording goes in flash, and size how much
+    // room it has there
+    void init(size_t address = 0, size_t size = SIZE_MAX)
     {
         analogReference(AR_INTERNAL2V23);
 
         _writer.init();
+        _writer.reset(address, size);
 
         initBufferHeader();
+
+#if KWS_ENABLED
+        _kws.init();
+#endif
+
         configureDmaAdc();
     }
 
-    void reset()
+    void reset(size_t address = 0, size_t size = SIZE_MAX)
     {
         _isRecordingReady = false;
         _isRecording = false;
 
-        _writer.reset();
+        _writer.reset(address, size);
 
         initBufferHeader();
+
+#if KWS_ENABLED
+        _kws.reset();
+        _kws_preroll_count = 0;
+#endif
     }
 
 private:
     volatile bool _isRecording;
     volatile bool _isRecordingReady;
-    FlashWriter _writer;
+    CaptureWriter _writer;
+    VoiceActivityDetector _vad;
+    AudioEncoder _encoder;
+
+    size_t _length;
+    size_t _headerSize;
+    uint32_t _samples;
+    bool _voiceActivated;
+    bool _speechStarted;
+    bool _hasPreroll;
+    uint32_t _silentBlocks;
+    uint32_t _waitedBlocks;
+
+    dmacdescriptor _descriptor __attribute__((aligned(16)));
 
-    typedef struct
+    dmacdescriptor _ring_descriptors[ADC_BUF_COUNT - 1] __attribute__((aligned(16)));
+
+    uint16_t _adc_bufs[ADC_BUF_COUNT][ADC_BUF_LEN] __attribute__((aligned(4)));
+
+    // Single-producer (ISR) / single-consumer (loop) queue of filled buffers
+    volatile uint8_t _ready[ADC_BUF_COUNT];
+    volatile uint8_t _ready_head;
+    volatile uint8_t _ready_tail;
+    volatile uint8_t _dma_index;
+    volatile bool _held; // _dma_index is filled and waiting for room in the queue
+    volatile uint32_t _overruns;
+    volatile uint8_t _high_water_mark;
+#if PROFILE_AUDIO
+    volatile uint32_t _ready_cycles[ADC_BUF_COUNT];
+#endif
+
+    int16_t _pcm_bufs[2][ADC_BUF_LEN] __attribute__((aligned(4)));
+    int16_t *_pcm_buf;
+    int16_t *_pcm_preroll;
+    byte _encoded_buf[ENCODED_BUF_LEN];
+
+#if KWS_ENABLED
+    KeywordSpotter _kws;
+    int16_t _kws_preroll[KWS_PREROLL_BLOCKS][ADC_BUF_LEN] __attribute__((aligned(4)));
+    uint8_t _kws_preroll_pos;
+    uint8_t _kws_preroll_count;
+    bool _keywordDetected;
+#endif
+
+    // The queue holds at most ADC_BUF_COUNT - 1 buffers, so once the one
+    // that just filled is queued the DMA's next buffer is always free. When
+    // the queue is full the next buffer is the one loop() is working on, so
+    // the channel is left suspended, losing samples rather than overwriting
+    // them, until processBuffers() makes room.
+    void queueFilledBuffer()
     {
-        uint16_t btctrl;
-        uint16_t btcnt;
-        uint32_t srcaddr;
-        uint32_t dstaddr;
-        uint32_t descaddr;
-    } dmacdescriptor;
+        if (DMAC->Channel[1].CHINTFLAG.bit.SUSP)
+        {
+            DMAC->Channel[1].CHINTFLAG.bit.SUSP = 1;
 
-    volatile dmacdescriptor _wrb[DMAC_CH_NUM] __attribute__((aligned(16)));
-    dmacdescriptor _descriptor_section[DMAC_CH_NUM] __attribute__((aligned(16)));
-    dmacdescriptor _descriptor __attribute__((aligned(16)));
+            // The keyword spotter needs the stream between recordings too
+            if (_isRecording || KWS_ENABLED)
+            {
+                if ((_ready_head + 1) % ADC_BUF_COUNT == _ready_tail)
+                {
+                    if (_isRecording)
+                    {
+                        _overruns++;
+                    }
+                    _held = true;
+                    return;
+                }
+
+                queueBuffer(_dma_index);
+            }
 
-    uint16_t _adc_buf_0[ADC_BUF_LEN];
-    uint16_t _adc_buf_1[ADC_BUF_LEN];
-
-    struct wavFileHeader
-    {
-        char riff[4];
-        long flength;
-        char wave[4];
-        char fmt[4];
-        long chunk_size;
-        short format_tag;
-        short num_chans;
-        long srate;
-        long bytes_per_sec;
-        short bytes_per_samp;
-        short bits_per_samp;
-        char data[4];
-        long dlength;
-    };
+            _dma_index = (_dma_index + 1) % ADC_BUF_COUNT;
+            DMAC->Channel[1].CHCTRLB.reg = DMAC_CHCTRLB_CMD_RESUME;
+        }
+    }
+
+    void queueBuffer(uint8_t filled)
+    {
+        uint8_t head = _ready_head;
+        uint8_t next = (head + 1) % ADC_BUF_COUNT;
+
+        _ready[head] = filled;
+        PROFILE_STAMP(_ready_cycles[head]);
+        __DMB();
+        _ready_head = next;
+
+        uint8_t pending = (next + ADC_BUF_COUNT - _ready_tail) % ADC_BUF_COUNT;
+        if (pending > _high_water_mark)
+        {
+            _high_water_mark = pending;
+        }
+    }
 
     void audioCallback(uint16_t *buf, uint32_t buf_len)
     {
-        static uint32_t idx = 44;
+#if KWS_ENABLED
+        if (!_isRecording && !_isRecordingReady)
+        {
+            listen(buf, buf_len);
+            return;
+        }
+#endif
 
         if (_isRecording)
         {
-            for (uint32_t i = 0; i < buf_len; i++)
+            convertAdcToPcm(buf, _pcm_buf, buf_len);
+
+            if (_voiceActivated)
             {
-                int16_t audio_value = ((int16_t)buf[i] - 2048) * 16;
-                _writer.writeSfudBuffer(audio_value & 0xFF);
-                _writer.writeSfudBuffer((audio_value >> 8) & 0xFF);
+                bool speech = _vad.isSpeech(_pcm_buf, buf_len);
+
+                if (!_speechStarted)
+                {
+                    if (!speech)
+                    {
+                        // Keep the last silent block so the onset isn't clipped
+                        int16_t *tmp = _pcm_preroll;
+                        _pcm_preroll = _pcm_buf;
+                        _pcm_buf = tmp;
+                        _hasPreroll = true;
+
+                        if (++_waitedBlocks * ADC_BUF_MS >= VAD_ONSET_TIMEOUT_MS)
+                        {
+                            _isRecording = false;
+                        }
+                        return;
+                    }
+
+                    _speechStarted = true;
+                    if (_hasPreroll)
+                    {
+                        writePcm(_pcm_preroll, buf_len);
+                    }
+                }
+
+                _silentBlocks = speech ? 0 : _silentBlocks + 1;
             }
 
-            idx += buf_len;
+            writePcm(_pcm_buf, buf_len);
 
-            if (idx >= BUFFER_SIZE)
+            if (_samples >= SAMPLES || _length >= _writer.capacity() ||
+                (_voiceActivated && _silentBlocks * ADC_BUF_MS >= VAD_TRAILING_SILENCE_MS))
             {
-                _writer.flushSfudBuffer();
-                idx = 44;
-                _isRecording = false;
-                _isRecordingReady = true;
+                finishRecording();
             }
         }
     }
 
-    void initBufferHeader()
+#if KWS_ENABLED
+    // Runs the keyword spotter between recordings. The last few blocks are
+    // kept so the command that follows the keyword isn't clipped while the
+    // model catches up.
+    void listen(uint16_t *buf, uint32_t buf_len)
     {
-        wavFileHeader wavh;
+        int16_t *pcm = _kws_preroll[_kws_preroll_pos];
+        convertAdcToPcm(buf, pcm, buf_len);
+        _kws_preroll_pos = (_kws_preroll_pos + 1) % KWS_PREROLL_BLOCKS;
+        _kws_preroll_count = min(_kws_preroll_count + 1, KWS_PREROLL_BLOCKS);
+
+        if (!_kws.process(pcm, buf_len))
+        {
+            return;
+        }
+
+        _keywordDetected = true;
+        startRecording(VAD_ENABLED);
+        _speechStarted = true;
+
+        // Oldest first, ending with the block just heard
+        for (uint8_t i = KWS_PREROLL_BLOCKS - _kws_preroll_count; i < KWS_PREROLL_BLOCKS; i++)
+        {
+            writePcm(_kws_preroll[(_kws_preroll_pos + i) % KWS_PREROLL_BLOCKS], buf_len);
+        }
+    }
+#endif
 
-        strncpy(wavh.riff, "RIFF", 4);
-        strncpy(wavh.wave, "WAVE", 4);
-        strncpy(wavh.fmt, "fmt ", 4);
-        strncpy(wavh.data, "data", 4);
+    void writePcm(int16_t *pcm, uint32_t len)
+    {
+        len = min(len, (uint32_t)(SAMPLES - _samples));
+        _samples += len;
 
-        wavh.chunk_size = 16;
-        wavh.format_tag = 1;
-        wavh.num_chans = 1;
-        wavh.srate = RATE;
-        wavh.bytes_per_sec = (RATE * 1 * 16 * 1) / 8;
-        wavh.bytes_per_samp = 2;
-        wavh.bits_per_samp = 16;
-        wavh.dlength = RATE * 2 * 1 * 16 / 2;
-        wavh.flength = wavh.dlength + 44;
+        if (AUDIO_CODEC == CODEC_PCM)
+        {
+            writeCapture((byte *)pcm, len * sizeof(int16_t));
+            return;
+        }
 
-        _writer.writeSfudBuffer((byte *)&wavh, 44);
+        size_t bytes = _encoder.encode(pcm, len, _encoded_buf);
+        writeCapture(_encoded_buf, bytes);
+    }
+
+    void writeCapture(const byte *b, size_t len)
+    {
+        len = min(len, _writer.capacity() - _length);
+
+        _writer.write(b, len);
+        _length += len;
+    }
+
+    void finishRecording()
+    {
+        if (AUDIO_CODEC != CODEC_PCM)
+        {
+            size_t bytes = _encoder.flush(_encoded_buf);
+            writeCapture(_encoded_buf, bytes);
+        }
+
+        _writer.flush();
+
+        // The header went out with the lengths left erased (0xFFFFFFFF), so
+        // they can be programmed now that the real size is known
+        uint32_t flength = _length - 8;
+        uint32_t dlength = _length - _headerSize;
+        _writer.patch(_encoder.riffLengthOffset(), (byte *)&flength, sizeof(flength));
+        _writer.patch(_encoder.dataLengthOffset(), (byte *)&dlength, sizeof(dlength));
+
+        if (_encoder.factOffset() != 0)
+        {
+            _writer.patch(_encoder.factOffset(), (byte *)&_samples, sizeof(_samples));
+        }
+
+        _isRecording = false;
+        _isRecordingReady = true;
+    }
+
+    void initBufferHeader()
+    {
+        byte header[WAV_MAX_HEADER_SIZE];
+
+        _encoder.reset();
+        _headerSize = _encoder.writeHeader(header);
+
+        _writer.write(header, _headerSize);
+        _length = _headerSize;
+        _samples = 0;
     }
 
     void configureDmaAdc()
     {
-        DMAC->BASEADDR.reg = (uint32_t)_descriptor_section;
-        DMAC->WRBADDR.reg = (uint32_t)_wrb;
-        DMAC->CTRL.reg = DMAC_CTRL_DMAENABLE | DMAC_CTRL_LVLEN(0xf);
+        Dmac::init();
 
         DMAC->Channel[1].CHCTRLA.reg = DMAC_CHCTRLA_TRIGSRC(TC5_DMAC_ID_OVF) |
                                        DMAC_CHCTRLA_TRIGACT_BURST;
 
-        // Descriptor for buffer 0
-        _descriptor.descaddr = (uint32_t)&_descriptor_section[1];
-        _descriptor.srcaddr = (uint32_t)&ADC1->RESULT.reg;
-        _descriptor.dstaddr = (uint32_t)_adc_buf_0 + sizeof(uint16_t) * ADC_BUF_LEN;
-        _descriptor.btcnt = ADC_BUF_LEN;
-        _descriptor.btctrl = DMAC_BTCTRL_BEATSIZE_HWORD |
-                              DMAC_BTCTRL_DSTINC |
-                              DMAC_BTCTRL_VALID |
-                              DMAC_BTCTRL_BLOCKACT_SUSPEND;
-        memcpy(&_descriptor_section[0], &_descriptor, sizeof(_descriptor));
-
-        // Descriptor for buffer 1
-        _descriptor.descaddr = (uint32_t)&_descriptor_section[0];
-        _descriptor.srcaddr = (uint32_t)&ADC1->RESULT.reg;
-        _descriptor.dstaddr = (uint32_t)_adc_buf_1 + sizeof(uint16_t) * ADC_BUF_LEN;
-        _descriptor.btcnt = ADC_BUF_LEN;
-        _descriptor.btctrl = DMAC_BTCTRL_BEATSIZE_HWORD |
-                              DMAC_BTCTRL_DSTINC |
-                              DMAC_BTCTRL_VALID |
-                              DMAC_BTCTRL_BLOCKACT_SUSPEND;
-        memcpy(&_descriptor_section[1], &_descriptor, sizeof(_descriptor));
+        // Channel 1 starts at its section descriptor (buffer 0), which links
+        // through the ring descriptors (buffers 1..N-1) and back again
+        for (uint8_t i = 0; i < ADC_BUF_COUNT; i++)
+        {
+            dmacdescriptor *desc = (i == 0) ? &Dmac::descriptor(1) : &_ring_descriptors[i - 1];
+            dmacdescriptor *next = (i == ADC_BUF_COUNT - 1) ? &Dmac::descriptor(1) : &_ring_descriptors[i];
+
+            _descriptor.descaddr = (uintptr_t)next;
+            _descriptor.srcaddr = (uintptr_t)&ADC1->RESULT.reg;
+            _descriptor.dstaddr = (uintptr_t)_adc_bufs[i] + sizeof(uint16_t) * ADC_BUF_LEN;
+            _descriptor.btcnt = ADC_BUF_LEN;
+            _descriptor.btctrl = DMAC_BTCTRL_BEATSIZE_HWORD |
+                                  DMAC_BTCTRL_DSTINC |
+                                  DMAC_BTCTRL_VALID |
+                                  DMAC_BTCTRL_BLOCKACT_SUSPEND;
+            memcpy(desc, &_descriptor, sizeof(_descriptor));
+        }
 
         NVIC_SetPriority(DMAC_1_IRQn, 0);
         NVIC_EnableIRQ(DMAC_1_IRQn);
@@ -191,7 +498,7 @@ private:
         ADC1->SAMPCTRL.bit.SAMPLEN = 0x00;
         while (ADC1->SYNCBUSY.bit.SAMPCTRL)
             ;
-        ADC1->CTRLA.reg = ADC_CTRLA_PRESCALER_DIV128;
+        ADC1->CTRLA.reg = ADC_CTRLA_PRESCALER(adcPrescalerShift() - 1);
         ADC1->CTRLB.reg = ADC_CTRLB_RESSEL_12BIT | ADC_CTRLB_FREERUN;
         while (ADC1->SYNCBUSY.bit.CTRLB)
             ;
@@ -206,7 +513,7 @@ private:
 
         GCLK->PCHCTRL[TC5_GCLK_ID].reg = GCLK_PCHCTRL_CHEN | GCLK_PCHCTRL_GEN_GCLK1;
         TC5->COUNT16.WAVE.reg = TC_WAVE_WAVEGEN_MFRQ;
-        TC5->COUNT16.CC[0].reg = 3000 - 1;
+        TC5->COUNT16.CC[0].reg = TC5_PERIOD - 1;
         while (TC5->COUNT16.SYNCBUSY.bit.CC0)
             ;
         TC5->COUNT16.CTRLA.bit.ENABLE = 1;
@@ -0,0 +1,13 @@
+#pragma once
+
+#include <Arduino.h>
+
+// Converts 12-bit unsigned ADC samples to signed 16-bit PCM,
+// ((int16_t)sample - 2048) * 16, one sample at a time. dst may be src.
+inline void convertAdcToPcm(const uint16_t *src, int16_t *dst, size_t len)
+{
+    for (size_t i = 0; i < len; i++)
+    {
+        dst[i] = ((int16_t)src[i] - 2048) * 16;
+    }
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include "config.h"
+
+// Cycle-count probes for the audio path, read from the DWT cycle counter.
+// With PROFILE_AUDIO off the macros compile to nothing.
+#if PROFILE_AUDIO
+#define PROFILE_START(name) uint32_t name##_cycles = DWT->CYCCNT
+#define PROFILE_END(name, probe) audioProfiler.record(probe, DWT->CYCCNT - name##_cycles)
+#define PROFILE_STAMP(var) var = DWT->CYCCNT
+#define PROFILE_SINCE(var, probe) audioProfiler.record(probe, DWT->CYCCNT - (var))
+#else
+#define PROFILE_START(name)
+#define PROFILE_END(name, probe)
+#define PROFILE_STAMP(var)
+#define PROFILE_SINCE(var, probe)
+#endif
+
+#define PROFILE_MAGIC 0x464F5250 // "PROF"
+#define PROFILE_BUCKETS 32
+
+enum ProfileProbe
+{
+    PROFILE_DMA_ISR,       // Mic::dmaHandler, entry to exit
+    PROFILE_BLOCK_LATENCY, // Buffer filled by DMA until loop() picks it up
+    PROFILE_BLOCK_PROCESS, // Conversion, encoding and writing of one buffer
+    PROFILE_FLASH_ERASE,   // One sector erase
+    PROFILE_FLASH_PROGRAM, // One page program
+    PROFILE_KWS_FRAME,     // MFCCs of one keyword spotter frame
+    PROFILE_KWS_INFERENCE, // One run of the keyword model
+    PROFILE_PROBE_COUNT
+};
+
+// Sent over Serial as-is, little-endian. tools/decode_profile.py decodes it.
+struct ProfileHistogram
+{
+    uint32_t count;
+    uint32_t max;
+    uint64_t total;
+    uint32_t buckets[PROFILE_BUCKETS]; // buckets[n] counts durations in [2^(n-1), 2^n) cycles
+} __attribute__((packed));
+
+struct ProfileReport
+{
+    uint32_t magic;
+    uint32_t cpu_hz;
+    uint32_t deadline_cycles; // Time the DMA takes to fill one buffer
+    uint32_t overruns;
+    uint32_t deadline_misses; // Block latencies longer than deadline_cycles
+    ProfileHistogram probes[PROFILE_PROBE_COUNT];
+} __attribute__((packed));
+
+class AudioProfiler
+{
+public:
+    void init()
+    {
+        CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+        DWT->CYCCNT = 0;
+        DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+        reset();
+    }
+
+    void reset()
+    {
+        memset(&_report, 0, sizeof(_report));
+        _report.magic = PROFILE_MAGIC;
+        _report.cpu_hz = SystemCoreClock;
+        _report.deadline_cycles = (uint64_t)SystemCoreClock * ADC_BUF_LEN / RATE;
+    }
+
+    void record(ProfileProbe probe, uint32_t cycles)
+    {
+        ProfileHistogram &histogram = _report.probes[probe];
+
+        histogram.count++;
+        histogram.total += cycles;
+        histogram.max = max(histogram.max, cycles);
+        histogram.buckets[cycles == 0 ? 0 : min(32 - __builtin_clz(cycles), PROFILE_BUCKETS - 1)]++;
+
+        if (probe == PROFILE_BLOCK_LATENCY && cycles > _report.deadline_cycles)
+        {
+            _report.deadline_misses++;
+        }
+    }
+
+    // Writes the report as a binary blob, starting with PROFILE_MAGIC
+    void dump(Stream &stream, uint32_t overruns)
+    {
+        _report.overruns = overruns;
+        stream.write((const uint8_t *)&_report, sizeof(_report));
+        stream.println();
+    }
+
+private:
+    ProfileReport _report;
+};
+
+#if PROFILE_AUDIO
+// Global instance
+AudioProfiler audioProfiler;
+#endif
@@ -0,0 +1,205 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include "config.h"
+#include "dmac.h"
+#include "jitter_buffer.h"
+
+// TC4 triggers one DMA transfer per sample from a ping-pong pair of
+// buffers to DAC0, on DMAC channel 2. Both run from GCLK1 like the mic.
+#define SPEAKER_GCLK_HZ 48000000UL
+#define SPEAKER_BUF_LEN 512
+#define SPEAKER_SILENCE 2048
+
+class Speaker
+{
+public:
+    Speaker()
+    {
+        _dma_index = 0;
+        _filled[0] = false;
+        _filled[1] = false;
+        _ending = false;
+        _underruns = 0;
+    }
+
+    void init()
+    {
+        // Lets the core power up and configure the DAC
+        analogWriteResolution(12);
+        analogWrite(DAC0, SPEAKER_SILENCE);
+
+        fillSilence(0);
+        fillSilence(1);
+        configureDmaDac();
+    }
+
+    // Runs in the DMAC interrupt when a buffer has played
+    void dmaHandler()
+    {
+        if (DMAC->Channel[2].CHINTFLAG.bit.TCMPL)
+        {
+            DMAC->Channel[2].CHINTFLAG.bit.TCMPL = 1;
+
+            // What just played is replaced with silence, which is what
+            // plays if it isn't refilled in time
+            uint8_t played = _dma_index;
+            fillSilence(played);
+            _filled[played] = false;
+
+            _dma_index = played ^ 1;
+            if (!_filled[_dma_index] && !_ending)
+            {
+                _underruns++;
+            }
+        }
+    }
+
+    // Fills the buffer that isn't playing, if it is free and jitter has a
+    // buffer's worth. ending pads the last samples out with silence.
+    void pump(JitterBuffer &jitter, bool ending)
+    {
+        if (_filled[_dma_index ^ 1] || (jitter.available() < SPEAKER_BUF_LEN && !ending))
+        {
+            return;
+        }
+
+        int16_t samples[SPEAKER_BUF_LEN];
+        size_t count = jitter.read(samples, SPEAKER_BUF_LEN);
+        if (count == 0)
+        {
+            _ending = true;
+            return;
+        }
+
+        // Converted in place, so only the copy has to wait on the DMA
+        uint16_t *converted = (uint16_t *)samples;
+        for (size_t i = 0; i < count; i++)
+        {
+            converted[i] = (uint16_t)(samples[i] ^ 0x8000) >> 4;
+        }
+        for (size_t i = count; i < SPEAKER_BUF_LEN; i++)
+        {
+            converted[i] = SPEAKER_SILENCE;
+        }
+
+        // If a buffer finished playing since the check above, the one that
+        // was free is now playing, so which buffer to fill is only decided
+        // with the DMAC interrupt held off. The other is free either way,
+        // the interrupt has just emptied it.
+        __disable_irq();
+        uint8_t next = _dma_index ^ 1;
+        memcpy(_bufs[next], converted, sizeof(_bufs[next]));
+        __DMB();
+        _filled[next] = true;
+        __enable_irq();
+    }
+
+    // Starts playing at rate, after pump() has filled what it can
+    void start(uint32_t rate)
+    {
+        _ending = false;
+        _underruns = 0;
+
+        // Play the filled buffer first
+        if (!_filled[_dma_index])
+        {
+            _dma_index ^= 1;
+        }
+
+        DMAC->Channel[2].CHCTRLA.bit.ENABLE = 0;
+        while (DMAC->Channel[2].CHCTRLA.bit.ENABLE)
+            ;
+        dmacdescriptor &first = Dmac::descriptor(2);
+        memcpy(&first, _dma_index == 0 ? &_descriptors[0] : &_descriptors[1], sizeof(first));
+        DMAC->Channel[2].CHCTRLA.bit.ENABLE = 1;
+
+        uint32_t period = (SPEAKER_GCLK_HZ + rate / 2) / rate;
+        TC4->COUNT16.CC[0].reg = min(period, 0x10000UL) - 1;
+        while (TC4->COUNT16.SYNCBUSY.bit.CC0)
+            ;
+        TC4->COUNT16.CTRLA.bit.ENABLE = 1;
+        while (TC4->COUNT16.SYNCBUSY.bit.ENABLE)
+            ;
+    }
+
+    void stop()
+    {
+        TC4->COUNT16.CTRLA.bit.ENABLE = 0;
+        while (TC4->COUNT16.SYNCBUSY.bit.ENABLE)
+            ;
+        DMAC->Channel[2].CHCTRLA.bit.ENABLE = 0;
+
+        DAC->DATA[0].reg = SPEAKER_SILENCE;
+        fillSilence(0);
+        fillSilence(1);
+        _filled[0] = false;
+        _filled[1] = false;
+    }
+
+    // True once everything pumped has played
+    bool idle()
+    {
+        return !_filled[0] && !_filled[1];
+    }
+
+    uint32_t underruns()
+    {
+        return _underruns;
+    }
+
+private:
+    uint16_t _bufs[2][SPEAKER_BUF_LEN] __attribute__((aligned(4)));
+    volatile bool _filled[2];
+    volatile uint8_t _dma_index;
+    volatile bool _ending;
+    volatile uint32_t _underruns;
+
+    // Templates for the channel's first descriptor, starting on either
+    // buffer. Each links to the ring descriptor for the other buffer.
+    dmacdescriptor _descriptors[2] __attribute__((aligned(16)));
+    dmacdescriptor _ring_descriptors[2] __attribute__((aligned(16)));
+
+    void fillSilence(uint8_t index)
+    {
+        for (size_t i = 0; i < SPEAKER_BUF_LEN; i++)
+        {
+            _bufs[index][i] = SPEAKER_SILENCE;
+        }
+    }
+
+    void configureDmaDac()
+    {
+        Dmac::init();
+
+        DMAC->Channel[2].CHCTRLA.reg = DMAC_CHCTRLA_TRIGSRC(TC4_DMAC_ID_OVF) |
+                                       DMAC_CHCTRLA_TRIGACT_BURST;
+
+        // The ring descriptors loop between the buffers, whichever one the
+        // channel started on
+        for (uint8_t i = 0; i < 2; i++)
+        {
+            dmacdescriptor descriptor;
+            descriptor.srcaddr = (uintptr_t)_bufs[i] + sizeof(uint16_t) * SPEAKER_BUF_LEN;
+            descriptor.dstaddr = (uintptr_t)&DAC->DATA[0].reg;
+            descriptor.btcnt = SPEAKER_BUF_LEN;
+            descriptor.btctrl = DMAC_BTCTRL_BEATSIZE_HWORD |
+                                DMAC_BTCTRL_SRCINC |
+                                DMAC_BTCTRL_VALID |
+                                DMAC_BTCTRL_BLOCKACT_INT;
+            descriptor.descaddr = (uintptr_t)&_ring_descriptors[i ^ 1];
+
+            memcpy(&_descriptors[i], &descriptor, sizeof(descriptor));
+            memcpy(&_ring_descriptors[i], &descriptor, sizeof(descriptor));
+        }
+
+        // Below the mic, which must never miss a block
+        NVIC_SetPriority(DMAC_2_IRQn, 1);
+        NVIC_EnableIRQ(DMAC_2_IRQn);
+        DMAC->Channel[2].CHINTENSET.reg = DMAC_CHINTENSET_TCMPL;
+
+        GCLK->PCHCTRL[TC4_GCLK_ID].reg = GCLK_PCHCTRL_CHEN | GCLK_PCHCTRL_GEN_GCLK1;
+        TC4->COUNT16.WAVE.reg = TC_WAVE_WAVEGEN_MFRQ;
+    }
+};
@@ -0,0 +1,284 @@
+#pragma once
+
+#include <Arduino.h>
+#include <Seeed_FS.h>
+#include <SD/Seeed_SD.h>
+
+#include "config.h"
+#include "hash.h"
+
+#define SPEECH_CACHE_DIR "/TTS"
+#define SPEECH_CACHE_INDEX SPEECH_CACHE_DIR "/INDEX.BIN"
+#define SPEECH_CACHE_PARTIAL SPEECH_CACHE_DIR "/PARTIAL.WAV"
+#define SPEECH_CACHE_MAGIC 0x53535454 // "TTSS"
+
+struct SpeechCacheEntry
+{
+    uint32_t key;
+    uint32_t size;
+    uint32_t used; // 0 for an empty slot
+};
+
+// Synthesized speech kept on the SD card, one WAV file per phrase named
+// after a hash of the text, voice and language. An index of the files is
+// kept in RAM so checking for a phrase never touches the card. It is saved
+// to the card whenever a phrase is added, and hits, which only move a
+// phrase up the recently used order, are saved by update() at most every
+// SPEECH_CACHE_SAVE_MS. Once the files pass SPEECH_CACHE_MAX_BYTES the
+// least recently used ones are deleted.
+class SpeechCache
+{
+public:
+    bool init()
+    {
+        memset(_entries, 0, sizeof(_entries));
+        _clock = 0;
+        _hits = 0;
+        _misses = 0;
+        _bytesSaved = 0;
+        _dirty = false;
+
+        _ready = SD.begin(SDCARD_SS_PIN, SDCARD_SPI);
+        if (!_ready)
+        {
+            Serial.println("No SD card, speech won't be cached");
+            return false;
+        }
+
+        if (!SD.exists(SPEECH_CACHE_DIR))
+        {
+            SD.mkdir(SPEECH_CACHE_DIR);
+        }
+
+        loadIndex();
+        return true;
+    }
+
+    bool ready()
+    {
+        return _ready;
+    }
+
+    static uint32_t key(const String &text, const String &voice, const String &language)
+    {
+        // FNV-1a, with the zero terminators keeping the fields apart
+        uint32_t hash = FNV1A_INIT;
+        hash = fnv1aUpdate(hash, text.c_str(), text.length() + 1);
+        hash = fnv1aUpdate(hash, voice.c_str(), voice.length() + 1);
+        return fnv1aUpdate(hash, language.c_str(), language.length() + 1);
+    }
+
+    // File holding the phrase with this key
+    static String path(uint32_t key)
+    {
+        char name[32];
+        sprintf(name, SPEECH_CACHE_DIR "/%08lX.WAV", (unsigned long)key);
+        return String(name);
+    }
+
+    // Checks the index for a phrase, counting the hit or miss
+    bool find(uint32_t key)
+    {
+        SpeechCacheEntry *entry = _ready ? lookup(key) : NULL;
+        if (entry == NULL)
+        {
+            _misses++;
+            return false;
+        }
+
+        _hits++;
+        _bytesSaved += entry->size;
+        entry->used = ++_clock;
+        if (!_dirty)
+        {
+            _dirty = true;
+            _dirtySince = millis();
+        }
+        return true;
+    }
+
+    // Saves the use order hits have changed once it has waited
+    // SPEECH_CACHE_SAVE_MS. Call from loop() while nothing is being recorded.
+    void update()
+    {
+        if (_dirty && millis() - _dirtySince >= SPEECH_CACHE_SAVE_MS)
+        {
+            saveIndex();
+        }
+    }
+
+    // Where to download a phrase to, before it is known to be complete
+    const char *partialPath()
+    {
+        return SPEECH_CACHE_PARTIAL;
+    }
+
+    // Moves a completed download into the cache, making room for it
+    bool store(uint32_t key, uint32_t size)
+    {
+        if (!_ready)
+        {
+            return false;
+        }
+
+        String file = path(key);
+        SD.remove(file.c_str());
+        if (!SD.rename(SPEECH_CACHE_PARTIAL, file.c_str()))
+        {
+            return false;
+        }
+
+        SpeechCacheEntry *entry = lookup(key);
+        if (entry == NULL)
+        {
+            entry = leastRecentlyUsed();
+            if (entry->used != 0)
+            {
+                evict(*entry);
+            }
+        }
+
+        entry->key = key;
+        entry->size = size;
+        entry->used = ++_clock;
+
+        while (totalSize() > SPEECH_CACHE_MAX_BYTES)
+        {
+            SpeechCacheEntry *oldest = leastRecentlyUsed(entry);
+            if (oldest == NULL)
+            {
+                break;
+            }
+            evict(*oldest);
+        }
+
+        saveIndex();
+        return true;
+    }
+
+    void printStats()
+    {
+        uint32_t lookups = _hits + _misses;
+
+        Serial.print("Speech cache: ");
+        Serial.print(_hits);
+        Serial.print(" of ");
+        Serial.print(lookups);
+        Serial.print(" phrases hit (");
+        Serial.print(lookups == 0 ? 0 : _hits * 100 / lookups);
+        Serial.print("%), ");
+        Serial.print(_bytesSaved / 1024);
+        Serial.println(" KB not downloaded");
+    }
+
+private:
+    bool _ready;
+    SpeechCacheEntry _entries[SPEECH_CACHE_MAX_FILES];
+    uint32_t _clock;
+
+    uint32_t _hits;
+    uint32_t _misses;
+    uint32_t _bytesSaved;
+
+    bool _dirty; // Hits since the index was last saved
+    unsigned long _dirtySince;
+
+    SpeechCacheEntry *lookup(uint32_t key)
+    {
+        for (size_t i = 0; i < SPEECH_CACHE_MAX_FILES; i++)
+        {
+            if (_entries[i].used != 0 && _entries[i].key == key)
+            {
+                return &_entries[i];
+            }
+        }
+
+        return NULL;
+    }
+
+    // The slot to reuse next, empty ones first. With except set, only
+    // occupied slots other than except count, and NULL means there are none.
+    SpeechCacheEntry *leastRecentlyUsed(SpeechCacheEntry *except = NULL)
+    {
+        SpeechCacheEntry *oldest = NULL;
+        for (size_t i = 0; i < SPEECH_CACHE_MAX_FILES; i++)
+        {
+            SpeechCacheEntry *entry = &_entries[i];
+            if (except != NULL && (entry == except || entry->used == 0))
+            {
+                continue;
+            }
+
+            if (oldest == NULL || entry->used < oldest->used)
+            {
+                oldest = entry;
+            }
+        }
+
+        return oldest;
+    }
+
+    void evict(SpeechCacheEntry &entry)
+    {
+        SD.remove(path(entry.key).c_str());
+        memset(&entry, 0, sizeof(entry));
+    }
+
+    uint32_t totalSize()
+    {
+        uint32_t total = 0;
+        for (size_t i = 0; i < SPEECH_CACHE_MAX_FILES; i++)
+        {
+            total += _entries[i].size;
+        }
+
+        return total;
+    }
+
+    // Entries whose file has gone missing are dropped
+    void loadIndex()
+    {
+        File index = SD.open(SPEECH_CACHE_INDEX, FILE_READ);
+        if (!index)
+        {
+            return;
+        }
+
+        uint32_t magic = 0;
+        index.read((uint8_t *)&magic, sizeof(magic));
+        if (magic == SPEECH_CACHE_MAGIC)
+        {
+            index.read((uint8_t *)_entries, sizeof(_entries));
+        }
+        index.close();
+
+        for (size_t i = 0; i < SPEECH_CACHE_MAX_FILES; i++)
+        {
+            SpeechCacheEntry &entry = _entries[i];
+            if (entry.used != 0 && !SD.exists(path(entry.key).c_str()))
+            {
+                memset(&entry, 0, sizeof(entry));
+            }
+            _clock = max(_clock, entry.used);
+        }
+    }
+
+    void saveIndex()
+    {
+        _dirty = false;
+
+        File index = SD.open(SPEECH_CACHE_INDEX, FILE_WRITE);
+        if (!index)
+        {
+            return;
+        }
+
+        uint32_t magic = SPEECH_CACHE_MAGIC;
+        index.write((uint8_t *)&magic, sizeof(magic));
+        index.write((uint8_t *)_entries, sizeof(_entries));
+        index.close();
+    }
+};
+
+// Global instance
+SpeechCache speechCache;
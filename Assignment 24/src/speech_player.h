@@ -0,0 +1,300 @@
+#pragma once
+
+#include <Arduino.h>
+#include <Seeed_FS.h>
+
+#include "bulk_stream.h"
+#include "config.h"
+#include "jitter_buffer.h"
+#include "speaker.h"
+
+enum SpeechPlayerState
+{
+    PLAYER_IDLE,
+    PLAYER_READING_HEADER,
+    PLAYER_BUFFERING,
+    PLAYER_PLAYING
+};
+
+// Called once playback has finished. complete is false if the speech
+// stopped arriving part way, or wasn't a WAV file that could be played.
+typedef void (*PlaybackCallback)(bool complete, void *context);
+
+// Plays a 16-bit mono PCM WAV file while it is still arriving. Samples
+// collect in a jitter buffer until PLAYBACK_START_MS worth have arrived,
+// then the speaker starts and the rest is played as it comes in. Runs as
+// a state machine moved on by poll(), so loop() carries on meanwhile.
+class SpeechPlayer
+{
+public:
+    SpeechPlayer()
+    {
+        _state = PLAYER_IDLE;
+        _callback = NULL;
+        _context = NULL;
+    }
+
+    void init()
+    {
+        _speaker.init();
+    }
+
+    void dmaHandler()
+    {
+        _speaker.dmaHandler();
+    }
+
+    // Starts playing the WAV file read from source, also writing every
+    // byte read to copy if it isn't NULL. spill is a file the jitter
+    // buffer can overflow to, or NULL. requested is when the speech was
+    // asked for, to time the first audio from. source, copy and spill have
+    // to stay open until callback is called. Returns false if something
+    // is already playing.
+    bool start(BulkStream &source, Print *copy, File *spill, unsigned long requested,
+               PlaybackCallback callback = NULL, void *context = NULL)
+    {
+        if (busy())
+        {
+            return false;
+        }
+
+        _source = &source;
+        _copy = copy;
+        _spill = spill;
+        _requested = requested;
+        _callback = callback;
+        _context = context;
+
+        _lastData = millis();
+        _received = false;
+        _stalled = false;
+        _hasOddByte = false;
+        _oddByte = 0;
+        _state = PLAYER_READING_HEADER;
+        return true;
+    }
+
+    bool busy()
+    {
+        return _state != PLAYER_IDLE;
+    }
+
+    // Call from loop(). Reads at most a speaker buffer's worth and keeps
+    // the speaker fed, calling the callback once everything has played.
+    void poll()
+    {
+        if (_state == PLAYER_IDLE)
+        {
+            return;
+        }
+
+        if (_state == PLAYER_READING_HEADER)
+        {
+            // The header is read in one go once the file starts arriving
+            if (_source->available() <= 0 && millis() - _lastData <= PLAYBACK_STALL_MS)
+            {
+                return;
+            }
+
+            if (!readHeader(_rate, _remaining))
+            {
+                Serial.println("Speech isn't a 16-bit mono PCM WAV file");
+                done(false);
+                return;
+            }
+
+            _jitter.reset(_spill);
+            _startSamples = min((size_t)(_rate * PLAYBACK_START_MS / 1000), (size_t)JITTER_BUFFER_SAMPLES);
+            _lastData = millis();
+            _state = PLAYER_BUFFERING;
+        }
+
+        if (!_received)
+        {
+            receive();
+        }
+
+        if (_state == PLAYER_BUFFERING && (_jitter.available() >= _startSamples || _received))
+        {
+            _speaker.pump(_jitter, _received);
+            if (_speaker.idle())
+            {
+                finish();
+                return;
+            }
+
+            _speaker.start(_rate);
+            _state = PLAYER_PLAYING;
+
+            Serial.print("Time to first audio: ");
+            Serial.print(millis() - _requested);
+            Serial.println(" ms");
+        }
+
+        if (_state == PLAYER_PLAYING)
+        {
+            _speaker.pump(_jitter, _received);
+            if (_received && _jitter.available() == 0 && _speaker.idle())
+            {
+                finish();
+            }
+        }
+    }
+
+private:
+    Speaker _speaker;
+    JitterBuffer _jitter;
+    SpeechPlayerState _state;
+    PlaybackCallback _callback;
+    void *_context;
+
+    BulkStream *_source;
+    Print *_copy;
+    File *_spill;
+    unsigned long _requested;
+
+    uint32_t _rate;
+    uint32_t _remaining;
+    size_t _startSamples;
+    unsigned long _lastData;
+    bool _received;
+    bool _stalled;
+    bool _hasOddByte;
+    uint8_t _oddByte;
+
+    // Moves what has arrived into the jitter buffer, a speaker buffer's
+    // worth at most, and only what it has room for unless it can spill
+    void receive()
+    {
+        size_t room = SPEAKER_BUF_LEN * 2;
+        if (_spill == NULL)
+        {
+            room = min(room, _jitter.space() * 2);
+        }
+        int available = _source->available();
+
+        if (available > 0 && room > 0)
+        {
+            uint8_t bytes[SPEAKER_BUF_LEN * 2 + 2] __attribute__((aligned(4)));
+            size_t offset = _hasOddByte ? 1 : 0;
+            bytes[0] = _oddByte;
+
+            size_t count = _source->readBytes(bytes + offset, min((size_t)available, min(room, (size_t)_remaining)));
+            if (_copy != NULL)
+            {
+                _copy->write(bytes + offset, count);
+            }
+            _remaining -= count;
+            _lastData = millis();
+
+            count += offset;
+            _hasOddByte = count % 2 != 0;
+            _oddByte = _hasOddByte ? bytes[count - 1] : 0;
+            _jitter.write((const int16_t *)bytes, count / 2);
+        }
+        else if (_remaining == 0 || millis() - _lastData > PLAYBACK_STALL_MS)
+        {
+            _stalled = _remaining != 0;
+            _received = true;
+        }
+    }
+
+    void finish()
+    {
+        _speaker.stop();
+
+        Serial.print("Playback underruns: ");
+        Serial.print(_speaker.underruns());
+        Serial.print(", spilled to SD: ");
+        Serial.print(_jitter.spilledBytes() / 1024);
+        Serial.println(" KB");
+
+        if (_stalled)
+        {
+            Serial.println("Speech stopped arriving, played what there was");
+        }
+
+        done(!_stalled);
+    }
+
+    // Idle first, so the callback can start the next file
+    void done(bool complete)
+    {
+        _state = PLAYER_IDLE;
+        if (_callback != NULL)
+        {
+            _callback(complete, _context);
+        }
+    }
+
+    // Reads up to the start of the samples, skipping any chunks other
+    // than fmt and data
+    bool readHeader(uint32_t &rate, uint32_t &length)
+    {
+        uint8_t riff[12];
+        if (!readExactly(riff, sizeof(riff)) || memcmp(riff, "RIFF", 4) != 0 || memcmp(riff + 8, "WAVE", 4) != 0)
+        {
+            return false;
+        }
+
+        bool format = false;
+        while (true)
+        {
+            uint8_t chunk[8];
+            if (!readExactly(chunk, sizeof(chunk)))
+            {
+                return false;
+            }
+
+            uint32_t size = chunk[4] | (chunk[5] << 8) | (chunk[6] << 16) | ((uint32_t)chunk[7] << 24);
+
+            if (memcmp(chunk, "data", 4) == 0)
+            {
+                // Streamed WAV files may not know their length up front
+                length = (size == 0) ? 0xFFFFFFFF : size;
+                return format;
+            }
+
+            if (memcmp(chunk, "fmt ", 4) == 0 && size >= 16)
+            {
+                uint8_t fmt[16];
+                if (!readExactly(fmt, sizeof(fmt)))
+                {
+                    return false;
+                }
+                size -= sizeof(fmt);
+
+                uint16_t audioFormat = fmt[0] | (fmt[1] << 8);
+                uint16_t channels = fmt[2] | (fmt[3] << 8);
+                uint16_t bits = fmt[14] | (fmt[15] << 8);
+                rate = fmt[4] | (fmt[5] << 8) | (fmt[6] << 16) | ((uint32_t)fmt[7] << 24);
+
+                format = audioFormat == 1 && channels == 1 && bits == 16 && rate > 0;
+            }
+
+            // Chunks are padded to an even length
+            for (uint32_t i = 0; i < size + (size & 1); i++)
+            {
+                uint8_t skipped;
+                if (!readExactly(&skipped, 1))
+                {
+                    return false;
+                }
+            }
+        }
+    }
+
+    bool readExactly(uint8_t *buf, size_t len)
+    {
+        size_t count = _source->readBytes(buf, len);
+        if (_copy != NULL)
+        {
+            _copy->write(buf, count);
+        }
+
+        return count == len;
+    }
+};
+
+// Global instance
+SpeechPlayer speechPlayer;
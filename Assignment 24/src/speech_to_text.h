@@ -3,92 +3,395 @@
 #include <Arduino.h>
 #include <ArduinoJson.h>
 #include <HTTPClient.h>
-#include <WiFiClientSecure.h>
+#include <sfud.h>
 
+#include "async_http.h"
 #include "flash_stream.h"
+#include "codec.h"
 #include "config.h"
+#include "json_response.h"
+#include "keep_alive_client.h"
 #include "mic.h"
+#include "token_manager.h"
+#include "url.h"
+
+// The short audio REST API takes PCM WAV or Ogg Opus, nothing AudioEncoder
+// can make smaller
+static_assert(AUDIO_CODEC == CODEC_PCM, "The speech service only accepts PCM, set AUDIO_CODEC to CODEC_PCM");
+
+// Called with the recognised text, empty if nothing was recognised. Check
+// shouldRetry() to tell a failure that is worth trying again.
+typedef void (*RecognitionCallback)(const String &text, void *context);
 
 class SpeechToText {
 public:
+    SpeechToText() : _speech("Speech") {
+        _recognizing = false;
+        _pending_attempt = false;
+        _callback = NULL;
+    }
+
     void init() {
-        _speech_client.setCACert(SPEECH_CERTIFICATE);
-        _token_client.setCACert(TOKEN_CERTIFICATE);
-        _access_token = getAccessToken();
+        _speech.setCACert(SPEECH_CERTIFICATE);
+        _tokens.init();
     }
 
-    String convertSpeechToText() {
+    // Refreshes the access token ahead of its expiry. Call from loop()
+    // while nothing is being recorded.
+    void updateToken() {
+        _tokens.update();
+    }
+
+    // Starts any upload that was waiting for a token or for a retry. Call
+    // from loop() while nothing is being recorded, connecting blocks.
+    void poll() {
+        if (_pending_attempt && !_tokens.refreshing()) {
+            _pending_attempt = false;
+            startAttempt();
+        }
+    }
+
+    // True from the start of a recognition until its callback
+    bool busy() {
+        return _recognizing;
+    }
+
+    // Starts uploading the recording from data when it is in SRAM,
+    // otherwise reading it back from flash at address. callback gets the
+    // text. Returns false if a recognition is already under way.
+    bool convertSpeechToText(size_t length, const byte *data, size_t address,
+                             RecognitionCallback callback, void *context) {
+        if (busy()) {
+            return false;
+        }
+
+        startRecognition(length, data, address, callback, context);
+        Serial.println("Sending speech...");
+        startAttempt();
+        return true;
+    }
+
+    // Opens the recognition request with a chunked body so audio can be
+    // uploaded while it is still being recorded.
+    bool beginStreaming(const byte *data = NULL, size_t address = 0) {
         char url[128];
         sprintf(url, SPEECH_URL, SPEECH_LOCATION, LANGUAGE);
 
-        HTTPClient httpClient;
-        httpClient.begin(_speech_client, url);
-        httpClient.addHeader("Authorization", String("Bearer ") + _access_token);
-        httpClient.addHeader("Content-Type", "audio/wav; codecs=audio/pcm; samplerate=" + String(RATE));
-        httpClient.addHeader("Accept", "application/json;text/xml");
+        Url parts;
+        parseUrl(url, parts);
 
-        Serial.println("Sending speech...");
+        // Fetch a token now if it is due, it can't be done mid-recording
+        if (!_tokens.ensureValid()) {
+            Serial.println("No access token, will upload after recording");
+            return false;
+        }
+
+        if (!_speech.connect(parts.host, parts.port)) {
+            Serial.println("Failed to connect to speech service, will upload after recording");
+            return false;
+        }
+
+        _speech.client().print(String("POST ") + parts.path + " HTTP/1.1\r\n" +
+                             "Host: " + parts.host + "\r\n" +
+                             "Authorization: Bearer " + _tokens.token() + "\r\n" +
+                             "Content-Type: " + AudioEncoder::contentType() + String(RATE) + "\r\n" +
+                             "Accept: application/json;text/xml\r\n" +
+                             "Transfer-Encoding: chunked\r\n" +
+                             "Connection: keep-alive\r\n\r\n");
+
+        _flash = sfud_get_device_table() + 0;
+        _stream_data = data;
+        _stream_address = address;
+        _streaming = true;
+        _stream_failed = false;
+        _stream_sent = 0;
+
+        return true;
+    }
+
+    bool isStreaming() {
+        return _streaming;
+    }
+
+    // Sends the next full chunk of audio that has reached flash. Call from
+    // loop() with the number of bytes recorded so far.
+    void streamRecording(size_t recorded) {
+        if (_streaming && !_stream_failed && recorded - _stream_sent >= HTTP_TCP_BUFFER_SIZE) {
+            sendChunk(HTTP_TCP_BUFFER_SIZE);
+        }
+    }
+
+    // Sends whatever is left of the recording and ends the body, then
+    // waits for the recognition result, which goes to callback. Falls back
+    // to a normal upload if the stream broke.
+    void finishStreaming(size_t length, RecognitionCallback callback, void *context) {
+        size_t sent_while_recording = _stream_sent;
+
+        while (!_stream_failed && _stream_sent < length) {
+            sendChunk(min((size_t)HTTP_TCP_BUFFER_SIZE, length - _stream_sent));
+        }
+
+        _streaming = false;
+        startRecognition(length, _stream_data, _stream_address, callback, context);
+
+        if (_stream_failed || _speech.client().print("0\r\n\r\n") == 0) {
+            Serial.println("Speech stream failed, uploading the recording instead...");
+            _speech.close();
+            startAttempt();
+            return;
+        }
+
+        Serial.print("Speech sent! ");
+        Serial.print(sent_while_recording);
+        Serial.print(" of ");
+        Serial.print(length);
+        Serial.println(" bytes were uploaded while recording");
+
+        if (!_request.beginResponse(_speech.client())) {
+            requestNotStarted();
+            return;
+        }
+
+        _request.setReuse(true);
+        _request.onComplete(streamResponseReceived, this);
+
+        if (!asyncHttp.start(_request)) {
+            requestNotStarted();
+        }
+    }
+
+    // Half a request body can't be followed by another request, so the
+    // connection has to go
+    void cancelStreaming() {
+        _speech.close();
+        _streaming = false;
+    }
+
+    // HTTP status of the last recognition request, negative if it never
+    // reached the server
+    int lastResponseCode() {
+        return _last_response_code;
+    }
+
+    // True when the last recognition failed in a way that trying again
+    // later could fix: a network error, no valid token, a timeout, being
+    // throttled or a server error
+    bool shouldRetry() {
+        return _last_response_code < 0 || _last_response_code == 401 || _last_response_code == 408 ||
+               _last_response_code == 429 || _last_response_code >= 500;
+    }
+
+    String AccessToken() {
+        return _tokens.token();
+    }
+
+private:
+    KeepAliveClient _speech;
+    AsyncHttpRequest _request;
+    TokenManager _tokens;
+    int _last_response_code;
+
+    bool _recognizing;
+    bool _pending_attempt;
+    int _attempt;
+    RecognitionCallback _callback;
+    void *_context;
+    size_t _upload_length;
+    const byte *_upload_data;
+    size_t _upload_address;
+    BufferStream _upload_memory;
+    FlashStream _upload_flash;
+
+    const sfud_flash *_flash;
+    const byte *_stream_data;
+    size_t _stream_address;
+    bool _streaming = false;
+    bool _stream_failed;
+    size_t _stream_sent;
+    byte _stream_buffer[HTTP_TCP_BUFFER_SIZE];
+
+    void startRecognition(size_t length, const byte *data, size_t address,
+                          RecognitionCallback callback, void *context) {
+        _recognizing = true;
+        _attempt = 0;
+        _callback = callback;
+        _context = context;
+        _upload_length = length;
+        _upload_data = data;
+        _upload_address = address;
+    }
+
+    // Starts the next try at uploading. Without a usable token it waits
+    // for poll() to find one has been fetched, giving up if that fails.
+    void startAttempt() {
+        if (!_tokens.ensureValid()) {
+            if (_tokens.refreshing()) {
+                _pending_attempt = true;
+            } else {
+                finishRecognition(HTTPC_ERROR_CONNECTION_REFUSED, "");
+            }
+            return;
+        }
+
+        _attempt++;
+
+        char url[128];
+        sprintf(url, SPEECH_URL, SPEECH_LOCATION, LANGUAGE);
+
+        Url parts;
+        parseUrl(url, parts);
+
+        // Connect here rather than leaving it to the request so the
+        // handshake can be timed, the request then uses the open connection
+        if (!_speech.connect(parts.host, parts.port)) {
+            _speech.printStats();
+            finishRecognition(HTTPC_ERROR_CONNECTION_REFUSED, "");
+            return;
+        }
+
+        if (!_request.begin(_speech.client(), url)) {
+            requestNotStarted();
+            return;
+        }
+
+        _request.setReuse(true);
+        _request.addHeader("Authorization", String("Bearer ") + _tokens.token());
+        _request.addHeader("Content-Type", AudioEncoder::contentType() + String(RATE));
+        _request.addHeader("Accept", "application/json;text/xml");
+
+        if (_upload_data != NULL) {
+            _upload_memory = BufferStream(_upload_data, _upload_length);
+            _request.setBody(_upload_memory, _upload_length);
+        } else {
+            _upload_flash = FlashStream(_upload_length, _upload_address);
+            _request.setBody(_upload_flash, _upload_length);
+        }
+
+        _request.onComplete(responseReceived, this);
+
+        if (!asyncHttp.start(_request)) {
+            requestNotStarted();
+        }
+    }
 
-        FlashStream stream;
-        int httpResponseCode = httpClient.sendRequest("POST", &stream, BUFFER_SIZE);
+    // The request couldn't be handed to asyncHttp, so there is nothing to
+    // wait for. Ends the recognition as a failure worth retrying.
+    void requestNotStarted() {
+        Serial.println("Couldn't start the speech request");
+        _speech.close();
+        finishRecognition(HTTPC_ERROR_TOO_LESS_RAM, "");
+    }
+
+    // Keeps the connection for next time if the server will have it
+    void releaseConnection(AsyncHttpRequest &request) {
+        if (request.keepAlive()) {
+            _speech.release();
+        } else {
+            _speech.close();
+        }
+    }
+
+    static void responseReceived(AsyncHttpRequest &request, Stream &body, void *context) {
+        SpeechToText *self = (SpeechToText *)context;
+        int httpResponseCode = request.status();
+        self->releaseConnection(request);
+
+        // Retries are left to poll(), which isn't called mid-recording
+        if (self->_attempt < SPEECH_MAX_ATTEMPTS) {
+            // The server may have closed a kept-alive connection without us
+            // noticing, so give it another go on a fresh one
+            if (httpResponseCode < 0 && self->_speech.reused()) {
+                Serial.println("Kept-alive connection was closed, reconnecting...");
+                self->_speech.close();
+                self->_pending_attempt = true;
+                return;
+            }
+
+            if (httpResponseCode == 401) {
+                Serial.println("Access token rejected, trying again with a new token...");
+                self->_tokens.invalidate();
+                self->_pending_attempt = true;
+                return;
+            }
+        }
 
         Serial.println("Speech sent!");
+        self->_speech.printStats();
+        self->readResult(httpResponseCode, body);
+    }
+
+    static void streamResponseReceived(AsyncHttpRequest &request, Stream &body, void *context) {
+        SpeechToText *self = (SpeechToText *)context;
+        int httpResponseCode = request.status();
+        self->releaseConnection(request);
+        self->_speech.printStats();
+
+        if (httpResponseCode == 401) {
+            // The streamed audio is gone with the rejected request, so this
+            // one has to be sent again
+            Serial.println("Access token rejected, uploading the recording again with a new token...");
+            self->_tokens.invalidate();
+            self->_pending_attempt = true;
+            return;
+        }
+
+        self->readResult(httpResponseCode, body);
+    }
+
+    void readResult(int httpResponseCode, Stream &body) {
         String text = "";
 
         if (httpResponseCode == 200) {
-            String result = httpClient.getString();
-            Serial.println(result);
-
-            DynamicJsonDocument doc(1024);
-            deserializeJson(doc, result.c_str());
-
-            JsonObject obj = doc.as<JsonObject>();
-            text = obj["DisplayText"].as<String>();
-        } 
-        else if (httpResponseCode == 401) {
-            Serial.println("Access token expired, trying again with a new token...");
-            _access_token = getAccessToken();
-            return convertSpeechToText();
-        } 
-        else {
+            text = readDisplayText(body);
+        } else {
             Serial.print("Failed to convert speech to text - error ");
             Serial.println(httpResponseCode);
         }
 
-        httpClient.end();
-        return text;
+        finishRecognition(httpResponseCode, text);
     }
 
-    String AccessToken() {
-        return _access_token;
+    void finishRecognition(int httpResponseCode, const String &text) {
+        _last_response_code = httpResponseCode;
+        _recognizing = false;
+
+        // The callback may start the next recognition
+        RecognitionCallback callback = _callback;
+        _callback = NULL;
+        callback(text, _context);
     }
 
-private:
-    WiFiClientSecure _speech_client;
-    WiFiClientSecure _token_client;
-    String _access_token;
+    void sendChunk(size_t len) {
+        const byte *chunk = _stream_buffer;
+        if (_stream_data != NULL) {
+            chunk = _stream_data + _stream_sent;
+        } else {
+            sfud_read(_flash, _stream_address + _stream_sent, len, _stream_buffer);
+        }
 
-    String getAccessToken() {
-        char url[128];
-        sprintf(url, TOKEN_URL, SPEECH_LOCATION);
+        WiFiClientSecure &client = _speech.client();
+        client.print(String(len, HEX) + "\r\n");
+        size_t written = client.write(chunk, len);
+        client.print("\r\n");
 
-        HTTPClient httpClient;
-        httpClient.begin(_token_client, url);
-        httpClient.addHeader("Ocp-Apim-Subscription-Key", SPEECH_API_KEY);
+        if (written != len) {
+            _stream_failed = true;
+            return;
+        }
 
-        int httpResultCode = httpClient.POST("{}");
+        _stream_sent += len;
+    }
 
-        if (httpResultCode != 200) {
-            Serial.println("Error getting access token, trying again...");
-            delay(10000);
-            return getAccessToken();
+    // Pulls the recognised text out of a response body
+    String readDisplayText(Stream &body) {
+        StaticJsonDocument<JSON_RESPONSE_SIZE> doc;
+        if (!parseJsonField(body, "DisplayText", doc)) {
+            return "";
         }
 
-        Serial.println("Got access token.");
-        String result = httpClient.getString();
-        httpClient.end();
-
-        return result;
+        String text = doc["DisplayText"] | "";
+        Serial.println(text);
+        return text;
     }
 };
 
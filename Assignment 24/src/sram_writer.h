@@ -0,0 +1,71 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include "config.h"
+
+// Keeps the recording in a fixed SRAM arena instead of external flash.
+// Same interface as FlashWriter, so Mic can use either.
+class SramWriter
+{
+public:
+void init()
+{
+    reset();
+}
+
+// SRAM has no addresses to choose from, the arena is always used from 0,
+// up to size bytes of it
+void reset(size_t address = 0, size_t size = SRAM_CAPTURE_SIZE)
+{
+    _pos = 0;
+    _capacity = min(size, (size_t)SRAM_CAPTURE_SIZE);
+}
+
+// Nothing to erase in SRAM
+bool eraseAhead(size_t ahead)
+{
+    return false;
+}
+
+size_t capacity()
+{
+    return _capacity;
+}
+
+size_t writtenBytes()
+{
+    return _pos;
+}
+
+const byte *data()
+{
+    return _arena;
+}
+
+void write(byte b)
+{
+    write(&b, 1);
+}
+
+void write(const byte *b, size_t len)
+{
+    len = min(len, _capacity - _pos);
+    memcpy(_arena + _pos, b, len);
+    _pos += len;
+}
+
+void patch(size_t address, const byte *b, size_t len)
+{
+    memcpy(_arena + address, b, len);
+}
+
+void flush()
+{
+}
+
+private:
+byte _arena[SRAM_CAPTURE_SIZE] __attribute__((aligned(4)));
+size_t _pos;
+size_t _capacity;
+};
@@ -2,78 +2,230 @@
 
 #include <Arduino.h>
 #include <ArduinoJson.h>
-#include <HTTPClient.h>
 #include <Seeed_FS.h>
 #include <SD/Seeed_SD.h>
 #include <WiFiClient.h>
 #include <WiFiClientSecure.h>
 
+#include "async_http.h"
 #include "config.h"
+#include "file_stream.h"
+#include "json_response.h"
+#include "speech_cache.h"
+#include "speech_player.h"
 #include "speech_to_text.h"
 
+// Where playback overflows to when speech arrives faster than it plays
+#define SPEECH_SPILL_FILE SPEECH_CACHE_DIR "/SPILL.BIN"
+
+// Called once speech has finished playing, or failed to
+typedef void (*SpeechCallback)(void *context);
+
 class TextToSpeech {
 public:
-void convertTextToSpeech(String text)
-{
-    DynamicJsonDocument doc(1024);
-doc["language"] = LANGUAGE;
-doc["voice"] = _voice;
-doc["text"] = text;
-
-String body;
-serializeJson(doc, body);
-HTTPClient httpClient;
-httpClient.begin(_client, TEXT_TO_SPEECH_FUNCTION_URL);
-
-int httpResponseCode = httpClient.POST(body);
-if (httpResponseCode == 200)
-{            
-    File wav_file = SD.open("SPEECH.WAV", FILE_WRITE);
-    httpClient.writeToStream(&wav_file);
-    wav_file.close();
-}
-else
-{
-    Serial.print("Failed to get speech - error ");
-    Serial.println(httpResponseCode);
-}
-httpClient.end();
-}
-    void init() {
-        // Prepare JSON body
+    TextToSpeech() {
+        _callback = NULL;
+        _context = NULL;
+        _voices_retry = 0;
+    }
+
+    // Synthesizes text and plays it as it downloads, keeping a copy in a
+    // WAV file on the SD card. Phrases said before play from the cache.
+    // Either way speechPlayer.poll() plays it, and callback is called once
+    // it has been said. Returns false if speech is already being fetched
+    // or played, or there is no voice yet, in which case callback isn't
+    // called. Without a voice it asks for one again, at most every
+    // VOICES_RETRY_MS.
+    bool convertTextToSpeech(const String &text, SpeechCallback callback = NULL, void *context = NULL) {
+        if (_request.busy() || speechPlayer.busy()) {
+            return false;
+        }
+
+        // Speech in no particular voice would be cached as if it were one
+        if (_voice.length() == 0) {
+            if ((long)(millis() - _voices_retry) >= 0) {
+                fetchVoices();
+            }
+            return false;
+        }
+
+        unsigned long requested = millis();
+
+        uint32_t key = SpeechCache::key(text, _voice, LANGUAGE);
+        if (speechCache.find(key)) {
+            _speech_file = SpeechCache::path(key);
+            speechCache.printStats();
+
+            _callback = callback;
+            _context = context;
+            _wav_file = SD.open(_speech_file.c_str(), FILE_READ);
+            _cached = FileStream(&_wav_file);
+            speechPlayer.start(_cached, NULL, NULL, requested, cachedPlayed, this);
+            return true;
+        }
+
         DynamicJsonDocument doc(1024);
         doc["language"] = LANGUAGE;
+        doc["voice"] = _voice;
+        doc["text"] = text;
+
         String body;
         serializeJson(doc, body);
 
-        // Make HTTP request to get voice list
-        HTTPClient httpClient;
-        httpClient.begin(_client, GET_VOICES_FUNCTION_URL);
-        int httpResponseCode = httpClient.POST(body);
+        // The audio is played as it is read, so the callback gets it
+        // straight off the connection
+        _request.begin(_client, TEXT_TO_SPEECH_FUNCTION_URL);
+        _request.addHeader("Content-Type", "application/json");
+        _request.setBody(body);
+        _request.setStreamBody(true);
+        _request.onComplete(speechReceived, this);
 
-        if (httpResponseCode == 200) {
-            String result = httpClient.getString();
-            Serial.println(result);
+        if (!asyncHttp.start(_request)) {
+            return false;
+        }
 
-            DynamicJsonDocument responseDoc(1024);
-            deserializeJson(responseDoc, result.c_str());
+        _key = key;
+        _requested = requested;
+        _callback = callback;
+        _context = context;
+        return true;
+    }
 
-            JsonArray voices = responseDoc.as<JsonArray>();
-            _voice = voices[0].as<String>();
+    // The WAV file made by the last call to convertTextToSpeech
+    String speechFile() {
+        return _speech_file;
+    }
 
-            Serial.print("Using voice: ");
-            Serial.println(_voice);
-        } else {
-            Serial.print("Failed to get voices - error ");
-            Serial.println(httpResponseCode);
-        }
+    // Starts fetching the voice to use. Speech waits until it is back.
+    void init() {
+        speechCache.init();
+        speechPlayer.init();
 
-        httpClient.end();
+        _voice = "";
+        fetchVoices();
     }
 
 private:
     WiFiClient _client;
+    AsyncHttpRequest _request;
     String _voice;
+    unsigned long _voices_retry;
+    String _speech_file;
+
+    // What is playing, open until the player is done with it
+    HttpBodyStream _body;
+    FileStream _cached;
+    File _wav_file;
+    File _spill_file;
+
+    uint32_t _key;
+    unsigned long _requested;
+    SpeechCallback _callback;
+    void *_context;
+
+    static void speechReceived(AsyncHttpRequest &request, Stream &body, void *context) {
+        TextToSpeech *self = (TextToSpeech *)context;
+
+        if (request.status() != 200) {
+            Serial.print("Failed to get speech - error ");
+            Serial.println(request.status());
+
+            self->_client.stop();
+            speechCache.printStats();
+            self->finished();
+            return;
+        }
+
+        // The player reads the rest of the body from loop(), so the
+        // connection stays open until it is done
+        self->_body = request.streamedBody();
+
+        // Download next to the cache first so a broken download is never
+        // mistaken for the phrase
+        const char *file_name = speechCache.ready() ? speechCache.partialPath() : "SPEECH.WAV";
+        self->_speech_file = file_name;
+        self->_wav_file = SD.open(file_name, FILE_WRITE);
+        self->_spill_file = speechCache.ready() ? SD.open(SPEECH_SPILL_FILE, FILE_WRITE) : File();
+
+        speechPlayer.start(self->_body, self->_wav_file ? &self->_wav_file : NULL,
+                           self->_spill_file ? &self->_spill_file : NULL, self->_requested,
+                           speechPlayed, self);
+    }
+
+    static void speechPlayed(bool complete, void *context) {
+        TextToSpeech *self = (TextToSpeech *)context;
+
+        uint32_t size = self->_wav_file ? self->_wav_file.size() : 0;
+        self->_wav_file.close();
+        if (self->_spill_file) {
+            self->_spill_file.close();
+            SD.remove(SPEECH_SPILL_FILE);
+        }
+
+        if (complete && size > 0 && speechCache.store(self->_key, size)) {
+            self->_speech_file = SpeechCache::path(self->_key);
+        }
+
+        self->_client.stop();
+        speechCache.printStats();
+        self->finished();
+    }
+
+    static void cachedPlayed(bool complete, void *context) {
+        TextToSpeech *self = (TextToSpeech *)context;
+        self->_wav_file.close();
+        self->finished();
+    }
+
+    void finished() {
+        if (_callback != NULL) {
+            _callback(_context);
+        }
+    }
+
+    void fetchVoices() {
+        // Prepare JSON body
+        DynamicJsonDocument doc(1024);
+        doc["language"] = LANGUAGE;
+        String body;
+        serializeJson(doc, body);
+
+        // The list runs to many KB, more than the request keeps, but only
+        // the first voice is parsed
+        _request.begin(_client, GET_VOICES_FUNCTION_URL);
+        _request.addHeader("Content-Type", "application/json");
+        _request.setBody(body);
+        _request.onComplete(voicesReceived, this);
+        if (!asyncHttp.start(_request)) {
+            voicesFailed();
+        }
+    }
+
+    // Speech waits for the next try
+    void voicesFailed() {
+        _voices_retry = millis() + VOICES_RETRY_MS;
+    }
+
+    static void voicesReceived(AsyncHttpRequest &request, Stream &body, void *context) {
+        TextToSpeech *self = (TextToSpeech *)context;
+
+        if (request.status() != 200) {
+            Serial.print("Failed to get voices - error ");
+            Serial.println(request.status());
+            self->voicesFailed();
+            return;
+        }
+
+        StaticJsonDocument<JSON_RESPONSE_SIZE> responseDoc;
+        if (!parseFirstJsonElement(body, responseDoc) || responseDoc.as<String>().length() == 0) {
+            self->voicesFailed();
+            return;
+        }
+
+        self->_voice = responseDoc.as<String>();
+        Serial.print("Using voice: ");
+        Serial.println(self->_voice);
+    }
 };
 
 // Global instance
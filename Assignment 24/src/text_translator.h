@@ -2,14 +2,34 @@
 
 #include <Arduino.h>
 #include <ArduinoJson.h>
-#include <HTTPClient.h>
 #include <WiFiClient.h>
 
+#include "async_http.h"
 #include "config.h"
+#include "translation_cache.h"
+
+// Called with the translated text, empty if it couldn't be translated
+typedef void (*TranslationCallback)(const String &translated_text, void *context);
 
 class TextTranslator {
 public:
-    String translateText(String text, String from_language, String to_language) {
+    // Translates text and passes the result to callback, straight away if
+    // it is cached. Returns false if a translation is already waiting on
+    // the cloud, in which case callback isn't called.
+    bool translateText(const String &text, const String &from_language, const String &to_language,
+                       TranslationCallback callback, void *context) {
+        uint32_t key = TranslationCache::key(text, from_language, to_language);
+
+        String translated_text;
+        if (translationCache.find(key, translated_text)) {
+            callback(translated_text, context);
+            return true;
+        }
+
+        if (_request.busy()) {
+            return false;
+        }
+
         // Prepare JSON body
         DynamicJsonDocument doc(1024);
         doc["text"] = text;
@@ -19,7 +39,6 @@ public:
         String body;
         serializeJson(doc, body);
 
-        // Debug print
         Serial.print("Translating ");
         Serial.print(text);
         Serial.print(" from ");
@@ -27,28 +46,49 @@ public:
         Serial.print(" to ");
         Serial.println(to_language);
 
-        // HTTP POST
-        HTTPClient httpClient;
-        httpClient.begin(_client, TRANSLATE_FUNCTION_URL);
-        int httpResponseCode = httpClient.POST(body);
+        _request.begin(_client, TRANSLATE_FUNCTION_URL);
+        _request.addHeader("Content-Type", "application/json");
+        _request.setBody(body);
+        _request.onComplete(responseReceived, this);
+
+        if (!asyncHttp.start(_request)) {
+            return false;
+        }
+
+        _key = key;
+        _callback = callback;
+        _context = context;
+        return true;
+    }
+
+private:
+    WiFiClient _client;
+    AsyncHttpRequest _request;
+    uint32_t _key;
+    TranslationCallback _callback;
+    void *_context;
 
-        String translated_text = "";
+    static void responseReceived(AsyncHttpRequest &request, Stream &body, void *context) {
+        TextTranslator *self = (TextTranslator *)context;
+        String translated_text;
 
-        if (httpResponseCode == 200) {
-            translated_text = httpClient.getString();
-            Serial.print("Translated: ");
+        if (request.status() == 200 && request.truncated()) {
+            // Only the start of it was kept, which mustn't be said or cached
+            Serial.println("Failed to translate text - translation too long");
+        } else if (request.status() == 200) {
+            translated_text = body.readString();
+            Serial.print("Translated in ");
+            Serial.print(request.elapsed());
+            Serial.print(" ms: ");
             Serial.println(translated_text);
+            translationCache.store(self->_key, translated_text);
         } else {
             Serial.print("Failed to translate text - error ");
-            Serial.println(httpResponseCode);
+            Serial.println(request.status());
         }
 
-        httpClient.end();
-        return translated_text;
+        self->_callback(translated_text, self->_context);
     }
-
-private:
-    WiFiClient _client;
 };
 
 // Global instance
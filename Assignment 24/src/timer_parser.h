@@ -0,0 +1,306 @@
+#pragma once
+
+#include <Arduino.h>
+
+#define TIMER_PARSER_MAX_TOKENS 32
+#define TIMER_PARSER_TOKEN_LEN 16
+
+struct TimerDuration
+{
+    int seconds;
+    bool confident; // False when the cloud should have a go instead
+};
+
+// Turns the common English ways of asking for a timer into a number of
+// seconds on the device: "set a 2 minute 30 second timer", "five minutes",
+// "an hour and a half", "two and a half minutes", "half a minute",
+// "a quarter of an hour", "1.5 hours", "90s". Numbers can be digits or
+// words up to the hundreds. It is only confident when the request sets or
+// starts a timer and says nothing else: with no such verb, or any word that
+// cancels, stops or asks about a timer, the cloud has a go. So does anything
+// it can't account for, such as a number with no unit, a unit with no number
+// or the same unit twice.
+class TimerParser
+{
+public:
+    static TimerDuration parse(const char *text)
+    {
+        TimerDuration result = {0, false};
+
+        char tokens[TIMER_PARSER_MAX_TOKENS][TIMER_PARSER_TOKEN_LEN];
+        size_t count = tokenize(text, tokens);
+        if (count == TIMER_PARSER_MAX_TOKENS)
+        {
+            return result;
+        }
+
+        float total = 0;
+        float number = 0;
+        bool hasNumber = false;
+        bool inNumberWords = false; // Still adding up "twenty five"
+        int lastUnit = 0;
+        int usedUnits = 0;
+        bool setsTimer = false;
+        bool problem = false;
+
+        for (size_t i = 0; i < count; i++)
+        {
+            const char *token = tokens[i];
+            const char *next = (i + 1 < count) ? tokens[i + 1] : "";
+            bool afterAnd = i > 0 && strcmp(tokens[i - 1], "and") == 0;
+            bool afterAndA = i > 1 && strcmp(tokens[i - 2], "and") == 0 && isArticle(tokens[i - 1]);
+
+            float value;
+            int unit;
+
+            if (isDigits(token, value))
+            {
+                problem |= hasNumber;
+                number = value;
+                hasNumber = true;
+                inNumberWords = false;
+            }
+            else if (numberWord(token, value))
+            {
+                if (hasNumber && !inNumberWords)
+                {
+                    problem = true;
+                }
+
+                if (value == 100)
+                {
+                    number = (inNumberWords ? max(number, 1.0f) : 1.0f) * 100;
+                }
+                else
+                {
+                    number = (inNumberWords ? number : 0) + value;
+                }
+                hasNumber = true;
+                inNumberWords = true;
+            }
+            else if (strcmp(token, "half") == 0)
+            {
+                if (afterAnd || afterAndA)
+                {
+                    // "two and a half minutes" or "two minutes and a half"
+                    if (hasNumber)
+                    {
+                        number += 0.5f;
+                    }
+                    else if (lastUnit != 0)
+                    {
+                        total += 0.5f * lastUnit;
+                    }
+                    else
+                    {
+                        problem = true;
+                    }
+                }
+                else
+                {
+                    // "half an hour"
+                    problem |= hasNumber;
+                    number = 0.5f;
+                    hasNumber = true;
+                }
+                inNumberWords = false;
+            }
+            else if (strcmp(token, "quarter") == 0 || strcmp(token, "quarters") == 0)
+            {
+                // "a quarter of an hour", "three quarters of an hour"
+                number = (hasNumber ? number : 1) * 0.25f;
+                hasNumber = true;
+                inNumberWords = false;
+            }
+            else if (isArticle(token))
+            {
+                // "a minute" is one minute, but not "a half" or "a 5 minute timer"
+                if (!hasNumber && unitSeconds(next) != 0)
+                {
+                    number = 1;
+                    hasNumber = true;
+                }
+            }
+            else if ((unit = unitSeconds(token)) != 0)
+            {
+                int flag = unit == 3600 ? 4 : unit == 60 ? 2 : 1;
+                if (!hasNumber || (usedUnits & flag) != 0)
+                {
+                    problem = true;
+                }
+
+                total += number * unit;
+                usedUnits |= flag;
+                lastUnit = unit;
+                number = 0;
+                hasNumber = false;
+                inNumberWords = false;
+            }
+            else if (strcmp(token, "and") == 0 || strcmp(token, "of") == 0)
+            {
+                inNumberWords = inNumberWords && strcmp(token, "and") == 0 && numberWord(next, value);
+            }
+            else
+            {
+                // Any other word can't come between a number and its unit
+                problem |= hasNumber;
+                inNumberWords = false;
+
+                setsTimer |= isSetVerb(token);
+                problem |= isOtherRequest(token);
+            }
+        }
+
+        problem |= hasNumber;
+
+        result.seconds = (int)(total + 0.5f);
+        result.confident = !problem && setsTimer && result.seconds > 0;
+        return result;
+    }
+
+private:
+    static bool isSetVerb(const char *token)
+    {
+        static const char *const verbs[] = {"set", "start", "make", "create", "begin"};
+
+        for (size_t i = 0; i < sizeof(verbs) / sizeof(verbs[0]); i++)
+        {
+            if (strcmp(token, verbs[i]) == 0)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Words for cancelling, stopping, changing or asking about a timer, and
+    // negations, none of which a new timer from the duration would answer
+    static bool isOtherRequest(const char *token)
+    {
+        static const char *const words[] = {
+            "cancel", "stop", "delete", "remove", "clear", "end", "pause", "resume", "reset",
+            "add", "extend", "change", "how", "what", "when", "left", "remaining",
+            "not", "don", "dont", "never"};
+
+        for (size_t i = 0; i < sizeof(words) / sizeof(words[0]); i++)
+        {
+            if (strcmp(token, words[i]) == 0)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Lower case words and numbers, splitting "5min" into "5" and "min"
+    static size_t tokenize(const char *text, char tokens[][TIMER_PARSER_TOKEN_LEN])
+    {
+        size_t count = 0;
+        size_t len = 0;
+        int kind = 0; // 0 between tokens, 1 in a word, 2 in a number
+
+        for (const char *c = text;; c++)
+        {
+            int next = isalpha(*c) ? 1 : (isdigit(*c) || (*c == '.' && kind == 2 && isdigit(c[1]))) ? 2 : 0;
+
+            if (next != kind && kind != 0)
+            {
+                tokens[count][len] = 0;
+                if (++count == TIMER_PARSER_MAX_TOKENS)
+                {
+                    return count;
+                }
+                len = 0;
+            }
+
+            if (*c == 0)
+            {
+                return count;
+            }
+
+            if (next != 0 && len < TIMER_PARSER_TOKEN_LEN - 1)
+            {
+                tokens[count][len++] = tolower(*c);
+            }
+            kind = next;
+        }
+    }
+
+    static bool isDigits(const char *token, float &value)
+    {
+        if (!isdigit(token[0]))
+        {
+            return false;
+        }
+
+        value = atof(token);
+        return true;
+    }
+
+    static bool isArticle(const char *token)
+    {
+        return strcmp(token, "a") == 0 || strcmp(token, "an") == 0;
+    }
+
+    static bool numberWord(const char *token, float &value)
+    {
+        static const char *const words[] = {
+            "zero", "one", "two", "three", "four", "five", "six", "seven", "eight", "nine",
+            "ten", "eleven", "twelve", "thirteen", "fourteen", "fifteen", "sixteen",
+            "seventeen", "eighteen", "nineteen"};
+        static const char *const tens[] = {
+            "twenty", "thirty", "forty", "fifty", "sixty", "seventy", "eighty", "ninety"};
+
+        for (size_t i = 0; i < sizeof(words) / sizeof(words[0]); i++)
+        {
+            if (strcmp(token, words[i]) == 0)
+            {
+                value = i;
+                return true;
+            }
+        }
+
+        for (size_t i = 0; i < sizeof(tens) / sizeof(tens[0]); i++)
+        {
+            if (strcmp(token, tens[i]) == 0)
+            {
+                value = (i + 2) * 10;
+                return true;
+            }
+        }
+
+        if (strcmp(token, "hundred") == 0)
+        {
+            value = 100;
+            return true;
+        }
+
+        return false;
+    }
+
+    // Seconds in a unit, 0 if token isn't one
+    static int unitSeconds(const char *token)
+    {
+        static const char *const hours[] = {"hour", "hours", "hr", "hrs", "h"};
+        static const char *const minutes[] = {"minute", "minutes", "min", "mins", "m"};
+        static const char *const seconds[] = {"second", "seconds", "sec", "secs", "s"};
+
+        for (size_t i = 0; i < 5; i++)
+        {
+            if (strcmp(token, hours[i]) == 0)
+            {
+                return 3600;
+            }
+            if (strcmp(token, minutes[i]) == 0)
+            {
+                return 60;
+            }
+            if (strcmp(token, seconds[i]) == 0)
+            {
+                return 1;
+            }
+        }
+
+        return 0;
+    }
+};
@@ -0,0 +1,132 @@
+#pragma once
+
+#include <Arduino.h>
+#include <HTTPClient.h>
+
+#include "async_http.h"
+#include "config.h"
+#include "keep_alive_client.h"
+#include "url.h"
+
+// Keeps a speech service access token fresh. Tokens last 10 minutes, so
+// this fetches a new one TOKEN_REFRESH_MARGIN_MS before that from loop()
+// rather than waiting for a request to be turned away with a 401.
+class TokenManager {
+public:
+    TokenManager() : _connection("Token") {
+        _issued = 0;
+        _next_attempt = 0;
+        _valid = false;
+    }
+
+    void init() {
+        _connection.setCACert(TOKEN_CERTIFICATE);
+        refresh();
+    }
+
+    // Starts fetching a new token if this one is close to expiring. Call
+    // from loop() while nothing is being recorded, connecting blocks.
+    void update() {
+        if (needsRefresh() && !refreshing() && (long)(millis() - _next_attempt) >= 0) {
+            refresh();
+        }
+    }
+
+    // For use just before a request. Returns true if the token can be used
+    // now. If not, a new one may be on its way, see refreshing().
+    bool ensureValid() {
+        update();
+        return valid();
+    }
+
+    bool valid() {
+        return _valid && millis() - _issued < TOKEN_LIFETIME_MS;
+    }
+
+    // True while a new token is being fetched
+    bool refreshing() {
+        return _request.busy();
+    }
+
+    // Drops the token after the server rejected it
+    void invalidate() {
+        _valid = false;
+        _next_attempt = millis();
+    }
+
+    // Starts a single attempt at a new token. On failure the next one from
+    // update() waits TOKEN_RETRY_MS.
+    void refresh() {
+        char url[128];
+        sprintf(url, TOKEN_URL, SPEECH_LOCATION);
+
+        Url parts;
+        parseUrl(url, parts);
+
+        // Connect here rather than leaving it to the request so the
+        // handshake is timed and the connection kept
+        if (!_connection.connect(parts.host, parts.port)) {
+            _connection.printStats();
+            failed(HTTPC_ERROR_CONNECTION_REFUSED);
+            return;
+        }
+
+        _request.begin(_connection.client(), url);
+        _request.setReuse(true);
+        _request.addHeader("Ocp-Apim-Subscription-Key", SPEECH_API_KEY);
+        _request.setBody("{}");
+        _request.onComplete(tokenReceived, this);
+        asyncHttp.start(_request);
+    }
+
+    const String &token() {
+        return _token;
+    }
+
+private:
+    KeepAliveClient _connection;
+    AsyncHttpRequest _request;
+    String _token;
+    unsigned long _issued;
+    unsigned long _next_attempt;
+    bool _valid;
+
+    bool needsRefresh() {
+        return !_valid || millis() - _issued >= TOKEN_LIFETIME_MS - TOKEN_REFRESH_MARGIN_MS;
+    }
+
+    void failed(int httpResultCode) {
+        Serial.print("Error getting access token - error ");
+        Serial.println(httpResultCode);
+
+        _connection.close();
+        _next_attempt = millis() + TOKEN_RETRY_MS;
+    }
+
+    static void tokenReceived(AsyncHttpRequest &request, Stream &body, void *context) {
+        TokenManager *self = (TokenManager *)context;
+        self->_connection.printStats();
+
+        if (request.status() != 200) {
+            self->failed(request.status());
+            return;
+        }
+
+        // A token cut short would only be turned away
+        if (request.truncated()) {
+            self->failed(HTTPC_ERROR_TOO_LESS_RAM);
+            return;
+        }
+
+        if (request.keepAlive()) {
+            self->_connection.release();
+        } else {
+            self->_connection.close();
+        }
+
+        Serial.println("Got access token.");
+        self->_token = body.readString();
+        self->_issued = millis();
+        self->_valid = true;
+    }
+};
@@ -0,0 +1,272 @@
+#pragma once
+
+#include <Arduino.h>
+#include <sfud.h>
+
+#include "config.h"
+#include "hash.h"
+
+#define TRANSLATION_RECORD_SIZE 128
+#define TRANSLATION_MAX_LEN 113 // Longest translation that is cached, in bytes
+#define TRANSLATION_PENDING 4 // Translations waiting for update() to write them
+
+static_assert(TRANSLATION_FLASH_OFFSET >= JOURNAL_FLASH_OFFSET + JOURNAL_FLASH_SIZE ||
+                  TRANSLATION_FLASH_OFFSET + TRANSLATION_FLASH_SIZE <= JOURNAL_FLASH_OFFSET,
+              "The translation cache must not overlap the journal");
+
+struct TranslationRecord
+{
+    uint32_t sequence; // Erased flash reads as 0xFFFFFFFF
+    uint32_t key;
+    uint16_t length;
+    char text[TRANSLATION_MAX_LEN + 1];
+    uint32_t crc;
+};
+
+// Translations keyed by a hash of the text and the language pair. The
+// most recently used ones are kept in RAM, and every translation is
+// written through to a ring of records in flash, so they survive a reboot.
+// Records are appended one after another and the oldest sector is erased
+// when the ring wraps, which just forgets the oldest translations.
+// Translations arrive in HTTP callbacks, which can run mid-recording, so
+// store() only queues the record and update() writes it later.
+class TranslationCache
+{
+public:
+    void init()
+    {
+        _flash = sfud_get_device_table() + 0;
+        _sectorSize = _flash->chip.erase_gran;
+        _clock = 0;
+        _ramHits = 0;
+        _flashHits = 0;
+        _misses = 0;
+        _pendingCount = 0;
+        memset(_entries, 0, sizeof(_entries));
+
+        // Carry on after the newest record
+        _head = TRANSLATION_FLASH_OFFSET;
+        _sequence = 0;
+        for (size_t address = TRANSLATION_FLASH_OFFSET; address < TRANSLATION_FLASH_OFFSET + TRANSLATION_FLASH_SIZE;
+             address += TRANSLATION_RECORD_SIZE)
+        {
+            uint32_t sequence;
+            sfud_read(_flash, address, sizeof(sequence), (uint8_t *)&sequence);
+            if (sequence != 0xFFFFFFFF && sequence >= _sequence)
+            {
+                _sequence = sequence + 1;
+                _head = nextAddress(address);
+            }
+        }
+    }
+
+    static uint32_t key(const String &text, const String &from, const String &to)
+    {
+        // FNV-1a, with the zero terminators keeping "ab" + "c" apart from "a" + "bc"
+        uint32_t hash = FNV1A_INIT;
+        hash = fnv1aUpdate(hash, text.c_str(), text.length() + 1);
+        hash = fnv1aUpdate(hash, from.c_str(), from.length() + 1);
+        return fnv1aUpdate(hash, to.c_str(), to.length() + 1);
+    }
+
+    // Looks in RAM, then flash
+    bool find(uint32_t key, String &translation)
+    {
+        Entry *entry = lookup(key);
+        if (entry != NULL)
+        {
+            _ramHits++;
+            entry->used = ++_clock;
+            translation = entry->text;
+            return true;
+        }
+
+        TranslationRecord record;
+        if (!findPending(key, record) && !findRecord(key, record))
+        {
+            _misses++;
+            return false;
+        }
+
+        _flashHits++;
+        remember(key, record.text);
+        translation = record.text;
+        return true;
+    }
+
+    // Adds a translation to RAM and queues it to be written to flash
+    void store(uint32_t key, const String &translation)
+    {
+        if (translation.length() == 0 || translation.length() > TRANSLATION_MAX_LEN)
+        {
+            return;
+        }
+
+        remember(key, translation.c_str());
+
+        if (_pendingCount == TRANSLATION_PENDING)
+        {
+            Serial.println("Translation cache write queue full, keeping it in RAM only");
+            return;
+        }
+
+        TranslationRecord &record = _pending[_pendingCount++];
+        memset(&record, 0, sizeof(record));
+        record.key = key;
+        record.length = translation.length();
+        memcpy(record.text, translation.c_str(), record.length);
+    }
+
+    // Writes queued translations to flash, erasing a sector when the ring
+    // reaches one. Call from loop() while nothing is being recorded.
+    void update()
+    {
+        for (size_t i = 0; i < _pendingCount; i++)
+        {
+            TranslationRecord &record = _pending[i];
+            record.sequence = _sequence++;
+            record.crc = recordCrc(record);
+
+            if (_head % _sectorSize == 0)
+            {
+                sfud_erase(_flash, _head, _sectorSize);
+            }
+
+            sfud_write(_flash, _head, sizeof(record), (uint8_t *)&record);
+            _head = nextAddress(_head);
+        }
+
+        _pendingCount = 0;
+    }
+
+    void printStats()
+    {
+        Serial.print("Translation cache: ");
+        Serial.print(_ramHits);
+        Serial.print(" RAM hits, ");
+        Serial.print(_flashHits);
+        Serial.print(" flash hits, ");
+        Serial.print(_misses);
+        Serial.println(" misses");
+    }
+
+private:
+    struct Entry
+    {
+        uint32_t key;
+        uint32_t used; // 0 for an empty slot
+        char text[TRANSLATION_MAX_LEN + 1];
+    };
+
+    static_assert(sizeof(TranslationRecord) <= TRANSLATION_RECORD_SIZE, "A translation record must fit its slot");
+
+    const sfud_flash *_flash;
+    size_t _sectorSize;
+    size_t _head;
+    uint32_t _sequence;
+
+    Entry _entries[TRANSLATION_CACHE_ENTRIES];
+    uint32_t _clock;
+
+    TranslationRecord _pending[TRANSLATION_PENDING];
+    size_t _pendingCount;
+
+    uint32_t _ramHits;
+    uint32_t _flashHits;
+    uint32_t _misses;
+
+    Entry *lookup(uint32_t key)
+    {
+        for (size_t i = 0; i < TRANSLATION_CACHE_ENTRIES; i++)
+        {
+            if (_entries[i].used != 0 && _entries[i].key == key)
+            {
+                return &_entries[i];
+            }
+        }
+
+        return NULL;
+    }
+
+    // Puts a translation in RAM, pushing out the least recently used
+    void remember(uint32_t key, const char *text)
+    {
+        Entry *entry = lookup(key);
+        if (entry == NULL)
+        {
+            // Empty slots have the lowest use count of all
+            entry = &_entries[0];
+            for (size_t i = 1; i < TRANSLATION_CACHE_ENTRIES; i++)
+            {
+                if (_entries[i].used < entry->used)
+                {
+                    entry = &_entries[i];
+                }
+            }
+        }
+
+        entry->key = key;
+        entry->used = ++_clock;
+        strncpy(entry->text, text, TRANSLATION_MAX_LEN);
+        entry->text[TRANSLATION_MAX_LEN] = 0;
+    }
+
+    // Newest queued record for key, for one pushed out of RAM before
+    // update() wrote it
+    bool findPending(uint32_t key, TranslationRecord &found)
+    {
+        for (size_t i = _pendingCount; i > 0; i--)
+        {
+            if (_pending[i - 1].key == key)
+            {
+                found = _pending[i - 1];
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    // Newest intact record for key
+    bool findRecord(uint32_t key, TranslationRecord &found)
+    {
+        bool any = false;
+
+        for (size_t address = TRANSLATION_FLASH_OFFSET; address < TRANSLATION_FLASH_OFFSET + TRANSLATION_FLASH_SIZE;
+             address += TRANSLATION_RECORD_SIZE)
+        {
+            uint32_t header[2];
+            sfud_read(_flash, address, sizeof(header), (uint8_t *)header);
+            if (header[0] == 0xFFFFFFFF || header[1] != key || (any && header[0] < found.sequence))
+            {
+                continue;
+            }
+
+            TranslationRecord record;
+            sfud_read(_flash, address, sizeof(record), (uint8_t *)&record);
+            if (record.length <= TRANSLATION_MAX_LEN && record.crc == recordCrc(record))
+            {
+                record.text[record.length] = 0;
+                found = record;
+                any = true;
+            }
+        }
+
+        return any;
+    }
+
+    size_t nextAddress(size_t address)
+    {
+        address += TRANSLATION_RECORD_SIZE;
+        return address >= TRANSLATION_FLASH_OFFSET + TRANSLATION_FLASH_SIZE ? TRANSLATION_FLASH_OFFSET : address;
+    }
+
+    // Covers everything before the CRC itself
+    static uint32_t recordCrc(const TranslationRecord &record)
+    {
+        return crc32(&record, offsetof(TranslationRecord, crc));
+    }
+};
+
+// Global instance
+TranslationCache translationCache;
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include "audio_journal.h"
+#include "config.h"
+#include "speech_to_text.h"
+
+// Uploads the recordings waiting in the journal, oldest first. When the
+// network fails it keeps the recording and waits before trying again,
+// doubling the wait each time up to JOURNAL_RETRY_MAX_MS, so a long outage
+// costs retries rather than a new recording. Recognised text goes to the
+// callback, in recording order. A recording that failed for good or had
+// nothing in it is dropped without a call.
+class UploadManager {
+public:
+    typedef void (*TextCallback)(const String &text);
+
+    UploadManager(AudioJournal &journal, SpeechToText &speech_to_text, TextCallback recognized)
+        : _journal(journal), _speech_to_text(speech_to_text), _recognized(recognized) {
+        _backoff_ms = JOURNAL_RETRY_MS;
+        _next_retry = 0;
+        _failures = 0;
+    }
+
+    // True when something is waiting, the backoff has run out and nothing
+    // is being recognised
+    bool isDue() {
+        return _journal.pendingCount() > 0 && (long)(millis() - _next_retry) >= 0 &&
+               !_speech_to_text.busy();
+    }
+
+    // Skips the rest of the current wait, for when there is a reason to
+    // think the network is back, such as a fresh recording
+    void retryNow() {
+        _next_retry = millis();
+    }
+
+    // Starts uploading the oldest recording. Recordings that fail their CRC
+    // are dropped rather than uploaded.
+    void uploadNext() {
+        if (!_journal.oldestPending(_record)) {
+            return;
+        }
+
+        if (!_journal.verify(_record)) {
+            Serial.println("Recording failed its CRC check, dropping it");
+            _journal.markUploaded(_record);
+            return;
+        }
+
+        _speech_to_text.convertSpeechToText(_record.length, NULL, _record.address, uploaded, this);
+    }
+
+    // Finishes the upload streamed while record was recorded
+    void finishStreaming(const JournalRecord &record) {
+        _record = record;
+        _speech_to_text.finishStreaming(record.length, uploaded, this);
+    }
+
+    void succeeded() {
+        _failures = 0;
+        _backoff_ms = JOURNAL_RETRY_MS;
+        _next_retry = millis();
+    }
+
+    void failed() {
+        _failures++;
+        _next_retry = millis() + _backoff_ms;
+
+        Serial.print("Upload failed ");
+        Serial.print(_failures);
+        Serial.print(" time(s), keeping the recording and retrying in ");
+        Serial.print(_backoff_ms / 1000);
+        Serial.println(" s");
+
+        _backoff_ms = min(_backoff_ms * 2, (unsigned long)JOURNAL_RETRY_MAX_MS);
+    }
+
+private:
+    AudioJournal &_journal;
+    SpeechToText &_speech_to_text;
+    TextCallback _recognized;
+    JournalRecord _record;
+
+    unsigned long _backoff_ms;
+    unsigned long _next_retry;
+    uint32_t _failures;
+
+    static void uploaded(const String &text, void *context) {
+        UploadManager *self = (UploadManager *)context;
+        if (self->_speech_to_text.shouldRetry()) {
+            self->failed();
+            return;
+        }
+
+        self->_journal.markUploaded(self->_record);
+        self->succeeded();
+
+        if (text.length() > 0) {
+            self->_recognized(text);
+        }
+    }
+};
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <Arduino.h>
+
+#define URL_HOST_SIZE 64
+
+// The parts of "scheme://host[:port]/path" a request needs
+struct Url {
+    char host[URL_HOST_SIZE];
+    uint16_t port;    // 443 for https, 80 otherwise, unless the URL gives one
+    const char *path; // Points into the URL, "/" if it has none
+};
+
+// Splits url into parts. Hosts too long for URL_HOST_SIZE are cut short.
+// Returns false if there is no host.
+inline bool parseUrl(const char *url, Url &parts) {
+    parts.port = strncmp(url, "https:", 6) == 0 ? 443 : 80;
+
+    const char *start = strstr(url, "://");
+    start = (start == NULL) ? url : start + 3;
+
+    const char *path = strchr(start, '/');
+    parts.path = (path == NULL) ? "/" : path;
+
+    size_t len = (path == NULL) ? strlen(start) : (size_t)(path - start);
+    const char *colon = (const char *)memchr(start, ':', len);
+    if (colon != NULL) {
+        parts.port = atoi(colon + 1);
+        len = colon - start;
+    }
+
+    len = min(len, (size_t)URL_HOST_SIZE - 1);
+    memcpy(parts.host, start, len);
+    parts.host[len] = 0;
+
+    return len > 0;
+}
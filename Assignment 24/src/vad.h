@@ -0,0 +1,58 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include "config.h"
+
+class VoiceActivityDetector
+{
+public:
+    // A block counts as speech when its mean absolute amplitude (after
+    // removing the DC offset) clears the energy threshold and it crosses
+    // zero less often than broadband noise does.
+    bool isSpeech(const int16_t *pcm, size_t len)
+    {
+        int32_t sum = 0;
+        for (size_t i = 0; i < len; i++)
+        {
+            sum += pcm[i];
+        }
+        int32_t mean = sum / (int32_t)len;
+
+        uint32_t energy = 0;
+        uint32_t crossings = 0;
+        bool wasPositive = pcm[0] >= mean;
+
+        for (size_t i = 0; i < len; i++)
+        {
+            int32_t value = pcm[i] - mean;
+            energy += abs(value);
+
+            bool isPositive = value >= 0;
+            if (isPositive != wasPositive)
+            {
+                crossings++;
+            }
+            wasPositive = isPositive;
+        }
+
+        _energy = energy / len;
+        _zeroCrossingPercent = crossings * 100 / len;
+
+        return _energy >= VAD_ENERGY_THRESHOLD && _zeroCrossingPercent <= VAD_MAX_ZERO_CROSSING_PERCENT;
+    }
+
+    uint32_t energy()
+    {
+        return _energy;
+    }
+
+    uint32_t zeroCrossingPercent()
+    {
+        return _zeroCrossingPercent;
+    }
+
+private:
+    uint32_t _energy;
+    uint32_t _zeroCrossingPercent;
+};
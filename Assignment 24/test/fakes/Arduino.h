@@ -0,0 +1,152 @@
+#pragma once
+
+// Host stand-in for the Wio Terminal's Arduino core, for the native
+// environment. Time comes from fake_clock.h, the peripherals the sources
+// program directly from samd51.h, and Serial collects its output so tests
+// can check it (set FAKE_SERIAL=1 in the environment to see it as well).
+
+#include <ctype.h>
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <string>
+#include <type_traits>
+
+#include "Print.h"
+#include "Stream.h"
+#include "WString.h"
+#include "fake_clock.h"
+#include "samd51.h"
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define LOW 0
+#define HIGH 1
+#define INPUT 0
+#define OUTPUT 1
+#define INPUT_PULLUP 2
+
+#define WIO_KEY_A 28
+#define WIO_KEY_B 29
+#define WIO_KEY_C 30
+#define DAC0 15
+#define AR_INTERNAL2V23 6
+
+#define SDCARD_SS_PIN 48
+
+// The core's min and max are macros that work on mixed types. Templates
+// keep them out of the way of the standard library.
+template <typename A, typename B>
+constexpr typename std::common_type<A, B>::type min(A a, B b)
+{
+    return a < b ? a : b;
+}
+
+template <typename A, typename B>
+constexpr typename std::common_type<A, B>::type max(A a, B b)
+{
+    return a > b ? a : b;
+}
+
+template <typename T, typename L, typename H>
+constexpr T constrain(T value, L low, H high)
+{
+    return value < (T)low ? (T)low : value > (T)high ? (T)high : value;
+}
+
+inline long map(long value, long in_min, long in_max, long out_min, long out_max)
+{
+    return (value - in_min) * (out_max - out_min) / (in_max - in_min) + out_min;
+}
+
+namespace fake {
+
+inline int *pinLevels()
+{
+    static int levels[64] = {};
+    return levels;
+}
+
+inline std::string &serialOutput()
+{
+    static std::string output;
+    return output;
+}
+
+} // namespace fake
+
+inline void pinMode(int pin, int mode)
+{
+    if (mode == INPUT_PULLUP) {
+        fake::pinLevels()[pin] = HIGH;
+    }
+}
+
+inline int digitalRead(int pin)
+{
+    return fake::pinLevels()[pin];
+}
+
+inline void digitalWrite(int pin, int level)
+{
+    fake::pinLevels()[pin] = level;
+}
+
+inline void analogReference(int reference)
+{
+}
+
+inline void analogWriteResolution(int bits)
+{
+}
+
+inline void analogWrite(int pin, int value)
+{
+    if (pin == DAC0) {
+        DAC->DATA[0].reg = value;
+    }
+}
+
+class FakeSerial : public Stream {
+public:
+    virtual size_t write(uint8_t c) override {
+        fake::serialOutput() += (char)c;
+        if (echo()) {
+            fputc(c, stdout);
+        }
+        return 1;
+    }
+
+    using Print::write;
+
+    virtual int available() override {
+        return 0;
+    }
+
+    virtual int read() override {
+        return -1;
+    }
+
+    virtual int peek() override {
+        return -1;
+    }
+
+    void begin(unsigned long baud) {}
+
+    operator bool() {
+        return true;
+    }
+
+private:
+    static bool echo() {
+        static bool echo = getenv("FAKE_SERIAL") != NULL;
+        return echo;
+    }
+};
+
+inline FakeSerial Serial;
@@ -0,0 +1,27 @@
+#pragma once
+
+// Only the status codes: the sources talk HTTP themselves through
+// AsyncHttpRequest, and the body streams just need the names.
+
+#include "WiFiClient.h"
+
+#define HTTPC_ERROR_CONNECTION_REFUSED (-1)
+#define HTTPC_ERROR_SEND_HEADER_FAILED (-2)
+#define HTTPC_ERROR_SEND_PAYLOAD_FAILED (-3)
+#define HTTPC_ERROR_NOT_CONNECTED (-4)
+#define HTTPC_ERROR_CONNECTION_LOST (-5)
+#define HTTPC_ERROR_NO_STREAM (-6)
+#define HTTPC_ERROR_NO_HTTP_SERVER (-7)
+#define HTTPC_ERROR_TOO_LESS_RAM (-8)
+#define HTTPC_ERROR_ENCODING (-9)
+#define HTTPC_ERROR_STREAM_WRITE (-10)
+#define HTTPC_ERROR_READ_TIMEOUT (-11)
+
+#define HTTP_TCP_BUFFER_SIZE (1460)
+
+#define HTTP_CODE_OK 200
+#define HTTP_CODE_UNAUTHORIZED 401
+#define HTTP_CODE_REQUEST_TIMEOUT 408
+#define HTTP_CODE_TOO_MANY_REQUESTS 429
+#define HTTP_CODE_INTERNAL_SERVER_ERROR 500
+#define HTTP_CODE_SERVICE_UNAVAILABLE 503
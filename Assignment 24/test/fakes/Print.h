@@ -0,0 +1,88 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "WString.h"
+
+// Host stand-in for the Arduino core's Print
+class Print {
+public:
+    virtual ~Print() {}
+
+    virtual size_t write(uint8_t c) = 0;
+
+    virtual size_t write(const uint8_t *buffer, size_t size) {
+        size_t n = 0;
+        while (size-- > 0 && write(*buffer++) == 1) {
+            n++;
+        }
+        return n;
+    }
+
+    size_t write(const char *str) {
+        return str == NULL ? 0 : write((const uint8_t *)str, strlen(str));
+    }
+
+    size_t write(const char *buffer, size_t size) {
+        return write((const uint8_t *)buffer, size);
+    }
+
+    size_t print(const char *value) {
+        return write(value);
+    }
+
+    size_t print(const String &value) {
+        return write((const uint8_t *)value.c_str(), value.length());
+    }
+
+    size_t print(char value) {
+        return write((uint8_t)value);
+    }
+
+    size_t print(int value, int base = DEC) {
+        return print(String(value, base));
+    }
+
+    size_t print(unsigned int value, int base = DEC) {
+        return print(String(value, base));
+    }
+
+    size_t print(long value, int base = DEC) {
+        return print(String(value, base));
+    }
+
+    size_t print(unsigned long value, int base = DEC) {
+        return print(String(value, base));
+    }
+
+    size_t print(long long value, int base = DEC) {
+        return print(String((long)value, base));
+    }
+
+    size_t print(unsigned long long value, int base = DEC) {
+        return print(String((unsigned long)value, base));
+    }
+
+    size_t print(double value, int decimals = 2) {
+        return print(String(value, decimals));
+    }
+
+    size_t println() {
+        return write("\r\n");
+    }
+
+    template <typename T>
+    size_t println(const T &value) {
+        size_t n = print(value);
+        return n + println();
+    }
+
+    template <typename T>
+    size_t println(const T &value, int format) {
+        size_t n = print(value, format);
+        return n + println();
+    }
+
+    virtual void flush() {}
+};
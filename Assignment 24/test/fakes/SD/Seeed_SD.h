@@ -0,0 +1,17 @@
+#pragma once
+
+#include "../SPI.h"
+#include "../Seeed_FS.h"
+
+#define SDCARD_SPI SPI2
+
+class SDFS : public fs::FS {
+public:
+    bool begin(int ss_pin, SPIClass &spi, int frequency = 4000000) {
+        return fake::sdCard().present;
+    }
+
+    void end() {}
+};
+
+inline SDFS SD;
@@ -0,0 +1,10 @@
+#pragma once
+
+class SPIClass {
+public:
+    void begin() {}
+    void end() {}
+};
+
+inline SPIClass SPI;
+inline SPIClass SPI2;
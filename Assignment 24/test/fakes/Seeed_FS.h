@@ -0,0 +1,209 @@
+#pragma once
+
+// Host stand-in for Seeed Arduino FS: files live in memory in fake::sdCard(),
+// and reading or writing them costs simulated time at the card's SPI speed.
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+
+#include "Stream.h"
+#include "fake_clock.h"
+
+#define FILE_READ 0x01
+#define FILE_WRITE (0x01 | 0x02 | 0x08) // Read, write, create and truncate
+#define FILE_APPEND (0x01 | 0x02 | 0x30)
+
+#define SeekSet 0
+#define SeekCur 1
+#define SeekEnd 2
+
+namespace fake {
+
+struct SdCard {
+    bool present = true;
+    uint32_t bytesPerMs = 1000; // About 1 MB/s over SPI
+    std::map<std::string, std::shared_ptr<std::string>> files;
+    std::set<std::string> directories;
+    uint64_t bytesWritten = 0;
+    uint64_t bytesRead = 0;
+
+    void reset() {
+        present = true;
+        files.clear();
+        directories.clear();
+        bytesWritten = 0;
+        bytesRead = 0;
+    }
+
+    void transfer(size_t bytes) {
+        if (bytesPerMs > 0) {
+            advanceMicros((uint64_t)bytes * 1000 / bytesPerMs);
+        }
+    }
+};
+
+inline SdCard &sdCard()
+{
+    static SdCard card;
+    return card;
+}
+
+} // namespace fake
+
+namespace fs {
+
+class File : public Stream {
+public:
+    File() : _position(0), _writable(false) {}
+
+    File(std::shared_ptr<std::string> data, const std::string &name, bool writable)
+        : _data(data), _name(name), _position(0), _writable(writable) {}
+
+    virtual size_t write(uint8_t c) override {
+        return write(&c, 1);
+    }
+
+    virtual size_t write(const uint8_t *buffer, size_t size) override {
+        if (!_data || !_writable) {
+            return 0;
+        }
+        if (_position + size > _data->size()) {
+            _data->resize(_position + size);
+        }
+        memcpy(&(*_data)[_position], buffer, size);
+        _position += size;
+
+        fake::sdCard().bytesWritten += size;
+        fake::sdCard().transfer(size);
+        return size;
+    }
+
+    using Print::write;
+
+    virtual int available() override {
+        return _data ? (int)(_data->size() - _position) : 0;
+    }
+
+    virtual int read() override {
+        uint8_t c;
+        return read(&c, 1) == 1 ? c : -1;
+    }
+
+    size_t read(uint8_t *buffer, size_t size) {
+        if (!_data) {
+            return 0;
+        }
+        size = std::min(size, _data->size() - _position);
+        memcpy(buffer, _data->data() + _position, size);
+        _position += size;
+
+        fake::sdCard().bytesRead += size;
+        fake::sdCard().transfer(size);
+        return size;
+    }
+
+    virtual int peek() override {
+        return _data && _position < _data->size() ? (uint8_t)(*_data)[_position] : -1;
+    }
+
+    bool seek(uint32_t position, int mode = SeekSet) {
+        if (!_data) {
+            return false;
+        }
+        size_t target = mode == SeekSet ? position : mode == SeekCur ? _position + position : _data->size() + position;
+        if (target > _data->size()) {
+            return false;
+        }
+        _position = target;
+        return true;
+    }
+
+    size_t position() {
+        return _position;
+    }
+
+    size_t size() {
+        return _data ? _data->size() : 0;
+    }
+
+    const char *name() {
+        return _name.c_str();
+    }
+
+    void close() {
+        _data.reset();
+    }
+
+    operator bool() const {
+        return (bool)_data;
+    }
+
+private:
+    std::shared_ptr<std::string> _data;
+    std::string _name;
+    size_t _position;
+    bool _writable;
+};
+
+class FS {
+public:
+    File open(const char *path, uint8_t mode = FILE_READ) {
+        fake::SdCard &card = fake::sdCard();
+        if (!card.present) {
+            return File();
+        }
+
+        std::map<std::string, std::shared_ptr<std::string>>::iterator found = card.files.find(path);
+        bool writable = (mode & 0x02) != 0;
+        if (found == card.files.end()) {
+            if (!writable) {
+                return File();
+            }
+            found = card.files.insert(std::make_pair(std::string(path), std::make_shared<std::string>())).first;
+        } else if ((mode & 0x08) != 0) {
+            found->second->clear();
+        }
+
+        File file(found->second, path, writable);
+        if ((mode & 0x30) == 0x30) {
+            file.seek(0, SeekEnd);
+        }
+        return file;
+    }
+
+    bool exists(const char *path) {
+        fake::SdCard &card = fake::sdCard();
+        return card.present && (card.files.count(path) > 0 || card.directories.count(path) > 0);
+    }
+
+    bool mkdir(const char *path) {
+        fake::sdCard().directories.insert(path);
+        return fake::sdCard().present;
+    }
+
+    bool remove(const char *path) {
+        return fake::sdCard().present && fake::sdCard().files.erase(path) > 0;
+    }
+
+    bool rename(const char *from, const char *to) {
+        fake::SdCard &card = fake::sdCard();
+        std::map<std::string, std::shared_ptr<std::string>>::iterator found = card.files.find(from);
+        if (!card.present || found == card.files.end() || card.files.count(to) > 0) {
+            return false;
+        }
+        card.files[to] = found->second;
+        card.files.erase(found);
+        return true;
+    }
+};
+
+} // namespace fs
+
+using fs::File;
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "Print.h"
+#include "fake_clock.h"
+
+// Host stand-in for the Arduino core's Stream. As in the SAMD core,
+// readBytes() is not virtual: a caller holding a plain Stream gets this
+// byte-at-a-time version whatever the stream is. Waiting for a byte that
+// hasn't arrived costs simulated time, so timeouts run out as they would
+// on the device.
+class Stream : public Print {
+public:
+    Stream() : _timeout(1000) {}
+
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+
+    void setTimeout(unsigned long timeout) {
+        _timeout = timeout;
+    }
+
+    unsigned long getTimeout() {
+        return _timeout;
+    }
+
+    size_t readBytes(char *buffer, size_t length) {
+        size_t count = 0;
+        while (count < length) {
+            int c = timedRead();
+            if (c < 0) {
+                break;
+            }
+            *buffer++ = (char)c;
+            count++;
+        }
+        return count;
+    }
+
+    size_t readBytes(uint8_t *buffer, size_t length) {
+        return readBytes((char *)buffer, length);
+    }
+
+    String readString() {
+        String out;
+        int c;
+        while ((c = timedRead()) >= 0) {
+            out += (char)c;
+        }
+        return out;
+    }
+
+    String readStringUntil(char terminator) {
+        String out;
+        int c;
+        while ((c = timedRead()) >= 0 && c != terminator) {
+            out += (char)c;
+        }
+        return out;
+    }
+
+protected:
+    unsigned long _timeout;
+
+    int timedRead() {
+        unsigned long start = millis();
+        do {
+            int c = read();
+            if (c >= 0) {
+                return c;
+            }
+            fake::advanceMillis(1);
+        } while (millis() - start < _timeout);
+        return -1;
+    }
+};
@@ -0,0 +1,225 @@
+#pragma once
+
+// Host stand-in for the Arduino core's String, backed by std::string. Only
+// the parts the sources and ArduinoJson use.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+#include <string>
+
+#define DEC 10
+#define HEX 16
+#define OCT 8
+#define BIN 2
+
+class String {
+public:
+    String(const char *value = "") : _value(value == NULL ? "" : value) {}
+    String(const std::string &value) : _value(value) {}
+    explicit String(char c) : _value(1, c) {}
+    String(int value, unsigned char base = DEC) : _value(format((long long)value, base)) {}
+    String(unsigned int value, unsigned char base = DEC) : _value(formatUnsigned(value, base)) {}
+    String(long value, unsigned char base = DEC) : _value(format((long long)value, base)) {}
+    String(unsigned long value, unsigned char base = DEC) : _value(formatUnsigned(value, base)) {}
+    String(float value, unsigned char decimals = 2) : _value(formatFloat(value, decimals)) {}
+    String(double value, unsigned char decimals = 2) : _value(formatFloat(value, decimals)) {}
+
+    unsigned int length() const {
+        return _value.length();
+    }
+
+    const char *c_str() const {
+        return _value.c_str();
+    }
+
+    bool reserve(unsigned int size) {
+        _value.reserve(size);
+        return true;
+    }
+
+    bool concat(const String &value) {
+        _value += value._value;
+        return true;
+    }
+
+    bool concat(const char *value) {
+        _value += value;
+        return true;
+    }
+
+    bool concat(const char *value, unsigned int length) {
+        _value.append(value, length);
+        return true;
+    }
+
+    bool concat(char c) {
+        _value += c;
+        return true;
+    }
+
+    String &operator+=(const String &value) {
+        _value += value._value;
+        return *this;
+    }
+
+    String &operator+=(const char *value) {
+        _value += value;
+        return *this;
+    }
+
+    String &operator+=(char c) {
+        _value += c;
+        return *this;
+    }
+
+    char charAt(unsigned int index) const {
+        return index < _value.length() ? _value[index] : 0;
+    }
+
+    char operator[](unsigned int index) const {
+        return charAt(index);
+    }
+
+    bool equals(const String &other) const {
+        return _value == other._value;
+    }
+
+    bool operator==(const String &other) const {
+        return _value == other._value;
+    }
+
+    bool operator==(const char *other) const {
+        return _value == other;
+    }
+
+    bool operator!=(const String &other) const {
+        return _value != other._value;
+    }
+
+    bool operator!=(const char *other) const {
+        return _value != other;
+    }
+
+    bool operator<(const String &other) const {
+        return _value < other._value;
+    }
+
+    bool startsWith(const String &prefix) const {
+        return _value.compare(0, prefix._value.length(), prefix._value) == 0;
+    }
+
+    bool endsWith(const String &suffix) const {
+        return _value.length() >= suffix._value.length() &&
+               _value.compare(_value.length() - suffix._value.length(), std::string::npos, suffix._value) == 0;
+    }
+
+    int indexOf(char c, unsigned int from = 0) const {
+        size_t pos = _value.find(c, from);
+        return pos == std::string::npos ? -1 : (int)pos;
+    }
+
+    int indexOf(const String &value, unsigned int from = 0) const {
+        size_t pos = _value.find(value._value, from);
+        return pos == std::string::npos ? -1 : (int)pos;
+    }
+
+    String substring(unsigned int from) const {
+        return from >= _value.length() ? String() : String(_value.substr(from));
+    }
+
+    String substring(unsigned int from, unsigned int to) const {
+        if (from > to) {
+            unsigned int swap = from;
+            from = to;
+            to = swap;
+        }
+        if (from >= _value.length()) {
+            return String();
+        }
+        return String(_value.substr(from, to - from));
+    }
+
+    void remove(unsigned int index) {
+        if (index < _value.length()) {
+            _value.erase(index);
+        }
+    }
+
+    void remove(unsigned int index, unsigned int count) {
+        if (index < _value.length()) {
+            _value.erase(index, count);
+        }
+    }
+
+    void toLowerCase() {
+        for (char &c : _value) {
+            c = tolower(c);
+        }
+    }
+
+    void toUpperCase() {
+        for (char &c : _value) {
+            c = toupper(c);
+        }
+    }
+
+    void trim() {
+        size_t start = _value.find_first_not_of(" \t\r\n");
+        size_t end = _value.find_last_not_of(" \t\r\n");
+        _value = start == std::string::npos ? "" : _value.substr(start, end - start + 1);
+    }
+
+    long toInt() const {
+        return atol(_value.c_str());
+    }
+
+    float toFloat() const {
+        return atof(_value.c_str());
+    }
+
+    friend String operator+(const String &a, const String &b) {
+        return String(a._value + b._value);
+    }
+
+    friend String operator+(const String &a, const char *b) {
+        return String(a._value + b);
+    }
+
+    friend String operator+(const char *a, const String &b) {
+        return String(a + b._value);
+    }
+
+    friend String operator+(const String &a, char b) {
+        return String(a._value + b);
+    }
+
+private:
+    std::string _value;
+
+    static std::string format(long long value, unsigned char base) {
+        if (value < 0 && base == DEC) {
+            return "-" + formatUnsigned((unsigned long long)-value, base);
+        }
+        return formatUnsigned((unsigned long long)value, base);
+    }
+
+    static std::string formatUnsigned(unsigned long long value, unsigned char base) {
+        const char *digits = "0123456789ABCDEF";
+        std::string out;
+        do {
+            out.insert(out.begin(), digits[value % base]);
+            value /= base;
+        } while (value != 0);
+        return out;
+    }
+
+    static std::string formatFloat(double value, unsigned char decimals) {
+        char buffer[64];
+        snprintf(buffer, sizeof(buffer), "%.*f", decimals, value);
+        return buffer;
+    }
+};
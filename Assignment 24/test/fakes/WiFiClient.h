@@ -0,0 +1,410 @@
+#pragma once
+
+// A loopback network for the native environment. Every WiFiClient talks to
+// fake::server(), which parses the requests as they are written (with a
+// Content-Length or chunked), records them with the device time each chunk
+// arrived, and answers from a handler a test supplies. Connecting, sending
+// and the response all cost simulated time, set through fake::network().
+
+#include <ctype.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Client.h"
+#include "fake_clock.h"
+
+namespace fake {
+
+struct NetworkConditions {
+    uint32_t connectUs = 30000;       // TCP handshake
+    uint32_t tlsHandshakeUs = 600000; // Full TLS handshake, on top of connectUs
+    uint32_t latencyUs = 50000;       // Request complete until the response starts arriving
+    uint32_t downloadBytesPerMs = 0;  // Response speed, 0 for no limit
+    uint32_t uploadBytesPerMs = 0;    // Request speed, 0 for no limit. Writes block for it.
+    bool refuse = false;              // Connects fail
+};
+
+struct HttpRequest {
+    std::string host;
+    uint16_t port = 0;
+    bool tls = false;
+    std::string method;
+    std::string path;
+    std::map<std::string, std::string> headers; // Names in lower case
+    std::string body;
+    bool chunked = false;
+    std::vector<size_t> chunkSizes;
+    std::vector<uint64_t> chunkMicros; // Device time each chunk had fully arrived
+    uint64_t startedMicros = 0;        // First byte of the request line
+    uint64_t completedMicros = 0;
+
+    std::string header(const std::string &name) const {
+        std::map<std::string, std::string>::const_iterator found = headers.find(name);
+        return found == headers.end() ? std::string() : found->second;
+    }
+};
+
+// A complete raw HTTP response
+inline std::string httpResponse(int status, const std::string &body,
+                                const std::string &content_type = "application/json", bool close = false)
+{
+    return "HTTP/1.1 " + std::to_string(status) + " Status\r\n" +
+           "Content-Type: " + content_type + "\r\n" +
+           "Content-Length: " + std::to_string(body.size()) + "\r\n" +
+           (close ? "Connection: close\r\n" : "") +
+           "\r\n" + body;
+}
+
+// The same, with the body sent in chunks of chunk_size
+inline std::string chunkedHttpResponse(int status, const std::string &body, size_t chunk_size,
+                                       const std::string &content_type = "application/json")
+{
+    std::string response = "HTTP/1.1 " + std::to_string(status) + " Status\r\n" +
+                           "Content-Type: " + content_type + "\r\n" +
+                           "Transfer-Encoding: chunked\r\n\r\n";
+    char size[16];
+    for (size_t offset = 0; offset < body.size(); offset += chunk_size) {
+        size_t length = std::min(chunk_size, body.size() - offset);
+        snprintf(size, sizeof(size), "%zx\r\n", length);
+        response += size;
+        response += body.substr(offset, length);
+        response += "\r\n";
+    }
+    return response + "0\r\n\r\n";
+}
+
+typedef std::function<std::string(const HttpRequest &request)> HttpHandler;
+
+class Server {
+public:
+    // Answers every request, by default with a 404
+    HttpHandler handler;
+    std::vector<HttpRequest> requests;
+    uint32_t connects = 0;
+    uint32_t tlsHandshakes = 0;
+
+    void reset() {
+        handler = nullptr;
+        requests.clear();
+        connects = 0;
+        tlsHandshakes = 0;
+    }
+
+    std::string respond(const HttpRequest &request) {
+        requests.push_back(request);
+        return handler ? handler(request) : httpResponse(404, "");
+    }
+};
+
+inline NetworkConditions &network()
+{
+    static NetworkConditions conditions;
+    return conditions;
+}
+
+inline Server &server()
+{
+    static Server server;
+    return server;
+}
+
+// One TCP connection as the server sees it
+class Connection {
+public:
+    Connection(const char *host, uint16_t port, bool tls) {
+        _request.host = host;
+        _request.port = port;
+        _request.tls = tls;
+        _open = true;
+        startRequest();
+    }
+
+    bool open() {
+        return _open;
+    }
+
+    void close() {
+        _open = false;
+    }
+
+    void receive(const uint8_t *data, size_t size) {
+        if (!_open) {
+            return;
+        }
+        if (_in.empty() && _stage == STAGE_HEADERS) {
+            _request.startedMicros = clockMicros();
+        }
+        _in.append((const char *)data, size);
+        parse();
+    }
+
+    // Response bytes that have arrived by now and not been read
+    size_t arrived() {
+        if (_out_position >= _out.size() || clockMicros() < _out_ready) {
+            return 0;
+        }
+
+        size_t total = _out.size();
+        uint32_t rate = network().downloadBytesPerMs;
+        if (rate > 0) {
+            uint64_t sent = (clockMicros() - _out_ready) * rate / 1000;
+            total = std::min<uint64_t>(total, _out_sent + sent);
+        }
+        return total > _out_position ? total - _out_position : 0;
+    }
+
+    size_t read(uint8_t *buffer, size_t size) {
+        size = std::min(size, arrived());
+        memcpy(buffer, _out.data() + _out_position, size);
+        _out_position += size;
+        if (_out_position == _out.size() && _close_after) {
+            _open = false;
+        }
+        return size;
+    }
+
+    int peek() {
+        return arrived() > 0 ? (uint8_t)_out[_out_position] : -1;
+    }
+
+    bool closedByServer() {
+        return _close_after && _out_position == _out.size();
+    }
+
+private:
+    enum Stage {
+        STAGE_HEADERS,
+        STAGE_BODY,
+        STAGE_CHUNK_SIZE,
+        STAGE_CHUNK_DATA,
+        STAGE_CHUNK_END,
+        STAGE_TRAILER
+    };
+
+    bool _open;
+    std::string _in;
+    Stage _stage;
+    size_t _remaining;
+    HttpRequest _request;
+
+    std::string _out;
+    size_t _out_position = 0;
+    size_t _out_sent = 0;     // Bytes already out when the current response became ready
+    uint64_t _out_ready = 0;  // Device time the current response starts arriving
+    bool _close_after = false;
+
+    void startRequest() {
+        HttpRequest next;
+        next.host = _request.host;
+        next.port = _request.port;
+        next.tls = _request.tls;
+        _request = next;
+        _stage = STAGE_HEADERS;
+        _remaining = 0;
+    }
+
+    // Takes a line off the front of _in, without its line break
+    bool takeLine(std::string &line) {
+        size_t end = _in.find("\r\n");
+        if (end == std::string::npos) {
+            return false;
+        }
+        line = _in.substr(0, end);
+        _in.erase(0, end + 2);
+        return true;
+    }
+
+    void parse() {
+        std::string line;
+        while (true) {
+            if (_stage == STAGE_HEADERS) {
+                if (!takeLine(line)) {
+                    return;
+                }
+                if (_request.method.empty()) {
+                    size_t space = line.find(' ');
+                    size_t second = line.find(' ', space + 1);
+                    _request.method = line.substr(0, space);
+                    _request.path = line.substr(space + 1, second - space - 1);
+                } else if (!line.empty()) {
+                    size_t colon = line.find(':');
+                    std::string name = line.substr(0, colon);
+                    for (char &c : name) {
+                        c = tolower(c);
+                    }
+                    size_t value = line.find_first_not_of(' ', colon + 1);
+                    _request.headers[name] = value == std::string::npos ? "" : line.substr(value);
+                } else if (_request.header("transfer-encoding").find("chunked") != std::string::npos) {
+                    _request.chunked = true;
+                    _stage = STAGE_CHUNK_SIZE;
+                } else {
+                    _remaining = strtoul(_request.header("content-length").c_str(), NULL, 10);
+                    _stage = STAGE_BODY;
+                    if (_remaining == 0) {
+                        complete();
+                    }
+                }
+            } else if (_stage == STAGE_BODY || _stage == STAGE_CHUNK_DATA) {
+                size_t take = std::min(_remaining, _in.size());
+                if (take == 0) {
+                    return;
+                }
+                _request.body += _in.substr(0, take);
+                _in.erase(0, take);
+                _remaining -= take;
+                if (_remaining > 0) {
+                    return;
+                }
+                if (_stage == STAGE_BODY) {
+                    complete();
+                } else {
+                    _request.chunkMicros.push_back(clockMicros());
+                    _stage = STAGE_CHUNK_END;
+                }
+            } else if (_stage == STAGE_CHUNK_SIZE) {
+                if (!takeLine(line)) {
+                    return;
+                }
+                _remaining = strtoul(line.c_str(), NULL, 16);
+                if (_remaining > 0) {
+                    _request.chunkSizes.push_back(_remaining);
+                    _stage = STAGE_CHUNK_DATA;
+                } else {
+                    _stage = STAGE_TRAILER;
+                }
+            } else if (_stage == STAGE_CHUNK_END) {
+                if (!takeLine(line)) {
+                    return;
+                }
+                _stage = STAGE_CHUNK_SIZE;
+            } else {
+                if (!takeLine(line)) {
+                    return;
+                }
+                if (line.empty()) {
+                    complete();
+                }
+            }
+        }
+    }
+
+    void complete() {
+        _request.completedMicros = clockMicros();
+        std::string response = server().respond(_request);
+
+        // Anything not yet read of an earlier response goes first
+        _out.erase(0, _out_position);
+        _out_position = 0;
+        _out_sent = _out.size();
+        _out += response;
+        _out_ready = clockMicros() + network().latencyUs;
+
+        std::string lower = response.substr(0, response.find("\r\n\r\n"));
+        for (char &c : lower) {
+            c = tolower(c);
+        }
+        _close_after = lower.find("connection: close") != std::string::npos ||
+                       _request.header("connection") == "close";
+
+        startRequest();
+    }
+};
+
+} // namespace fake
+
+class WiFiClient : public Client {
+public:
+    WiFiClient() : _tls(false) {}
+
+    virtual int connect(const char *host, uint16_t port) override {
+        stop();
+
+        fake::NetworkConditions &network = fake::network();
+        fake::advanceMicros(network.connectUs);
+        if (network.refuse) {
+            return 0;
+        }
+        if (_tls) {
+            fake::advanceMicros(network.tlsHandshakeUs);
+            fake::server().tlsHandshakes++;
+        }
+
+        fake::server().connects++;
+        _connection = std::make_shared<fake::Connection>(host, port, _tls);
+        return 1;
+    }
+
+    virtual size_t write(uint8_t c) override {
+        return write(&c, 1);
+    }
+
+    virtual size_t write(const uint8_t *buffer, size_t size) override {
+        if (!_connection || !_connection->open()) {
+            return 0;
+        }
+
+        uint32_t rate = fake::network().uploadBytesPerMs;
+        if (rate > 0) {
+            fake::advanceMicros((uint64_t)size * 1000 / rate);
+        }
+        _connection->receive(buffer, size);
+        return size;
+    }
+
+    using Print::write;
+
+    virtual int available() override {
+        return _connection ? (int)_connection->arrived() : 0;
+    }
+
+    virtual int read() override {
+        uint8_t c;
+        return read(&c, 1) == 1 ? c : -1;
+    }
+
+    virtual int read(uint8_t *buffer, size_t size) override {
+        if (!_connection || _connection->arrived() == 0) {
+            return -1;
+        }
+        return (int)_connection->read(buffer, size);
+    }
+
+    virtual int peek() override {
+        return _connection ? _connection->peek() : -1;
+    }
+
+    virtual void stop() override {
+        if (_connection) {
+            _connection->close();
+            _connection.reset();
+        }
+    }
+
+    // Still true while there is something left to read, as with rpcWiFi
+    virtual uint8_t connected() override {
+        if (!_connection) {
+            return 0;
+        }
+        return (_connection->open() && !_connection->closedByServer()) || _connection->arrived() > 0;
+    }
+
+    virtual operator bool() override {
+        return connected();
+    }
+
+protected:
+    bool _tls;
+
+private:
+    std::shared_ptr<fake::Connection> _connection;
+};
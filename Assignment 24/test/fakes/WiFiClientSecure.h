@@ -0,0 +1,22 @@
+#pragma once
+
+#include "WiFiClient.h"
+
+// A WiFiClient whose connects also pay for the TLS handshake
+class WiFiClientSecure : public WiFiClient {
+public:
+    WiFiClientSecure() {
+        _tls = true;
+    }
+
+    void setCACert(const char *certificate) {
+        _ca_cert = certificate;
+    }
+
+    void setInsecure() {
+        _ca_cert = NULL;
+    }
+
+private:
+    const char *_ca_cert = NULL;
+};
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <stdint.h>
+
+// Simulated device time. Nothing advances it on its own: tests move it on,
+// and the fakes move it by what the hardware they stand in for would take
+// (a sector erase, a TLS handshake, a byte waited for on a socket). So
+// millis() and micros() report device time, and benchmarks time the host
+// separately.
+namespace fake {
+
+inline uint64_t &clockMicros()
+{
+    static uint64_t micros = 0;
+    return micros;
+}
+
+inline void advanceMicros(uint64_t us)
+{
+    clockMicros() += us;
+}
+
+inline void advanceMillis(uint64_t ms)
+{
+    clockMicros() += ms * 1000;
+}
+
+} // namespace fake
+
+inline unsigned long micros()
+{
+    return (unsigned long)(uint32_t)fake::clockMicros();
+}
+
+inline unsigned long millis()
+{
+    return (unsigned long)(uint32_t)(fake::clockMicros() / 1000);
+}
+
+inline void delay(unsigned long ms)
+{
+    fake::advanceMillis(ms);
+}
+
+inline void delayMicroseconds(unsigned int us)
+{
+    fake::advanceMicros(us);
+}
+
+inline void yield()
+{
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include "WiFiClient.h"
+
+#define WL_IDLE_STATUS 0
+#define WL_NO_SSID_AVAIL 1
+#define WL_CONNECTED 3
+#define WL_DISCONNECTED 6
+
+// Always connected, unless a test says otherwise
+class FakeWiFi {
+public:
+    int status() {
+        return connected ? WL_CONNECTED : WL_DISCONNECTED;
+    }
+
+    int begin(const char *ssid, const char *password) {
+        return status();
+    }
+
+    bool connected = true;
+};
+
+inline FakeWiFi WiFi;
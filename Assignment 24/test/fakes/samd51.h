@@ -0,0 +1,555 @@
+#pragma once
+
+// The few SAMD51 peripherals the voice timer drives directly, simulated on
+// the host: the DMAC (descriptor chains, block suspend/resume, interrupt
+// flags), ADC1 fed with samples from a test, DAC0 collecting what is
+// played, and enough of TC4/TC5, GCLK, NVIC and the DWT to let the setup
+// code run. Register layouts are not the device's, only the names are.
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <vector>
+
+#include "fake_clock.h"
+
+namespace fake {
+
+// One bit of a register. Reads and writes go to the register word, or to
+// hook for bits with side effects (write-1-to-clear flags, enables).
+class RegisterBit {
+public:
+    typedef void (*Hook)(void *context, uint32_t value);
+
+    RegisterBit() : _reg(&_own), _mask(1), _hook(NULL), _context(NULL), _own(0) {}
+
+    void bind(uint32_t *reg, uint32_t mask, Hook hook = NULL, void *context = NULL) {
+        _reg = reg;
+        _mask = mask;
+        _hook = hook;
+        _context = context;
+    }
+
+    operator uint32_t() const {
+        return (*_reg & _mask) ? 1 : 0;
+    }
+
+    RegisterBit &operator=(uint32_t value) {
+        if (_hook != NULL) {
+            _hook(_context, value);
+        } else if (value) {
+            *_reg |= _mask;
+        } else {
+            *_reg &= ~_mask;
+        }
+        return *this;
+    }
+
+private:
+    uint32_t *_reg;
+    uint32_t _mask;
+    Hook _hook;
+    void *_context;
+    uint32_t _own;
+};
+
+struct PlainRegister {
+    uint32_t reg = 0;
+};
+
+} // namespace fake
+
+#define DMAC_CH_NUM 32
+
+#define DMAC_CTRL_DMAENABLE (1u << 1)
+#define DMAC_CTRL_LVLEN(value) ((uint32_t)(value) << 8)
+
+#define DMAC_CHCTRLA_ENABLE (1u << 1)
+#define DMAC_CHCTRLA_TRIGSRC(value) ((uint32_t)(value) << 8)
+#define DMAC_CHCTRLA_TRIGACT_BURST (2u << 20)
+#define DMAC_CHCTRLB_CMD_RESUME 2u
+
+#define DMAC_CHINTENSET_TERR (1u << 0)
+#define DMAC_CHINTENSET_TCMPL (1u << 1)
+#define DMAC_CHINTENSET_SUSP (1u << 2)
+
+#define DMAC_BTCTRL_VALID (1u << 0)
+#define DMAC_BTCTRL_BLOCKACT_NOACT (0u << 3)
+#define DMAC_BTCTRL_BLOCKACT_INT (1u << 3)
+#define DMAC_BTCTRL_BLOCKACT_SUSPEND (2u << 3)
+#define DMAC_BTCTRL_BLOCKACT_Msk (3u << 3)
+#define DMAC_BTCTRL_BEATSIZE_BYTE (0u << 8)
+#define DMAC_BTCTRL_BEATSIZE_HWORD (1u << 8)
+#define DMAC_BTCTRL_BEATSIZE_WORD (2u << 8)
+#define DMAC_BTCTRL_BEATSIZE_Msk (3u << 8)
+#define DMAC_BTCTRL_SRCINC (1u << 10)
+#define DMAC_BTCTRL_DSTINC (1u << 11)
+
+#define TC4_DMAC_ID_OVF 0x38
+#define TC5_DMAC_ID_OVF 0x3B
+#define TC4_GCLK_ID 30
+#define TC5_GCLK_ID 30
+#define TC_WAVE_WAVEGEN_MFRQ 1u
+
+#define GCLK_PCHCTRL_CHEN (1u << 6)
+#define GCLK_PCHCTRL_GEN_GCLK1 1u
+
+#define ADC_INPUTCTRL_MUXPOS_AIN12_Val 0xC
+#define ADC_CTRLA_PRESCALER(value) ((uint32_t)(value) << 8)
+#define ADC_CTRLB_RESSEL_12BIT 0u
+#define ADC_CTRLB_FREERUN (1u << 1)
+
+#define CoreDebug_DEMCR_TRCENA_Msk (1u << 24)
+#define DWT_CTRL_CYCCNTENA_Msk 1u
+
+enum IRQn_Type {
+    DMAC_0_IRQn = 31,
+    DMAC_1_IRQn,
+    DMAC_2_IRQn,
+    DMAC_3_IRQn,
+    DMAC_4_IRQn,
+    FAKE_IRQ_COUNT
+};
+
+namespace fake {
+
+struct DmacChannel {
+    struct {
+        uint32_t reg = 0;
+        struct {
+            RegisterBit ENABLE;
+        } bit;
+    } CHCTRLA;
+    PlainRegister CHCTRLB;
+    PlainRegister CHINTENSET;
+    struct {
+        uint32_t reg = 0;
+        struct {
+            RegisterBit TERR;
+            RegisterBit TCMPL;
+            RegisterBit SUSP;
+        } bit;
+    } CHINTFLAG;
+
+    // Simulation state
+    uintptr_t descriptor = 0; // Next descriptor to run, 0 for the channel's first
+    bool suspended = false;
+    uint32_t lostBlocks = 0;  // Blocks the trigger fired for while suspended
+};
+
+struct DmacRegisters {
+    PlainRegister CTRL;
+    struct {
+        uintptr_t reg = 0;
+    } BASEADDR, WRBADDR;
+    DmacChannel Channel[DMAC_CH_NUM];
+
+    DmacRegisters();
+};
+
+// Same layout as dmacdescriptor in src/dmac.h
+struct DmacDescriptor {
+    uint16_t btctrl;
+    uint16_t btcnt;
+    uintptr_t srcaddr;
+    uintptr_t dstaddr;
+    uintptr_t descaddr;
+};
+
+inline void writeChannelEnable(void *context, uint32_t value)
+{
+    DmacChannel *channel = (DmacChannel *)context;
+    if (value) {
+        // Enabling starts over from the channel's first descriptor
+        channel->CHCTRLA.reg |= DMAC_CHCTRLA_ENABLE;
+        channel->descriptor = 0;
+        channel->suspended = false;
+    } else {
+        channel->CHCTRLA.reg &= ~DMAC_CHCTRLA_ENABLE;
+    }
+}
+
+template <uint32_t Mask>
+void clearChannelFlag(void *context, uint32_t value)
+{
+    DmacChannel *channel = (DmacChannel *)context;
+    if (value) {
+        channel->CHINTFLAG.reg &= ~Mask;
+    }
+}
+
+inline DmacRegisters::DmacRegisters()
+{
+    for (DmacChannel &channel : Channel) {
+        channel.CHCTRLA.bit.ENABLE.bind(&channel.CHCTRLA.reg, DMAC_CHCTRLA_ENABLE, writeChannelEnable, &channel);
+        channel.CHINTFLAG.bit.TERR.bind(&channel.CHINTFLAG.reg, DMAC_CHINTENSET_TERR,
+                                        clearChannelFlag<DMAC_CHINTENSET_TERR>, &channel);
+        channel.CHINTFLAG.bit.TCMPL.bind(&channel.CHINTFLAG.reg, DMAC_CHINTENSET_TCMPL,
+                                         clearChannelFlag<DMAC_CHINTENSET_TCMPL>, &channel);
+        channel.CHINTFLAG.bit.SUSP.bind(&channel.CHINTFLAG.reg, DMAC_CHINTENSET_SUSP,
+                                        clearChannelFlag<DMAC_CHINTENSET_SUSP>, &channel);
+    }
+}
+
+struct AdcRegisters {
+    struct {
+        uint32_t reg = 0;
+        struct {
+            RegisterBit MUXPOS;
+        } bit;
+    } INPUTCTRL;
+    struct {
+        uint32_t reg = 0;
+        struct {
+            RegisterBit INPUTCTRL, SAMPCTRL, CTRLB, ENABLE, SWTRIG;
+        } bit;
+    } SYNCBUSY;
+    struct {
+        uint32_t reg = 0;
+        struct {
+            RegisterBit SAMPLEN;
+        } bit;
+    } SAMPCTRL;
+    struct {
+        uint32_t reg = 0;
+        struct {
+            RegisterBit ENABLE;
+        } bit;
+    } CTRLA;
+    PlainRegister CTRLB;
+    struct {
+        uint32_t reg = 0;
+        struct {
+            RegisterBit START;
+        } bit;
+    } SWTRIG;
+    struct {
+        uint16_t reg = 0;
+    } RESULT;
+};
+
+struct TcRegisters {
+    struct {
+        PlainRegister WAVE;
+        PlainRegister CC[2];
+        struct {
+            uint32_t reg = 0;
+            struct {
+                RegisterBit CC0, ENABLE;
+            } bit;
+        } SYNCBUSY;
+        struct {
+            uint32_t reg = 0;
+            struct {
+                RegisterBit ENABLE;
+            } bit;
+        } CTRLA;
+    } COUNT16;
+};
+
+struct GclkRegisters {
+    PlainRegister PCHCTRL[48];
+};
+
+struct DacRegisters {
+    struct {
+        uint16_t reg = 0;
+    } DATA[2];
+};
+
+struct DwtRegisters {
+    uint32_t CTRL = 0;
+    uint32_t CYCCNT = 0;
+};
+
+struct CoreDebugRegisters {
+    uint32_t DEMCR = 0;
+};
+
+inline DmacRegisters &dmac()
+{
+    static DmacRegisters registers;
+    return registers;
+}
+
+inline AdcRegisters &adc1()
+{
+    static AdcRegisters registers;
+    return registers;
+}
+
+inline TcRegisters &tc4()
+{
+    static TcRegisters registers;
+    return registers;
+}
+
+inline TcRegisters &tc5()
+{
+    static TcRegisters registers;
+    return registers;
+}
+
+inline GclkRegisters &gclk()
+{
+    static GclkRegisters registers;
+    return registers;
+}
+
+inline DacRegisters &dac()
+{
+    static DacRegisters registers;
+    return registers;
+}
+
+inline DwtRegisters &dwt()
+{
+    static DwtRegisters registers;
+    return registers;
+}
+
+inline CoreDebugRegisters &coreDebug()
+{
+    static CoreDebugRegisters registers;
+    return registers;
+}
+
+inline bool *nvicEnabled()
+{
+    static bool enabled[FAKE_IRQ_COUNT];
+    return enabled;
+}
+
+// Samples ADC1 converts next, as 12-bit values. Once they run out the
+// input sits at mid-scale, which Mic reads as silence.
+inline std::vector<uint16_t> &adcInput()
+{
+    static std::vector<uint16_t> input;
+    return input;
+}
+
+inline size_t &adcPosition()
+{
+    static size_t position = 0;
+    return position;
+}
+
+// Queues 16-bit PCM for ADC1, as the 12-bit readings Mic turns back into
+// exactly these samples with their low four bits cleared
+inline void feedAdc(const int16_t *pcm, size_t count)
+{
+    for (size_t i = 0; i < count; i++) {
+        adcInput().push_back((uint16_t)((pcm[i] >> 4) + 2048));
+    }
+}
+
+inline void resetAdc()
+{
+    adcInput().clear();
+    adcPosition() = 0;
+}
+
+inline uint16_t nextAdcReading()
+{
+    if (adcPosition() < adcInput().size()) {
+        return adcInput()[adcPosition()++];
+    }
+    return 2048;
+}
+
+// Everything DMA has written to DAC0's DATA register
+inline std::vector<uint16_t> &dacOutput()
+{
+    static std::vector<uint16_t> output;
+    return output;
+}
+
+// Runs the block of channel's current descriptor, as if its trigger had
+// fired once per beat, then takes the block action and calls handler if
+// the channel's interrupt is enabled. A suspended channel only moves again
+// once RESUME has been written to CHCTRLB; until then its blocks are lost,
+// and for ADC1 the samples are consumed unread. Returns false if nothing
+// was transferred.
+inline bool runDmaBlock(uint8_t index, IRQn_Type irq, void (*handler)())
+{
+    DmacChannel &channel = dmac().Channel[index];
+    if (!(channel.CHCTRLA.reg & DMAC_CHCTRLA_ENABLE)) {
+        return false;
+    }
+
+    if (channel.suspended && channel.CHCTRLB.reg == DMAC_CHCTRLB_CMD_RESUME) {
+        channel.CHCTRLB.reg = 0;
+        channel.suspended = false;
+    }
+
+    DmacDescriptor *descriptor = channel.descriptor != 0
+                                     ? (DmacDescriptor *)channel.descriptor
+                                     : (DmacDescriptor *)dmac().BASEADDR.reg + index;
+    bool fromAdc = descriptor->srcaddr == (uintptr_t)&adc1().RESULT.reg;
+
+    if (channel.suspended || !(descriptor->btctrl & DMAC_BTCTRL_VALID)) {
+        channel.lostBlocks++;
+        for (uint16_t i = 0; fromAdc && i < descriptor->btcnt; i++) {
+            nextAdcReading();
+        }
+        return false;
+    }
+
+    size_t beat = (size_t)1 << ((descriptor->btctrl & DMAC_BTCTRL_BEATSIZE_Msk) >> 8);
+    uint8_t *src = (uint8_t *)descriptor->srcaddr;
+    uint8_t *dst = (uint8_t *)descriptor->dstaddr;
+
+    // Incrementing addresses in a descriptor point just past the block
+    if (descriptor->btctrl & DMAC_BTCTRL_SRCINC) {
+        src -= beat * descriptor->btcnt;
+    }
+    if (descriptor->btctrl & DMAC_BTCTRL_DSTINC) {
+        dst -= beat * descriptor->btcnt;
+    }
+
+    for (uint16_t i = 0; i < descriptor->btcnt; i++) {
+        if (fromAdc) {
+            adc1().RESULT.reg = nextAdcReading();
+        }
+
+        uint8_t value[4];
+        memcpy(value, src, beat);
+        memcpy(dst, value, beat);
+
+        if (dst == (uint8_t *)&dac().DATA[0].reg) {
+            uint16_t sample;
+            memcpy(&sample, value, sizeof(sample));
+            dacOutput().push_back(sample);
+        }
+
+        if (descriptor->btctrl & DMAC_BTCTRL_SRCINC) {
+            src += beat;
+        }
+        if (descriptor->btctrl & DMAC_BTCTRL_DSTINC) {
+            dst += beat;
+        }
+    }
+
+    channel.descriptor = descriptor->descaddr;
+
+    uint32_t flag = DMAC_CHINTENSET_TCMPL;
+    if ((descriptor->btctrl & DMAC_BTCTRL_BLOCKACT_Msk) == DMAC_BTCTRL_BLOCKACT_SUSPEND) {
+        channel.suspended = true;
+        flag = DMAC_CHINTENSET_SUSP;
+    }
+    if (descriptor->descaddr == 0) {
+        channel.CHCTRLA.reg &= ~DMAC_CHCTRLA_ENABLE;
+    }
+
+    channel.CHINTFLAG.reg |= flag;
+    if ((channel.CHINTENSET.reg & flag) && nvicEnabled()[irq] && handler != NULL) {
+        handler();
+    }
+
+    // A RESUME written by the handler takes effect straight away
+    if (channel.suspended && channel.CHCTRLB.reg == DMAC_CHCTRLB_CMD_RESUME) {
+        channel.CHCTRLB.reg = 0;
+        channel.suspended = false;
+    }
+
+    return true;
+}
+
+// Fires a channel's trigger on the device clock, one block every blockUs:
+// run() runs the blocks that have fallen due, so a loop() that took too
+// long gets them all at once, as the DMAC would have moved on without it.
+class DmaTimeline {
+public:
+    DmaTimeline(uint8_t channel, IRQn_Type irq, void (*handler)(), uint32_t blockUs)
+        : _channel(channel), _irq(irq), _handler(handler), _blockUs(blockUs) {
+        _next = clockMicros() + blockUs;
+    }
+
+    // Returns how many blocks fell due
+    uint32_t run() {
+        uint32_t blocks = 0;
+        while (clockMicros() >= _next) {
+            runDmaBlock(_channel, _irq, _handler);
+            _next += _blockUs;
+            blocks++;
+        }
+        return blocks;
+    }
+
+    // Moves the clock on to the next block, for a loop() with nothing to do
+    void waitForBlock() {
+        if (clockMicros() < _next) {
+            clockMicros() = _next;
+        }
+    }
+
+private:
+    uint8_t _channel;
+    IRQn_Type _irq;
+    void (*_handler)();
+    uint32_t _blockUs;
+    uint64_t _next;
+};
+
+// Stops every channel. The descriptor section stays where Dmac::init()
+// put it, since that only runs once.
+inline void resetDmac()
+{
+    for (DmacChannel &channel : dmac().Channel) {
+        channel.CHCTRLA.reg = 0;
+        channel.CHCTRLB.reg = 0;
+        channel.CHINTENSET.reg = 0;
+        channel.CHINTFLAG.reg = 0;
+        channel.descriptor = 0;
+        channel.suspended = false;
+        channel.lostBlocks = 0;
+    }
+    dacOutput().clear();
+}
+
+} // namespace fake
+
+#define DMAC (&fake::dmac())
+#define ADC1 (&fake::adc1())
+#define TC4 (&fake::tc4())
+#define TC5 (&fake::tc5())
+#define GCLK (&fake::gclk())
+#define DAC (&fake::dac())
+#define DWT (&fake::dwt())
+#define CoreDebug (&fake::coreDebug())
+
+inline uint32_t &fakeSystemCoreClock()
+{
+    static uint32_t clock = 120000000;
+    return clock;
+}
+
+#define SystemCoreClock fakeSystemCoreClock()
+
+inline void NVIC_SetPriority(IRQn_Type irq, uint32_t priority)
+{
+}
+
+inline void NVIC_EnableIRQ(IRQn_Type irq)
+{
+    fake::nvicEnabled()[irq] = true;
+}
+
+inline void NVIC_DisableIRQ(IRQn_Type irq)
+{
+    fake::nvicEnabled()[irq] = false;
+}
+
+inline void __DMB()
+{
+    __sync_synchronize();
+}
+
+inline void __disable_irq()
+{
+}
+
+inline void __enable_irq()
+{
+}
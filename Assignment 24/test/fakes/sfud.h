@@ -0,0 +1,199 @@
+#pragma once
+
+// In-memory stand-in for the Wio Terminal's W25Q32 QSPI flash behind SFUD.
+// It behaves like NOR flash: erases set whole sectors to 0xFF and programs
+// can only clear bits, and every operation moves the fake clock on by
+// what the chip takes (datasheet typicals). Per-sector erase counts and
+// any attempt to program bits that weren't erased are kept for tests.
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <vector>
+
+#include "fake_clock.h"
+
+#define SFUD_W25Q32_DEVICE_INDEX 0
+
+typedef enum {
+    SFUD_SUCCESS = 0,
+    SFUD_ERR_NOT_FOUND = 1,
+    SFUD_ERR_WRITE = 2,
+    SFUD_ERR_READ = 3,
+    SFUD_ERR_TIMEOUT = 4,
+    SFUD_ERR_ADDR_OUT_OF_BOUND = 5,
+} sfud_err;
+
+typedef struct {
+    const char *name;
+    uint8_t mf_id;
+    uint8_t type_id;
+    uint8_t capacity_id;
+    uint32_t capacity;
+    uint16_t write_mode;
+    uint32_t erase_gran;
+    uint8_t erase_gran_cmd;
+} sfud_flash_chip;
+
+typedef struct {
+    const char *name;
+    size_t index;
+    sfud_flash_chip chip;
+    bool init_ok;
+} sfud_flash;
+
+namespace fake {
+
+struct FlashTiming {
+    uint32_t sectorEraseUs = 45000; // tSE, 4 KB
+    uint32_t pageProgramUs = 700;   // tPP, up to 256 bytes
+    uint32_t readNsPerByte = 25;    // Quad fast read at 40 MHz
+    uint32_t commandUs = 2;         // Opcode, address and dummy cycles
+};
+
+struct Flash {
+    static const uint32_t CAPACITY = 4 * 1024 * 1024;
+    static const uint32_t SECTOR = 4096;
+    static const uint32_t PAGE = 256;
+
+    sfud_flash device;
+    std::vector<uint8_t> memory;
+    std::vector<uint32_t> sectorErases;
+    FlashTiming timing;
+
+    uint64_t erases = 0;
+    uint64_t programs = 0;
+    uint64_t reads = 0;
+    uint64_t bytesProgrammed = 0;
+    uint64_t bytesRead = 0;
+    uint64_t programErrors = 0; // Programs that needed a 0 bit to become 1
+
+    Flash() {
+        device.name = "W25Q32JV";
+        device.index = 0;
+        device.chip = {"W25Q32JV", 0xEF, 0x40, 0x16, CAPACITY, 0, SECTOR, 0x20};
+        device.init_ok = true;
+        reset();
+    }
+
+    // Back to a freshly erased chip with no history
+    void reset() {
+        memory.assign(CAPACITY, 0xFF);
+        sectorErases.assign(CAPACITY / SECTOR, 0);
+        erases = 0;
+        programs = 0;
+        reads = 0;
+        bytesProgrammed = 0;
+        bytesRead = 0;
+        programErrors = 0;
+    }
+
+    void clearStats() {
+        sectorErases.assign(CAPACITY / SECTOR, 0);
+        erases = 0;
+        programs = 0;
+        reads = 0;
+        bytesProgrammed = 0;
+        bytesRead = 0;
+        programErrors = 0;
+    }
+};
+
+inline Flash &flash()
+{
+    static Flash flash;
+    return flash;
+}
+
+} // namespace fake
+
+inline sfud_err sfud_init(void)
+{
+    return SFUD_SUCCESS;
+}
+
+inline sfud_flash *sfud_get_device(size_t index)
+{
+    return index == 0 ? &fake::flash().device : NULL;
+}
+
+inline const sfud_flash *sfud_get_device_table(void)
+{
+    return &fake::flash().device;
+}
+
+inline sfud_err sfud_qspi_fast_read_enable(sfud_flash *flash, uint8_t data_line_width)
+{
+    return SFUD_SUCCESS;
+}
+
+inline sfud_err sfud_read(const sfud_flash *flash, uint32_t addr, size_t size, uint8_t *data)
+{
+    fake::Flash &chip = fake::flash();
+    if ((uint64_t)addr + size > fake::Flash::CAPACITY) {
+        return SFUD_ERR_ADDR_OUT_OF_BOUND;
+    }
+
+    memcpy(data, chip.memory.data() + addr, size);
+    chip.reads++;
+    chip.bytesRead += size;
+    fake::advanceMicros(chip.timing.commandUs + size * chip.timing.readNsPerByte / 1000);
+    return SFUD_SUCCESS;
+}
+
+// Erases every sector the range touches
+inline sfud_err sfud_erase(const sfud_flash *flash, uint32_t addr, size_t size)
+{
+    fake::Flash &chip = fake::flash();
+    if ((uint64_t)addr + size > fake::Flash::CAPACITY) {
+        return SFUD_ERR_ADDR_OUT_OF_BOUND;
+    }
+
+    uint32_t first = addr / fake::Flash::SECTOR;
+    uint32_t last = (addr + (size == 0 ? 1 : size) - 1) / fake::Flash::SECTOR;
+    for (uint32_t sector = first; sector <= last; sector++) {
+        memset(chip.memory.data() + sector * fake::Flash::SECTOR, 0xFF, fake::Flash::SECTOR);
+        chip.sectorErases[sector]++;
+        chip.erases++;
+        fake::advanceMicros(chip.timing.sectorEraseUs);
+    }
+    return SFUD_SUCCESS;
+}
+
+// Programs page by page, as SFUD splits writes at page boundaries
+inline sfud_err sfud_write(const sfud_flash *flash, uint32_t addr, size_t size, const uint8_t *data)
+{
+    fake::Flash &chip = fake::flash();
+    if ((uint64_t)addr + size > fake::Flash::CAPACITY) {
+        return SFUD_ERR_ADDR_OUT_OF_BOUND;
+    }
+
+    while (size > 0) {
+        size_t chunk = fake::Flash::PAGE - addr % fake::Flash::PAGE;
+        chunk = chunk < size ? chunk : size;
+
+        uint8_t *cell = chip.memory.data() + addr;
+        for (size_t i = 0; i < chunk; i++) {
+            if ((cell[i] & data[i]) != data[i]) {
+                chip.programErrors++;
+            }
+            cell[i] &= data[i];
+        }
+
+        chip.programs++;
+        chip.bytesProgrammed += chunk;
+        fake::advanceMicros(chip.timing.commandUs + chip.timing.pageProgramUs);
+
+        addr += chunk;
+        data += chunk;
+        size -= chunk;
+    }
+    return SFUD_SUCCESS;
+}
+
+inline sfud_err sfud_erase_write(const sfud_flash *flash, uint32_t addr, size_t size, const uint8_t *data)
+{
+    sfud_err result = sfud_erase(flash, addr, size);
+    return result == SFUD_SUCCESS ? sfud_write(flash, addr, size, data) : result;
+}
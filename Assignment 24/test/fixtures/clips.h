@@ -0,0 +1,166 @@
+#pragma once
+
+// Test audio with the character of what the Wio Terminal's microphone
+// records: a DC offset from the bias, hiss, and 12-bit resolution. Nothing
+// recorded ships with the repo, so the clips are synthesised the same way
+// every run: vowels are a glottal pulse train through two formant
+// resonators, and the noises are what the board picks up in a room.
+
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+#include "config.h"
+
+namespace clips {
+
+class Noise {
+public:
+    explicit Noise(uint32_t seed) : _state(seed) {}
+
+    // Roughly Gaussian with standard deviation 1
+    double next() {
+        double sum = 0;
+        for (int i = 0; i < 12; i++) {
+            _state = _state * 1664525 + 1013904223;
+            sum += (_state >> 8) / 16777216.0;
+        }
+        return sum - 6;
+    }
+
+private:
+    uint32_t _state;
+};
+
+// Two-pole resonator at frequency with the given bandwidth, both in Hz
+class Resonator {
+public:
+    Resonator(double frequency, double bandwidth) {
+        double r = exp(-M_PI * bandwidth / RATE);
+        _a1 = 2 * r * cos(2 * M_PI * frequency / RATE);
+        _a2 = -r * r;
+        _gain = 1 - r;
+    }
+
+    double next(double x) {
+        double y = _gain * x + _a1 * _y1 + _a2 * _y2;
+        _y2 = _y1;
+        _y1 = y;
+        return y;
+    }
+
+private:
+    double _a1, _a2, _gain;
+    double _y1 = 0, _y2 = 0;
+};
+
+struct Clip {
+    std::vector<double> samples;
+
+    explicit Clip(size_t count = 0) : samples(count, 0.0) {}
+
+    Clip &append(const Clip &other) {
+        samples.insert(samples.end(), other.samples.begin(), other.samples.end());
+        return *this;
+    }
+
+    Clip &add(const Clip &other) {
+        for (size_t i = 0; i < samples.size() && i < other.samples.size(); i++) {
+            samples[i] += other.samples[i];
+        }
+        return *this;
+    }
+
+    // As the ADC would hand it to convertAdcToPcm(), offset and clipped
+    // to 12 bits, then back to the 16-bit PCM Mic works with
+    std::vector<int16_t> pcm(double offset = 300) const {
+        std::vector<int16_t> out(samples.size());
+        for (size_t i = 0; i < samples.size(); i++) {
+            double value = samples[i] + offset;
+            value = value < -32768 ? -32768 : value > 32767 ? 32767 : value;
+            out[i] = (int16_t)((int32_t)floor(value) & ~0xF);
+        }
+        return out;
+    }
+};
+
+inline size_t samplesFor(uint32_t ms)
+{
+    return (size_t)RATE * ms / 1000;
+}
+
+// The mic's own hiss in a quiet room
+inline Clip roomTone(uint32_t ms, uint32_t seed = 1, double level = 60)
+{
+    Clip clip(samplesFor(ms));
+    Noise noise(seed);
+    for (double &sample : clip.samples) {
+        sample = level * noise.next();
+    }
+    return clip;
+}
+
+// Mains hum picked up by the board, with its third harmonic
+inline Clip hum(uint32_t ms, double level = 400)
+{
+    Clip clip(samplesFor(ms));
+    for (size_t i = 0; i < clip.samples.size(); i++) {
+        double t = (double)i / RATE;
+        clip.samples[i] = level * (sin(2 * M_PI * 50 * t) + 0.3 * sin(2 * M_PI * 150 * t));
+    }
+    return clip.add(roomTone(ms, 2));
+}
+
+// A fan or air conditioning close by: loud, but broadband
+inline Clip fan(uint32_t ms, double level = 1600)
+{
+    return roomTone(ms, 3, level);
+}
+
+// A sustained vowel at pitch Hz, with formants for "ah" by default and a
+// short rise and fall so it starts and stops like a syllable
+inline Clip vowel(uint32_t ms, double level = 20000, double pitch = 130,
+                  double f1 = 730, double f2 = 1090, uint32_t seed = 4)
+{
+    Clip clip(samplesFor(ms));
+    Resonator first(f1, 90);
+    Resonator second(f2, 110);
+    Noise jitter(seed);
+
+    double phase = 0;
+    size_t ramp = samplesFor(30);
+    for (size_t i = 0; i < clip.samples.size(); i++) {
+        phase += pitch * (1 + 0.01 * jitter.next()) / RATE;
+        double pulse = 0;
+        if (phase >= 1) {
+            phase -= 1;
+            pulse = 1;
+        }
+
+        double envelope = 1;
+        if (i < ramp) {
+            envelope = (double)i / ramp;
+        } else if (clip.samples.size() - i < ramp) {
+            envelope = (double)(clip.samples.size() - i) / ramp;
+        }
+
+        clip.samples[i] = envelope * level * 8 * (first.next(pulse) + 0.5 * second.next(pulse));
+    }
+    return clip.add(roomTone(ms, seed + 1));
+}
+
+// Words with short gaps between them, as in "set a timer"
+inline Clip phrase(double level = 20000)
+{
+    Clip clip;
+    clip.append(vowel(220, level, 130, 730, 1090, 10))
+        .append(roomTone(80, 11))
+        .append(vowel(160, level, 125, 270, 2290, 12))
+        .append(roomTone(120, 13))
+        .append(vowel(300, level, 120, 530, 1840, 14));
+    return clip;
+}
+
+} // namespace clips
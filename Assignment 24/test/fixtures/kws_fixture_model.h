@@ -0,0 +1,45 @@
+#pragma once
+
+// Generated by tools/export_kws_model.py from synthetic weights by tools/make_kws_fixture.py
+
+#include "ds_cnn.h"
+
+#define KWS_MODEL_AVAILABLE 1
+
+#define KWS_MODEL_CLASSES 2
+#define KWS_MODEL_KEYWORD 1
+#define KWS_MODEL_LAYER_COUNT 5
+#define KWS_MODEL_MAX_ACTIVATIONS 2000
+
+#define KWS_MODEL_INPUT_SCALE 1.0f
+#define KWS_MODEL_INPUT_ZERO_POINT 0
+#define KWS_MODEL_OUTPUT_SCALE 0.1f
+#define KWS_MODEL_OUTPUT_ZERO_POINT 0
+
+static const char *const KWS_MODEL_LABELS[KWS_MODEL_CLASSES] = {"_unknown_", "keyword"};
+
+static const int8_t kws_weights_0[] = {92, -47, -110, 55, 43, 101, 46, 123, -23, -25, -17, -47, 96, -98, -88, 37, 59, 24, -119, 56, 121, -24, -126, 48, -111, -76, -115, 25, 16, -95, -121, 108, -87, 51, -5, -31, -5, 43, -9, 43, -95, 9, -19, 114, 48, 42, 23, -104, 85, -66, -13, -94, 42, -4, -49, -35, 89, 85, 115, -121, -26, -111, 95, 26, 115, 12, 47, -107, 117, -114, 30, 48, -68, 99, -65, -112, 24, -67, 73, 76, 57, 120, 52, 72, -28, -46, -27, 90, 28, -80, -70, 41, 7, 121, -81, 55, 123, -79, 88, -106, -109, -64, 26, -79, -80, -80, -82, 27, -42, -65, 102, 104, 54, 7, -40, 107, 79, -89, -67, 110, 33, 38, 77, 46, 35, 10, 92, -63, 33, -57, -29, -96, 42, -124, -28, -116, 24, 118, -55, -5, -114, -86, -103, 67, 63, 123, -83, -65, -6, 75, -49, -116, -43, -16, -36, -72, 80, 9, 86, -23, 107, 73, 127, -33, -5, 55, -8, 78, -74, 28, -30, 10, -56, 10, 14, 107, -19, 57, -56, 106, 82, 32, 30, -36, -55, 21, -35, -41, 7, 77, -116, 25, 3, -119, 37, -13, -88, -58, 89, 61, 102, -45, -113, 21, 108, -121, -7, -94, 121, -6, 126, 7, -81, 32, 43, 63, -78, 118, -123, -104, 37, -58, -14, -22, 55, 39, 11, -11, -73, -79, -115, 80, 53, -94, 40, -31, -51, -46, -111, -38, -57, -52, 107, -88, 68, -43, -1, 71, 104, -60, -47, -12, -20, 113, -126, 43, -9, 27, -80, 108, -109, 15, -98, 52, 74, 102, -50, 34, -100, -70, 15, 61, 88, 14, 110, -52, 49, 94, 39, 55, -22, -124, -127, -36, 2, 100, 54, -31, -37, -78, -44, 86, -118, -118, 22, 72, -10, -48, 98, -124, -16, 27, -77, 41, 84, 120, -84, 111, 118, 113, -81, 12, 85, 17, 25, 54, 110, -55, 17, 64, 27, -119, 122, 37, -51, 94, 10, -94, -85, 100, -118, -91, 70, -23, -65, 47, -119, 18, -119, -5, -9, 84, 43, 113, -16, -103, -30, -37, -97, -37, 23, -75, -106, -107, -17, -67, 117, 95, 14, 5, -1, 122, -81, 21, 125, 42, 120, 19, 100, 56, -80, 77, 122, -28, -74, -52, 36, 31, -24, -108, 101, -22, 79, -34, -50, 27, -67, 120, 122, -15, 60, -14, -82, 61, 1, 95, -39, -6, 43, -51, -6, -99, 17, -67, -80, -112, -25, 47, 125, 120, -6, 35, -10, 92, -55, -115, -25, -73, -73, 36, -69, 14, 50, -105, -105, -80, 113, -5, 0, -122, 37, -116, 2, 69, -33, 14, 37, 89, -31, 101, -82, 79, -82, 61, -20, -86, -110, -53, -83, 89, -16, 1, -6, 68, 17, -42, -69, -92, -75, 86, -4, 17, -70, -80, -39, -118, -110, 125, 80, -37, 70, -19, -120, 35, 88, -116, 67, 96, -65, -47, -114, 67, -61, -57, -34, -76, 126, 74, 66, -62, 70, -43, 62, -15, 63, -51, 125, 24, -28, -69, -119, 63, 62, -7, 6, 68, 24, -87, 93, 31, 106, 15, -103, 13, -53, -99, -16, 20, -91, 61, 118, -120, 99, -51, -102, -108, 16, -83, -107, -16, -44, -24, 9, 69, 117, 107, 70, -38, -52, 37, 0, -101, -80, 41, -123, -93, -20, 32, -96, -82, 47, -79, -56, 67, 15, -119, 69, 116, -118, 75, 100, 105, -90, -97, -12, 66, 25, -29, -121, -34, 24, -120, 84, -98, -81, -13, -83, 65, 72, 100, 62, 94, 81, 87, -56, 27, 15, 70, -36, 38, 16, -36, -37, 44, -33, -23, 76, 27, -33, -86, 44, 29, 101, 70, -25, 2, -114, 122, 13, 125, 73, -20, 4, -102, -63, -104, 46, 5, -19, 55, 94, 82, 8, -62, -121, 51, 76, 70, -4, 79, -3, -59, -62, 60, -32, -51, -87, -70, 114, -3};
+static const int32_t kws_bias_0[] = {4608, 3968, -6272, -4864, 576, 6208, -4736, -7040, -2688, -3200, -576, -7872, 2944, -5056, -2176, -6784};
+static const int32_t kws_multiplier_0[] = {1378145291, 1399872807, 1182597648, 1424704254, 1818903470, 2123088692, 2042386490, 1492990732, 1142246548, 1986515735, 1123622963, 1489886801, 1499198594, 1489886801, 1365729568, 1406080669};
+static const int8_t kws_shift_0[] = {-9, -9, -9, -9, -10, -10, -10, -9, -9, -10, -9, -9, -9, -9, -9, -9};
+static const int8_t kws_weights_1[] = {-92, -66, 52, 39, 75, 82, -18, 18, -67, 23, 64, 71, 21, 16, 0, 36, -15, -79, 63, 124, 113, -107, -72, 125, -112, -61, -33, -83, 118, 74, 10, -13, 9, -114, 68, 38, -81, -102, -83, -100, 6, 84, -99, -115, 59, 85, -32, 112, 2, -62, -79, -104, 126, -125, 86, -91, -114, -108, -112, -93, 88, 105, 34, -24, 8, -113, 69, 9, -7, -8, -74, 106, -8, -52, -88, 88, 49, 116, -12, -84, -15, 87, 40, 76, 105, 127, 83, 45, 6, 19, -59, -101, 24, 101, 11, -35, -48, -9, -12, -104, -44, -60, 83, 102, -2, -100, -65, -94, -21, 122, -70, 66, 127, 15, -57, 91, -111, -20, 124, -98, 54, 7, 126, -58, -101, -108, 2, 20, 55, 85, 84, 15, -49, -26, 82, 50, -89, -76, 4, 80, -65, -123, -85, -49};
+static const int32_t kws_bias_1[] = {1408, -1920, -1024, 0, 3264, -4288, 1984, 3136, 7936, 768, -8128, 4608, 2560, 6016, 4608, 192};
+static const int32_t kws_multiplier_1[] = {1480809536, 1645343929, 1755033524, 2092539972, 1265649176, 1552529656, 1501903689, 1881598442, 1852066628, 1666438082, 1552529656, 1679094574, 1379557602, 2100977633, 1430183569, 1797221830};
+static const int8_t kws_shift_1[] = {-8, -8, -8, -8, -8, -8, -8, -8, -8, -8, -8, -8, -8, -8, -8, -8};
+static const int8_t kws_weights_2[] = {-64, 22, 73, -28, 117, 118, 15, -44, 95, -114, 84, 60, 110, 64, 33, 87, 111, -67, 120, -11, -48, -68, 64, 57, -49, -95, 118, 81, 8, -123, 39, 70, 47, 74, -66, 36, 97, 56, -91, 41, -120, -48, 69, -85, 126, -53, -43, -19, 32, -125, -108, 34, 102, 37, 94, 56, 32, 121, -68, 60, 31, 28, -62, 108, -76, 111, 124, 88, -30, -79, -69, -121, -62, -24, 98, -104, -49, -93, -78, -40, 48, -80, 11, -73, 60, 84, 60, -113, -72, -92, 95, -65, -105, -6, -83, 6, 72, -54, -8, -123, -56, 34, -79, -11, -1, -64, -125, -12, 55, 127, 7, 96, -88, 117, 50, 50, 86, 23, 60, 93, -40, 50, 87, -119, -71, -93, 121, -76, -120, -13, -22, 37, -56, 101, 106, 52, 82, 23, 57, -84, -10, 48, 42, -1, 55, 86, -92, -115, -103, -51, 66, -127, -25, 13, 93, 60, 53, -85, -64, 72, -78, -39, 74, 43, 120, -26, 80, -75, -9, 126, -26, -103, -83, -107, 115, 100, 45, 41, 59, 46, -49, 111, -69, 127, 111, -14, -15, 111, 31, -65, 27, -49, -86, -69, 89, -9, 86, -93, 77, -99, 73, 92, -88, -116, 96, -96, 62, 115, -126, 25, 28, -12, -90, -123, -112, -97, 33, 111, 82, -84, -19, -99, 39, -125, -8, 49, -100, 99, -60, 49, -48, -58, -55, -20, 98, 74, 121, 91, -19, 65, -50, -90, -87, 48, -79, 44, 52, -49, -48, -21, -119, 113, 123, 22, -120, -41};
+static const int32_t kws_bias_2[] = {-3520, 2176, -2688, -4480, 192, -4736, -3264, -4160, 1728, 3648, -4160, -7360, -3712, -1728, -1920, 1792};
+static const int32_t kws_multiplier_2[] = {1095718647, 1576297001, 1326396257, 1164921930, 1376376406, 2068409236, 1330240884, 2099166250, 1403288794, 1583986255, 1849265506, 1799285357, 1676257299, 1507093718, 1607054016, 1522472225};
+static const int8_t kws_shift_2[] = {-7, -7, -7, -7, -7, -8, -7, -8, -7, -7, -7, -7, -7, -7, -7, -7};
+static const int8_t kws_weights_4[] = {-20, -53, 19, -71, 61, -16, -69, -55, 8, 40, 39, -3, 118, 107, -120, 127, -25, 54, -80, -108, 33, -116, 71, -72, 29, -113, 94, 84, 58, -114, -26, 34};
+static const int32_t kws_bias_4[] = {0, 1077};
+static const int32_t kws_multiplier_4[] = {1276522788, 1276522788};
+static const int8_t kws_shift_4[] = {-4, -4};
+
+static const DsCnnLayer KWS_MODEL_LAYER_TABLE[KWS_MODEL_LAYER_COUNT] = {
+    {DSCNN_CONV, 10, 4, 2, 2, 4, 1, 49, 10, 1, 25, 5, 16, 0, -128, -128, 127, kws_weights_0, kws_bias_0, kws_multiplier_0, kws_shift_0},
+    {DSCNN_DEPTHWISE, 3, 3, 1, 1, 1, 1, 25, 5, 16, 25, 5, 16, 128, -128, -128, 127, kws_weights_1, kws_bias_1, kws_multiplier_1, kws_shift_1},
+    {DSCNN_CONV, 1, 1, 1, 1, 0, 0, 25, 5, 16, 25, 5, 16, 128, -128, -128, 127, kws_weights_2, kws_bias_2, kws_multiplier_2, kws_shift_2},
+    {DSCNN_AVERAGE_POOL, 25, 5, 25, 5, 0, 0, 25, 5, 16, 1, 1, 16, 128, -128, -128, 127, NULL, NULL, NULL, NULL},
+    {DSCNN_FULLY_CONNECTED, 1, 1, 1, 1, 1, 1, 1, 1, 16, 1, 1, 2, 128, 0, -128, 127, kws_weights_4, kws_bias_4, kws_multiplier_4, kws_shift_4},
+};
+static const DsCnnLayer *const KWS_MODEL_LAYERS = KWS_MODEL_LAYER_TABLE;
@@ -0,0 +1,26 @@
+#pragma once
+
+// Generated by tools/make_kws_fixture.py: inputs for kws_fixture_model.h and
+// what the TensorFlow Lite int8 reference kernels make of them
+
+#include <stdint.h>
+
+#define KWS_REPLAY_COUNT 3
+
+static const int8_t kws_replay_input_0[] = {-15, 21, -94, 1, 23, -1, 59, -74, -98, 55, 41, 31, -29, -27, -19, -48, -96, 46, -3, -19, -6, -70, -21, -83, -77, -80, 44, 30, -22, -16, 18, 23, -68, -7, -94, 39, 50, -26, 6, -76, 26, -72, 53, 42, -45, -81, 43, -19, 41, 9, -47, -63, 59, 43, -88, -28, 51, 50, 58, -87, -91, 45, -75, -71, 25, -29, -17, -25, 35, -69, 57, -67, -32, 43, -32, 1, -46, -93, -40, 46, -95, -54, 0, 48, 49, -81, -55, 60, -40, -90, -1, -78, -89, -79, -22, -58, 12, 58, -78, -81, -38, -51, 57, -95, -15, 28, 42, 9, 46, 42, -19, -70, -85, -94, 25, -33, 41, 7, -9, -61, -34, -79, 46, 7, -74, -31, -57, -39, 42, -48, -90, 11, 37, -94, -89, 26, -48, 36, -71, -94, -38, -61, -2, 50, -25, -34, -14, 38, -38, -36, -85, -10, -86, -44, -49, -59, 43, -67, -64, 55, -40, -24, -29, -37, -67, -96, 51, -64, -88, 15, -25, -9, -98, -8, -59, -17, 7, 12, -31, 13, -89, 48, 6, -16, -44, -51, -78, 35, -45, -71, -64, -89, -99, -66, -1, -94, -71, -99, 16, -2, 0, -37, 26, 42, -58, 50, -72, -53, 12, -96, 11, 49, 49, -6, -77, -60, -25, -13, -98, -75, -68, -56, -98, -64, 30, 30, -53, -39, -10, 30, -20, 14, -17, -69, -77, -36, -20, 4, -57, 15, -90, -94, 18, 50, -99, 33, -43, -33, -42, -48, 26, -76, -50, -100, -20, -60, -67, -34, 10, 36, 34, -2, -42, -12, -68, -85, 24, -58, -58, -5, 58, 36, -92, -76, 5, -1, -28, 30, -68, 35, -4, -74, -56, -33, -19, 29, 32, -90, 33, 1, 10, 19, 50, -34, 28, -42, -78, 10, -12, 33, -89, -65, 1, 43, -88, -47, -93, -62, -39, 25, 45, -56, -99, 55, 44, 30, -89, 1, 47, 42, 26, -7, 8, -36, -34, 47, -2, -73, -79, 7, -9, -73, -5, -7, -4, -99, -94, -42, -10, -50, -89, -85, -99, -50, -28, -3, 4, -72, 45, 26, -59, 11, 48, 36, 27, 11, -46, -11, 1, -1, 41, -3, -6, 38, -34, 4, 47, -33, -97, -21, 57, -49, 26, 29, -27, -87, -92, -58, 30, 46, 30, -92, 29, 29, 3, 41, -2, -70, -36, -67, -42, 40, -88, -76, -11, -14, -46, 46, -38, -34, 34, 34, 32, -96, 38, 15, 31, 44, 53, 37, 40, -74, 21, 37, 21, -5, 24, 50, 22, -43, 18, 33, 6, -8, -24, -62, -34, -100, -86, 32, -41, 49, -24, -50, -94, -26, -38, -28, 19, 5, 42, -15, -42, -19, 60, -74, -27, -30, 51, -31, -41, -47, -11, 16, -89, 59, -99, -22, 59, 32, -62, 24, -39, 3, -32, -50, 15, -52, -75, 48, -16, -33, 46, -75, 4, 60, 0, -14, -29, -81, 54, 54, 0, 30, -42, 17, 35, 34, -97, -75};
+static const int8_t kws_replay_output_0[] = {-48, 75};
+static const int8_t kws_replay_input_1[] = {25, 17, -60, 54, 29, 53, -54, 28, 59, -68, -99, -7, -28, -81, -32, -59, 18, 34, -45, -81, 16, -24, -32, 48, -77, -74, -19, 56, -74, -27, 19, -73, -84, -19, -16, 54, -71, -11, 33, -19, -20, -100, -22, -76, 45, -6, -35, -94, -12, 1, 13, -52, 47, 58, -40, -10, 60, -97, -48, -37, -100, 55, 29, 31, -49, 22, 58, -23, -62, -4, -10, -55, -10, -54, -57, -6, 33, -17, -13, -54, -54, 28, -74, -44, 19, -70, 14, 1, -95, -55, -13, 3, 53, 24, 17, 58, -100, 43, -86, -67, -4, 41, 39, -2, -51, -17, -95, -81, -49, 22, 27, -68, 19, -18, -35, -78, 25, -98, -29, -45, -81, -17, 2, -74, 51, -86, -89, 51, -49, -95, 45, -41, -99, 50, -2, 60, 59, 29, 34, 30, -95, 23, -89, -5, 57, -83, -46, -76, -76, -84, -38, -35, 60, 39, -76, -36, 53, -96, -49, -5, -38, -65, 14, -76, -90, 0, -36, -21, -12, 38, -22, -84, -36, -23, -1, -49, -45, -40, -86, -40, 36, -88, -75, -86, 23, -82, 2, 1, -49, -62, 51, -19, -61, -80, 53, -7, -4, 44, -98, -44, 26, -45, -71, 39, 27, 20, -47, 38, -36, -18, -97, -83, 0, 3, -62, -90, 56, -45, -36, -23, 10, -61, -33, 50, -18, -47, -91, 58, 48, 10, -33, -6, 42, -9, -20, 5, -43, -58, -40, -47, -41, -66, -99, 36, -21, -16, 37, 39, 55, 42, -21, 7, -36, -87, 31, 24, -75, 32, -55, -58, -68, -97, -50, -33, 24, -29, 21, -12, 27, 45, 0, 43, 7, 50, -12, -40, 1, 30, -38, 46, -75, 19, 58, -98, -18, 7, -65, 42, -53, -48, -81, 40, 24, 48, -10, -65, -20, 32, 56, 46, 54, 31, 35, 11, -38, 47, 57, -97, -90, 60, -43, 11, 14, 28, -100, 16, 13, 30, 58, 31, -39, -26, -54, -15, 34, 27, -64, -75, 49, -13, 49, 51, -55, -57, -80, -15, 33, -67, 48, 11, 60, -9, -28, 46, -57, -56, -30, -89, 19, 28, -22, -75, -25, 42, 16, 39, -82, -91, -35, 56, 46, 12, -36, 43, -58, -81, -53, -73, -59, -1, -24, 43, 27, -87, 25, -84, 39, -39, -11, -28, -96, -13, 11, -31, -18, -92, -56, -92, -77, -67, 22, -22, 39, -45, -2, -39, 17, 23, 8, -30, -15, -82, -47, -93, -92, -30, 2, -3, 4, -69, -50, 0, 54, -34, -59, 28, -33, -10, -47, 46, 11, -33, -41, 13, -16, -17, -24, 40, -67, 26, 7, 21, -35, 19, 27, 25, -72, -7, 29, -59, -68, -78, -32, -80, 5, 11, -91, -16, -98, 27, -70, -85, 60, -6, -71, 31, 26, 32, 6, -22, -62, 55, -56, 48, 59, -97, 0, -47, -86, -75, 28, -31, 37, -12, 59, -65, 49, 36, 20, -31, -86, 42, 60, -8, 36, -6, 42, -24, 50, -68};
+static const int8_t kws_replay_output_1[] = {-58, 75};
+static const int8_t kws_replay_input_2[] = {-14, -84, -100, 52, -78, 11, -14, -5, 40, -16, -5, -15, -38, -64, -30, 23, -75, 1, 47, -12, -22, -43, -47, -26, -22, -20, -68, 24, 5, -15, -29, 32, -17, -92, -81, 49, -13, 37, -99, -13, 32, -37, 54, -83, 9, -39, 24, -42, -74, -91, 23, -45, 35, -72, -97, -8, 52, 4, -71, -33, -16, -52, 24, -12, 28, -97, 28, -50, -33, 31, -65, 20, 46, -5, -99, 53, -43, -46, 41, -63, -12, -96, 53, 59, -58, -39, -35, -85, -9, 10, -25, -60, -56, -56, -69, -24, 40, -75, 0, -39, 5, -99, 52, -18, -12, 56, -83, 40, -67, -32, 30, -63, -41, -78, 15, -85, -2, -19, -48, -100, -88, 40, -69, 3, 39, -28, -83, -48, -90, -45, -7, -61, -74, -17, 0, 5, -50, 57, 16, 9, -18, -80, -38, -79, -52, -94, -60, 33, 2, 13, -16, 12, -82, -98, 21, 14, -42, -55, -45, 27, -49, 34, -5, -61, -79, -32, 33, 14, 10, -42, -11, -55, -44, -84, 49, -46, -25, 31, -92, -70, -85, 24, 12, -34, -74, -70, -49, -7, -98, -85, -33, -74, -35, -45, 7, -55, 60, -24, -72, 18, -90, 11, -73, -8, -64, -29, -82, -66, -40, -59, -85, -85, 16, -63, -76, 25, -100, -40, -2, 25, -71, 4, 14, -91, 15, 1, 21, -86, -2, 16, -21, -19, -88, -76, -5, -77, -68, -75, -90, -33, -65, 2, -64, 54, 43, -64, 24, -58, -9, -73, -67, -19, 15, -53, -53, 8, -24, 43, -7, 51, 15, -61, -7, -53, -22, 42, -84, 9, -88, 7, -36, -62, 1, -11, -30, -87, 49, -64, -94, 30, -89, 58, 37, 59, -6, -28, 19, -20, -19, -35, 28, 7, -38, 24, -81, 32, -91, -71, -89, -26, -19, 55, -33, 41, -60, 17, 57, 4, -20, -92, 14, -95, 44, -3, -26, 44, 48, 21, 59, 5, -23, -21, 25, 49, 16, -44, -35, 46, 13, -47, -22, 52, -57, -80, -12, -22, 38, -50, -22, -43, -14, 33, 32, 32, 15, -58, -20, -78, -53, 53, 27, 39, -40, -11, -55, -48, -97, -94, -39, -71, 51, -19, -80, -69, -59, 29, 13, -61, 37, 37, 49, -28, 10, -45, -100, 15, -43, -13, -57, -23, -78, -42, 3, -71, 48, 28, -49, 47, 8, 40, -68, -35, 31, -35, 50, 55, -64, 18, 29, 39, 23, 1, 6, 17, 28, -88, 26, -29, 50, 42, 42, -3, -100, -38, -24, -62, -63, -83, -42, -42, 55, 40, -2, -91, -53, -33, -36, 28, -43, -16, -8, -88, -18, -53, 6, -78, 28, -77, 5, 39, 16, -51, 10, 54, -13, 58, 6, -57, -22, -77, -78, -79, -20, -83, -98, -78, -71, -31, 41, -65, -99, -56, -11, -70, -100, -96, -50, -13, 33, 2, 13, -60, -54, -32, -71, -48, -54, -13, -52, -16, 0, -2, -27, -55, -63, -7, -96, -30, 44, 42};
+static const int8_t kws_replay_output_2[] = {-60, 76};
+
+// Every layer's output for input 0
+static const int8_t kws_replay_layer_0[] = {-128, -112, -95, -128, -128, -128, -128, -109, -128, -116, -119, -128, -98, -128, -128, -128, -84, -128, -128, -127, -128, -128, -128, -128, -122, -117, -110, -78, -128, -88, -128, -119, -86, -128, -63, -128, -124, -119, -128, -128, -128, -128, -106, -111, -128, -110, -128, -128, -111, -87, -128, -101, -123, -117, -128, -128, -128, -103, -114, -128, -88, -128, -128, -122, -110, -128, -128, -128, -128, -122, -128, -115, -121, -128, -122, -104, -128, -109, -115, -128, -94, -128, -128, -128, -120, -76, -113, -128, -115, -128, -128, -85, -106, -116, -128, -128, -128, -128, -128, -104, -120, -103, -128, -128, -128, -120, -121, -128, -128, -128, -128, -112, -82, -112, -128, -125, -128, -118, -128, -128, -111, -109, -110, -70, -128, -128, -128, -128, -116, -128, -128, -128, -123, -116, -128, -116, -110, -123, -128, -128, -128, -128, -81, -112, -90, -119, -128, -103, -113, -128, -128, -111, -128, -128, -128, -128, -107, -128, -126, -107, -114, -128, -128, -92, -117, -114, -128, -128, -89, -128, -128, -128, -128, -108, -120, -128, -128, -122, -127, -128, -128, -116, -128, -128, -95, -128, -128, -118, -128, -128, -113, -128, -84, -115, -128, -116, -122, -127, -128, -128, -128, -128, -128, -117, -128, -53, -128, -128, -114, -128, -128, -128, -106, -106, -128, -128, -101, -126, -125, -81, -118, -128, -61, -128, -115, -128, -113, -128, -128, -104, -91, -118, -105, -128, -128, -128, -128, -128, -128, -128, -108, -128, -124, -128, -128, -120, -128, -74, -110, -111, -128, -119, -128, -128, -125, -128, -128, -125, -128, -128, -128, -87, -128, -128, -128, -128, -67, -91, -90, -77, -128, -128, -69, -121, -128, -127, -128, -82, -120, -120, -128, -112, -128, -128, -109, -128, -128, -128, -128, -128, -128, -128, -118, -128, -128, -128, -125, -128, -108, -101, -128, -85, -128, -128, -90, -106, -116, -128, -128, -98, -109, -128, -110, -128, -103, -91, -128, -126, -128, -128, -86, -128, -86, -128, -128, -112, -128, -128, -128, -128, -108, -99, -128, -128, -128, -112, -111, -114, -128, -72, -128, -116, -106, -128, -128, -128, -128, -97, -122, -77, -127, -128, -74, -128, -128, -112, -121, -78, -128, -128, -128, -128, -128, -128, -123, -125, -128, -92, -128, -123, -114, -125, -128, -128, -128, -98, -128, -102, -128, -128, -121, -128, -107, -119, -90, -125, -128, -125, -120, -109, -128, -112, -128, -128, -128, -121, -128, -117, -128, -119, -85, -128, -118, -128, -128, -128, -107, -128, -119, -128, -119, -113, -128, -128, -128, -128, -83, -128, -128, -56, -123, -73, -128, -96, -120, -128, -128, -128, -128, -109, -128, -125, -128, -117, -121, -128, -128, -106, -100, -128, -95, -128, -98, -124, -128, -128, -128, -128, -128, -128, -128, -128, -128, -117, -128, -128, -128, -128, -120, -43, -110, -88, -115, -128, -70, -91, -127, -94, -121, -120, -128, -106, -128, -103, -128, -128, -121, -128, -125, -128, -101, -119, -128, -106, -128, -104, -128, -128, -95, -128, -105, -92, -128, -106, -128, -128, -128, -120, -128, -127, -120, -109, -128, -128, -93, -128, -107, -101, -128, -128, -128, -81, -128, -128, -71, -128, -120, -92, -128, -117, -128, -128, -128, -128, -128, -128, -128, -128, -128, -124, -128, -128, -125, -128, -128, -128, -99, -128, -79, -117, -119, -82, -128, -113, -77, -128, -128, -128, -128, -58, -119, -128, -112, -128, -123, -94, -128, -117, -128, -128, -127, -128, -128, -127, -128, -83, -128, -128, -116, -128, -128, -93, -128, -109, -128, -128, -128, -99, -107, -128, -128, -109, -128, -128, -128, -128, -94, -80, -126, -128, -128, -125, -79, -122, -125, -109, -128, -128, -128, -128, -121, -128, -128, -91, -100, -92, -128, -128, -120, -128, -115, -103, -113, -126, -128, -128, -128, -128, -128, -128, -86, -128, -128, -126, -107, -123, -97, -128, -118, -128, -128, -128, -110, -120, -103, -128, -128, -128, -128, -105, -93, -111, -128, -123, -128, -120, -128, -128, -128, -121, -71, -124, -128, -128, -128, -119, -123, -90, -128, -97, -128, -98, -127, -128, -108, -128, -128, -92, -128, -125, -116, -128, -108, -128, -128, -112, -117, -73, -112, -128, -98, -128, -102, -128, -128, -68, -128, -128, -126, -127, -128, -128, -128, -39, -128, -128, -101, -128, -111, -128, -128, -128, -128, -128, -128, -128, -109, -128, -128, -98, -128, -128, -128, -128, -128, -107, -128, -128, -128, -128, -128, -103, -126, -110, -128, -112, -128, -125, -128, -128, -126, -80, -115, -115, -128, -128, -128, -107, -128, -45, -128, -127, -128, -128, -123, -128, -128, -128, -77, -118, -128, -128, -94, -121, -121, -128, -128, -101, -128, -128, -128, -128, -111, -122, -123, -103, -128, -128, -128, -128, -128, -100, -128, -128, -128, -128, -75, -128, -128, -98, -128, -86, -128, -128, -71, -128, -112, -109, -126, -109, -127, -120, -125, -128, -126, -125, -100, -80, -128, -128, -117, -112, -128, -101, -128, -103, -128, -128, -96, -128, -123, -128, -103, -128, -98, -128, -103, -125, -128, -128, -128, -83, -128, -128, -127, -124, -106, -73, -114, -106, -114, -114, -112, -105, -119, -128, -128, -80, -128, -128, -128, -128, -119, -128, -128, -128, -128, -128, -128, -124, -119, -128, -128, -120, -128, -123, -128, -128, -128, -120, -90, -128, -128, -128, -109, -119, -128, -118, -128, -97, -103, -128, -114, -128, -98, -128, -128, -99, -128, -128, -128, -128, -128, -128, -128, -102, -128, -126, -89, -128, -120, -80, -128, -60, -128, -128, -112, -128, -128, -128, -119, -88, -128, -128, -120, -128, -67, -96, -128, -66, -128, -105, -128, -104, -128, -104, -128, -84, -128, -128, -111, -128, -113, -128, -128, -128, -123, -128, -128, -100, -128, -121, -128, -127, -119, -128, -124, -128, -80, -111, -110, -107, -128, -121, -88, -128, -121, -124, -123, -128, -128, -104, -85, -128, -128, -128, -128, -124, -96, -128, -97, -128, -128, -78, -127, -128, -128, -128, -116, -128, -118, -128, -78, -117, -128, -121, -108, -69, -124, -78, -128, -122, -126, -119, -96, -128, -128, -128, -128, -128, -128, -128, -128, -128, -113, -128, -128, -124, -128, -128, -120, -128, -111, -92, -128, -68, -128, -128, -128, -98, -110, -92, -128, -113, -128, -117, -128, -128, -105, -128, -122, -95, -128, -128, -106, -116, -128, -128, -128, -125, -128, -128, -128, -126, -97, -54, -93, -119, -121, -125, -125, -128, -124, -128, -128, -107, -126, -127, -119, -120, -126, -128, -96, -128, -116, -128, -69, -78, -128, -121, -128, -105, -128, -104, -119, -128, -128, -92, -128, -120, -128, -99, -128, -128, -128, -87, -128, -118, -102, -128, -118, -128, -86, -100, -105, -124, -128, -124, -113, -97, -128, -100, -128, -69, -128, -102, -93, -128, -128, -128, -128, -128, -128, -128, -128, -128, -128, -128, -121, -128, -128, -128, -117, -127, -117, -107, -126, -94, -128, -128, -110, -128, -128, -128, -128, -100, -128, -128, -97, -128, -102, -91, -128, -108, -128, -128, -121, -121, -128, -128, -128, -128, -115, -128, -97, -128, -100, -128, -104, -119, -108, -113, -128, -128, -128, -128, -128, -128, -128, -126, -100, -128, -108, -90, -128, -77, -128, -128, -76, -116, -123, -128, -121, -105, -128, -128, -126, -128, -105, -107, -111, -71, -128, -128, -113, -128, -128, -128, -125, -123, -128, -128, -103, -128, -128, -128, -100, -126, -96, -128, -111, -125, -128, -115, -100, -114, -128, -116, -102, -128, -128, -128, -123, -120, -128, -128, -128, -105, -113, -120, -128, -105, -119, -128, -90, -128, -128, -128, -124, -88, -128, -128, -117, -128, -128, -128, -128, -118, -128, -120, -118, -128, -81, -107, -128, -128, -128, -115, -118, -107, -128, -117, -128, -96, -128, -117, -113, -124, -124, -128, -128, -128, -128, -128, -111, -128, -128, -128, -128, -128, -128, -128, -100, -128, -107, -94, -128, -94, -117, -128, -54, -108, -103, -128, -128, -128, -105, -128, -128, -128, -108, -113, -98, -116, -128, -128, -93, -128, -128, -128, -124, -128, -128, -124, -109, -128, -128, -108, -107, -121, -128, -128, -128, -128, -119, -115, -128, -128, -128, -128, -128, -128, -122, -100, -128, -128, -128, -128, -69, -76, -91, -89, -128, -90, -128, -109, -128, -125, -128, -118, -71, -80, -128, -128, -128, -128, -128, -128, -120, -128, -128, -128, -128, -128, -128, -117, -108, -128, -128, -128, -113, -103, -128, -119, -128, -101, -128, -81, -114, -118, -128, -128, -128, -128, -128, -128, -128, -128, -128, -128, -128, -128, -128, -128, -104, -128, -91, -117, -82, -106, -123, -128, -114, -128, -128, -128, -128, -96, -128, -106, -128, -121, -114, -128, -128, -128, -93, -128, -80, -106, -128, -96, -128, -77, -94, -128, -128, -128, -114, -128, -128, -128, -128, -128, -116, -123, -121, -128, -128, -128, -128, -128, -83, -128, -128, -128, -128, -120, -100, -128, -98, -128, -125, -104, -128, -128, -113, -115, -111, -128, -128, -108, -123, -95, -96, -128, -121, -111, -109, -128, -123, -128, -128, -128, -128, -128, -115, -128, -112, -112, -118, -128, -128, -126, -128, -126, -128, -128, -128, -128, -117, -128, -106, -88, -128, -72, -128, -122, -128, -121, -108, -97, -128, -110, -116, -108, -128, -128, -109, -128, -120, -91, -128, -128, -121, -128, -127, -128, -128, -128, -128, -117, -105, -128, -87, -69, -128, -93, -128, -128, -108, -128, -128, -128, -113, -88, -110, -128, -128, -126, -96, -128, -128, -128, -128, -125, -118, -128, -128, -120, -128, -94, -112, -83, -128, -128, -128, -120, -128, -128, -126, -128, -128, -88, -119, -110, -128, -128, -128, -126, -128, -105, -124, -128, -93, -128, -128, -104, -111, -78, -128, -116, -128, -97, -128, -128, -124, -123, -128, -123, -79, -128, -125, -99, -128, -128, -128, -121, -106, -112, -128, -125, -128, -128, -128, -112, -115, -128, -128, -128, -120, -120, -128, -121, -128, -128, -128, -128, -128, -126, -125, -119, -122, -128, -111, -106, -118, -128, -128, -80, -113, -128, -128, -128, -89, -127, -128, -128, -122, -128, -97, -117, -126, -98, -128, -112, -128, -83, -128, -128, -109, -128, -128, -121, -128, -128, -111, -109, -114, -127, -94, -128, -114, -128, -128, -128, -128, -128, -109, -128, -90, -119, -109, -128, -59, -125, -128, -128, -128, -128, -128, -128, -94, -128, -120, -128, -128, -79, -101, -121, -128, -85, -128, -128, -128, -77, -128, -128, -128, -125, -126, -128, -114, -128, -128, -128, -128, -128, -116, -128, -128, -105, -121, -128, -128, -128, -94, -66, -128, -84, -128, -128, -128, -128, -123, -107, -120, -128, -128, -128, -108, -128, -111, -121, -128, -79, -128, -128, -77, -125, -128, -128, -128, -69, -128, -128, -120, -112, -101, -72, -102, -71, -128, -128, -128, -128, -128, -128, -128, -104, -128, -128, -127, -127, -118, -92, -106, -128, -128, -128, -100, -106, -128, -128, -125, -111, -128, -128, -128, -128, -128, -128, -128, -128, -128, -118, -100, -128, -128, -113, -128, -125, -128, -128, -128, -128, -106, -123, -118, -128, -115, -124, -125, -115, -115, -110, -126, -118, -128, -128, -122, -109, -128, -128, -128, -128, -128, -128, -65, -102, -128, -77, -101, -128, -127, -128, -93, -128, -128, -118, -128, -91, -105, -128, -116, -128, -128, -128, -93, -103, -128, -128, -108, -128, -128, -128, -128, -128, -100, -128, -128, -108, -128, -108, -128, -128, -128, -128, -125, -127, -128, -128, -117, -128, -125, -126, -128, -117, -128, -114, -128, -109, -128, -111, -128, -128, -128, -128, -128, -128, -128, -128, -128, -128, -128, -126, -128, -128, -128, -128, -115, -128, -90, -94, -100, -120, -125, -128, -104, -128, -128, -128, -128, -108, -128, -98, -128, -128, -128, -128, -103, -128, -118, -128, -128, -128, -128, -128, -128, -128, -124, -113, -104, -128, -117, -85, -128, -99, -128, -128, -128, -107, -125, -128, -126, -113, -127, -128, -128, -128, -128, -128, -117, -128, -100, -128, -128, -75, -115, -128, -128, -113, -128, -121, -128, -128, -128, -128, -122, -127, -128, -128, -128, -121, -128, -128, -128, -108, -128, -117, -128, -128, -128, -112, -103, -115, -128, -128, -119, -82, -120, -125, -128, -123, -128, -128, -128, -115, -128, -128, -95, -128, -128, -128, -92, -128, -125, -128, -128, -128, -128, -122, -128, -127, -128, -128, -108, -128, -114, -128};
+static const int8_t kws_replay_layer_1[] = {-114, -128, -124, -126, -123, -128, -117, -110, -99, -128, -128, -128, -123, -95, -116, -128, -123, -128, -128, -119, -122, -128, -119, -123, -107, -128, -128, -104, -116, -75, -116, -128, -106, -122, -117, -128, -121, -128, -123, -115, -106, -128, -128, -128, -119, -81, -126, -128, -121, -128, -128, -127, -122, -128, -123, -116, -98, -128, -128, -128, -120, -90, -116, -128, -112, -128, -128, -128, -123, -128, -123, -114, -102, -128, -128, -107, -118, -97, -125, -123, -118, -128, -124, -108, -121, -128, -126, -109, -104, -125, -128, -117, -110, -95, -119, -126, -122, -128, -112, -128, -121, -128, -119, -116, -102, -127, -128, -128, -115, -109, -117, -128, -119, -128, -118, -128, -121, -128, -123, -115, -111, -124, -128, -85, -117, -128, -128, -127, -128, -128, -116, -114, -121, -128, -114, -113, -110, -128, -128, -128, -111, -63, -118, -128, -126, -128, -128, -123, -121, -128, -110, -113, -107, -126, -128, -128, -117, -100, -124, -128, -118, -128, -128, -123, -120, -128, -126, -128, -103, -123, -128, -120, -121, -117, -116, -122, -127, -128, -128, -127, -112, -128, -122, -97, -120, -128, -128, -128, -128, -88, -116, -128, -105, -128, -128, -122, -116, -128, -120, -124, -120, -127, -128, -128, -128, -68, -117, -120, -128, -128, -126, -128, -123, -128, -108, -114, -117, -128, -128, -88, -118, -94, -117, -120, -115, -128, -128, -116, -110, -128, -124, -106, -113, -126, -128, -128, -113, -86, -110, -126, -107, -128, -128, -108, -118, -128, -118, -98, -116, -128, -128, -124, -120, -104, -117, -126, -120, -128, -128, -100, -120, -128, -113, -128, -128, -128, -128, -127, -118, -79, -115, -128, -108, -128, -127, -128, -122, -128, -119, -109, -108, -128, -128, -128, -112, -24, -126, -126, -128, -128, -128, -128, -115, -128, -125, -128, -111, -128, -128, -126, -116, -84, -114, -120, -114, -128, -126, -128, -116, -128, -128, -108, -118, -128, -128, -103, -121, -91, -120, -125, -103, -128, -123, -108, -121, -128, -110, -89, -109, -128, -128, -128, -116, -78, -116, -128, -119, -128, -128, -96, -120, -128, -118, -127, -114, -120, -128, -125, -106, -75, -116, -128, -128, -128, -128, -128, -123, -128, -109, -98, -95, -127, -128, -104, -115, -76, -118, -128, -128, -128, -126, -128, -115, -128, -121, -100, -102, -128, -128, -128, -124, -103, -117, -128, -105, -128, -128, -117, -121, -128, -126, -128, -109, -128, -128, -128, -123, -78, -117, -128, -117, -128, -121, -91, -120, -128, -128, -112, -106, -126, -128, -128, -121, -90, -116, -128, -128, -128, -111, -105, -125, -128, -116, -104, -98, -126, -128, -128, -119, -71, -116, -110, -128, -128, -128, -128, -120, -128, -128, -128, -114, -119, -128, -128, -119, -100, -117, -118, -128, -128, -128, -114, -121, -128, -114, -103, -113, -128, -128, -88, -119, -108, -116, -119, -107, -128, -128, -125, -119, -128, -120, -101, -99, -128, -128, -128, -117, -69, -115, -123, -124, -127, -124, -116, -119, -128, -127, -128, -102, -126, -128, -111, -122, -97, -116, -128, -128, -128, -124, -102, -117, -128, -128, -102, -121, -126, -128, -125, -127, -99, -116, -128, -117, -128, -115, -110, -118, -128, -128, -111, -127, -126, -128, -128, -128, -88, -117, -128, -125, -128, -128, -122, -124, -128, -122, -128, -115, -121, -128, -128, -126, -52, -116, -128, -119, -128, -128, -122, -122, -128, -124, -108, -110, -128, -128, -89, -119, -79, -116, -127, -113, -121, -128, -114, -122, -128, -122, -117, -119, -126, -128, -128, -121, -92, -119, -110, -128, -128, -114, -109, -121, -128, -119, -121, -128, -128, -128, -128, -120, -112, -116, -128, -117, -128, -123, -127, -117, -128, -117, -113, -112, -126, -128, -126, -114, -97, -118, -117, -125, -128, -111, -128, -117, -128, -121, -117, -109, -125, -128, -128, -108, -46, -116, -128, -126, -128, -128, -128, -116, -128, -124, -117, -115, -127, -128, -124, -112, -99, -116, -128, -124, -128, -127, -107, -120, -128, -122, -118, -107, -127, -128, -128, -128, -109, -116, -128, -119, -128, -125, -100, -118, -124, -119, -116, -103, -128, -128, -128, -128, -77, -116, -128, -114, -128, -126, -128, -123, -118, -126, -117, -128, -126, -128, -117, -111, -92, -115, -126, -128, -128, -115, -109, -115, -128, -119, -116, -106, -124, -128, -119, -112, -107, -116, -119, -108, -128, -122, -128, -116, -128, -122, -120, -118, -127, -128, -117, -126, -105, -116, -128, -118, -128, -128, -87, -120, -128, -123, -116, -95, -128, -128, -101, -126, -105, -120, -128, -124, -128, -128, -125, -123, -128, -126, -118, -108, -125, -128, -128, -117, -74, -121, -125, -123, -128, -128, -128, -118, -128, -126, -116, -117, -127, -128, -128, -117, -46, -119, -124, -128, -128, -128, -119, -118, -128, -118, -118, -124, -126, -128, -117, -128, -68, -116, -127, -117, -128, -124, -128, -121, -128, -114, -113, -125, -126, -128, -128, -120, -79, -116, -127, -123, -128, -128, -107, -121, -128, -123, -117, -97, -125, -128, -128, -106, -128, -117, -128, -118, -128, -128, -95, -123, -128, -123, -116, -119, -126, -128, -110, -98, -77, -115, -128, -127, -128, -127, -103, -121, -128, -121, -116, -100, -127, -128, -128, -115, -56, -115, -125, -126, -128, -125, -116, -121, -128, -114, -114, -128, -126, -128, -122, -117, -75, -124, -127, -112, -128, -128, -116, -121, -128, -126, -123, -107, -126, -128, -115, -106, -68, -116, -126, -111, -124, -128, -95, -119, -128, -122, -115, -122, -125, -128, -128, -125, -48, -116, -124, -124, -128, -126, -120, -121, -128, -122, -121, -120, -126, -128, -124, -119, -67, -116, -128, -128, -128, -126, -128, -118, -128, -120, -114, -104, -125, -128, -126, -115, -111, -116, -128, -126, -128, -128, -122, -119, -128, -128, -115, -107, -126, -128, -104, -115, -75, -116, -128, -117, -128, -128, -128, -121, -128, -125, -104, -109, -126, -128, -128, -125, -75, -117, -128, -114, -106, -128, -111, -122, -128, -121, -111, -117, -126, -128, -128, -124, -65, -116, -126, -104, -128, -128, -128, -118, -128, -117, -122, -119, -128, -128, -122, -116, -61, -119, -128, -128, -128, -127, -112, -119, -128, -115, -106, -128, -126, -128, -119, -124, -53, -116, -116, -119, -128, -128, -126, -122, -128, -118, -128, -106, -126, -128, -128, -115, -70, -118, -127, -127, -128, -128, -128, -121, -128, -123, -101, -117, -126, -128, -94, -116, -99, -115, -127, -120, -128, -128, -95, -120, -128, -121, -116, -109, -127, -128, -128, -107, -111, -121, -128, -128, -128, -128, -85, -120, -128, -112, -105, -122, -128, -128, -127, -117, -98, -115, -128, -123, -128, -122, -109, -121, -128, -125, -125, -110, -126, -128, -127, -122, -116, -120, -128, -103, -128, -126, -126, -121, -128, -116, -102, -115, -125, -128, -128, -118, -75, -124, -127, -127, -128, -128, -128, -122, -128, -123, -125, -110, -126, -128, -128, -119, -60, -116, -127, -117, -128, -126, -122, -128, -128, -118, -128, -111, -127, -128, -117, -113, -112, -115, -118, -128, -128, -128, -121, -123, -128, -128, -101, -115, -125, -128, -128, -115, -83, -117, -128, -128, -128, -128, -106, -119, -128, -123, -125, -122, -127, -128, -113, -109, -37, -114, -124, -120, -128, -128, -105, -121, -128, -124, -108, -128, -125, -128, -118, -116, -63, -118, -124, -123, -128, -128, -128, -117, -128, -123, -112, -110, -127, -128, -128, -114, -86, -117, -127, -94, -128, -128, -125, -121, -128, -116, -112, -118, -126, -128, -121, -128, -86, -118, -122, -127, -128, -127, -128, -113, -128, -122, -122, -127, -126, -128, -127, -120, -61, -115, -128, -121, -125, -126, -121, -122, -128, -121, -107, -128, -126, -128, -128, -127, -75, -116, -128, -106, -128, -128, -119, -120, -128, -123, -122, -112, -126, -128, -128, -128, -92, -118, -128, -128, -128, -128, -128, -121, -128, -123, -114, -118, -128, -128, -105, -120, -64, -116, -127, -120, -128, -123, -118, -112, -128, -128, -127, -115, -125, -128, -113, -122, -92, -117, -127, -127, -128, -128, -122, -116, -128, -119, -98, -118, -128, -128, -128, -123, -94, -124, -123, -115, -126, -122, -112, -119, -128, -115, -123, -121, -124, -128, -124, -116, -71, -117, -128, -109, -128, -124, -116, -119, -128, -111, -97, -122, -128, -128, -128, -113, -76, -128, -126, -128, -128, -128, -128, -121, -128, -115, -123, -107, -126, -128, -122, -107, -79, -116, -127, -115, -128, -122, -119, -122, -128, -122, -106, -98, -127, -128, -128, -111, -112, -118, -127, -128, -128, -128, -128, -121, -128, -120, -122, -118, -128, -128, -119, -112, -110, -121, -128, -128, -128, -117, -105, -120, -128, -112, -112, -113, -126, -128, -128, -104, -113, -118, -127, -125, -128, -125, -97, -122, -128, -125, -121, -107, -128, -128, -111, -104, -94, -112, -126, -128, -128, -125, -128, -118, -128, -112, -113, -98, -125, -128, -125, -113, -96, -117, -127, -116, -128, -128, -122, -123, -128, -116, -85, -107, -127, -128, -110, -113, -77, -118, -127, -126, -128, -125, -128, -122, -128, -110, -128, -120, -128, -128, -128, -111, -57, -116, -128, -122, -128, -128, -111, -119, -128, -124, -90, -108, -128, -128, -102, -128, -58, -115, -128, -124, -128, -126, -115, -123, -128, -128, -106, -103, -128, -128, -128, -128, -50, -118, -121, -128, -128, -128, -128, -126, -128, -121, -121, -119, -127, -128, -102, -126, -72, -116, -121, -121, -128, -127, -109, -123, -128, -126, -105, -119, -126, -128, -123, -120, -90, -123, -128, -128, -121, -126, -104, -119, -128, -122, -100, -103, -126, -128, -122, -116, -80, -123, -126, -125, -128, -113, -128, -123, -128, -122, -128, -102, -128, -128, -128, -119, -80, -126, -128, -109, -128, -128, -124, -119, -128, -125, -113, -114, -128, -128, -128, -114, -106, -125, -128, -103, -128, -128, -128, -122, -128, -123, -110, -105, -127, -128, -126, -111, -109, -119, -128, -125, -128, -128, -113, -113, -128, -128, -128, -100, -126, -128, -99, -124, -126, -116, -128, -128, -128, -128, -117, -119, -128, -124, -99, -108, -121, -128, -128, -115, -128, -115, -125, -119, -128, -126, -128, -115, -128, -122, -114, -115, -128, -128, -117, -105, -128, -114, -124, -110, -128, -122, -128, -126, -128, -123, -118, -108, -125, -128, -126, -109, -83, -114, -128, -128, -128, -128, -123, -111, -128, -123, -116, -103, -128, -128, -128, -114, -53, -115, -126, -111, -128, -128, -117, -124, -128, -121, -117, -100, -126, -128, -128, -119, -88, -121, -124, -120, -128, -124, -90, -115, -128, -124, -117, -117, -128, -128, -101, -119, -67, -117, -116, -122, -128, -128, -109, -124, -128, -121, -117, -127, -124, -128, -128, -115, -58, -125, -126, -100, -128, -126, -123, -126, -126, -122, -117, -112, -128, -128, -112, -106, -57, -124, -123, -128, -128, -126, -128, -128, -128, -122, -117, -114, -128, -128, -123, -111, -50, -119, -128, -125, -128, -128, -116, -121, -128, -124, -114, -101, -126, -128, -128, -120, -91, -116, -128, -124, -128, -126, -122, -121, -128, -124, -123, -105, -125, -128, -122, -125, -80, -118, -128, -122, -128, -125, -114, -112, -128, -123, -106, -106, -125, -128, -128, -127, -59, -116, -128, -117, -128, -128, -128, -110, -128, -122, -125, -119, -128, -128, -128, -118, -79, -116, -127, -128, -128, -128, -128, -113, -128, -121, -112, -113, -125, -128, -121, -115, -99, -117, -127, -125, -128, -128, -121, -120, -128, -122, -113, -101, -126, -128, -116, -123, -105, -117, -127, -128, -128, -128, -125, -121, -128, -122, -112, -102, -121, -128, -122, -121, -108, -120, -127, -128, -128, -127, -115, -125, -128, -123, -119, -103, -128, -128, -110, -128, -94, -118, -127, -118, -128, -128, -101, -120, -128, -122, -99, -120, -124, -128, -128, -125, -74, -121, -127, -128, -128, -128, -122, -107, -128, -123, -123, -117, -128, -128, -100, -123, -90, -114, -127, -124, -128, -128, -117, -121, -128, -123, -122, -102, -126, -128, -114, -117, -105, -117, -127, -124, -128, -128, -118, -120, -128, -122, -106, -102, -126, -128, -128, -112, -97, -114, -127, -124, -128, -128, -124, -120, -128, -123, -125, -106, -125, -128, -118, -103, -97, -117, -127, -126, -128, -128, -128, -120, -128, -123, -112, -104, -128, -128, -126, -102, -90, -115, -127, -128, -128, -128, -128, -120, -128, -123, -107, -110, -128, -128, -125, -111, -97, -116, -127};
+static const int8_t kws_replay_layer_2[] = {-122, -124, -128, -128, -128, -128, -125, -128, -96, -128, -128, -128, -128, -128, -128, -128, -108, -128, -128, -124, -128, -128, -118, -128, -103, -128, -128, -128, -128, -128, -102, -102, -118, -128, -128, -128, -128, -128, -111, -128, -109, -128, -128, -128, -128, -128, -128, -128, -117, -128, -128, -128, -128, -128, -120, -128, -95, -128, -128, -128, -128, -128, -128, -128, -117, -117, -128, -122, -128, -128, -119, -128, -114, -121, -128, -128, -128, -128, -122, -113, -117, -126, -128, -124, -128, -128, -128, -128, -103, -128, -128, -128, -128, -128, -113, -115, -116, -114, -128, -128, -128, -128, -128, -128, -101, -128, -128, -128, -128, -128, -128, -128, -120, -85, -128, -125, -128, -128, -128, -128, -128, -105, -128, -118, -128, -128, -128, -101, -106, -128, -128, -128, -128, -128, -116, -128, -84, -128, -128, -128, -128, -128, -110, -115, -122, -128, -128, -125, -128, -128, -128, -128, -92, -128, -128, -128, -128, -128, -128, -117, -123, -119, -128, -128, -128, -128, -128, -128, -113, -117, -128, -128, -128, -128, -128, -128, -125, -128, -128, -127, -128, -128, -127, -128, -97, -128, -128, -128, -128, -128, -128, -128, -121, -128, -128, -124, -128, -128, -105, -128, -110, -128, -128, -128, -128, -128, -114, -128, -109, -106, -128, -117, -128, -128, -128, -128, -109, -116, -128, -128, -128, -128, -112, -95, -117, -128, -128, -123, -128, -128, -123, -128, -102, -128, -128, -128, -128, -128, -121, -128, -128, -108, -128, -121, -128, -128, -128, -128, -107, -128, -128, -128, -128, -128, -128, -128, -124, -128, -128, -128, -128, -128, -128, -128, -99, -128, -128, -128, -128, -128, -98, -107, -105, -128, -128, -116, -128, -128, -74, -128, -90, -128, -128, -128, -128, -128, -91, -113, -108, -128, -128, -128, -128, -128, -114, -128, -102, -128, -128, -128, -128, -128, -116, -124, -119, -116, -128, -124, -128, -128, -119, -128, -122, -128, -128, -128, -128, -128, -120, -117, -125, -117, -128, -117, -128, -128, -124, -128, -91, -128, -128, -128, -128, -128, -125, -128, -117, -128, -128, -121, -128, -128, -128, -128, -95, -128, -128, -128, -128, -128, -89, -102, -106, -128, -128, -114, -128, -128, -120, -128, -84, -128, -128, -128, -128, -128, -121, -108, -120, -128, -128, -128, -128, -128, -128, -128, -93, -128, -128, -128, -128, -128, -128, -128, -122, -128, -128, -128, -128, -128, -113, -128, -110, -128, -128, -128, -128, -128, -114, -127, -124, -128, -128, -128, -128, -128, -128, -128, -97, -128, -128, -128, -128, -128, -114, -127, -105, -128, -128, -122, -128, -128, -119, -128, -76, -128, -128, -128, -128, -128, -116, -128, -121, -128, -128, -128, -128, -128, -124, -128, -106, -124, -128, -128, -128, -128, -124, -126, -115, -98, -128, -114, -128, -128, -128, -128, -108, -128, -128, -127, -128, -128, -114, -101, -113, -128, -128, -119, -128, -128, -103, -128, -94, -128, -128, -128, -128, -128, -123, -128, -114, -128, -128, -128, -128, -128, -128, -128, -108, -128, -128, -128, -128, -128, -120, -119, -128, -128, -128, -128, -128, -128, -128, -128, -99, -128, -128, -128, -128, -128, -126, -128, -128, -125, -128, -128, -128, -128, -128, -128, -110, -128, -128, -128, -128, -128, -127, -128, -118, -128, -128, -128, -128, -128, -104, -128, -90, -128, -128, -128, -128, -128, -103, -119, -111, -122, -128, -119, -128, -128, -117, -128, -113, -128, -128, -128, -128, -128, -104, -102, -123, -125, -128, -126, -128, -128, -121, -128, -107, -128, -128, -128, -128, -128, -111, -128, -128, -112, -128, -128, -128, -128, -128, -128, -106, -128, -128, -128, -128, -128, -128, -123, -116, -118, -128, -123, -128, -128, -121, -128, -104, -128, -128, -128, -128, -128, -128, -128, -97, -128, -128, -128, -128, -128, -95, -128, -89, -128, -128, -128, -128, -128, -109, -123, -117, -128, -128, -128, -128, -128, -127, -128, -106, -128, -128, -128, -128, -128, -126, -120, -128, -128, -128, -128, -128, -128, -128, -128, -98, -128, -128, -128, -128, -128, -128, -128, -118, -128, -128, -125, -128, -128, -128, -128, -87, -128, -128, -128, -128, -128, -116, -127, -119, -123, -128, -128, -128, -128, -113, -128, -114, -128, -128, -128, -128, -128, -109, -112, -110, -116, -128, -125, -128, -128, -128, -128, -100, -128, -128, -128, -127, -128, -126, -123, -127, -109, -128, -128, -128, -128, -128, -128, -122, -127, -128, -128, -128, -128, -128, -128, -120, -119, -128, -119, -128, -128, -128, -128, -104, -128, -128, -120, -128, -128, -110, -108, -116, -128, -128, -128, -128, -128, -110, -128, -96, -128, -128, -128, -128, -128, -113, -120, -109, -128, -128, -126, -128, -128, -91, -128, -95, -128, -128, -128, -128, -128, -99, -119, -119, -128, -128, -126, -128, -128, -120, -128, -98, -128, -128, -128, -128, -128, -110, -115, -124, -128, -128, -128, -128, -128, -116, -128, -101, -128, -128, -128, -128, -128, -124, -124, -123, -117, -128, -128, -128, -128, -128, -128, -100, -128, -128, -128, -123, -128, -128, -119, -113, -128, -128, -120, -128, -128, -126, -128, -105, -128, -128, -128, -128, -128, -76, -89, -106, -128, -128, -123, -128, -128, -114, -128, -79, -128, -128, -128, -128, -128, -96, -116, -122, -128, -128, -125, -128, -128, -123, -128, -98, -128, -128, -128, -128, -128, -107, -105, -108, -128, -128, -123, -128, -128, -106, -128, -107, -128, -128, -128, -128, -128, -92, -107, -122, -128, -128, -122, -128, -128, -113, -128, -95, -128, -128, -128, -128, -128, -86, -121, -117, -128, -128, -128, -128, -128, -112, -128, -98, -128, -128, -128, -128, -128, -106, -116, -119, -126, -128, -128, -128, -128, -128, -128, -99, -128, -128, -128, -128, -128, -128, -127, -108, -128, -128, -124, -128, -128, -115, -128, -105, -128, -128, -128, -128, -128, -104, -108, -123, -128, -128, -128, -128, -128, -111, -128, -97, -128, -128, -128, -128, -128, -128, -128, -122, -128, -128, -128, -128, -128, -120, -128, -97, -128, -128, -128, -128, -128, -102, -128, -115, -128, -128, -124, -128, -128, -98, -128, -110, -128, -128, -128, -128, -128, -106, -116, -115, -128, -128, -116, -128, -128, -110, -128, -89, -128, -128, -128, -128, -128, -95, -114, -112, -128, -128, -128, -128, -128, -108, -128, -95, -128, -128, -128, -128, -128, -111, -117, -117, -111, -128, -122, -128, -128, -128, -128, -112, -128, -128, -128, -128, -128, -118, -106, -125, -124, -128, -126, -128, -128, -128, -128, -100, -128, -128, -128, -128, -128, -112, -110, -128, -126, -128, -123, -128, -128, -128, -128, -87, -128, -128, -128, -128, -128, -109, -110, -128, -121, -128, -128, -128, -128, -128, -128, -107, -128, -128, -128, -128, -128, -128, -124, -126, -128, -128, -120, -128, -128, -109, -128, -104, -128, -128, -128, -128, -128, -124, -126, -111, -128, -128, -128, -128, -128, -103, -128, -91, -128, -128, -128, -128, -128, -108, -119, -120, -108, -128, -128, -128, -128, -128, -128, -111, -107, -128, -128, -128, -128, -120, -114, -123, -128, -128, -128, -128, -128, -120, -128, -94, -128, -128, -128, -128, -128, -119, -123, -100, -128, -128, -121, -128, -128, -99, -128, -94, -128, -128, -128, -128, -128, -66, -94, -121, -128, -128, -121, -128, -128, -115, -128, -101, -128, -128, -128, -128, -128, -89, -107, -116, -128, -128, -128, -128, -128, -118, -128, -99, -128, -128, -128, -128, -128, -125, -125, -128, -112, -128, -121, -128, -128, -113, -128, -117, -128, -128, -128, -128, -128, -127, -128, -114, -128, -128, -128, -128, -128, -107, -128, -100, -128, -128, -128, -128, -128, -109, -120, -128, -128, -128, -128, -128, -128, -119, -128, -99, -128, -128, -128, -128, -128, -120, -128, -128, -128, -128, -128, -128, -128, -124, -128, -111, -128, -128, -128, -128, -128, -128, -128, -110, -128, -128, -125, -128, -128, -107, -128, -103, -128, -128, -128, -128, -128, -102, -107, -116, -128, -128, -128, -128, -128, -128, -128, -117, -128, -128, -128, -128, -128, -118, -121, -125, -128, -128, -123, -128, -128, -128, -128, -96, -128, -128, -128, -128, -128, -128, -126, -118, -128, -128, -127, -128, -128, -120, -128, -102, -128, -128, -128, -128, -128, -105, -115, -124, -124, -128, -117, -128, -128, -118, -128, -100, -128, -128, -128, -128, -128, -117, -115, -107, -128, -128, -126, -128, -128, -115, -128, -93, -128, -128, -128, -128, -128, -111, -109, -121, -113, -128, -128, -128, -128, -128, -128, -101, -128, -128, -128, -128, -128, -128, -128, -121, -122, -128, -128, -128, -128, -128, -128, -110, -117, -128, -128, -128, -128, -125, -109, -119, -113, -128, -128, -128, -128, -128, -128, -94, -128, -128, -128, -126, -128, -126, -113, -110, -128, -128, -127, -128, -128, -128, -128, -102, -128, -128, -128, -128, -128, -94, -101, -111, -128, -128, -124, -128, -128, -128, -128, -89, -128, -128, -128, -128, -128, -128, -123, -117, -122, -128, -114, -128, -128, -117, -128, -94, -128, -128, -128, -128, -128, -118, -115, -108, -128, -128, -128, -128, -128, -103, -128, -90, -128, -128, -128, -128, -128, -102, -107, -114, -128, -128, -115, -128, -128, -116, -128, -93, -128, -128, -128, -128, -128, -106, -117, -112, -128, -128, -125, -128, -128, -101, -128, -83, -128, -128, -128, -128, -128, -107, -128, -114, -128, -128, -126, -128, -128, -111, -128, -105, -128, -128, -128, -128, -128, -103, -106, -128, -128, -128, -128, -128, -128, -128, -128, -102, -128, -128, -128, -128, -128, -115, -116, -115, -128, -128, -122, -128, -128, -128, -128, -87, -128, -128, -128, -128, -128, -110, -119, -109, -128, -128, -128, -128, -128, -115, -128, -98, -128, -128, -128, -128, -128, -128, -123, -128, -118, -128, -128, -128, -128, -127, -128, -116, -128, -128, -128, -128, -128, -128, -123, -126, -110, -128, -128, -128, -128, -124, -128, -114, -124, -128, -128, -128, -128, -128, -128, -117, -113, -128, -128, -128, -128, -128, -128, -120, -123, -128, -128, -128, -128, -128, -116, -128, -112, -128, -127, -128, -128, -128, -128, -99, -128, -128, -128, -128, -128, -128, -128, -119, -98, -128, -128, -128, -128, -128, -128, -119, -115, -128, -128, -128, -128, -128, -120, -117, -128, -128, -128, -128, -128, -109, -128, -105, -128, -128, -128, -128, -128, -119, -123, -99, -128, -128, -122, -128, -128, -103, -128, -86, -128, -128, -128, -128, -128, -107, -123, -121, -128, -128, -125, -128, -128, -120, -128, -99, -128, -128, -128, -128, -128, -122, -125, -107, -128, -128, -113, -128, -128, -125, -128, -106, -128, -128, -128, -128, -128, -79, -102, -122, -128, -128, -124, -128, -128, -111, -128, -96, -128, -128, -128, -128, -128, -90, -103, -109, -128, -128, -118, -128, -128, -89, -128, -112, -128, -128, -128, -128, -128, -88, -101, -108, -128, -128, -128, -128, -128, -94, -128, -89, -128, -128, -128, -128, -128, -96, -106, -119, -128, -128, -128, -128, -128, -128, -128, -92, -128, -128, -128, -128, -128, -126, -127, -117, -128, -128, -128, -128, -128, -120, -128, -98, -128, -128, -128, -128, -128, -121, -123, -114, -128, -128, -122, -128, -128, -116, -128, -88, -128, -128, -128, -128, -128, -119, -128, -114, -128, -128, -128, -128, -128, -114, -128, -109, -128, -128, -128, -128, -128, -119, -126, -117, -128, -128, -126, -128, -128, -128, -128, -103, -128, -128, -128, -128, -128, -128, -122, -120, -125, -128, -127, -128, -128, -128, -128, -101, -128, -128, -128, -128, -128, -128, -124, -124, -128, -128, -127, -128, -128, -128, -128, -98, -128, -128, -128, -128, -128, -128, -125, -119, -128, -128, -128, -128, -128, -128, -128, -99, -128, -128, -128, -128, -128, -121, -116, -128, -128, -128, -120, -128, -128, -128, -128, -93, -128, -128, -128, -128, -128, -111, -122, -109, -128, -128, -123, -128, -128, -128, -128, -115, -128, -128, -128, -128, -128, -115, -112, -117, -127, -128, -128, -128, -128, -128, -128, -105, -128, -128, -128, -128, -128, -122, -115, -118, -128, -128, -127, -128, -128, -128, -128, -92, -128, -128, -128, -128, -128, -128, -126, -110, -128, -128, -128, -128, -128, -124, -128, -106, -124, -128, -128, -128, -128, -112, -108, -109, -128, -128, -128, -128, -128, -117, -128, -96, -128, -128, -128, -128, -128, -118, -117, -117, -128, -128, -128, -128, -128, -125, -128, -98, -128, -128, -128, -128, -128, -127, -122};
+static const int8_t kws_replay_layer_3[] = {-117, -124, -128, -125, -128, -128, -119, -128, -101, -127, -128, -128, -128, -128, -115, -118};
+static const int8_t kws_replay_layer_4[] = {-48, 75};
+
+static const int8_t *const KWS_REPLAY_INPUTS[KWS_REPLAY_COUNT] = {kws_replay_input_0, kws_replay_input_1, kws_replay_input_2};
+static const int8_t *const KWS_REPLAY_OUTPUTS[KWS_REPLAY_COUNT] = {kws_replay_output_0, kws_replay_output_1, kws_replay_output_2};
+static const int8_t *const KWS_REPLAY_LAYERS[5] = {kws_replay_layer_0, kws_replay_layer_1, kws_replay_layer_2, kws_replay_layer_3, kws_replay_layer_4};
@@ -0,0 +1,176 @@
+// Responses longer than ASYNC_HTTP_BODY_SIZE: the request keeps the start
+// of the body, reads and drops the rest, and says so through truncated(),
+// whether the body has a Content-Length or comes in chunks. A translation
+// cut short that way is neither passed on nor cached.
+
+#include <Arduino.h>
+#include <WiFiClient.h>
+#include <unity.h>
+
+#include <string>
+
+#include "async_http.h"
+#include "text_translator.h"
+
+struct Response {
+    bool done;
+    int status;
+    bool truncated;
+    std::string body;
+};
+
+static std::string text(size_t size)
+{
+    std::string body;
+    for (size_t i = 0; i < size; i++) {
+        body += (char)('a' + i % 26);
+    }
+    return body;
+}
+
+static void responseReceived(AsyncHttpRequest &request, Stream &body, void *context)
+{
+    Response *response = (Response *)context;
+    response->done = true;
+    response->status = request.status();
+    response->truncated = request.truncated();
+    response->body = body.readString().c_str();
+}
+
+static Response get(AsyncHttpRequest &request, WiFiClient &client, const char *url)
+{
+    Response response = {false, 0, false, ""};
+    TEST_ASSERT_TRUE(request.begin(client, url, "GET"));
+    request.onComplete(responseReceived, &response);
+    TEST_ASSERT_TRUE(asyncHttp.start(request));
+
+    uint64_t deadline = fake::clockMicros() + 5000000;
+    while (!response.done && fake::clockMicros() < deadline) {
+        asyncHttp.poll();
+        fake::advanceMillis(1);
+    }
+
+    TEST_ASSERT_TRUE(response.done);
+    return response;
+}
+
+static String translated;
+static bool translationDone;
+
+static void translationReceived(const String &translated_text, void *context)
+{
+    translated = translated_text;
+    translationDone = true;
+}
+
+static void translate(const String &text)
+{
+    translationDone = false;
+    TEST_ASSERT_TRUE(textTranslator.translateText(text, "en-GB", "fr-FR", translationReceived, NULL));
+
+    uint64_t deadline = fake::clockMicros() + 5000000;
+    while (!translationDone && fake::clockMicros() < deadline) {
+        asyncHttp.poll();
+        fake::advanceMillis(1);
+    }
+    TEST_ASSERT_TRUE(translationDone);
+}
+
+void setUp(void)
+{
+    fake::server().reset();
+    fake::network() = fake::NetworkConditions();
+    fake::network().downloadBytesPerMs = 100;
+    fake::flash().reset();
+
+    fake::server().handler = [](const fake::HttpRequest &request) {
+        if (request.path.rfind("/chunked/", 0) == 0) {
+            return fake::chunkedHttpResponse(200, text(strtoul(request.path.c_str() + 9, NULL, 10)), 300,
+                                             "text/plain");
+        }
+        if (request.path.rfind("/length/", 0) == 0) {
+            return fake::httpResponse(200, text(strtoul(request.path.c_str() + 8, NULL, 10)), "text/plain");
+        }
+        return fake::httpResponse(200, text(5000), "text/plain");
+    };
+}
+
+void tearDown(void)
+{
+}
+
+void test_body_that_fits_is_kept_whole(void)
+{
+    WiFiClient client;
+    AsyncHttpRequest request;
+    Response response = get(request, client, "http://example.com/length/2048");
+
+    TEST_ASSERT_EQUAL(200, response.status);
+    TEST_ASSERT_FALSE(response.truncated);
+    TEST_ASSERT_TRUE(response.body == text(ASYNC_HTTP_BODY_SIZE));
+}
+
+void test_longer_body_is_cut_and_flagged(void)
+{
+    WiFiClient client;
+    AsyncHttpRequest request;
+    Response response = get(request, client, "http://example.com/length/5000");
+
+    TEST_ASSERT_EQUAL(200, response.status);
+    TEST_ASSERT_TRUE(response.truncated);
+    TEST_ASSERT_TRUE(response.body == text(ASYNC_HTTP_BODY_SIZE));
+}
+
+void test_longer_chunked_body_is_cut_and_flagged(void)
+{
+    WiFiClient client;
+    AsyncHttpRequest request;
+    Response response = get(request, client, "http://example.com/chunked/5000");
+
+    TEST_ASSERT_EQUAL(200, response.status);
+    TEST_ASSERT_TRUE(response.truncated);
+    TEST_ASSERT_TRUE(response.body == text(ASYNC_HTTP_BODY_SIZE));
+}
+
+void test_flag_is_cleared_for_the_next_request(void)
+{
+    WiFiClient client;
+    AsyncHttpRequest request;
+    TEST_ASSERT_TRUE(get(request, client, "http://example.com/chunked/5000").truncated);
+
+    Response response = get(request, client, "http://example.com/chunked/100");
+    TEST_ASSERT_FALSE(response.truncated);
+    TEST_ASSERT_TRUE(response.body == text(100));
+}
+
+void test_truncated_translation_is_dropped(void)
+{
+    TRANSLATE_FUNCTION_URL = "http://functions.local/api/translate";
+    translationCache.init();
+
+    translate("Your timer is done");
+    TEST_ASSERT_EQUAL(0, translated.length());
+
+    // Not cached, so asked for again
+    translate("Your timer is done");
+    TEST_ASSERT_EQUAL(0, translated.length());
+    TEST_ASSERT_EQUAL(2, fake::server().requests.size());
+
+    // A translation that fits still comes through
+    fake::server().handler = [](const fake::HttpRequest &request) {
+        return fake::httpResponse(200, "Votre minuteur est fini", "text/plain");
+    };
+    translate("Your timer is done");
+    TEST_ASSERT_EQUAL_STRING("Votre minuteur est fini", translated.c_str());
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_body_that_fits_is_kept_whole);
+    RUN_TEST(test_longer_body_is_cut_and_flagged);
+    RUN_TEST(test_longer_chunked_body_is_cut_and_flagged);
+    RUN_TEST(test_flag_is_cleared_for_the_next_request);
+    RUN_TEST(test_truncated_translation_is_dropped);
+    return UNITY_END();
+}
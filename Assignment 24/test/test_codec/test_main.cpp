@@ -0,0 +1,318 @@
+// AudioEncoder's WAV headers and encoders, checked by decoding what they
+// produce with the standard G.711 mu-law and IMA ADPCM decoders. Only PCM
+// has a content type to upload with.
+
+#include <Arduino.h>
+#include <unity.h>
+
+#include <math.h>
+#include <vector>
+
+#include "clips.h"
+#include "codec.h"
+
+static uint16_t get16(const byte *in)
+{
+    return in[0] | (in[1] << 8);
+}
+
+static uint32_t get32(const byte *in)
+{
+    return get16(in) | ((uint32_t)get16(in + 2) << 16);
+}
+
+static int16_t decodeMulaw(byte encoded)
+{
+    encoded = ~encoded;
+    int32_t exponent = (encoded >> 4) & 0x07;
+    int32_t mantissa = encoded & 0x0F;
+    int32_t magnitude = (((mantissa << 3) + 0x84) << exponent) - 0x84;
+    return (encoded & 0x80) ? -magnitude : magnitude;
+}
+
+static std::vector<int16_t> decodeImaAdpcm(const std::vector<byte> &data, size_t samples)
+{
+    static const int16_t stepTable[89] = {
+        7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31,
+        34, 37, 41, 45, 50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130, 143,
+        157, 173, 190, 209, 230, 253, 279, 307, 337, 371, 408, 449, 494, 544, 598, 658,
+        724, 796, 876, 963, 1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066, 2272, 2499, 2749, 3024,
+        3327, 3660, 4026, 4428, 4871, 5358, 5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487, 12635, 13899,
+        15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767};
+    static const int8_t indexTable[16] = {-1, -1, -1, -1, 2, 4, 6, 8, -1, -1, -1, -1, 2, 4, 6, 8};
+
+    std::vector<int16_t> out;
+    for (size_t block = 0; block < data.size() && out.size() < samples; block += IMA_ADPCM_BLOCK_ALIGN) {
+        int32_t predictor = (int16_t)get16(&data[block]);
+        int32_t index = data[block + 2];
+        TEST_ASSERT_LESS_OR_EQUAL(88, index);
+        TEST_ASSERT_EQUAL_UINT8(0, data[block + 3]);
+        out.push_back(predictor);
+
+        size_t end = min(block + IMA_ADPCM_BLOCK_ALIGN, data.size());
+        for (size_t pos = block + 4; pos < end && out.size() < samples; pos++) {
+            for (int shift = 0; shift <= 4 && out.size() < samples; shift += 4) {
+                byte nibble = (data[pos] >> shift) & 0x0F;
+                int32_t step = stepTable[index];
+                int32_t delta = step >> 3;
+                if (nibble & 4) delta += step;
+                if (nibble & 2) delta += step >> 1;
+                if (nibble & 1) delta += step >> 2;
+                predictor = constrain(predictor + ((nibble & 8) ? -delta : delta), -32768, 32767);
+                index = constrain(index + indexTable[nibble], 0, 88);
+                out.push_back(predictor);
+            }
+        }
+    }
+    return out;
+}
+
+// Signal to noise ratio of decoded against original, in dB
+static double snr(const std::vector<int16_t> &original, const std::vector<int16_t> &decoded)
+{
+    double signal = 0, noise = 0;
+    for (size_t i = 0; i < original.size(); i++) {
+        signal += (double)original[i] * original[i];
+        noise += ((double)original[i] - decoded[i]) * ((double)original[i] - decoded[i]);
+    }
+    return 10 * log10(signal / max(noise, 1.0));
+}
+
+// Encodes pcm in pieces of the given size, as Mic does block by block
+static std::vector<byte> encodeAll(AudioEncoder &encoder, const std::vector<int16_t> &pcm, size_t piece)
+{
+    std::vector<byte> out;
+    std::vector<byte> buffer(ENCODED_MAX_SIZE(piece));
+    for (size_t i = 0; i < pcm.size(); i += piece) {
+        size_t len = min(piece, pcm.size() - i);
+        size_t bytes = encoder.encode(pcm.data() + i, len, buffer.data());
+        TEST_ASSERT_LESS_OR_EQUAL(ENCODED_MAX_SIZE(len), bytes);
+        out.insert(out.end(), buffer.begin(), buffer.begin() + bytes);
+    }
+    size_t bytes = encoder.flush(buffer.data());
+    out.insert(out.end(), buffer.begin(), buffer.begin() + bytes);
+    return out;
+}
+
+static std::vector<int16_t> speech()
+{
+    clips::Clip clip = clips::roomTone(200);
+    clip.append(clips::phrase()).append(clips::roomTone(200));
+    return clip.pcm(0);
+}
+
+void setUp(void)
+{
+}
+
+void tearDown(void)
+{
+}
+
+void test_pcm_header(void)
+{
+    AudioEncoder encoder(CODEC_PCM);
+    byte header[WAV_MAX_HEADER_SIZE];
+    size_t size = encoder.writeHeader(header);
+
+    TEST_ASSERT_EQUAL(44, size);
+    TEST_ASSERT_EQUAL_MEMORY("RIFF", header, 4);
+    TEST_ASSERT_EQUAL_MEMORY("WAVEfmt ", header + 8, 8);
+    TEST_ASSERT_EQUAL_UINT32(16, get32(header + 16));
+    TEST_ASSERT_EQUAL_UINT16(1, get16(header + 20));
+    TEST_ASSERT_EQUAL_UINT16(1, get16(header + 22));
+    TEST_ASSERT_EQUAL_UINT32(RATE, get32(header + 24));
+    TEST_ASSERT_EQUAL_UINT32(RATE * 2, get32(header + 28));
+    TEST_ASSERT_EQUAL_UINT16(2, get16(header + 32));
+    TEST_ASSERT_EQUAL_UINT16(16, get16(header + 34));
+    TEST_ASSERT_EQUAL_MEMORY("data", header + 36, 4);
+
+    // Lengths are left erased to be programmed once known
+    TEST_ASSERT_EQUAL(4, encoder.riffLengthOffset());
+    TEST_ASSERT_EQUAL(40, encoder.dataLengthOffset());
+    TEST_ASSERT_EQUAL(0, encoder.factOffset());
+    TEST_ASSERT_EQUAL_HEX32(0xFFFFFFFF, get32(header + 4));
+    TEST_ASSERT_EQUAL_HEX32(0xFFFFFFFF, get32(header + 40));
+}
+
+void test_pcm_is_unchanged(void)
+{
+    AudioEncoder encoder(CODEC_PCM);
+    std::vector<int16_t> pcm = speech();
+    std::vector<byte> encoded = encodeAll(encoder, pcm, ADC_BUF_LEN);
+
+    TEST_ASSERT_EQUAL(pcm.size() * sizeof(int16_t), encoded.size());
+    TEST_ASSERT_EQUAL_MEMORY(pcm.data(), encoded.data(), encoded.size());
+}
+
+void test_mulaw_header(void)
+{
+    AudioEncoder encoder(CODEC_MULAW);
+    byte header[WAV_MAX_HEADER_SIZE];
+
+    TEST_ASSERT_EQUAL(44, encoder.writeHeader(header));
+    TEST_ASSERT_EQUAL_UINT16(7, get16(header + 20));
+    TEST_ASSERT_EQUAL_UINT32(RATE, get32(header + 28));
+    TEST_ASSERT_EQUAL_UINT16(1, get16(header + 32));
+    TEST_ASSERT_EQUAL_UINT16(8, get16(header + 34));
+}
+
+void test_mulaw_matches_g711(void)
+{
+    AudioEncoder encoder(CODEC_MULAW);
+    int16_t pcm[] = {0, -1, 32767, -32768, 1000, -1000};
+    byte encoded[ENCODED_MAX_SIZE(6)];
+
+    TEST_ASSERT_EQUAL(6, encoder.encode(pcm, 6, encoded));
+    TEST_ASSERT_EQUAL_HEX8(0xFF, encoded[0]);
+    TEST_ASSERT_EQUAL_HEX8(0x7F, encoded[1]);
+    TEST_ASSERT_EQUAL_HEX8(0x80, encoded[2]);
+    TEST_ASSERT_EQUAL_HEX8(0x00, encoded[3]);
+    TEST_ASSERT_EQUAL_HEX8(0xCE, encoded[4]);
+    TEST_ASSERT_EQUAL_HEX8(0x4E, encoded[5]);
+}
+
+void test_mulaw_round_trip_error_is_within_a_step(void)
+{
+    AudioEncoder encoder(CODEC_MULAW);
+    for (int32_t value = -32768; value <= 32767; value++) {
+        int16_t sample = value;
+        byte encoded;
+        encoder.encode(&sample, 1, &encoded);
+        int32_t decoded = decodeMulaw(encoded);
+
+        // Each segment's step is twice the last, from 8 near zero to 1024
+        int32_t magnitude = min(abs(value), 32635);
+        int32_t step = 8;
+        while (step < 1024 && magnitude + 0x84 >= (step << 5)) {
+            step <<= 1;
+        }
+        TEST_ASSERT_INT_WITHIN(step + (abs(value) - magnitude), value, decoded);
+    }
+}
+
+void test_mulaw_speech_snr(void)
+{
+    AudioEncoder encoder(CODEC_MULAW);
+    std::vector<int16_t> pcm = speech();
+    std::vector<byte> encoded = encodeAll(encoder, pcm, ADC_BUF_LEN);
+
+    TEST_ASSERT_EQUAL(pcm.size(), encoded.size());
+    std::vector<int16_t> decoded;
+    for (byte b : encoded) {
+        decoded.push_back(decodeMulaw(b));
+    }
+    TEST_ASSERT_GREATER_THAN(30, snr(pcm, decoded));
+}
+
+void test_ima_adpcm_header(void)
+{
+    AudioEncoder encoder(CODEC_IMA_ADPCM);
+    byte header[WAV_MAX_HEADER_SIZE];
+
+    TEST_ASSERT_EQUAL(60, encoder.writeHeader(header));
+    TEST_ASSERT_EQUAL_UINT32(20, get32(header + 16));
+    TEST_ASSERT_EQUAL_UINT16(0x11, get16(header + 20));
+    TEST_ASSERT_EQUAL_UINT16(IMA_ADPCM_BLOCK_ALIGN, get16(header + 32));
+    TEST_ASSERT_EQUAL_UINT16(4, get16(header + 34));
+    TEST_ASSERT_EQUAL_UINT16(2, get16(header + 36));
+    TEST_ASSERT_EQUAL_UINT16(IMA_ADPCM_SAMPLES_PER_BLOCK, get16(header + 38));
+    TEST_ASSERT_EQUAL_MEMORY("fact", header + 40, 4);
+    TEST_ASSERT_EQUAL(48, encoder.factOffset());
+    TEST_ASSERT_EQUAL_MEMORY("data", header + 52, 4);
+    TEST_ASSERT_EQUAL(56, encoder.dataLengthOffset());
+}
+
+void test_ima_adpcm_round_trip(void)
+{
+    AudioEncoder encoder(CODEC_IMA_ADPCM);
+    std::vector<int16_t> pcm = speech();
+    std::vector<byte> encoded = encodeAll(encoder, pcm, ADC_BUF_LEN);
+
+    // Whole blocks, then one that holds the rest
+    size_t blocks = pcm.size() / IMA_ADPCM_SAMPLES_PER_BLOCK;
+    size_t rest = pcm.size() % IMA_ADPCM_SAMPLES_PER_BLOCK;
+    size_t expected = blocks * IMA_ADPCM_BLOCK_ALIGN + (rest > 0 ? 4 + rest / 2 : 0);
+    TEST_ASSERT_EQUAL(expected, encoded.size());
+
+    std::vector<int16_t> decoded = decodeImaAdpcm(encoded, pcm.size());
+    TEST_ASSERT_EQUAL(pcm.size(), decoded.size());
+    // The glottal pulses are about the hardest thing for ADPCM to follow
+    TEST_ASSERT_GREATER_THAN(15, snr(pcm, decoded));
+
+    // Every block restarts from the exact sample
+    for (size_t i = 0; i < pcm.size(); i += IMA_ADPCM_SAMPLES_PER_BLOCK) {
+        TEST_ASSERT_EQUAL_INT16(pcm[i], decoded[i]);
+    }
+}
+
+void test_ima_adpcm_tone_snr(void)
+{
+    AudioEncoder encoder(CODEC_IMA_ADPCM);
+    std::vector<int16_t> pcm(RATE);
+    for (size_t i = 0; i < pcm.size(); i++) {
+        pcm[i] = (int16_t)(8000 * sin(2 * M_PI * 440 * i / RATE));
+    }
+
+    std::vector<int16_t> decoded = decodeImaAdpcm(encodeAll(encoder, pcm, ADC_BUF_LEN), pcm.size());
+    TEST_ASSERT_GREATER_THAN(30, snr(pcm, decoded));
+}
+
+void test_ima_adpcm_odd_lengths_flush_the_last_nibble(void)
+{
+    AudioEncoder encoder(CODEC_IMA_ADPCM);
+    std::vector<int16_t> pcm(IMA_ADPCM_SAMPLES_PER_BLOCK + 2);
+    for (size_t i = 0; i < pcm.size(); i++) {
+        pcm[i] = (int16_t)(8000 * sin(2 * M_PI * 440 * i / RATE));
+    }
+
+    // One sample past a block leaves just its header, a second a nibble
+    std::vector<byte> encoded = encodeAll(encoder, pcm, 1);
+    TEST_ASSERT_EQUAL(IMA_ADPCM_BLOCK_ALIGN + 4 + 1, encoded.size());
+    TEST_ASSERT_EQUAL_INT16(pcm[IMA_ADPCM_SAMPLES_PER_BLOCK], (int16_t)get16(&encoded[IMA_ADPCM_BLOCK_ALIGN]));
+
+    std::vector<int16_t> decoded = decodeImaAdpcm(encoded, pcm.size());
+    TEST_ASSERT_EQUAL(pcm.size(), decoded.size());
+    TEST_ASSERT_INT_WITHIN(500, pcm.back(), decoded.back());
+}
+
+void test_piece_size_does_not_change_the_encoding(void)
+{
+    std::vector<int16_t> pcm = speech();
+    const uint8_t codecs[] = {CODEC_PCM, CODEC_MULAW, CODEC_IMA_ADPCM};
+
+    for (uint8_t codec : codecs) {
+        AudioEncoder whole(codec);
+        AudioEncoder pieces(codec);
+        std::vector<byte> expected = encodeAll(whole, pcm, pcm.size());
+        std::vector<byte> actual = encodeAll(pieces, pcm, 333);
+
+        TEST_ASSERT_EQUAL(expected.size(), actual.size());
+        TEST_ASSERT_EQUAL_MEMORY(expected.data(), actual.data(), expected.size());
+    }
+}
+
+void test_only_pcm_has_a_content_type(void)
+{
+    TEST_ASSERT_EQUAL_STRING("audio/wav; codecs=audio/pcm; samplerate=", AudioEncoder::contentType(CODEC_PCM));
+    TEST_ASSERT_TRUE(AudioEncoder::contentType(CODEC_MULAW) == NULL);
+    TEST_ASSERT_TRUE(AudioEncoder::contentType(CODEC_IMA_ADPCM) == NULL);
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_pcm_header);
+    RUN_TEST(test_pcm_is_unchanged);
+    RUN_TEST(test_mulaw_header);
+    RUN_TEST(test_mulaw_matches_g711);
+    RUN_TEST(test_mulaw_round_trip_error_is_within_a_step);
+    RUN_TEST(test_mulaw_speech_snr);
+    RUN_TEST(test_ima_adpcm_header);
+    RUN_TEST(test_ima_adpcm_round_trip);
+    RUN_TEST(test_ima_adpcm_tone_snr);
+    RUN_TEST(test_ima_adpcm_odd_lengths_flush_the_last_nibble);
+    RUN_TEST(test_piece_size_does_not_change_the_encoding);
+    RUN_TEST(test_only_pcm_has_a_content_type);
+    return UNITY_END();
+}
@@ -0,0 +1,249 @@
+// The fixed-point FFT and MFCC front end against double-precision
+// references of the same maths (TensorFlow's audio_spectrogram and mfcc
+// ops), plus a host timing of a frame.
+
+#include <Arduino.h>
+#include <unity.h>
+
+#include <chrono>
+#include <complex>
+#include <vector>
+
+#include "clips.h"
+#include "dsp.h"
+#include "mfcc.h"
+
+static std::vector<q15_t> noise(size_t count, int32_t peak, uint32_t seed)
+{
+    std::vector<q15_t> data(count);
+    for (size_t i = 0; i < count; i++) {
+        seed = seed * 1664525 + 1013904223;
+        data[i] = (q15_t)((int32_t)(seed >> 16) % (peak + 1) * ((seed & 0x100) ? 1 : -1));
+    }
+    return data;
+}
+
+static std::vector<std::complex<double>> dft(const std::vector<double> &x)
+{
+    size_t n = x.size();
+    std::vector<std::complex<double>> out(n / 2 + 1);
+    for (size_t k = 0; k <= n / 2; k++) {
+        for (size_t i = 0; i < n; i++) {
+            out[k] += x[i] * std::polar(1.0, -2 * M_PI * k * i / n);
+        }
+    }
+    return out;
+}
+
+// Worst error of RealFft<N> against X[k] / N, relative to the largest bin,
+// in dB
+template <size_t N>
+static double fftErrorDb(const std::vector<q15_t> &in)
+{
+    std::vector<q15_t> scratch(N);
+    std::vector<q31_t> out(2 * RealFft<N>::BINS);
+    RealFft<N>::forward(in.data(), out.data(), scratch.data());
+
+    std::vector<double> x(in.begin(), in.end());
+    std::vector<std::complex<double>> expected = dft(x);
+
+    double largest = 0;
+    double error = 0;
+    for (size_t k = 0; k < RealFft<N>::BINS; k++) {
+        std::complex<double> want = expected[k] / (double)N * 4.0; // Q15 in, Q17 out
+        std::complex<double> got(out[2 * k], out[2 * k + 1]);
+        largest = std::max(largest, std::abs(want));
+        error = std::max(error, std::abs(got - want));
+    }
+    return 20 * log10(std::max(error, 1e-9) / largest);
+}
+
+// TensorFlow's mfcc op on one frame, in doubles
+static std::vector<double> referenceMfcc(const q15_t *frame)
+{
+    std::vector<double> x(MFCC_FFT_LEN, 0.0);
+    for (size_t i = 0; i < MFCC_FRAME_LEN; i++) {
+        x[i] = frame[i] / 32768.0 * (0.5 - 0.5 * cos(2 * M_PI * i / MFCC_FRAME_LEN));
+    }
+    std::vector<std::complex<double>> spectrum = dft(x);
+
+    auto mel = [](double hz) { return 1127.0 * log(1.0 + hz / 700.0); };
+    double hzPerBin = (double)MFCC_SAMPLE_RATE / MFCC_FFT_LEN;
+    double low = mel(MFCC_LOWER_HZ), high = mel(MFCC_UPPER_HZ);
+    std::vector<double> centres(MFCC_MEL_BANDS + 1);
+    for (size_t i = 0; i <= MFCC_MEL_BANDS; i++) {
+        centres[i] = low + (high - low) * (i + 1) / (MFCC_MEL_BANDS + 1);
+    }
+
+    std::vector<double> bands(MFCC_MEL_BANDS, 0.0);
+    size_t start = (size_t)(1.5 + MFCC_LOWER_HZ / hzPerBin);
+    size_t end = std::min((size_t)(MFCC_UPPER_HZ / hzPerBin), spectrum.size() - 1);
+    size_t next = 0;
+    for (size_t i = start; i <= end; i++) {
+        double m = mel(i * hzPerBin);
+        while (next < MFCC_MEL_BANDS && centres[next] < m) {
+            next++;
+        }
+        double magnitude = std::abs(spectrum[i]);
+        double weight = next > 0 ? (centres[next] - m) / (centres[next] - centres[next - 1]) : 0;
+        if (next > 0) {
+            bands[next - 1] += magnitude * weight;
+        }
+        if (next < MFCC_MEL_BANDS) {
+            bands[next] += magnitude * (1 - weight);
+        }
+    }
+
+    std::vector<double> mfcc(MFCC_COEFFS, 0.0);
+    for (size_t i = 0; i < MFCC_COEFFS; i++) {
+        for (size_t j = 0; j < MFCC_MEL_BANDS; j++) {
+            mfcc[i] += log(std::max(bands[j], 1e-12)) * sqrt(2.0 / MFCC_MEL_BANDS) *
+                       cos(M_PI / MFCC_MEL_BANDS * (j + 0.5) * i);
+        }
+    }
+    return mfcc;
+}
+
+void setUp(void)
+{
+}
+
+void tearDown(void)
+{
+}
+
+void test_fft_matches_the_dft(void)
+{
+    char report[128];
+    double worst = -1000;
+
+    worst = std::max(worst, fftErrorDb<8>(noise(8, 16383, 1)));
+    worst = std::max(worst, fftErrorDb<16>(noise(16, 16383, 2)));
+    worst = std::max(worst, fftErrorDb<64>(noise(64, 16383, 3)));
+    worst = std::max(worst, fftErrorDb<128>(noise(128, 16383, 4)));
+    worst = std::max(worst, fftErrorDb<512>(noise(512, 16383, 5)));
+    worst = std::max(worst, fftErrorDb<1024>(noise(1024, 16383, 6)));
+
+    snprintf(report, sizeof(report), "Worst FFT error %.1f dB below the largest bin", worst);
+    TEST_MESSAGE(report);
+    TEST_ASSERT_LESS_THAN(-50, (int)worst);
+}
+
+void test_fft_puts_a_tone_in_its_bin(void)
+{
+    const size_t n = MFCC_FFT_LEN;
+    std::vector<q15_t> tone(n);
+    for (size_t i = 0; i < n; i++) {
+        tone[i] = (q15_t)lround(16000 * cos(2 * M_PI * 100 * i / n));
+    }
+
+    std::vector<q15_t> scratch(n);
+    std::vector<q31_t> out(2 * RealFft<n>::BINS);
+    std::vector<uint32_t> magnitudes(RealFft<n>::BINS);
+    RealFft<n>::forward(tone.data(), out.data(), scratch.data());
+    dspMagnitudes(out.data(), magnitudes.data(), RealFft<n>::BINS);
+
+    // Half the amplitude in Q17 at bin 100, next to nothing elsewhere
+    TEST_ASSERT_UINT32_WITHIN(64, 16000 * 4 / 2, magnitudes[100]);
+    for (size_t k = 0; k < RealFft<n>::BINS; k++) {
+        if (k != 100) {
+            TEST_ASSERT_LESS_THAN_UINT32(64, magnitudes[k]);
+        }
+    }
+}
+
+// TensorFlow scales every DCT row by sqrt(2 / N), so a flat log spectrum
+// gives c0 = sqrt(2 N) x rather than the orthonormal sqrt(N) x
+void test_dct_uses_tensorflow_scaling(void)
+{
+    q31_t in[MFCC_MEL_BANDS];
+    q31_t out[MFCC_COEFFS];
+    for (size_t i = 0; i < MFCC_MEL_BANDS; i++) {
+        in[i] = 1024;
+    }
+
+    Dct<MFCC_MEL_BANDS, MFCC_COEFFS>::apply(in, out);
+
+    TEST_ASSERT_INT32_WITHIN(4, (int32_t)lround(sqrt(2.0 * MFCC_MEL_BANDS) * 1024), out[0]);
+    for (size_t i = 1; i < MFCC_COEFFS; i++) {
+        TEST_ASSERT_INT32_WITHIN(4, 0, out[i]);
+    }
+}
+
+// Speech-like frames, loud and quiet, against the double reference
+void test_mfcc_matches_the_reference(void)
+{
+    std::vector<std::vector<int16_t>> clipsToCheck = {
+        clips::vowel(200).pcm(),
+        clips::vowel(200, 2000, 220, 500, 1800, 7).pcm(),
+        clips::fan(200).pcm(),
+        clips::roomTone(200, 3, 400).pcm(),
+    };
+
+    MfccFrontEnd *frontEnd = new MfccFrontEnd();
+    double worst = 0;
+    for (const std::vector<int16_t> &pcm : clipsToCheck) {
+        for (size_t offset = 0; offset + MFCC_FRAME_LEN <= pcm.size(); offset += MFCC_FRAME_STRIDE) {
+            q31_t mfcc[MFCC_COEFFS];
+            frontEnd->compute(pcm.data() + offset, mfcc);
+            std::vector<double> expected = referenceMfcc(pcm.data() + offset);
+
+            for (size_t i = 0; i < MFCC_COEFFS; i++) {
+                worst = std::max(worst, fabs(mfcc[i] / 1024.0 - expected[i]));
+            }
+        }
+    }
+    delete frontEnd;
+
+    char report[64];
+    snprintf(report, sizeof(report), "Worst MFCC error %.3f", worst);
+    TEST_MESSAGE(report);
+    TEST_ASSERT_FLOAT_WITHIN(0.2, 0.0, worst);
+}
+
+template <typename Run>
+static uint64_t hostNsPerFrame(Run run)
+{
+    const int rounds = 500;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (int i = 0; i < rounds; i++) {
+        run();
+    }
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count() / rounds;
+}
+
+void test_benchmark(void)
+{
+    std::vector<int16_t> pcm = clips::vowel(100).pcm();
+    std::vector<q15_t> samples = noise(MFCC_FFT_LEN, 16383, 9);
+    std::vector<q15_t> scratch(MFCC_FFT_LEN);
+    std::vector<q31_t> spectrum(2 * MfccFrontEnd::Fft::BINS);
+    q31_t mfcc[MFCC_COEFFS];
+    MfccFrontEnd *frontEnd = new MfccFrontEnd();
+
+    uint64_t fft = hostNsPerFrame([&]() {
+        MfccFrontEnd::Fft::forward(samples.data(), spectrum.data(), scratch.data());
+        __asm__ __volatile__("" : : "r"(spectrum.data()) : "memory");
+    });
+    uint64_t frame = hostNsPerFrame([&]() {
+        frontEnd->compute(pcm.data(), mfcc);
+        __asm__ __volatile__("" : : "r"(mfcc) : "memory");
+    });
+    delete frontEnd;
+
+    char report[128];
+    snprintf(report, sizeof(report), "%u-point FFT %llu ns, MFCC frame %llu ns (host)",
+             MFCC_FFT_LEN, (unsigned long long)fft, (unsigned long long)frame);
+    TEST_MESSAGE(report);
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_fft_matches_the_dft);
+    RUN_TEST(test_fft_puts_a_tone_in_its_bin);
+    RUN_TEST(test_dct_uses_tensorflow_scaling);
+    RUN_TEST(test_mfcc_matches_the_reference);
+    RUN_TEST(test_benchmark);
+    return UNITY_END();
+}
@@ -0,0 +1,65 @@
+// The firmware's own src/main.cpp, built against the fakes. No other test
+// compiles it, so a global defined both there and in a header, or a call
+// that no longer matches a header, would only show up in the board build.
+// setup() then runs, and loop() goes round with nothing to do. A recording
+// that nothing was recognised in is not sent on to be understood.
+
+#include "main.cpp"
+
+#include <unity.h>
+
+void setUp(void)
+{
+    fake::flash().reset();
+    fake::sdCard().reset();
+    fake::server().reset();
+    fake::resetDmac();
+    fake::serialOutput().clear();
+}
+
+void tearDown(void)
+{
+}
+
+void test_setup_and_an_idle_loop_run(void)
+{
+    setup();
+    TEST_ASSERT_TRUE(fake::serialOutput().find("Ready.") != std::string::npos);
+
+    for (int i = 0; i < 1000; i++) {
+        loop();
+        fake::advanceMillis(1);
+    }
+
+    TEST_ASSERT_FALSE(mic.isRecording());
+    TEST_ASSERT_FALSE(speechPlayer.busy());
+}
+
+void test_nothing_recognized_is_not_understood(void)
+{
+    TEXT_TO_TIMER_FUNCTION_URL = "http://functions.local/api/text-to-timer";
+    setup();
+    for (int i = 0; i < 1000; i++) {
+        loop();
+        fake::advanceMillis(1);
+    }
+    size_t requests = fake::server().requests.size();
+
+    recordingRecognized("", NULL);
+    processText("");
+    for (int i = 0; i < 100; i++) {
+        loop();
+        fake::advanceMillis(1);
+    }
+
+    TEST_ASSERT_TRUE(fake::serialOutput().find("Nothing recognized") != std::string::npos);
+    TEST_ASSERT_EQUAL(requests, fake::server().requests.size());
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_setup_and_an_idle_loop_run);
+    RUN_TEST(test_nothing_recognized_is_not_understood);
+    return UNITY_END();
+}
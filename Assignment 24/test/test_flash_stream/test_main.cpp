@@ -0,0 +1,138 @@
+// FlashStream reading a recording back out of flash: bulk reads go
+// straight to sfud_read, and mixing them with read() and peek() keeps the
+// bytes in order.
+
+#include <Arduino.h>
+#include <unity.h>
+
+#include <string>
+#include <vector>
+
+#include "async_http.h"
+#include "flash_stream.h"
+
+static const size_t ADDRESS = 3 * 4096 + 100;
+
+static std::vector<byte> pattern(size_t length, uint32_t seed)
+{
+    std::vector<byte> data(length);
+    for (size_t i = 0; i < length; i++) {
+        seed = seed * 1664525 + 1013904223;
+        data[i] = seed >> 24;
+    }
+    return data;
+}
+
+static std::vector<byte> stored;
+
+void setUp(void)
+{
+    fake::flash().reset();
+    fake::server().reset();
+    fake::network() = fake::NetworkConditions();
+
+    stored = pattern(20000, 1);
+    sfud_write(sfud_get_device_table(), ADDRESS, stored.size(), stored.data());
+    fake::flash().clearStats();
+}
+
+void tearDown(void)
+{
+}
+
+void test_bulk_reads_go_straight_to_flash(void)
+{
+    FlashStream stream(stored.size(), ADDRESS);
+    BulkStream &bulk = stream;
+
+    std::vector<byte> read(stored.size());
+    size_t total = 0;
+    while (total < read.size()) {
+        size_t count = bulk.readBytes(read.data() + total, 1024);
+        TEST_ASSERT_EQUAL(min((size_t)1024, read.size() - total), count);
+        total += count;
+    }
+
+    TEST_ASSERT_EQUAL_MEMORY(stored.data(), read.data(), stored.size());
+    TEST_ASSERT_EQUAL((stored.size() + 1023) / 1024, fake::flash().reads);
+    TEST_ASSERT_EQUAL(stored.size(), fake::flash().bytesRead);
+}
+
+void test_reads_stop_at_the_length(void)
+{
+    FlashStream stream(1000, ADDRESS);
+    BulkStream &bulk = stream;
+    byte buffer[2048];
+
+    TEST_ASSERT_EQUAL(1000, bulk.readBytes(buffer, sizeof(buffer)));
+    TEST_ASSERT_EQUAL(0, bulk.readBytes(buffer, sizeof(buffer)));
+    TEST_ASSERT_EQUAL(-1, stream.read());
+    TEST_ASSERT_EQUAL(-1, stream.peek());
+    TEST_ASSERT_EQUAL_MEMORY(stored.data(), buffer, 1000);
+}
+
+void test_mixed_reads_keep_the_bytes_in_order(void)
+{
+    FlashStream stream(stored.size(), ADDRESS);
+    BulkStream &bulk = stream;
+    std::vector<byte> read;
+
+    // A byte or two, then a bulk read that starts inside the buffer that
+    // filled, and so on
+    byte buffer[3000];
+    size_t sizes[] = {1, 2000, 3000, 7, 1460, 2999};
+    for (size_t i = 0; read.size() < stored.size(); i++) {
+        int peeked = stream.peek();
+        int c = stream.read();
+        TEST_ASSERT_EQUAL(peeked, c);
+        read.push_back(c);
+
+        size_t count = bulk.readBytes(buffer, sizes[i % 6]);
+        read.insert(read.end(), buffer, buffer + count);
+    }
+
+    TEST_ASSERT_EQUAL(stored.size(), read.size());
+    TEST_ASSERT_EQUAL_MEMORY(stored.data(), read.data(), stored.size());
+}
+
+// Through a Stream the core's byte-at-a-time readBytes() is used, so the
+// body source has to be held as a BulkStream
+void test_upload_reads_flash_in_chunks(void)
+{
+    fake::server().handler = [](const fake::HttpRequest &request) {
+        return fake::httpResponse(200, "{}");
+    };
+
+    FlashStream stream(stored.size(), ADDRESS);
+    WiFiClient client;
+    AsyncHttpRequest request;
+    request.begin(client, "http://example.com/upload");
+    request.setBody(stream, stored.size());
+
+    bool done = false;
+    request.onComplete([](AsyncHttpRequest &request, Stream &body, void *context) {
+        *(bool *)context = true;
+    }, &done);
+    asyncHttp.start(request);
+
+    uint64_t deadline = fake::clockMicros() + 10000000;
+    while (!done && fake::clockMicros() < deadline) {
+        asyncHttp.poll();
+        fake::advanceMillis(1);
+    }
+
+    TEST_ASSERT_TRUE(done);
+    TEST_ASSERT_EQUAL(200, request.status());
+    TEST_ASSERT_TRUE(fake::server().requests.back().body == std::string(stored.begin(), stored.end()));
+    TEST_ASSERT_EQUAL((stored.size() + ASYNC_HTTP_SEND_CHUNK - 1) / ASYNC_HTTP_SEND_CHUNK, fake::flash().reads);
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_bulk_reads_go_straight_to_flash);
+    RUN_TEST(test_reads_stop_at_the_length);
+    RUN_TEST(test_mixed_reads_keep_the_bytes_in_order);
+    RUN_TEST(test_upload_reads_flash_in_chunks);
+    return UNITY_END();
+}
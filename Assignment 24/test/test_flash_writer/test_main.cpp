@@ -0,0 +1,163 @@
+#include <Arduino.h>
+#include <unity.h>
+
+#include <string>
+#include <vector>
+
+#include "flash_writer.h"
+
+static FlashWriter writer;
+
+static std::vector<byte> pattern(size_t length, uint32_t seed)
+{
+    std::vector<byte> data(length);
+    for (size_t i = 0; i < length; i++) {
+        seed = seed * 1664525 + 1013904223;
+        data[i] = seed >> 24;
+    }
+    return data;
+}
+
+static std::string flashContents(size_t address, size_t length)
+{
+    return std::string((const char *)fake::flash().memory.data() + address, length);
+}
+
+static std::string asString(const std::vector<byte> &data)
+{
+    return std::string(data.begin(), data.end());
+}
+
+void setUp(void)
+{
+    fake::flash().reset();
+    writer.init();
+    fake::flash().clearStats();
+}
+
+void tearDown(void)
+{
+}
+
+// An ADC block's worth of PCM (3200 bytes) is 12.5 pages
+void test_whole_blocks_program_whole_pages(void)
+{
+    std::vector<byte> data = pattern(3200 * 4, 1);
+    for (size_t i = 0; i < data.size(); i += 3200) {
+        writer.write(data.data() + i, 3200);
+    }
+
+    TEST_ASSERT_EQUAL(50, fake::flash().programs);
+    TEST_ASSERT_EQUAL(50 * SFUD_PAGE_SIZE, fake::flash().bytesProgrammed);
+    TEST_ASSERT_EQUAL(data.size(), writer.writtenBytes());
+    TEST_ASSERT_TRUE(flashContents(0, data.size()) == asString(data));
+}
+
+void test_partial_page_waits_for_flush(void)
+{
+    std::vector<byte> data = pattern(300, 2);
+    writer.write(data.data(), data.size());
+
+    TEST_ASSERT_EQUAL(1, fake::flash().programs);
+    TEST_ASSERT_EQUAL(SFUD_PAGE_SIZE, writer.writtenBytes());
+
+    writer.flush();
+    TEST_ASSERT_EQUAL(2, fake::flash().programs);
+    TEST_ASSERT_EQUAL(data.size(), writer.writtenBytes());
+    TEST_ASSERT_TRUE(flashContents(0, data.size()) == asString(data));
+}
+
+void test_small_writes_fill_the_page_buffer(void)
+{
+    std::vector<byte> data = pattern(1000, 3);
+    for (size_t i = 0; i < data.size(); i += 7) {
+        writer.write(data.data() + i, min((size_t)7, data.size() - i));
+    }
+    writer.flush();
+
+    TEST_ASSERT_EQUAL(4, fake::flash().programs);
+    TEST_ASSERT_TRUE(flashContents(0, data.size()) == asString(data));
+}
+
+void test_each_sector_erased_once(void)
+{
+    std::vector<byte> data = pattern(3 * 4096 + 100, 4);
+    writer.write(data.data(), data.size());
+    writer.flush();
+
+    TEST_ASSERT_EQUAL(4, fake::flash().erases);
+    TEST_ASSERT_EQUAL(0, fake::flash().programErrors);
+    for (size_t sector = 0; sector < 4; sector++) {
+        TEST_ASSERT_EQUAL(1, fake::flash().sectorErases[sector]);
+    }
+}
+
+// The WAV lengths are written as 0xFF and programmed once known
+void test_patch_programs_over_erased_bytes(void)
+{
+    byte header[8];
+    memset(header, 0xFF, sizeof(header));
+    writer.write(header, sizeof(header));
+
+    std::vector<byte> data = pattern(600, 5);
+    writer.write(data.data(), data.size());
+    writer.flush();
+
+    uint32_t length = 1234;
+    writer.patch(4, (byte *)&length, sizeof(length));
+
+    TEST_ASSERT_EQUAL(0, fake::flash().programErrors);
+    TEST_ASSERT_TRUE(flashContents(4, 4) == std::string((const char *)&length, 4));
+    TEST_ASSERT_TRUE(flashContents(8, data.size()) == asString(data));
+}
+
+void test_addresses_are_relative_to_reset(void)
+{
+    writer.reset(8192);
+
+    std::vector<byte> data = pattern(512, 6);
+    writer.write(data.data(), data.size());
+
+    uint16_t value = 0x1234;
+    writer.patch(600, (byte *)&value, sizeof(value));
+
+    TEST_ASSERT_EQUAL(data.size(), writer.writtenBytes());
+    TEST_ASSERT_EQUAL(0, fake::flash().sectorErases[0]);
+    TEST_ASSERT_EQUAL(1, fake::flash().sectorErases[2]);
+    TEST_ASSERT_TRUE(flashContents(8192, data.size()) == asString(data));
+    TEST_ASSERT_EQUAL_HEX8(0x34, fake::flash().memory[8192 + 600]);
+    TEST_ASSERT_EQUAL(0, fake::flash().programErrors);
+}
+
+void test_capacity_is_bounded_by_region(void)
+{
+    writer.reset(8192, 5000);
+    TEST_ASSERT_EQUAL(5000, writer.capacity());
+
+    // Erasing ahead stops at the sector holding the end of the region
+    while (writer.eraseAhead(1024 * 1024)) {
+    }
+    TEST_ASSERT_EQUAL(2, fake::flash().erases);
+    TEST_ASSERT_EQUAL(1, fake::flash().sectorErases[2]);
+    TEST_ASSERT_EQUAL(1, fake::flash().sectorErases[3]);
+
+    // A region running off the end of the chip is cut short
+    writer.reset(fake::Flash::CAPACITY - 1000, 4096);
+    TEST_ASSERT_EQUAL(1000, writer.capacity());
+
+    writer.reset(4096);
+    TEST_ASSERT_EQUAL(fake::Flash::CAPACITY - 4096, writer.capacity());
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_whole_blocks_program_whole_pages);
+    RUN_TEST(test_partial_page_waits_for_flush);
+    RUN_TEST(test_small_writes_fill_the_page_buffer);
+    RUN_TEST(test_each_sector_erased_once);
+    RUN_TEST(test_patch_programs_over_erased_bytes);
+    RUN_TEST(test_addresses_are_relative_to_reset);
+    RUN_TEST(test_capacity_is_bounded_by_region);
+    return UNITY_END();
+}
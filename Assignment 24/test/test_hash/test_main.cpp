@@ -0,0 +1,73 @@
+// The checksums records in flash and on the SD card are kept with, and the
+// hash the caches are keyed by, against the published check values.
+
+#include <Arduino.h>
+#include <unity.h>
+
+#include <vector>
+
+#include "hash.h"
+
+static const char CHECK[] = "123456789";
+
+void setUp(void)
+{
+}
+
+void tearDown(void)
+{
+}
+
+void test_crc32_check_value(void)
+{
+    TEST_ASSERT_EQUAL_HEX32(0xCBF43926, crc32(CHECK, 9));
+    TEST_ASSERT_EQUAL_HEX32(0x00000000, crc32(CHECK, 0));
+    TEST_ASSERT_EQUAL_HEX32(0x414FA339, crc32("The quick brown fox jumps over the lazy dog", 43));
+}
+
+void test_crc32_can_be_carried_on(void)
+{
+    uint32_t crc = CRC32_INIT;
+    for (size_t i = 0; i < 9; i++) {
+        crc = crc32Update(crc, CHECK + i, 1);
+    }
+    TEST_ASSERT_EQUAL_HEX32(0xCBF43926, ~crc);
+}
+
+void test_crc32_catches_a_flipped_bit(void)
+{
+    std::vector<uint8_t> data(4096, 0xA5);
+    uint32_t good = crc32(data.data(), data.size());
+    for (size_t bit = 0; bit < data.size() * 8; bit += 97) {
+        data[bit / 8] ^= 1 << (bit % 8);
+        TEST_ASSERT_NOT_EQUAL(good, crc32(data.data(), data.size()));
+        data[bit / 8] ^= 1 << (bit % 8);
+    }
+}
+
+// The published FNV-1a 32-bit test vectors
+void test_fnv1a_check_values(void)
+{
+    TEST_ASSERT_EQUAL_HEX32(0x811C9DC5, fnv1a("", 0));
+    TEST_ASSERT_EQUAL_HEX32(0xE40C292C, fnv1a("a", 1));
+    TEST_ASSERT_EQUAL_HEX32(0xBF9CF968, fnv1a("foobar", 6));
+}
+
+void test_fnv1a_can_be_carried_on(void)
+{
+    uint32_t hash = FNV1A_INIT;
+    hash = fnv1aUpdate(hash, "foo", 3);
+    hash = fnv1aUpdate(hash, "bar", 3);
+    TEST_ASSERT_EQUAL_HEX32(0xBF9CF968, hash);
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_crc32_check_value);
+    RUN_TEST(test_crc32_can_be_carried_on);
+    RUN_TEST(test_crc32_catches_a_flipped_bit);
+    RUN_TEST(test_fnv1a_check_values);
+    RUN_TEST(test_fnv1a_can_be_carried_on);
+    return UNITY_END();
+}
@@ -0,0 +1,192 @@
+// The audio journal on the fake flash: a sealed recording verifies, a bit
+// flipped in one block is caught at that block, a torn header is turned
+// away without reading past the CRCs it has room for, recordings wrap
+// round the region and are found again after a reboot, and the upload
+// manager's wait after each failed upload doubles up to JOURNAL_RETRY_MAX_MS.
+
+#include <Arduino.h>
+#include <unity.h>
+
+#include <string>
+#include <vector>
+
+#include "audio_journal.h"
+#include "upload_manager.h"
+
+// A recording of length bytes that differs from one sequence to the next
+static JournalRecord record(AudioJournal &journal, size_t length)
+{
+    size_t address = journal.beginRecord();
+
+    std::vector<uint8_t> data(length);
+    for (size_t i = 0; i < length; i++) {
+        data[i] = (uint8_t)(i * 7 + address / 4096);
+    }
+    sfud_write(sfud_get_device_table() + 0, address, length, data.data());
+
+    return journal.seal(length);
+}
+
+static bool logged(const char *text)
+{
+    return fake::serialOutput().find(text) != std::string::npos;
+}
+
+void setUp(void)
+{
+    fake::flash().reset();
+    fake::server().reset();
+    fake::network() = fake::NetworkConditions();
+    fake::serialOutput().clear();
+    sfud_init();
+}
+
+void tearDown(void)
+{
+}
+
+void test_sealed_recording_verifies(void)
+{
+    AudioJournal journal;
+    journal.init();
+
+    JournalRecord sealed = record(journal, 3 * JOURNAL_CRC_BLOCK + 100);
+
+    TEST_ASSERT_EQUAL(1, journal.pendingCount());
+    TEST_ASSERT_TRUE(journal.verify(sealed));
+}
+
+void test_bit_flip_fails_its_block(void)
+{
+    AudioJournal journal;
+    journal.init();
+
+    JournalRecord sealed = record(journal, 3 * JOURNAL_CRC_BLOCK + 100);
+    fake::flash().memory[sealed.address + JOURNAL_CRC_BLOCK + 10] ^= 0x04;
+
+    TEST_ASSERT_FALSE(journal.verify(sealed));
+    TEST_ASSERT_TRUE(logged("Journal record fails its CRC at block 1"));
+}
+
+void test_torn_header_is_rejected(void)
+{
+    // A header that made it to flash with its magic but a length no
+    // recording can have, so far more blocks than it holds CRCs for
+    uint32_t torn[3] = {JOURNAL_MAGIC, 0, 1024 * 1024};
+    sfud_write(sfud_get_device_table() + 0, JOURNAL_FLASH_OFFSET, sizeof(torn), (uint8_t *)torn);
+
+    AudioJournal journal;
+    journal.init();
+
+    JournalRecord pending;
+    TEST_ASSERT_TRUE(journal.oldestPending(pending));
+    TEST_ASSERT_EQUAL(1024 * 1024, pending.length);
+    TEST_ASSERT_FALSE(journal.verify(pending));
+    TEST_ASSERT_TRUE(logged("Journal record is longer than a recording can be"));
+
+    // One cut off before its length was written is never sealed
+    fake::flash().reset();
+    journal.init();
+    journal.beginRecord();
+    journal.init();
+    TEST_ASSERT_EQUAL(0, journal.pendingCount());
+}
+
+void test_recordings_wrap_round_the_region(void)
+{
+    AudioJournal journal;
+    journal.init();
+
+    size_t length = journal.recordCapacity();
+    size_t fit = JOURNAL_FLASH_SIZE / (length + JOURNAL_HEADER_SIZE);
+    for (size_t i = 0; i < fit; i++) {
+        record(journal, length);
+    }
+
+    JournalRecord wrapped = record(journal, length);
+    TEST_ASSERT_EQUAL(JOURNAL_FLASH_OFFSET + JOURNAL_HEADER_SIZE, wrapped.address);
+    TEST_ASSERT_EQUAL(fit, wrapped.sequence);
+    TEST_ASSERT_TRUE(journal.verify(wrapped));
+
+    // What is still pending wasn't overwritten, and survives a reboot
+    TEST_ASSERT_EQUAL(JOURNAL_MAX_PENDING, journal.pendingCount());
+    AudioJournal rebooted;
+    rebooted.init();
+    TEST_ASSERT_EQUAL(JOURNAL_MAX_PENDING, rebooted.pendingCount());
+
+    JournalRecord pending;
+    while (rebooted.oldestPending(pending)) {
+        TEST_ASSERT_TRUE(rebooted.verify(pending));
+        rebooted.markUploaded(pending);
+    }
+    TEST_ASSERT_EQUAL(fit, pending.sequence);
+
+    // The next recording goes after the newest, not after the highest address
+    TEST_ASSERT_EQUAL(wrapped.address + length + JOURNAL_HEADER_SIZE, rebooted.beginRecord());
+}
+
+static String recognized;
+
+static void textRecognized(const String &text)
+{
+    recognized = text;
+}
+
+void test_upload_backoff_doubles_up_to_the_cap(void)
+{
+    static int status;
+    status = 503;
+    fake::server().handler = [](const fake::HttpRequest &request) {
+        if (request.path.find("issuetoken") != std::string::npos) {
+            return fake::httpResponse(200, "token", "text/plain");
+        }
+        return fake::httpResponse(status, "{\"RecognitionStatus\":\"Success\",\"DisplayText\":\"Set a timer.\"}");
+    };
+
+    AudioJournal journal;
+    journal.init();
+    record(journal, 2 * JOURNAL_CRC_BLOCK);
+
+    speechToText.init();
+    UploadManager uploads(journal, speechToText, textRecognized);
+
+    const unsigned long expected[] = {30000, 60000, 120000, 240000, 480000, 600000, 600000};
+    for (unsigned long wait : expected) {
+        TEST_ASSERT_TRUE(uploads.isDue());
+        uploads.uploadNext();
+        while (speechToText.busy()) {
+            asyncHttp.poll();
+            speechToText.poll();
+            fake::advanceMillis(1);
+        }
+        TEST_ASSERT_EQUAL(1, journal.pendingCount());
+
+        unsigned long failed = millis();
+        while (!uploads.isDue()) {
+            fake::advanceMillis(100);
+        }
+        TEST_ASSERT_UINT32_WITHIN(100, wait, millis() - failed);
+    }
+
+    status = 200;
+    uploads.uploadNext();
+    while (speechToText.busy()) {
+        asyncHttp.poll();
+        speechToText.poll();
+        fake::advanceMillis(1);
+    }
+
+    TEST_ASSERT_EQUAL(0, journal.pendingCount());
+    TEST_ASSERT_EQUAL_STRING("Set a timer.", recognized.c_str());
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_sealed_recording_verifies);
+    RUN_TEST(test_bit_flip_fails_its_block);
+    RUN_TEST(test_torn_header_is_rejected);
+    RUN_TEST(test_recordings_wrap_round_the_region);
+    RUN_TEST(test_upload_backoff_doubles_up_to_the_cap);
+    return UNITY_END();
+}
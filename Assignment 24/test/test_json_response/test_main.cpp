@@ -0,0 +1,297 @@
+// Reading cloud responses straight off the connection: big bodies have to
+// parse into the small filtered documents, chunked bodies have to come out
+// whole wherever the chunks split them, and the connection has to be left
+// at the start of the next response. On a slow network read() and
+// available() must not wait for the chunk framing, and a body that runs
+// until the server closes must not end when a read runs out of time.
+
+#include <Arduino.h>
+#include <WiFiClient.h>
+#include <unity.h>
+
+#include <string>
+
+#include "json_response.h"
+
+// Pads a recognition result with fields nobody asks for
+static std::string recognitionResult(size_t padding)
+{
+    std::string body = "{\"RecognitionStatus\":\"Success\",\"Offset\":1200000,\"NBest\":[";
+    while (body.size() < padding) {
+        body += "{\"Confidence\":0.93,\"Lexical\":\"set a two minute timer\",\"ITN\":\"set a 2 minute timer\"},";
+    }
+    body += "{}],\"DisplayText\":\"Set a 2 minute timer.\",\"Duration\":21000000}";
+    return body;
+}
+
+static std::string voiceList(size_t count)
+{
+    std::string body = "[";
+    for (size_t i = 0; i < count; i++) {
+        body += (i ? "," : "");
+        body += "{\"Name\":\"Microsoft Server Speech Text to Speech Voice (en-GB, Voice" + std::to_string(i) +
+                ")\",\"ShortName\":\"en-GB-Voice" + std::to_string(i) + "Neural\",\"Gender\":\"Female\",\"Locale\":\"en-GB\"}";
+    }
+    return body + "]";
+}
+
+// Reads a response's headers off client, as AsyncHttpRequest does before
+// handing the body on
+static int readHeaders(WiFiClient &client, long &length, bool &chunked)
+{
+    length = -1;
+    chunked = false;
+
+    String status = client.readStringUntil('\n');
+    String line;
+    while ((line = client.readStringUntil('\n')) != "\r" && line.length() > 0) {
+        line.toLowerCase();
+        if (line.startsWith("content-length:")) {
+            length = atol(line.c_str() + 15);
+        } else if (line.startsWith("transfer-encoding:") && line.indexOf("chunked") >= 0) {
+            chunked = true;
+        }
+    }
+    return atoi(status.c_str() + 9);
+}
+
+static void sendRequest(WiFiClient &client, const char *path)
+{
+    client.print(String("GET ") + path + " HTTP/1.1\r\nHost: example.com\r\n\r\n");
+}
+
+static WiFiClient *connect()
+{
+    WiFiClient *client = new WiFiClient();
+    TEST_ASSERT_EQUAL(1, client->connect("example.com", 80));
+    client->setTimeout(2000);
+    return client;
+}
+
+void setUp(void)
+{
+    fake::server().reset();
+    fake::network() = fake::NetworkConditions();
+    fake::network().downloadBytesPerMs = 100;
+
+    fake::server().handler = [](const fake::HttpRequest &request) {
+        if (request.path == "/big") {
+            return fake::httpResponse(200, recognitionResult(20000));
+        }
+        if (request.path.rfind("/chunked/", 0) == 0) {
+            size_t size = strtoul(request.path.c_str() + 9, NULL, 10);
+            return fake::chunkedHttpResponse(200, recognitionResult(3000), size);
+        }
+        if (request.path == "/voices") {
+            return fake::chunkedHttpResponse(200, voiceList(200), 1000);
+        }
+        if (request.path == "/close") {
+            return "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\nConnection: close\r\n\r\n" + recognitionResult(2000);
+        }
+        return fake::httpResponse(200, "{\"DisplayText\":\"Next.\"}");
+    };
+}
+
+void tearDown(void)
+{
+}
+
+void test_a_big_body_parses_into_a_small_document(void)
+{
+    WiFiClient *client = connect();
+    sendRequest(*client, "/big");
+
+    long length;
+    bool chunked;
+    TEST_ASSERT_EQUAL(200, readHeaders(*client, length, chunked));
+    TEST_ASSERT_GREATER_THAN(20000, length);
+
+    HttpBodyStream body(*client, length, chunked);
+    StaticJsonDocument<JSON_RESPONSE_SIZE> doc;
+    TEST_ASSERT_TRUE(parseJsonField(body, "DisplayText", doc));
+    TEST_ASSERT_EQUAL_STRING("Set a 2 minute timer.", doc["DisplayText"] | "");
+    TEST_ASSERT_TRUE(body.drain());
+
+    // Nothing of the first body is left ahead of the next response
+    sendRequest(*client, "/next");
+    TEST_ASSERT_EQUAL(200, readHeaders(*client, length, chunked));
+    HttpBodyStream next(*client, length, chunked);
+    TEST_ASSERT_TRUE(parseJsonField(next, "DisplayText", doc));
+    TEST_ASSERT_EQUAL_STRING("Next.", doc["DisplayText"] | "");
+
+    delete client;
+}
+
+// Chunk sizes that split the field, its name and the chunk lines
+// themselves at every offset
+void test_chunked_bodies_come_out_whole(void)
+{
+    const size_t sizes[] = {1, 2, 7, 64, 333, 4096};
+    for (size_t size : sizes) {
+        WiFiClient *client = connect();
+        std::string path = "/chunked/" + std::to_string(size);
+        sendRequest(*client, path.c_str());
+
+        long length;
+        bool chunked;
+        TEST_ASSERT_EQUAL(200, readHeaders(*client, length, chunked));
+        TEST_ASSERT_TRUE(chunked);
+
+        HttpBodyStream body(*client, length, chunked);
+        std::string text;
+        char block[100];
+        size_t read;
+        while ((read = body.readBytes(block, sizeof(block))) > 0) {
+            text.append(block, read);
+        }
+        TEST_ASSERT_TRUE(text == recognitionResult(3000));
+        TEST_ASSERT_TRUE(body.drain());
+
+        sendRequest(*client, "/next");
+        TEST_ASSERT_EQUAL_MESSAGE(200, readHeaders(*client, length, chunked), path.c_str());
+
+        delete client;
+    }
+}
+
+void test_chunked_field_parses_and_leaves_the_connection_ready(void)
+{
+    WiFiClient *client = connect();
+    sendRequest(*client, "/chunked/7");
+
+    long length;
+    bool chunked;
+    readHeaders(*client, length, chunked);
+    HttpBodyStream body(*client, length, chunked);
+    StaticJsonDocument<JSON_RESPONSE_SIZE> doc;
+    TEST_ASSERT_TRUE(parseJsonField(body, "DisplayText", doc));
+    TEST_ASSERT_EQUAL_STRING("Set a 2 minute timer.", doc["DisplayText"] | "");
+    TEST_ASSERT_TRUE(body.drain());
+
+    sendRequest(*client, "/next");
+    TEST_ASSERT_EQUAL(200, readHeaders(*client, length, chunked));
+    HttpBodyStream next(*client, length, chunked);
+    TEST_ASSERT_TRUE(parseJsonField(next, "DisplayText", doc));
+    TEST_ASSERT_EQUAL_STRING("Next.", doc["DisplayText"] | "");
+
+    delete client;
+}
+
+// The voice list runs to tens of KB, only the first voice is parsed
+void test_first_element_of_a_long_list(void)
+{
+    WiFiClient *client = connect();
+    sendRequest(*client, "/voices");
+
+    long length;
+    bool chunked;
+    readHeaders(*client, length, chunked);
+    HttpBodyStream body(*client, length, chunked);
+    StaticJsonDocument<JSON_RESPONSE_SIZE> doc;
+    TEST_ASSERT_TRUE(parseFirstJsonElement(body, doc));
+    TEST_ASSERT_EQUAL_STRING("en-GB-Voice0Neural", doc["ShortName"] | "");
+    TEST_ASSERT_TRUE(body.drain());
+
+    sendRequest(*client, "/next");
+    TEST_ASSERT_EQUAL(200, readHeaders(*client, length, chunked));
+
+    delete client;
+}
+
+void test_body_that_runs_until_the_server_closes(void)
+{
+    WiFiClient *client = connect();
+    sendRequest(*client, "/close");
+
+    long length;
+    bool chunked;
+    readHeaders(*client, length, chunked);
+    TEST_ASSERT_EQUAL(-1, length);
+    TEST_ASSERT_FALSE(chunked);
+
+    HttpBodyStream body(*client, length, chunked);
+    StaticJsonDocument<JSON_RESPONSE_SIZE> doc;
+    TEST_ASSERT_TRUE(parseJsonField(body, "DisplayText", doc));
+    TEST_ASSERT_EQUAL_STRING("Set a 2 minute timer.", doc["DisplayText"] | "");
+
+    delete client;
+}
+
+void test_slow_chunked_body_reads_without_waiting(void)
+{
+    fake::network().downloadBytesPerMs = 1;
+    WiFiClient *client = connect();
+    sendRequest(*client, "/chunked/7");
+
+    long length;
+    bool chunked;
+    readHeaders(*client, length, chunked);
+    HttpBodyStream body(*client, length, chunked);
+
+    // The chunk sizes trickle in a byte at a time along with the data
+    std::string text;
+    uint64_t deadline = fake::clockMicros() + 60000000;
+    while (text.size() < recognitionResult(3000).size() && fake::clockMicros() < deadline) {
+        uint64_t before = fake::clockMicros();
+        for (int available = body.available(); available > 0; available--) {
+            text += (char)body.read();
+        }
+        int c = body.read();
+        TEST_ASSERT_EQUAL(before, fake::clockMicros());
+
+        if (c >= 0) {
+            text += (char)c;
+        }
+        fake::advanceMillis(1);
+    }
+
+    TEST_ASSERT_TRUE(text == recognitionResult(3000));
+    TEST_ASSERT_TRUE(body.drain());
+
+    sendRequest(*client, "/next");
+    TEST_ASSERT_EQUAL(200, readHeaders(*client, length, chunked));
+
+    delete client;
+}
+
+void test_body_until_close_outlasts_read_timeouts(void)
+{
+    fake::network().downloadBytesPerMs = 1;
+    WiFiClient *client = connect();
+    sendRequest(*client, "/close");
+
+    long length;
+    bool chunked;
+    readHeaders(*client, length, chunked);
+
+    // Every read that finds nothing there times out at once
+    client->setTimeout(0);
+    HttpBodyStream body(*client, length, chunked);
+
+    std::string text;
+    char block[64];
+    uint64_t deadline = fake::clockMicros() + 60000000;
+    while (text.size() < recognitionResult(2000).size() && fake::clockMicros() < deadline) {
+        text.append(block, body.readBytes(block, sizeof(block)));
+        fake::advanceMillis(1);
+    }
+
+    TEST_ASSERT_TRUE(text == recognitionResult(2000));
+    TEST_ASSERT_FALSE(body.drain());
+    TEST_ASSERT_EQUAL(-1, body.read());
+
+    delete client;
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_a_big_body_parses_into_a_small_document);
+    RUN_TEST(test_chunked_bodies_come_out_whole);
+    RUN_TEST(test_chunked_field_parses_and_leaves_the_connection_ready);
+    RUN_TEST(test_first_element_of_a_long_list);
+    RUN_TEST(test_body_that_runs_until_the_server_closes);
+    RUN_TEST(test_slow_chunked_body_reads_without_waiting);
+    RUN_TEST(test_body_until_close_outlasts_read_timeouts);
+    return UNITY_END();
+}
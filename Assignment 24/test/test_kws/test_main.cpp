@@ -0,0 +1,129 @@
+// The keyword spotter on a small DS-CNN with synthetic weights, written
+// by tools/make_kws_fixture.py through the exporter. The int8 layers have
+// to match the TensorFlow Lite reference kernels bit for bit, and the
+// spotter has to smooth the scores and fire once per utterance.
+
+#define KWS_MODEL_HEADER "kws_fixture_model.h"
+
+#include <Arduino.h>
+#include <unity.h>
+
+#include <vector>
+
+#include "clips.h"
+#include "keyword_spotter.h"
+#include "kws_fixture_replay.h"
+
+#define INPUT_SIZE (KWS_FRAMES * MFCC_COEFFS)
+
+static int8_t buffers[2][KWS_MODEL_MAX_ACTIVATIONS];
+
+static size_t layerSize(const DsCnnLayer &layer)
+{
+    return (size_t)layer.out_h * layer.out_w * layer.out_c;
+}
+
+void setUp(void)
+{
+    memset(buffers, 0, sizeof(buffers));
+}
+
+void tearDown(void)
+{
+}
+
+void test_fixture_fits_the_spotter(void)
+{
+    TEST_ASSERT_EQUAL(KWS_FRAMES, KWS_MODEL_LAYERS[0].in_h);
+    TEST_ASSERT_EQUAL(MFCC_COEFFS, KWS_MODEL_LAYERS[0].in_w);
+    TEST_ASSERT_EQUAL(KWS_MODEL_CLASSES, layerSize(KWS_MODEL_LAYERS[KWS_MODEL_LAYER_COUNT - 1]));
+
+    for (size_t i = 0; i < KWS_MODEL_LAYER_COUNT; i++) {
+        TEST_ASSERT_LESS_OR_EQUAL(KWS_MODEL_MAX_ACTIVATIONS, layerSize(KWS_MODEL_LAYERS[i]));
+    }
+}
+
+void test_each_layer_matches_the_reference(void)
+{
+    const int8_t *in = kws_replay_input_0;
+    for (size_t i = 0; i < KWS_MODEL_LAYER_COUNT; i++) {
+        const int8_t *out = DsCnn::run(KWS_MODEL_LAYERS + i, 1, in, buffers[i % 2], buffers[i % 2]);
+
+        char message[32];
+        snprintf(message, sizeof(message), "Layer %zu", i);
+        TEST_ASSERT_EQUAL_INT8_ARRAY_MESSAGE(KWS_REPLAY_LAYERS[i], out, layerSize(KWS_MODEL_LAYERS[i]), message);
+        in = out;
+    }
+}
+
+void test_logits_match_the_reference(void)
+{
+    for (size_t n = 0; n < KWS_REPLAY_COUNT; n++) {
+        const int8_t *logits = DsCnn::run(KWS_MODEL_LAYERS, KWS_MODEL_LAYER_COUNT, KWS_REPLAY_INPUTS[n],
+                                          buffers[0], buffers[1]);
+        TEST_ASSERT_EQUAL_INT8_ARRAY(KWS_REPLAY_OUTPUTS[n], logits, KWS_MODEL_CLASSES);
+    }
+}
+
+// Feeds a stride at a time and notes the frames the spotter fired on
+static std::vector<uint32_t> detections(KeywordSpotter &spotter, const std::vector<int16_t> &pcm)
+{
+    std::vector<uint32_t> frames;
+    uint32_t frame = 0;
+    for (size_t offset = 0; offset + MFCC_FRAME_STRIDE <= pcm.size(); offset += MFCC_FRAME_STRIDE) {
+        if (offset + MFCC_FRAME_STRIDE >= MFCC_FRAME_LEN) {
+            frame++;
+        }
+        if (spotter.process(pcm.data() + offset, MFCC_FRAME_STRIDE)) {
+            frames.push_back(frame);
+            TEST_ASSERT_GREATER_OR_EQUAL(KWS_THRESHOLD_PERCENT, spotter.score());
+        }
+    }
+    return frames;
+}
+
+// The fixture always favours the keyword, so the spotter fires as soon as
+// the window is full and the smoothing has caught up, then waits for the
+// scores to build up again
+void test_spotter_fires_once_the_scores_are_smoothed(void)
+{
+    KeywordSpotter *spotter = new KeywordSpotter();
+    spotter->init();
+
+    std::vector<uint32_t> frames = detections(*spotter, clips::roomTone(1700).pcm());
+
+    const uint32_t first = KWS_FRAMES + KWS_SMOOTHING * KWS_INFERENCE_FRAMES - 1;
+    TEST_ASSERT_EQUAL(2, frames.size());
+    TEST_ASSERT_EQUAL(first, frames[0]);
+    TEST_ASSERT_EQUAL(first + KWS_SMOOTHING * KWS_INFERENCE_FRAMES, frames[1]);
+
+    delete spotter;
+}
+
+void test_reset_forgets_the_window(void)
+{
+    KeywordSpotter *spotter = new KeywordSpotter();
+    spotter->init();
+
+    std::vector<int16_t> pcm = clips::roomTone(1400).pcm();
+    TEST_ASSERT_EQUAL(1, detections(*spotter, pcm).size());
+
+    spotter->reset();
+    TEST_ASSERT_EQUAL(0, spotter->score());
+    std::vector<uint32_t> frames = detections(*spotter, pcm);
+    TEST_ASSERT_EQUAL(1, frames.size());
+    TEST_ASSERT_EQUAL(KWS_FRAMES + KWS_SMOOTHING * KWS_INFERENCE_FRAMES - 1, frames[0]);
+
+    delete spotter;
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_fixture_fits_the_spotter);
+    RUN_TEST(test_each_layer_matches_the_reference);
+    RUN_TEST(test_logits_match_the_reference);
+    RUN_TEST(test_spotter_fires_once_the_scores_are_smoothed);
+    RUN_TEST(test_reset_forgets_the_window);
+    return UNITY_END();
+}
@@ -0,0 +1,237 @@
+#include <Arduino.h>
+#include <unity.h>
+
+#include <string>
+#include <vector>
+
+#include "mic.h"
+
+static const uint32_t BLOCK_US = (uint64_t)ADC_BUF_LEN * 1000000 / RATE;
+static const uint32_t SECTOR = 4096;
+
+static Mic *mic;
+
+void DMAC_1_Handler()
+{
+    mic->dmaHandler();
+}
+
+static std::vector<int16_t> ramp(size_t samples)
+{
+    std::vector<int16_t> clip(samples);
+    for (size_t i = 0; i < samples; i++) {
+        clip[i] = (int16_t)((i * 37) << 4);
+    }
+    return clip;
+}
+
+// Runs loop() against the DMA until the recording is ready, returning the
+// longest a single loop() took
+static uint64_t record(fake::DmaTimeline &dma)
+{
+    uint64_t worst = 0;
+    uint64_t deadline = fake::clockMicros() + 2 * SAMPLE_LENGTH_SECONDS * 1000000;
+
+    mic->startRecording();
+    while (!mic->isRecordingReady() && fake::clockMicros() < deadline) {
+        dma.run();
+
+        uint64_t start = fake::clockMicros();
+        mic->processBuffers();
+        uint64_t took = fake::clockMicros() - start;
+
+        worst = max(worst, took);
+        if (took == 0) {
+            dma.waitForBlock();
+        }
+    }
+    return worst;
+}
+
+static void checkRecording(size_t address, const std::vector<int16_t> &clip)
+{
+    const int16_t *samples = (const int16_t *)(fake::flash().memory.data() + address + 44);
+    for (size_t i = 0; i < SAMPLES; i++) {
+        TEST_ASSERT_EQUAL_INT16(clip[i], samples[i]);
+    }
+}
+
+void setUp(void)
+{
+    fake::flash().reset();
+    fake::resetAdc();
+    fake::resetDmac();
+    mic = new Mic();
+}
+
+void tearDown(void)
+{
+    delete mic;
+}
+
+void test_init_does_not_wait_on_erases(void)
+{
+    uint64_t start = fake::clockMicros();
+    mic->init(0);
+
+    TEST_ASSERT_EQUAL(0, fake::flash().erases);
+    TEST_ASSERT_LESS_THAN(1000, fake::clockMicros() - start);
+}
+
+void test_idle_loop_erases_a_few_sectors_ahead(void)
+{
+    mic->init(0);
+    for (int i = 0; i < 100; i++) {
+        uint64_t start = fake::clockMicros();
+        mic->processBuffers();
+        TEST_ASSERT_LESS_OR_EQUAL(fake::flash().timing.sectorEraseUs, fake::clockMicros() - start);
+    }
+
+    size_t sectors = (44 + MIC_ERASE_AHEAD + SECTOR - 1) / SECTOR;
+    TEST_ASSERT_EQUAL(sectors, fake::flash().erases);
+}
+
+void test_recording_erases_each_sector_once(void)
+{
+    std::vector<int16_t> clip = ramp(SAMPLES);
+    fake::feedAdc(clip.data(), clip.size());
+
+    mic->init(0);
+    fake::DmaTimeline dma(1, DMAC_1_IRQn, DMAC_1_Handler, BLOCK_US);
+    uint64_t worst = record(dma);
+
+    TEST_ASSERT_TRUE(mic->isRecordingReady());
+    TEST_ASSERT_EQUAL_UINT32(0, mic->overruns());
+    TEST_ASSERT_EQUAL(0, fake::flash().programErrors);
+    TEST_ASSERT_LESS_THAN(BLOCK_US, worst);
+    checkRecording(0, clip);
+
+    // Nothing past the recording and the erase-ahead margin was touched
+    size_t last = (BUFFER_SIZE + MIC_ERASE_AHEAD - 1) / SECTOR;
+    for (size_t sector = 0; sector < fake::Flash::CAPACITY / SECTOR; sector++) {
+        TEST_ASSERT_EQUAL(sector <= last ? 1 : 0, fake::flash().sectorErases[sector]);
+    }
+
+    // Nor is it once the recording is finished
+    uint64_t erases = fake::flash().erases;
+    for (int i = 0; i < 10; i++) {
+        mic->processBuffers();
+    }
+    TEST_ASSERT_EQUAL(erases, fake::flash().erases);
+}
+
+void test_reset_moves_the_erases_to_the_next_recording(void)
+{
+    mic->init(0);
+    fake::DmaTimeline first(1, DMAC_1_IRQn, DMAC_1_Handler, BLOCK_US);
+    record(first);
+
+    size_t address = 64 * SECTOR + 256;
+    fake::flash().clearStats();
+    uint64_t start = fake::clockMicros();
+    mic->reset(address);
+
+    TEST_ASSERT_EQUAL(0, fake::flash().erases);
+    TEST_ASSERT_LESS_THAN(1000, fake::clockMicros() - start);
+
+    // The journal erases the sector holding the record header itself
+    sfud_erase(sfud_get_device_table(), 64 * SECTOR, SECTOR);
+
+    std::vector<int16_t> clip = ramp(SAMPLES);
+    fake::feedAdc(clip.data(), clip.size());
+    fake::DmaTimeline second(1, DMAC_1_IRQn, DMAC_1_Handler, BLOCK_US);
+    record(second);
+
+    TEST_ASSERT_EQUAL_UINT32(0, mic->overruns());
+    TEST_ASSERT_EQUAL(0, fake::flash().programErrors);
+    checkRecording(address, clip);
+}
+
+void test_recording_stops_at_the_end_of_its_region(void)
+{
+    std::vector<int16_t> clip = ramp(SAMPLES);
+    fake::feedAdc(clip.data(), clip.size());
+
+    size_t size = 5 * SECTOR - 1000;
+    mic->init(SECTOR, size);
+    fake::DmaTimeline dma(1, DMAC_1_IRQn, DMAC_1_Handler, BLOCK_US);
+    record(dma);
+
+    TEST_ASSERT_TRUE(mic->isRecordingReady());
+    TEST_ASSERT_EQUAL(size, mic->recordingLength());
+    TEST_ASSERT_EQUAL(0, fake::flash().programErrors);
+
+    uint32_t dataLength;
+    memcpy(&dataLength, fake::flash().memory.data() + SECTOR + 40, sizeof(dataLength));
+    TEST_ASSERT_EQUAL_UINT32(size - 44, dataLength);
+
+    // Nothing either side of the region was erased
+    TEST_ASSERT_EQUAL(5, fake::flash().erases);
+    TEST_ASSERT_EQUAL(0, fake::flash().sectorErases[0]);
+    TEST_ASSERT_EQUAL(0, fake::flash().sectorErases[6]);
+}
+
+// Every sample of block n is n + 1, so blocks can be told apart once recorded
+static std::vector<int16_t> numberedBlocks(size_t blocks)
+{
+    std::vector<int16_t> clip(blocks * ADC_BUF_LEN);
+    for (size_t i = 0; i < clip.size(); i++) {
+        clip[i] = (int16_t)((i / ADC_BUF_LEN + 1) << 4);
+    }
+    return clip;
+}
+
+void test_full_queue_suspends_the_dma_instead_of_overwriting(void)
+{
+    std::vector<int16_t> clip = numberedBlocks(2 * SAMPLES / ADC_BUF_LEN);
+    fake::feedAdc(clip.data(), clip.size());
+
+    mic->init(0);
+    fake::DmaTimeline dma(1, DMAC_1_IRQn, DMAC_1_Handler, BLOCK_US);
+    mic->startRecording();
+
+    // loop() stalls for long enough that the whole ring fills and more
+    for (int i = 0; i < 3; i++) {
+        dma.waitForBlock();
+        dma.run();
+        mic->processBuffers();
+    }
+    fake::advanceMicros((ADC_BUF_COUNT + 3) * BLOCK_US);
+    dma.run();
+
+    TEST_ASSERT_EQUAL_UINT32(1, mic->overruns());
+    TEST_ASSERT_EQUAL_UINT8(ADC_BUF_COUNT - 1, mic->highWaterMark());
+    uint32_t lost = fake::dmac().Channel[1].lostBlocks;
+    TEST_ASSERT_GREATER_THAN(0, lost);
+
+    record(dma);
+    TEST_ASSERT_TRUE(mic->isRecordingReady());
+    TEST_ASSERT_EQUAL_UINT32(1, mic->overruns());
+    TEST_ASSERT_EQUAL_UINT32(lost, fake::dmac().Channel[1].lostBlocks);
+
+    // The held block and the ones queued ahead of it survive, in order,
+    // with only the blocks that came while the channel was suspended gone
+    const int16_t *samples = (const int16_t *)(fake::flash().memory.data() + 44);
+    int16_t previous = 0;
+    for (size_t block = 0; block < SAMPLES / ADC_BUF_LEN; block++) {
+        const int16_t *pcm = samples + block * ADC_BUF_LEN;
+        for (size_t i = 1; i < ADC_BUF_LEN; i++) {
+            TEST_ASSERT_EQUAL_INT16(pcm[0], pcm[i]);
+        }
+        TEST_ASSERT_GREATER_THAN_INT16(previous, pcm[0]);
+        TEST_ASSERT_EQUAL_INT16(block == ADC_BUF_COUNT + 3 ? previous + 16 * (lost + 1) : previous + 16, pcm[0]);
+        previous = pcm[0];
+    }
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_init_does_not_wait_on_erases);
+    RUN_TEST(test_idle_loop_erases_a_few_sectors_ahead);
+    RUN_TEST(test_recording_erases_each_sector_once);
+    RUN_TEST(test_reset_moves_the_erases_to_the_next_recording);
+    RUN_TEST(test_recording_stops_at_the_end_of_its_region);
+    RUN_TEST(test_full_queue_suspends_the_dma_instead_of_overwriting);
+    return UNITY_END();
+}
@@ -0,0 +1,97 @@
+// convertAdcToPcm() for every 12-bit reading, the ends of the range and
+// converting a block in place, as the mic does, plus a host timing.
+
+#include <Arduino.h>
+#include <unity.h>
+
+#include <chrono>
+#include <vector>
+
+#include "config.h"
+#include "pcm.h"
+
+static std::vector<uint16_t> readings(size_t count, uint32_t seed)
+{
+    std::vector<uint16_t> data(count);
+    for (size_t i = 0; i < count; i++) {
+        seed = seed * 1664525 + 1013904223;
+        data[i] = (seed >> 16) & 0x0FFF;
+    }
+    return data;
+}
+
+void setUp(void)
+{
+}
+
+void tearDown(void)
+{
+}
+
+void test_every_reading_converts(void)
+{
+    std::vector<uint16_t> all(4096);
+    for (size_t i = 0; i < all.size(); i++) {
+        all[i] = i;
+    }
+
+    std::vector<int16_t> pcm(all.size() + 1, 0x5A5A);
+    convertAdcToPcm(all.data(), pcm.data(), all.size());
+
+    for (size_t i = 0; i < all.size(); i++) {
+        TEST_ASSERT_EQUAL_INT16(((int)i - 2048) * 16, pcm[i]);
+    }
+    // Nothing written past the end
+    TEST_ASSERT_EQUAL_INT16(0x5A5A, pcm[all.size()]);
+}
+
+void test_range_ends_map_to_full_scale(void)
+{
+    uint16_t src[4] = {0, 2048, 4095, 2047};
+    int16_t dst[4];
+    convertAdcToPcm(src, dst, 4);
+
+    TEST_ASSERT_EQUAL_INT16(-32768, dst[0]);
+    TEST_ASSERT_EQUAL_INT16(0, dst[1]);
+    TEST_ASSERT_EQUAL_INT16(32752, dst[2]);
+    TEST_ASSERT_EQUAL_INT16(-16, dst[3]);
+}
+
+void test_converts_in_place(void)
+{
+    std::vector<uint16_t> src = readings(ADC_BUF_LEN, 3);
+    std::vector<int16_t> expected(ADC_BUF_LEN);
+    convertAdcToPcm(src.data(), expected.data(), ADC_BUF_LEN);
+
+    convertAdcToPcm(src.data(), (int16_t *)src.data(), ADC_BUF_LEN);
+
+    TEST_ASSERT_EQUAL_INT16_ARRAY(expected.data(), (int16_t *)src.data(), ADC_BUF_LEN);
+}
+
+void test_benchmark(void)
+{
+    std::vector<uint16_t> src = readings(ADC_BUF_LEN, 4);
+    std::vector<int16_t> dst(ADC_BUF_LEN);
+
+    const int rounds = 2000;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (int i = 0; i < rounds; i++) {
+        convertAdcToPcm(src.data(), dst.data(), ADC_BUF_LEN);
+        __asm__ __volatile__("" : : "r"(dst.data()) : "memory");
+    }
+    uint64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count() / rounds;
+
+    char report[96];
+    snprintf(report, sizeof(report), "%u samples: %llu ns (host)", ADC_BUF_LEN, (unsigned long long)ns);
+    TEST_MESSAGE(report);
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_every_reading_converts);
+    RUN_TEST(test_range_ends_map_to_full_scale);
+    RUN_TEST(test_converts_in_place);
+    RUN_TEST(test_benchmark);
+    return UNITY_END();
+}
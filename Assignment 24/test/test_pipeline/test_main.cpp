@@ -0,0 +1,188 @@
+// Capture to flash and upload, end to end on the native environment: the
+// simulated DMAC fills the mic's ring from ADC1 in device time, loop()
+// drains it into flash, and the recording is uploaded from flash to the
+// loopback speech service. Device times come from the fakes' clock, host
+// times from std::chrono.
+
+#include <Arduino.h>
+#include <unity.h>
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "mic.h"
+#include "speech_to_text.h"
+
+static const uint32_t BLOCK_US = (uint64_t)ADC_BUF_LEN * 1000000 / RATE;
+
+static Mic *mic;
+
+void DMAC_1_Handler()
+{
+    mic->dmaHandler();
+}
+
+struct CaptureStats {
+    uint64_t worstBlockUs;
+    uint64_t hostNs;
+    uint32_t blocks;
+};
+
+// A few syllables of voiced sound with pauses between, loud enough for the VAD
+static std::vector<int16_t> speechLikeClip(size_t samples)
+{
+    std::vector<int16_t> clip(samples);
+    uint32_t noise = 12345;
+    for (size_t i = 0; i < samples; i++) {
+        double t = (double)i / RATE;
+        double envelope = fmod(t, 0.4) < 0.25 ? sin(M_PI * fmod(t, 0.4) / 0.25) : 0;
+        noise = noise * 1664525 + 1013904223;
+        double voiced = sin(2 * M_PI * 140 * t) + 0.5 * sin(2 * M_PI * 280 * t) + 0.3 * sin(2 * M_PI * 700 * t);
+        clip[i] = (int16_t)(envelope * 9000 * voiced + (int16_t)(noise >> 16) / 256);
+    }
+    return clip;
+}
+
+// Runs loop()'s part of a recording until it is ready
+static CaptureStats record(const std::vector<int16_t> &clip)
+{
+    fake::feedAdc(clip.data(), clip.size());
+    fake::DmaTimeline dma(1, DMAC_1_IRQn, DMAC_1_Handler, BLOCK_US);
+
+    CaptureStats stats = {0, 0, 0};
+    uint64_t deadline = fake::clockMicros() + 2 * SAMPLE_LENGTH_SECONDS * 1000000;
+    mic->startRecording();
+
+    while (!mic->isRecordingReady() && fake::clockMicros() < deadline) {
+        stats.blocks += dma.run();
+
+        uint64_t start = fake::clockMicros();
+        std::chrono::steady_clock::time_point host = std::chrono::steady_clock::now();
+        mic->processBuffers();
+        stats.hostNs += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - host).count();
+
+        uint64_t took = fake::clockMicros() - start;
+        stats.worstBlockUs = max(stats.worstBlockUs, took);
+        if (took == 0) {
+            dma.waitForBlock();
+        }
+    }
+
+    return stats;
+}
+
+static std::string flashContents(size_t address, size_t length)
+{
+    return std::string((const char *)fake::flash().memory.data() + address, length);
+}
+
+void setUp(void)
+{
+    fake::flash().reset();
+    fake::resetAdc();
+    fake::resetDmac();
+    fake::server().reset();
+    fake::network() = fake::NetworkConditions();
+
+    mic = new Mic();
+    mic->init(0);
+}
+
+void tearDown(void)
+{
+    delete mic;
+}
+
+void test_capture_keeps_up_with_dma(void)
+{
+    std::vector<int16_t> clip = speechLikeClip(SAMPLES);
+    fake::flash().clearStats();
+
+    CaptureStats stats = record(clip);
+
+    TEST_ASSERT_TRUE(mic->isRecordingReady());
+    TEST_ASSERT_EQUAL_UINT32(0, mic->overruns());
+    TEST_ASSERT_EQUAL_UINT32(0, fake::dmac().Channel[1].lostBlocks);
+    TEST_ASSERT_EQUAL_UINT32(0, fake::flash().programErrors);
+    TEST_ASSERT_LESS_THAN(BLOCK_US, stats.worstBlockUs);
+
+    // What reached flash is the clip, less the bits the 12-bit ADC drops
+    TEST_ASSERT_EQUAL(BUFFER_SIZE, mic->recordingLength());
+    std::string recorded = flashContents(44, SAMPLES * sizeof(int16_t));
+    const int16_t *samples = (const int16_t *)recorded.data();
+    for (size_t i = 0; i < SAMPLES; i++) {
+        TEST_ASSERT_EQUAL_INT16((int16_t)(clip[i] & ~0xF), samples[i]);
+    }
+
+    char report[160];
+    snprintf(report, sizeof(report),
+             "%u blocks, worst loop() %llu us of %u us, %llu erases, %llu page programs, host %llu ns/block",
+             stats.blocks, (unsigned long long)stats.worstBlockUs, BLOCK_US,
+             (unsigned long long)fake::flash().erases, (unsigned long long)fake::flash().programs,
+             (unsigned long long)(stats.hostNs / max(stats.blocks, 1u)));
+    TEST_MESSAGE(report);
+}
+
+static String recognized;
+static bool recognitionDone;
+
+static void recognitionCallback(const String &text, void *context)
+{
+    recognized = text;
+    recognitionDone = true;
+}
+
+void test_recording_uploads_from_flash(void)
+{
+    fake::server().handler = [](const fake::HttpRequest &request) {
+        if (request.path.find("issuetoken") != std::string::npos) {
+            return fake::httpResponse(200, "token", "text/plain");
+        }
+        return fake::httpResponse(200, "{\"RecognitionStatus\":\"Success\",\"DisplayText\":\"Set a 2 minute timer.\"}");
+    };
+
+    record(speechLikeClip(SAMPLES));
+    TEST_ASSERT_TRUE(mic->isRecordingReady());
+
+    speechToText.init();
+    uint64_t deadline = fake::clockMicros() + 60000000;
+    while (speechToText.AccessToken().length() == 0 && fake::clockMicros() < deadline) {
+        asyncHttp.poll();
+        fake::advanceMillis(1);
+    }
+
+    recognitionDone = false;
+    uint64_t start = fake::clockMicros();
+    std::chrono::steady_clock::time_point host = std::chrono::steady_clock::now();
+
+    TEST_ASSERT_TRUE(speechToText.convertSpeechToText(mic->recordingLength(), NULL, 0, recognitionCallback, NULL));
+    while (!recognitionDone && fake::clockMicros() < start + 60000000) {
+        asyncHttp.poll();
+        speechToText.poll();
+        fake::advanceMillis(1);
+    }
+
+    uint64_t hostNs = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - host).count();
+
+    TEST_ASSERT_TRUE(recognitionDone);
+    TEST_ASSERT_EQUAL_STRING("Set a 2 minute timer.", recognized.c_str());
+
+    const fake::HttpRequest &upload = fake::server().requests.back();
+    TEST_ASSERT_EQUAL_STRING("Bearer token", upload.header("authorization").c_str());
+    TEST_ASSERT_TRUE(upload.body == flashContents(0, mic->recordingLength()));
+
+    char report[128];
+    snprintf(report, sizeof(report), "%u bytes uploaded from flash in %llu ms device time, host %llu us",
+             (unsigned)upload.body.size(), (unsigned long long)(fake::clockMicros() - start) / 1000,
+             (unsigned long long)hostNs / 1000);
+    TEST_MESSAGE(report);
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_capture_keeps_up_with_dma);
+    RUN_TEST(test_recording_uploads_from_flash);
+    return UNITY_END();
+}
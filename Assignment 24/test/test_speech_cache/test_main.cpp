@@ -0,0 +1,119 @@
+// The SD card phrase cache: a hit only marks the index for saving, which
+// update() does once SPEECH_CACHE_SAVE_MS has passed, while adding a
+// phrase saves it at once. The least recently used phrases go first.
+
+#include <Arduino.h>
+#include <unity.h>
+
+#include <string>
+
+#include "hash.h"
+#include "speech_cache.h"
+
+static SpeechCache *cache;
+
+// Downloads a phrase of size bytes to the partial file and stores it
+static void download(uint32_t key, size_t size)
+{
+    File file = SD.open(cache->partialPath(), FILE_WRITE);
+    std::string data(size, 'x');
+    file.write((const uint8_t *)data.data(), data.size());
+    file.close();
+    TEST_ASSERT_TRUE(cache->store(key, size));
+}
+
+static bool cached(uint32_t key)
+{
+    return SD.exists(SpeechCache::path(key).c_str());
+}
+
+void setUp(void)
+{
+    fake::sdCard().reset();
+    cache = new SpeechCache();
+    TEST_ASSERT_TRUE(cache->init());
+}
+
+void tearDown(void)
+{
+    delete cache;
+}
+
+void test_key_is_fnv1a_of_the_fields(void)
+{
+    const char fields[] = "Hello\0en-GB-Voice\0en-GB";
+    TEST_ASSERT_EQUAL_HEX32(fnv1a(fields, sizeof(fields)), SpeechCache::key("Hello", "en-GB-Voice", "en-GB"));
+    TEST_ASSERT_NOT_EQUAL(SpeechCache::key("ab", "c", "d"), SpeechCache::key("a", "bc", "d"));
+}
+
+void test_hits_wait_for_update_to_be_saved(void)
+{
+    download(1, 1000);
+    uint64_t written = fake::sdCard().bytesWritten;
+
+    for (int i = 0; i < 20; i++) {
+        TEST_ASSERT_TRUE(cache->find(1));
+        cache->update();
+    }
+    TEST_ASSERT_EQUAL_UINT32(written, fake::sdCard().bytesWritten);
+
+    fake::advanceMillis(SPEECH_CACHE_SAVE_MS);
+    cache->update();
+    TEST_ASSERT_GREATER_THAN_UINT32(written, fake::sdCard().bytesWritten);
+
+    // Nothing new to save
+    written = fake::sdCard().bytesWritten;
+    fake::advanceMillis(SPEECH_CACHE_SAVE_MS);
+    cache->update();
+    TEST_ASSERT_EQUAL_UINT32(written, fake::sdCard().bytesWritten);
+}
+
+void test_least_recently_used_phrase_goes_first(void)
+{
+    const size_t size = SPEECH_CACHE_MAX_BYTES / 3;
+    download(1, size);
+    download(2, size);
+    download(3, size);
+    TEST_ASSERT_TRUE(cache->find(1));
+
+    download(4, size);
+
+    TEST_ASSERT_TRUE(cached(1));
+    TEST_ASSERT_FALSE(cached(2));
+    TEST_ASSERT_TRUE(cached(3));
+    TEST_ASSERT_TRUE(cached(4));
+}
+
+// Once update() has saved them, hits keep their place in the order across
+// a reboot
+void test_index_survives_a_reboot(void)
+{
+    const size_t size = SPEECH_CACHE_MAX_BYTES / 3;
+    download(1, size);
+    download(2, size);
+    download(3, size);
+    TEST_ASSERT_TRUE(cache->find(1));
+    fake::advanceMillis(SPEECH_CACHE_SAVE_MS);
+    cache->update();
+
+    delete cache;
+    cache = new SpeechCache();
+    TEST_ASSERT_TRUE(cache->init());
+    TEST_ASSERT_TRUE(cache->find(3));
+    TEST_ASSERT_FALSE(cache->find(5));
+
+    download(4, size);
+    TEST_ASSERT_TRUE(cached(1));
+    TEST_ASSERT_FALSE(cached(2));
+    TEST_ASSERT_TRUE(cached(3));
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_key_is_fnv1a_of_the_fields);
+    RUN_TEST(test_hits_wait_for_update_to_be_saved);
+    RUN_TEST(test_least_recently_used_phrase_goes_first);
+    RUN_TEST(test_index_survives_a_reboot);
+    return UNITY_END();
+}
@@ -0,0 +1,288 @@
+// Speech played as it downloads from the loopback text to speech service,
+// with loop() calling speechPlayer.poll() and the speaker's DMA running on
+// the device clock: a network only just faster than playback, one slower
+// than playback, one so fast the jitter buffer spills to the SD card, a
+// phrase played back from the cache and a download that stops part way.
+// No poll() may hold loop() up for long. Until the voice list has been
+// fetched nothing is said, and a failed fetch is tried again.
+
+#include <Arduino.h>
+#include <unity.h>
+
+#include <string>
+#include <vector>
+
+#include "text_to_speech.h"
+
+static const uint32_t BLOCK_US = (uint64_t)SPEAKER_BUF_LEN * 1000000 / RATE;
+static const uint64_t WORST_POLL_US = 5000;
+
+static std::string served;
+
+void DMAC_2_Handler()
+{
+    speechPlayer.dmaHandler();
+}
+
+// A ramp that never comes out of the DAC as its silence level, so what
+// was played can be told apart from the gaps
+static std::vector<int16_t> speech(size_t samples)
+{
+    std::vector<int16_t> pcm(samples);
+    for (size_t i = 0; i < samples; i++) {
+        pcm[i] = (int16_t)(1000 + (i * 37) % 20000);
+    }
+    return pcm;
+}
+
+static std::string wav(const std::vector<int16_t> &pcm)
+{
+    uint32_t data = pcm.size() * sizeof(int16_t);
+    uint8_t header[44] = {'R', 'I', 'F', 'F', 0, 0, 0, 0, 'W', 'A', 'V', 'E',
+                          'f', 'm', 't', ' ', 16, 0, 0, 0, 1, 0, 1, 0,
+                          0, 0, 0, 0, 0, 0, 0, 0, 2, 0, 16, 0,
+                          'd', 'a', 't', 'a', 0, 0, 0, 0};
+    uint32_t riff = data + 36;
+    uint32_t rate = RATE;
+    uint32_t bytes_per_second = RATE * 2;
+    memcpy(header + 4, &riff, 4);
+    memcpy(header + 24, &rate, 4);
+    memcpy(header + 28, &bytes_per_second, 4);
+    memcpy(header + 40, &data, 4);
+    return std::string((const char *)header, sizeof(header)) + std::string((const char *)pcm.data(), data);
+}
+
+// The samples that reached the DAC, leaving out the silence around them
+static std::vector<uint16_t> played()
+{
+    std::vector<uint16_t> samples;
+    for (uint16_t sample : fake::dacOutput()) {
+        if (sample != SPEAKER_SILENCE) {
+            samples.push_back(sample);
+        }
+    }
+    return samples;
+}
+
+static void checkPlayed(const std::vector<int16_t> &pcm)
+{
+    std::vector<uint16_t> samples = played();
+    TEST_ASSERT_EQUAL(pcm.size(), samples.size());
+    for (size_t i = 0; i < pcm.size(); i++) {
+        TEST_ASSERT_EQUAL_UINT16((uint16_t)(pcm[i] ^ 0x8000) >> 4, samples[i]);
+    }
+}
+
+// The number the player last printed after label
+static long reported(const char *label)
+{
+    const std::string &output = fake::serialOutput();
+    size_t found = output.rfind(label);
+    TEST_ASSERT_TRUE(found != std::string::npos);
+    return strtol(output.c_str() + found + strlen(label), NULL, 10);
+}
+
+static bool cached(const String &text)
+{
+    return SD.exists(SpeechCache::path(SpeechCache::key(text, "en-GB-Voice", LANGUAGE)).c_str());
+}
+
+static void spoken(void *context)
+{
+    *(bool *)context = true;
+}
+
+// Says text as loop() would, returning the longest any one call to
+// speechPlayer.poll() took. asyncHttp.poll() blocks for the connect.
+static uint64_t say(const String &text)
+{
+    bool said = false;
+    TEST_ASSERT_TRUE(textToSpeech.convertTextToSpeech(text, spoken, &said));
+    TEST_ASSERT_FALSE(textToSpeech.convertTextToSpeech(text));
+
+    fake::DmaTimeline dma(2, DMAC_2_IRQn, DMAC_2_Handler, BLOCK_US);
+    uint64_t worst = 0;
+    uint64_t deadline = fake::clockMicros() + 30000000;
+    while (!said && fake::clockMicros() < deadline) {
+        asyncHttp.poll();
+        uint64_t start = fake::clockMicros();
+        speechPlayer.poll();
+        worst = max(worst, fake::clockMicros() - start);
+
+        dma.run();
+        fake::advanceMillis(1);
+    }
+
+    TEST_ASSERT_TRUE(said);
+    TEST_ASSERT_FALSE(speechPlayer.busy());
+    return worst;
+}
+
+void setUp(void)
+{
+    fake::server().reset();
+    fake::network() = fake::NetworkConditions();
+    fake::sdCard().reset();
+    fake::resetDmac();
+    fake::serialOutput().clear();
+
+    TEXT_TO_SPEECH_FUNCTION_URL = "http://functions.local/api/text-to-speech";
+    GET_VOICES_FUNCTION_URL = "http://functions.local/api/get-voices";
+    served = wav(speech(RATE));
+
+    fake::server().handler = [](const fake::HttpRequest &request) {
+        if (request.path.find("get-voices") != std::string::npos) {
+            return fake::httpResponse(200, "[\"en-GB-Voice\", \"en-GB-Other\"]");
+        }
+        return fake::httpResponse(200, served, "audio/wav");
+    };
+
+    speechCache.init();
+    textToSpeech.init();
+    for (int i = 0; i < 1000; i++) {
+        asyncHttp.poll();
+        fake::advanceMillis(1);
+    }
+}
+
+void tearDown(void)
+{
+}
+
+void test_plays_as_it_downloads(void)
+{
+    std::vector<int16_t> pcm = speech(2 * RATE);
+    served = wav(pcm);
+    fake::network().downloadBytesPerMs = RATE * 2 / 1000 + 8;
+
+    uint64_t worst = say("Timer set");
+
+    TEST_ASSERT_LESS_OR_EQUAL(WORST_POLL_US, worst);
+    checkPlayed(pcm);
+    TEST_ASSERT_EQUAL(0, reported("Playback underruns: "));
+    TEST_ASSERT_LESS_THAN(PLAYBACK_START_MS + 300, reported("Time to first audio: "));
+    TEST_ASSERT_TRUE(cached("Timer set"));
+
+    char message[64];
+    snprintf(message, sizeof(message), "Worst poll %.1f ms", worst / 1000.0);
+    TEST_MESSAGE(message);
+}
+
+void test_slow_network_underruns_and_still_finishes(void)
+{
+    std::vector<int16_t> pcm = speech(RATE);
+    served = wav(pcm);
+    fake::network().downloadBytesPerMs = RATE * 2 / 1000 / 2;
+
+    uint64_t worst = say("Timer set");
+
+    TEST_ASSERT_LESS_OR_EQUAL(WORST_POLL_US, worst);
+    checkPlayed(pcm);
+    TEST_ASSERT_GREATER_THAN(0, reported("Playback underruns: "));
+    TEST_ASSERT_TRUE(cached("Timer set"));
+}
+
+void test_fast_network_spills_to_sd_card(void)
+{
+    std::vector<int16_t> pcm = speech(3 * RATE);
+    served = wav(pcm);
+
+    uint64_t worst = say("Five minute timer set");
+
+    TEST_ASSERT_LESS_OR_EQUAL(WORST_POLL_US, worst);
+    checkPlayed(pcm);
+    TEST_ASSERT_EQUAL(0, reported("Playback underruns: "));
+    TEST_ASSERT_GREATER_THAN(0, reported("spilled to SD: "));
+    TEST_ASSERT_TRUE(cached("Five minute timer set"));
+    TEST_ASSERT_FALSE(SD.exists(SPEECH_SPILL_FILE));
+}
+
+void test_cached_phrase_plays_from_sd_card(void)
+{
+    std::vector<int16_t> pcm = speech(2 * RATE);
+    served = wav(pcm);
+    say("Timer set");
+
+    size_t requests = fake::server().requests.size();
+    fake::dacOutput().clear();
+    uint64_t read = fake::sdCard().bytesRead;
+
+    uint64_t worst = say("Timer set");
+
+    TEST_ASSERT_EQUAL(requests, fake::server().requests.size());
+    TEST_ASSERT_LESS_OR_EQUAL(WORST_POLL_US, worst);
+    TEST_ASSERT_GREATER_OR_EQUAL(read + served.size(), fake::sdCard().bytesRead);
+    checkPlayed(pcm);
+    TEST_ASSERT_EQUAL(0, reported("Playback underruns: "));
+}
+
+void test_speech_that_stops_arriving_is_not_cached(void)
+{
+    std::vector<int16_t> pcm = speech(RATE);
+    fake::server().handler = [&pcm](const fake::HttpRequest &request) {
+        std::string response = fake::httpResponse(200, wav(pcm), "audio/wav");
+        return response.substr(0, response.size() - RATE);
+    };
+
+    uint64_t started = fake::clockMicros();
+    uint64_t worst = say("Timer set");
+
+    TEST_ASSERT_LESS_OR_EQUAL(WORST_POLL_US, worst);
+    TEST_ASSERT_GREATER_OR_EQUAL((uint64_t)PLAYBACK_STALL_MS * 1000, fake::clockMicros() - started);
+    TEST_ASSERT_EQUAL(pcm.size() - RATE / 2, played().size());
+    TEST_ASSERT_TRUE(fake::serialOutput().find("Speech stopped arriving") != std::string::npos);
+    TEST_ASSERT_FALSE(cached("Timer set"));
+}
+
+void test_speech_waits_for_a_voice(void)
+{
+    static int voices_status;
+    voices_status = 500;
+    fake::server().handler = [](const fake::HttpRequest &request) {
+        if (request.path.find("get-voices") != std::string::npos) {
+            return fake::httpResponse(voices_status, "[\"en-GB-Voice\", \"en-GB-Other\"]");
+        }
+        return fake::httpResponse(200, served, "audio/wav");
+    };
+
+    textToSpeech.init();
+    for (int i = 0; i < 1000; i++) {
+        asyncHttp.poll();
+        fake::advanceMillis(1);
+    }
+    TEST_ASSERT_TRUE(fake::serialOutput().find("Failed to get voices - error 500") != std::string::npos);
+
+    // Refused, without asking for speech or for the voices again too soon
+    size_t requests = fake::server().requests.size();
+    TEST_ASSERT_FALSE(textToSpeech.convertTextToSpeech("Timer set"));
+    TEST_ASSERT_EQUAL(requests, fake::server().requests.size());
+
+    // Once the retry is due, asking for speech fetches the voices again
+    voices_status = 200;
+    fake::advanceMillis(VOICES_RETRY_MS);
+    TEST_ASSERT_FALSE(textToSpeech.convertTextToSpeech("Timer set"));
+    for (int i = 0; i < 1000; i++) {
+        asyncHttp.poll();
+        fake::advanceMillis(1);
+    }
+    TEST_ASSERT_EQUAL(requests + 1, fake::server().requests.size());
+    TEST_ASSERT_TRUE(fake::server().requests.back().path.find("get-voices") != std::string::npos);
+
+    std::vector<int16_t> pcm = speech(RATE / 2);
+    served = wav(pcm);
+    say("Timer set");
+    checkPlayed(pcm);
+    TEST_ASSERT_TRUE(cached("Timer set"));
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_plays_as_it_downloads);
+    RUN_TEST(test_slow_network_underruns_and_still_finishes);
+    RUN_TEST(test_fast_network_spills_to_sd_card);
+    RUN_TEST(test_cached_phrase_plays_from_sd_card);
+    RUN_TEST(test_speech_that_stops_arriving_is_not_cached);
+    RUN_TEST(test_speech_waits_for_a_voice);
+    return UNITY_END();
+}
@@ -0,0 +1,122 @@
+// The SRAM capture backend: writes stop at the capacity reset() was given,
+// however much more comes, and a WAV header whose lengths are patched
+// after the recording reads back through the BufferStream the speech
+// upload uses.
+
+#include <Arduino.h>
+#include <unity.h>
+
+#include <string>
+#include <vector>
+
+#include "async_http.h"
+#include "codec.h"
+#include "sram_writer.h"
+
+static SramWriter writer;
+
+static std::vector<byte> pattern(size_t length, uint32_t seed)
+{
+    std::vector<byte> data(length);
+    for (size_t i = 0; i < length; i++) {
+        seed = seed * 1664525 + 1013904223;
+        data[i] = seed >> 24;
+    }
+    return data;
+}
+
+static uint32_t get32(const std::string &data, size_t offset)
+{
+    uint32_t value;
+    memcpy(&value, data.data() + offset, sizeof(value));
+    return value;
+}
+
+void setUp(void)
+{
+    writer.init();
+}
+
+void tearDown(void)
+{
+}
+
+void test_capacity_is_capped_at_the_arena(void)
+{
+    TEST_ASSERT_EQUAL(SRAM_CAPTURE_SIZE, writer.capacity());
+
+    writer.reset(0, SRAM_CAPTURE_SIZE * 2);
+    TEST_ASSERT_EQUAL(SRAM_CAPTURE_SIZE, writer.capacity());
+
+    writer.reset(0, 1000);
+    TEST_ASSERT_EQUAL(1000, writer.capacity());
+}
+
+void test_writes_stop_at_capacity(void)
+{
+    std::vector<byte> data = pattern(1500, 1);
+    writer.reset(0, 1000);
+
+    writer.write(data.data(), 600);
+    writer.write(data.data() + 600, 600);
+    writer.write(data[1200]);
+
+    TEST_ASSERT_EQUAL(1000, writer.writtenBytes());
+    TEST_ASSERT_EQUAL_MEMORY(data.data(), writer.data(), 1000);
+
+    // A new recording starts from the top of the arena again
+    writer.reset(0, 1000);
+    TEST_ASSERT_EQUAL(0, writer.writtenBytes());
+    writer.write(data.data() + 500, 100);
+    TEST_ASSERT_EQUAL(100, writer.writtenBytes());
+    TEST_ASSERT_EQUAL_MEMORY(data.data() + 500, writer.data(), 100);
+}
+
+void test_patched_header_reads_back_through_the_stream(void)
+{
+    AudioEncoder encoder(CODEC_PCM);
+    byte header[WAV_MAX_HEADER_SIZE];
+    size_t header_size = encoder.writeHeader(header);
+
+    // Room for the header and 2000 bytes of the 3000 recorded
+    std::vector<byte> pcm = pattern(3000, 2);
+    writer.reset(0, header_size + 2000);
+    writer.write(header, header_size);
+    for (size_t i = 0; i < pcm.size(); i += 320) {
+        writer.write(pcm.data() + i, min((size_t)320, pcm.size() - i));
+    }
+    writer.flush();
+
+    size_t length = writer.writtenBytes();
+    TEST_ASSERT_EQUAL(header_size + 2000, length);
+
+    uint32_t riff_length = length - 8;
+    uint32_t data_length = length - header_size;
+    writer.patch(encoder.riffLengthOffset(), (byte *)&riff_length, sizeof(riff_length));
+    writer.patch(encoder.dataLengthOffset(), (byte *)&data_length, sizeof(data_length));
+
+    // Read back as the upload does, a block at a time
+    BufferStream stream(writer.data(), length);
+    std::string uploaded;
+    char block[512];
+    size_t read;
+    while ((read = stream.readBytes(block, sizeof(block))) > 0) {
+        uploaded.append(block, read);
+    }
+
+    TEST_ASSERT_EQUAL(length, uploaded.size());
+    TEST_ASSERT_EQUAL(0, stream.available());
+    TEST_ASSERT_EQUAL_MEMORY("RIFF", uploaded.data(), 4);
+    TEST_ASSERT_EQUAL_UINT32(riff_length, get32(uploaded, encoder.riffLengthOffset()));
+    TEST_ASSERT_EQUAL_UINT32(data_length, get32(uploaded, encoder.dataLengthOffset()));
+    TEST_ASSERT_EQUAL_MEMORY(pcm.data(), uploaded.data() + header_size, 2000);
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_capacity_is_capped_at_the_arena);
+    RUN_TEST(test_writes_stop_at_capacity);
+    RUN_TEST(test_patched_header_reads_back_through_the_stream);
+    return UNITY_END();
+}
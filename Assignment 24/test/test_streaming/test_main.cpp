@@ -0,0 +1,283 @@
+// Uploading the recording while it is being made: chunks should reach the
+// loopback speech service as the audio reaches flash, so that by the time
+// the recording ends there is little left to send. Compared against
+// uploading the finished recording. Also which failures leave the
+// recording to be tried again.
+
+#include <Arduino.h>
+#include <unity.h>
+
+#include <string>
+#include <vector>
+
+#include "clips.h"
+#include "mic.h"
+#include "speech_to_text.h"
+
+static const uint32_t BLOCK_US = (uint64_t)ADC_BUF_LEN * 1000000 / RATE;
+
+static Mic *mic;
+
+void DMAC_1_Handler()
+{
+    mic->dmaHandler();
+}
+
+static String recognized;
+static bool recognitionDone;
+
+static void recognitionCallback(const String &text, void *context)
+{
+    recognized = text;
+    recognitionDone = true;
+}
+
+struct StreamStats {
+    uint64_t recordingStarted;
+    uint64_t recordingEnded;
+    uint64_t resultArrived;
+    uint64_t worstLoopUs;
+};
+
+static std::vector<int16_t> fourSeconds()
+{
+    clips::Clip clip;
+    while (clip.samples.size() < SAMPLES) {
+        clip.append(clips::phrase()).append(clips::roomTone(400));
+    }
+    return clip.pcm();
+}
+
+static void waitForResult(uint64_t timeoutUs)
+{
+    uint64_t deadline = fake::clockMicros() + timeoutUs;
+    while (!recognitionDone && fake::clockMicros() < deadline) {
+        asyncHttp.poll();
+        speechToText.poll();
+        fake::advanceMillis(1);
+    }
+}
+
+// loop() as main.cpp runs it while streaming: record, then send whatever
+// has reached flash
+static StreamStats recordStreaming(bool stream)
+{
+    std::vector<int16_t> pcm = fourSeconds();
+    StreamStats stats = {0, 0, 0, 0};
+    if (stream) {
+        TEST_ASSERT_TRUE(speechToText.beginStreaming());
+    }
+
+    fake::feedAdc(pcm.data(), pcm.size());
+    fake::DmaTimeline dma(1, DMAC_1_IRQn, DMAC_1_Handler, BLOCK_US);
+
+    mic->startRecording();
+    stats.recordingStarted = fake::clockMicros();
+    uint64_t deadline = fake::clockMicros() + 2 * SAMPLE_LENGTH_SECONDS * 1000000;
+    while (!mic->isRecordingReady() && fake::clockMicros() < deadline) {
+        dma.run();
+
+        uint64_t start = fake::clockMicros();
+        mic->processBuffers();
+        speechToText.streamRecording(mic->recordedBytes());
+        stats.worstLoopUs = max(stats.worstLoopUs, fake::clockMicros() - start);
+
+        if (fake::clockMicros() == start) {
+            dma.waitForBlock();
+        }
+    }
+    TEST_ASSERT_TRUE(mic->isRecordingReady());
+    stats.recordingEnded = fake::clockMicros();
+
+    recognitionDone = false;
+    if (stream) {
+        speechToText.finishStreaming(mic->recordingLength(), recognitionCallback, NULL);
+    } else {
+        TEST_ASSERT_TRUE(speechToText.convertSpeechToText(mic->recordingLength(), NULL, 0, recognitionCallback, NULL));
+    }
+    waitForResult(60000000);
+    stats.resultArrived = fake::clockMicros();
+
+    TEST_ASSERT_TRUE(recognitionDone);
+    TEST_ASSERT_EQUAL_STRING("Set a 2 minute timer.", recognized.c_str());
+    return stats;
+}
+
+// The recording as it is in flash, with the WAV lengths as the stream sent
+// them: still erased, since they are only known at the end
+static std::string streamedRecording()
+{
+    std::string wav((const char *)fake::flash().memory.data(), mic->recordingLength());
+    memset(&wav[4], 0xFF, 4);
+    memset(&wav[40], 0xFF, 4);
+    return wav;
+}
+
+void setUp(void)
+{
+    fake::flash().reset();
+    fake::resetAdc();
+    fake::resetDmac();
+    fake::server().reset();
+    fake::network() = fake::NetworkConditions();
+    // A 1.5 Mbit/s uplink, slow enough that the upload takes a while
+    fake::network().uploadBytesPerMs = 190;
+
+    fake::server().handler = [](const fake::HttpRequest &request) {
+        if (request.path.find("issuetoken") != std::string::npos) {
+            return fake::httpResponse(200, "token", "text/plain");
+        }
+        return fake::httpResponse(200, "{\"RecognitionStatus\":\"Success\",\"DisplayText\":\"Set a 2 minute timer.\"}");
+    };
+
+    speechToText.init();
+    uint64_t deadline = fake::clockMicros() + 60000000;
+    while (speechToText.AccessToken().length() == 0 && fake::clockMicros() < deadline) {
+        asyncHttp.poll();
+        fake::advanceMillis(1);
+    }
+
+    mic = new Mic();
+    mic->init(0);
+}
+
+void tearDown(void)
+{
+    delete mic;
+}
+
+void test_chunks_are_sent_while_recording(void)
+{
+    StreamStats stats = recordStreaming(true);
+
+    const fake::HttpRequest &upload = fake::server().requests.back();
+    TEST_ASSERT_TRUE(upload.chunked);
+    TEST_ASSERT_EQUAL_STRING("Bearer token", upload.header("authorization").c_str());
+    TEST_ASSERT_TRUE(upload.body == streamedRecording());
+
+    // Only the tail of the recording is left to go once it ends
+    size_t sentWhileRecording = 0;
+    for (size_t i = 0; i < upload.chunkSizes.size(); i++) {
+        if (upload.chunkMicros[i] <= stats.recordingEnded) {
+            sentWhileRecording += upload.chunkSizes[i];
+        }
+    }
+    TEST_ASSERT_GREATER_OR_EQUAL(mic->recordingLength() - 2 * ADC_BUF_LEN * sizeof(int16_t), sentWhileRecording);
+
+    // Chunks go out steadily through the recording, not in a burst at the end
+    TEST_ASSERT_LESS_THAN(stats.recordingStarted + 2 * BLOCK_US, upload.chunkMicros.front());
+    size_t half = 0;
+    for (size_t i = 0; i < upload.chunkSizes.size(); i++) {
+        if (upload.chunkMicros[i] <= stats.recordingStarted + SAMPLE_LENGTH_SECONDS * 500000) {
+            half += upload.chunkSizes[i];
+        }
+    }
+    TEST_ASSERT_UINT32_WITHIN(2 * ADC_BUF_LEN * sizeof(int16_t), mic->recordingLength() / 2, half);
+
+    TEST_ASSERT_LESS_THAN(BLOCK_US, stats.worstLoopUs);
+    TEST_ASSERT_EQUAL_UINT32(0, mic->overruns());
+
+    char report[128];
+    snprintf(report, sizeof(report), "%u of %u bytes sent while recording, result %llu ms after recording ended",
+             (unsigned)sentWhileRecording, (unsigned)upload.body.size(),
+             (unsigned long long)(stats.resultArrived - stats.recordingEnded) / 1000);
+    TEST_MESSAGE(report);
+}
+
+void test_streaming_gets_the_result_sooner(void)
+{
+    StreamStats streamed = recordStreaming(true);
+    uint64_t streamedWait = streamed.resultArrived - streamed.recordingEnded;
+
+    fake::flash().reset();
+    fake::resetAdc();
+    delete mic;
+    mic = new Mic();
+    mic->init(0);
+
+    StreamStats uploaded = recordStreaming(false);
+    uint64_t uploadedWait = uploaded.resultArrived - uploaded.recordingEnded;
+
+    TEST_ASSERT_TRUE(fake::server().requests.back().body == std::string((const char *)fake::flash().memory.data(), mic->recordingLength()));
+    TEST_ASSERT_LESS_THAN(uploadedWait / 2, streamedWait);
+
+    char report[128];
+    snprintf(report, sizeof(report), "result %llu ms after recording when streamed, %llu ms when uploaded after",
+             (unsigned long long)streamedWait / 1000, (unsigned long long)uploadedWait / 1000);
+    TEST_MESSAGE(report);
+}
+
+// Timeouts, throttling and server errors are worth another go later, a
+// request the service can't make sense of isn't
+void test_only_transient_failures_are_retried(void)
+{
+    static const byte audio[4096] = {};
+    const int statuses[] = {200, 400, 401, 403, 408, 429, 500, 503};
+    const bool retry[] = {false, false, true, false, true, true, true, true};
+
+    for (size_t i = 0; i < sizeof(statuses) / sizeof(statuses[0]); i++) {
+        int status = statuses[i];
+        fake::server().handler = [status](const fake::HttpRequest &request) {
+            if (request.path.find("issuetoken") != std::string::npos) {
+                return fake::httpResponse(200, "token", "text/plain");
+            }
+            return fake::httpResponse(status, "{\"RecognitionStatus\":\"Success\",\"DisplayText\":\"Hi.\"}");
+        };
+
+        recognitionDone = false;
+        TEST_ASSERT_TRUE(speechToText.convertSpeechToText(sizeof(audio), audio, 0, recognitionCallback, NULL));
+        waitForResult(60000000);
+
+        TEST_ASSERT_TRUE(recognitionDone);
+        TEST_ASSERT_EQUAL(status, speechToText.lastResponseCode());
+        TEST_ASSERT_EQUAL_MESSAGE(retry[i], speechToText.shouldRetry(), std::to_string(status).c_str());
+    }
+}
+
+// With every asyncHttp slot taken the result can't be waited for, so the
+// recognition has to end as a retryable failure rather than hang busy
+void test_a_result_that_cant_be_awaited_is_retried(void)
+{
+    static const byte audio[4096] = {};
+    WiFiClient clients[ASYNC_HTTP_MAX_REQUESTS];
+    AsyncHttpRequest others[ASYNC_HTTP_MAX_REQUESTS];
+    TEST_ASSERT_TRUE(speechToText.beginStreaming(audio));
+
+    // Whatever else is running holds the rest
+    bool full = false;
+    for (size_t i = 0; i < ASYNC_HTTP_MAX_REQUESTS && !full; i++) {
+        others[i].begin(clients[i], "http://example.com/other");
+        full = !asyncHttp.start(others[i]);
+    }
+    TEST_ASSERT_TRUE(full);
+
+    recognitionDone = false;
+    speechToText.finishStreaming(sizeof(audio), recognitionCallback, NULL);
+
+    TEST_ASSERT_TRUE(recognitionDone);
+    TEST_ASSERT_FALSE(speechToText.busy());
+    TEST_ASSERT_FALSE(speechToText.isStreaming());
+    TEST_ASSERT_TRUE(speechToText.shouldRetry());
+
+    // Once there is room the upload goes through
+    for (size_t i = 0; i < ASYNC_HTTP_MAX_REQUESTS; i++) {
+        while (others[i].busy()) {
+            asyncHttp.poll();
+            fake::advanceMillis(1);
+        }
+    }
+    recognitionDone = false;
+    TEST_ASSERT_TRUE(speechToText.convertSpeechToText(sizeof(audio), audio, 0, recognitionCallback, NULL));
+    waitForResult(60000000);
+    TEST_ASSERT_EQUAL_STRING("Set a 2 minute timer.", recognized.c_str());
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_chunks_are_sent_while_recording);
+    RUN_TEST(test_streaming_gets_the_result_sooner);
+    RUN_TEST(test_only_transient_failures_are_retried);
+    RUN_TEST(test_a_result_that_cant_be_awaited_is_retried);
+    return UNITY_END();
+}
@@ -0,0 +1,119 @@
+// The on-device timer parser against a corpus of 28 utterances. Requests
+// that set or start a timer for a duration it can account for are parsed
+// on the device. Everything else goes to the cloud: no set verb, a cancel,
+// stop or question, a negation, or a duration it can't make sense of.
+
+#include <Arduino.h>
+#include <unity.h>
+
+#include <chrono>
+
+#include "timer_parser.h"
+
+struct Utterance {
+    const char *text;
+    bool confident;
+    int seconds; // Only checked when confident
+};
+
+static const Utterance corpus[] = {
+    {"Set a 2 minute 30 second timer", true, 150},
+    {"Set a timer for five minutes", true, 300},
+    {"Start a timer for an hour and a half", true, 5400},
+    {"Set a timer for two and a half minutes", true, 150},
+    {"Set a timer for half a minute", true, 30},
+    {"Start a quarter of an hour timer", true, 900},
+    {"Set a timer for 1.5 hours", true, 5400},
+    {"Start a 90s timer", true, 90},
+    {"Set a twenty five minute timer", true, 1500},
+    {"Make a timer for three quarters of an hour", true, 2700},
+    {"Set a timer for one hundred and twenty seconds", true, 120},
+    {"Set a timer for 1 hour and 15 minutes", true, 4500},
+    {"Set a timer for two minutes and a half", true, 150},
+    {"Please start a 10 min timer", true, 600},
+    {"Set a 5min timer", true, 300},
+
+    // No verb that sets a timer
+    {"Five minutes", false, 0},
+    {"Add five minutes to my timer", false, 0},
+
+    // Cancels, stops, questions and negations
+    {"Cancel the five minute timer", false, 0},
+    {"Stop the timer", false, 0},
+    {"How long is left on my timer", false, 0},
+    {"How much time is left", false, 0},
+    {"What's left on the 10 minute timer", false, 0},
+    {"Don't set a timer for five minutes", false, 0},
+    {"Set a timer for five minutes and cancel the other one", false, 0},
+
+    // Durations it can't account for
+    {"Set a timer", false, 0},
+    {"Set a timer for 5", false, 0},
+    {"Set a timer for minutes", false, 0},
+    {"Set a 5 minute 10 minute timer", false, 0},
+};
+
+static const size_t CORPUS_SIZE = sizeof(corpus) / sizeof(corpus[0]);
+
+void setUp(void)
+{
+}
+
+void tearDown(void)
+{
+}
+
+void test_corpus_has_28_utterances(void)
+{
+    TEST_ASSERT_EQUAL(28, CORPUS_SIZE);
+}
+
+void test_set_requests_are_parsed_on_the_device(void)
+{
+    for (size_t i = 0; i < CORPUS_SIZE; i++) {
+        if (!corpus[i].confident) {
+            continue;
+        }
+
+        TimerDuration duration = TimerParser::parse(corpus[i].text);
+        TEST_ASSERT_TRUE_MESSAGE(duration.confident, corpus[i].text);
+        TEST_ASSERT_EQUAL_INT_MESSAGE(corpus[i].seconds, duration.seconds, corpus[i].text);
+    }
+}
+
+void test_everything_else_goes_to_the_cloud(void)
+{
+    for (size_t i = 0; i < CORPUS_SIZE; i++) {
+        if (corpus[i].confident) {
+            continue;
+        }
+
+        TimerDuration duration = TimerParser::parse(corpus[i].text);
+        TEST_ASSERT_FALSE_MESSAGE(duration.confident, corpus[i].text);
+    }
+}
+
+void test_report(void)
+{
+    size_t local = 0;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < CORPUS_SIZE; i++) {
+        local += TimerParser::parse(corpus[i].text).confident ? 1 : 0;
+    }
+    double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+    char message[96];
+    snprintf(message, sizeof(message), "%zu of %zu parsed on the device, %.2f us each on the host",
+             local, CORPUS_SIZE, us / CORPUS_SIZE);
+    TEST_MESSAGE(message);
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_corpus_has_28_utterances);
+    RUN_TEST(test_set_requests_are_parsed_on_the_device);
+    RUN_TEST(test_everything_else_goes_to_the_cloud);
+    RUN_TEST(test_report);
+    return UNITY_END();
+}
@@ -0,0 +1,162 @@
+// The translation cache on the fake flash: store() leaves flash alone
+// until update(), a recent translation is found in RAM without reading
+// flash, one pushed out of RAM is found again in flash or in the write
+// queue, the ring wraps and forgets the oldest sector, and a record that
+// fails its CRC is passed over for an older intact one.
+
+#include <Arduino.h>
+#include <unity.h>
+
+#include "translation_cache.h"
+
+static const size_t RING_RECORDS = TRANSLATION_FLASH_SIZE / TRANSLATION_RECORD_SIZE;
+static const size_t SECTOR_RECORDS = fake::Flash::SECTOR / TRANSLATION_RECORD_SIZE;
+
+static String text(uint32_t key)
+{
+    return String("Translation ") + String(key);
+}
+
+static void storeAll(uint32_t first, uint32_t count)
+{
+    for (uint32_t key = first; key < first + count; key++) {
+        translationCache.store(key, text(key));
+        translationCache.update();
+    }
+}
+
+static bool found(uint32_t key)
+{
+    String translation;
+    if (!translationCache.find(key, translation)) {
+        return false;
+    }
+
+    String expected = text(key);
+    TEST_ASSERT_EQUAL_STRING(expected.c_str(), translation.c_str());
+    return true;
+}
+
+void setUp(void)
+{
+    fake::flash().reset();
+    fake::serialOutput().clear();
+    sfud_init();
+    translationCache.init();
+}
+
+void tearDown(void)
+{
+}
+
+void test_store_waits_for_update_to_write(void)
+{
+    fake::flash().clearStats();
+    translationCache.store(1, text(1));
+
+    TEST_ASSERT_EQUAL(0, fake::flash().erases);
+    TEST_ASSERT_EQUAL(0, fake::flash().programs);
+    TEST_ASSERT_TRUE(found(1));
+
+    translationCache.update();
+    TEST_ASSERT_EQUAL(1, fake::flash().erases);
+    TEST_ASSERT_GREATER_THAN(0, fake::flash().programs);
+
+    // Written, so still there after a reboot
+    translationCache.init();
+    TEST_ASSERT_TRUE(found(1));
+}
+
+void test_recent_translation_is_a_ram_hit(void)
+{
+    storeAll(1, 3);
+    fake::flash().clearStats();
+
+    TEST_ASSERT_TRUE(found(2));
+    TEST_ASSERT_EQUAL(0, fake::flash().reads);
+}
+
+void test_least_recently_used_goes_back_to_flash(void)
+{
+    storeAll(1, TRANSLATION_CACHE_ENTRIES);
+
+    // Using the first keeps it in RAM, so the second is pushed out
+    TEST_ASSERT_TRUE(found(1));
+    storeAll(100, 1);
+
+    fake::flash().clearStats();
+    TEST_ASSERT_TRUE(found(1));
+    TEST_ASSERT_EQUAL(0, fake::flash().reads);
+
+    TEST_ASSERT_TRUE(found(2));
+    TEST_ASSERT_GREATER_THAN(0, fake::flash().reads);
+}
+
+void test_queued_translation_pushed_out_of_ram_is_found(void)
+{
+    // More stores than RAM holds, with no update() to write them
+    translationCache.store(300, text(300));
+    for (uint32_t key = 1; key <= TRANSLATION_CACHE_ENTRIES; key++) {
+        translationCache.store(key, text(key));
+    }
+
+    TEST_ASSERT_TRUE(fake::serialOutput().find("write queue full") != std::string::npos);
+    TEST_ASSERT_TRUE(found(300));
+
+    translationCache.update();
+    translationCache.init();
+    TEST_ASSERT_TRUE(found(300));
+    TEST_ASSERT_TRUE(found(TRANSLATION_PENDING - 1));
+    TEST_ASSERT_FALSE(found(TRANSLATION_PENDING));
+}
+
+void test_ring_wraps_and_forgets_the_oldest_sector(void)
+{
+    storeAll(0, RING_RECORDS + 10);
+
+    // Rebooted, so everything comes from flash
+    translationCache.init();
+    TEST_ASSERT_FALSE(found(0));
+    TEST_ASSERT_FALSE(found(SECTOR_RECORDS - 1));
+    TEST_ASSERT_TRUE(found(SECTOR_RECORDS));
+    TEST_ASSERT_TRUE(found(RING_RECORDS + 9));
+
+    // The next record carries on after the newest
+    storeAll(5000, 1);
+    uint32_t key;
+    memcpy(&key, fake::flash().memory.data() + TRANSLATION_FLASH_OFFSET + 10 * TRANSLATION_RECORD_SIZE + 4, sizeof(key));
+    TEST_ASSERT_EQUAL_UINT32(5000, key);
+}
+
+void test_corrupt_record_is_rejected(void)
+{
+    translationCache.store(7, "Premier");
+    translationCache.update();
+    translationCache.store(7, "Second");
+    translationCache.update();
+
+    // Flip a bit in the text of the newer record
+    fake::flash().memory[TRANSLATION_FLASH_OFFSET + TRANSLATION_RECORD_SIZE + offsetof(TranslationRecord, text)] ^= 0x01;
+
+    translationCache.init();
+    String translation;
+    TEST_ASSERT_TRUE(translationCache.find(7, translation));
+    TEST_ASSERT_EQUAL_STRING("Premier", translation.c_str());
+
+    // With no intact record left, it is a miss
+    fake::flash().memory[TRANSLATION_FLASH_OFFSET + offsetof(TranslationRecord, crc)] ^= 0x80;
+    translationCache.init();
+    TEST_ASSERT_FALSE(translationCache.find(7, translation));
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_store_waits_for_update_to_write);
+    RUN_TEST(test_recent_translation_is_a_ram_hit);
+    RUN_TEST(test_least_recently_used_goes_back_to_flash);
+    RUN_TEST(test_queued_translation_pushed_out_of_ram_is_found);
+    RUN_TEST(test_ring_wraps_and_forgets_the_oldest_sector);
+    RUN_TEST(test_corrupt_record_is_rejected);
+    return UNITY_END();
+}
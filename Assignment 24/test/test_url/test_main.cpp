@@ -0,0 +1,75 @@
+// parseUrl() on the kinds of URL config.h and the cloud functions use.
+
+#include <Arduino.h>
+#include <unity.h>
+
+#include "url.h"
+
+void setUp(void)
+{
+}
+
+void tearDown(void)
+{
+}
+
+void test_https_with_a_path(void)
+{
+    Url parts;
+    TEST_ASSERT_TRUE(parseUrl("https://westeurope.stt.speech.microsoft.com/speech/recognition?language=en-GB", parts));
+    TEST_ASSERT_EQUAL_STRING("westeurope.stt.speech.microsoft.com", parts.host);
+    TEST_ASSERT_EQUAL(443, parts.port);
+    TEST_ASSERT_EQUAL_STRING("/speech/recognition?language=en-GB", parts.path);
+}
+
+void test_http_with_a_port(void)
+{
+    Url parts;
+    TEST_ASSERT_TRUE(parseUrl("http://192.168.0.10:7071/api/text-to-timer", parts));
+    TEST_ASSERT_EQUAL_STRING("192.168.0.10", parts.host);
+    TEST_ASSERT_EQUAL(7071, parts.port);
+    TEST_ASSERT_EQUAL_STRING("/api/text-to-timer", parts.path);
+}
+
+void test_no_path_or_scheme(void)
+{
+    Url parts;
+    TEST_ASSERT_TRUE(parseUrl("https://example.com", parts));
+    TEST_ASSERT_EQUAL_STRING("example.com", parts.host);
+    TEST_ASSERT_EQUAL_STRING("/", parts.path);
+
+    TEST_ASSERT_TRUE(parseUrl("example.com:8080/x", parts));
+    TEST_ASSERT_EQUAL_STRING("example.com", parts.host);
+    TEST_ASSERT_EQUAL(8080, parts.port);
+    TEST_ASSERT_EQUAL_STRING("/x", parts.path);
+}
+
+void test_long_hosts_are_cut_short(void)
+{
+    char url[200] = "https://";
+    memset(url + 8, 'a', 100);
+    strcpy(url + 108, "/path");
+
+    Url parts;
+    TEST_ASSERT_TRUE(parseUrl(url, parts));
+    TEST_ASSERT_EQUAL(URL_HOST_SIZE - 1, strlen(parts.host));
+    TEST_ASSERT_EQUAL_STRING("/path", parts.path);
+}
+
+void test_no_host(void)
+{
+    Url parts;
+    TEST_ASSERT_FALSE(parseUrl("https:///path", parts));
+    TEST_ASSERT_FALSE(parseUrl("", parts));
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_https_with_a_path);
+    RUN_TEST(test_http_with_a_port);
+    RUN_TEST(test_no_path_or_scheme);
+    RUN_TEST(test_long_hosts_are_cut_short);
+    RUN_TEST(test_no_host);
+    return UNITY_END();
+}
@@ -0,0 +1,191 @@
+// VoiceActivityDetector on its own, block by block, and Mic's
+// voice-activated recording driven through the simulated DMA, using the
+// clips in test/fixtures/clips.h.
+
+#include <Arduino.h>
+#include <unity.h>
+
+#include <string>
+#include <vector>
+
+#include "clips.h"
+#include "mic.h"
+#include "vad.h"
+
+static const uint32_t BLOCK_US = (uint64_t)ADC_BUF_LEN * 1000000 / RATE;
+static const uint32_t TRAILING_BLOCKS = VAD_TRAILING_SILENCE_MS / ADC_BUF_MS;
+
+static Mic *mic;
+
+void DMAC_1_Handler()
+{
+    mic->dmaHandler();
+}
+
+// What the detector says about each whole block of pcm
+static std::vector<bool> classify(const std::vector<int16_t> &pcm)
+{
+    VoiceActivityDetector vad;
+    std::vector<bool> blocks;
+    for (size_t offset = 0; offset + ADC_BUF_LEN <= pcm.size(); offset += ADC_BUF_LEN) {
+        blocks.push_back(vad.isSpeech(pcm.data() + offset, ADC_BUF_LEN));
+    }
+    return blocks;
+}
+
+static size_t countSpeech(const std::vector<bool> &blocks)
+{
+    size_t count = 0;
+    for (bool speech : blocks) {
+        count += speech;
+    }
+    return count;
+}
+
+// Records in voice-activated mode until the mic stops, one way or the other
+static void recordVoiceActivated(const std::vector<int16_t> &pcm)
+{
+    fake::feedAdc(pcm.data(), pcm.size());
+    fake::DmaTimeline dma(1, DMAC_1_IRQn, DMAC_1_Handler, BLOCK_US);
+
+    uint64_t deadline = fake::clockMicros() + (uint64_t)pcm.size() * 1000000 / RATE + 1000000;
+    mic->startRecording(true);
+    while (mic->isRecording() && fake::clockMicros() < deadline) {
+        dma.run();
+        mic->processBuffers();
+        dma.waitForBlock();
+    }
+    dma.run();
+    mic->processBuffers();
+}
+
+void setUp(void)
+{
+    fake::flash().reset();
+    fake::resetAdc();
+    fake::resetDmac();
+
+    mic = new Mic();
+    mic->init(0);
+}
+
+void tearDown(void)
+{
+    delete mic;
+}
+
+void test_room_tone_is_not_speech(void)
+{
+    TEST_ASSERT_EQUAL(0, countSpeech(classify(clips::roomTone(2000).pcm())));
+}
+
+void test_mains_hum_is_not_speech(void)
+{
+    TEST_ASSERT_EQUAL(0, countSpeech(classify(clips::hum(2000).pcm())));
+}
+
+void test_fan_noise_is_not_speech(void)
+{
+    // Louder than the vowels below, but it crosses zero far too often
+    std::vector<int16_t> pcm = clips::fan(2000).pcm();
+    VoiceActivityDetector vad;
+    vad.isSpeech(pcm.data(), ADC_BUF_LEN);
+    TEST_ASSERT_GREATER_THAN(VAD_ENERGY_THRESHOLD, vad.energy());
+
+    TEST_ASSERT_EQUAL(0, countSpeech(classify(pcm)));
+}
+
+void test_quiet_speech_is_below_threshold(void)
+{
+    TEST_ASSERT_EQUAL(0, countSpeech(classify(clips::vowel(1000, 1500).pcm())));
+}
+
+void test_vowels_are_speech(void)
+{
+    const double formants[][2] = {{730, 1090}, {270, 2290}, {530, 1840}, {300, 870}};
+    for (const double *f : formants) {
+        std::vector<bool> blocks = classify(clips::vowel(1000, 20000, 120, f[0], f[1]).pcm());
+        TEST_ASSERT_EQUAL(blocks.size(), countSpeech(blocks));
+    }
+}
+
+void test_speech_over_hum_is_speech(void)
+{
+    clips::Clip clip = clips::vowel(1000);
+    clip.add(clips::hum(1000));
+    std::vector<bool> blocks = classify(clip.pcm());
+    TEST_ASSERT_EQUAL(blocks.size(), countSpeech(blocks));
+}
+
+void test_dc_offset_does_not_matter(void)
+{
+    clips::Clip clip = clips::roomTone(1000);
+    clip.append(clips::vowel(1000));
+    std::vector<bool> centred = classify(clip.pcm(0));
+    std::vector<bool> offset = classify(clip.pcm(4000));
+    TEST_ASSERT_TRUE(centred == offset);
+    TEST_ASSERT_EQUAL(10, countSpeech(centred));
+}
+
+void test_recording_follows_the_phrase(void)
+{
+    clips::Clip clip = clips::roomTone(1000);
+    clip.append(clips::phrase()).append(clips::roomTone(2000, 5)).append(clips::phrase());
+    std::vector<int16_t> pcm = clip.pcm();
+
+    // The block before speech starts, through TRAILING_BLOCKS of silence
+    // after the last speech within the first phrase
+    std::vector<bool> blocks = classify(pcm);
+    size_t first = 0;
+    while (!blocks[first]) {
+        first++;
+    }
+    size_t last = first;
+    for (size_t block = first, silent = 0; silent < TRAILING_BLOCKS; block++) {
+        silent = blocks[block] ? 0 : silent + 1;
+        last = block;
+    }
+    size_t start = (first - 1) * ADC_BUF_LEN;
+    size_t samples = (last + 1) * ADC_BUF_LEN - start;
+
+    recordVoiceActivated(pcm);
+
+    TEST_ASSERT_FALSE(mic->isRecording());
+    TEST_ASSERT_TRUE(mic->isRecordingReady());
+    TEST_ASSERT_EQUAL(44 + samples * sizeof(int16_t), mic->recordingLength());
+    TEST_ASSERT_EQUAL_INT16_ARRAY(pcm.data() + start, (const int16_t *)(fake::flash().memory.data() + 44), samples);
+
+    uint32_t data_length;
+    memcpy(&data_length, fake::flash().memory.data() + 40, sizeof(data_length));
+    TEST_ASSERT_EQUAL_UINT32(samples * sizeof(int16_t), data_length);
+}
+
+void test_no_speech_times_out(void)
+{
+    clips::Clip clip = clips::hum(VAD_ONSET_TIMEOUT_MS + 1000);
+    clip.add(clips::fan(VAD_ONSET_TIMEOUT_MS + 1000, 800));
+    std::vector<int16_t> pcm = clip.pcm();
+
+    uint64_t start = fake::clockMicros();
+    recordVoiceActivated(pcm);
+
+    TEST_ASSERT_FALSE(mic->isRecording());
+    TEST_ASSERT_FALSE(mic->isRecordingReady());
+    TEST_ASSERT_EQUAL(44, mic->recordingLength());
+    TEST_ASSERT_UINT32_WITHIN(2 * BLOCK_US, VAD_ONSET_TIMEOUT_MS * 1000, fake::clockMicros() - start);
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_room_tone_is_not_speech);
+    RUN_TEST(test_mains_hum_is_not_speech);
+    RUN_TEST(test_fan_noise_is_not_speech);
+    RUN_TEST(test_quiet_speech_is_below_threshold);
+    RUN_TEST(test_vowels_are_speech);
+    RUN_TEST(test_speech_over_hum_is_speech);
+    RUN_TEST(test_dc_offset_does_not_matter);
+    RUN_TEST(test_recording_follows_the_phrase);
+    RUN_TEST(test_no_speech_times_out);
+    return UNITY_END();
+}
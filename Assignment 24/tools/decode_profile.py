@@ -0,0 +1,74 @@
+import struct
+import sys
+
+# Decodes the ProfileReport blobs the Wio Terminal writes over Serial when
+# built with PROFILE_AUDIO. Capture the serial output to a file, e.g.
+#   pio device monitor --raw > capture.bin
+# then run
+#   python decode_profile.py capture.bin
+
+PROFILE_MAGIC = b'PROF'
+PROBES = ['dma_isr', 'block_latency', 'block_process', 'flash_erase', 'flash_program',
+          'kws_frame', 'kws_inference']
+BUCKETS = 32
+
+report_header = struct.Struct('<4sIIII')
+histogram = struct.Struct('<IIQ' + 'I' * BUCKETS)
+report_size = report_header.size + histogram.size * len(PROBES)
+
+def cycles_to_us(cycles, cpu_hz):
+    return cycles * 1000000.0 / cpu_hz
+
+def print_report(data, offset):
+    magic, cpu_hz, deadline_cycles, overruns, deadline_misses = report_header.unpack_from(data, offset)
+    offset += report_header.size
+
+    print(f"CPU {cpu_hz / 1000000:.0f} MHz, buffer deadline {cycles_to_us(deadline_cycles, cpu_hz):.0f} us")
+    print(f"Deadline misses: {deadline_misses}, DMA overruns: {overruns}")
+
+    for name in PROBES:
+        fields = histogram.unpack_from(data, offset)
+        offset += histogram.size
+
+        count, max_cycles, total = fields[0], fields[1], fields[2]
+        buckets = fields[3:]
+
+        if count == 0:
+            print(f"  {name}: no samples")
+            continue
+
+        mean_us = cycles_to_us(total / count, cpu_hz)
+        max_us = cycles_to_us(max_cycles, cpu_hz)
+        print(f"  {name}: count {count}, mean {mean_us:.1f} us, max {max_us:.1f} us")
+
+        for bucket, hits in enumerate(buckets):
+            if hits == 0:
+                continue
+
+            low = cycles_to_us(1 << (bucket - 1), cpu_hz) if bucket > 0 else 0
+            high = cycles_to_us(1 << bucket, cpu_hz)
+            print(f"    {low:10.2f} - {high:10.2f} us  {hits}")
+
+def main():
+    if len(sys.argv) != 2:
+        print("Usage: python decode_profile.py <serial capture>")
+        sys.exit(1)
+
+    with open(sys.argv[1], 'rb') as capture:
+        data = capture.read()
+
+    reports = 0
+    offset = data.find(PROFILE_MAGIC)
+
+    while offset >= 0 and offset + report_size <= len(data):
+        reports += 1
+        print(f"Report {reports}")
+        print_report(data, offset)
+        print()
+        offset = data.find(PROFILE_MAGIC, offset + report_size)
+
+    if reports == 0:
+        print("No profile reports found")
+
+if __name__ == '__main__':
+    main()
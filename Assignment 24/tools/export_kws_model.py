@@ -0,0 +1,215 @@
+import math
+import sys
+
+# Turns a fully int8-quantized keyword spotting .tflite model into
+# src/kws_model.h for the on-device keyword spotter. The model must take
+# 49 x 10 MFCCs (40 ms frames every 20 ms, as computed by src/mfcc.h) and
+# be built from CONV_2D, DEPTHWISE_CONV_2D, AVERAGE_POOL_2D and
+# FULLY_CONNECTED layers, such as the DS-CNN models from ML-KWS-for-MCU.
+#   python export_kws_model.py ds_cnn.tflite keyword_label labels.txt > ../src/kws_model.h
+# TensorFlow and numpy are only needed to read the .tflite file, so
+# tools/make_kws_fixture.py can use write_header() without them.
+
+LAYER_TYPES = {
+    'CONV_2D': 'DSCNN_CONV',
+    'DEPTHWISE_CONV_2D': 'DSCNN_DEPTHWISE',
+    'AVERAGE_POOL_2D': 'DSCNN_AVERAGE_POOL',
+    'FULLY_CONNECTED': 'DSCNN_FULLY_CONNECTED',
+}
+
+# Ops that don't touch the int8 data, or that the device does itself
+SKIPPED_OPS = ['RESHAPE', 'SOFTMAX', 'QUANTIZE', 'DEQUANTIZE']
+
+def quantized_multiplier(real):
+    if real == 0:
+        return 0, 0
+
+    mantissa, exponent = math.frexp(real)
+    multiplier = int(round(mantissa * (1 << 31)))
+    if multiplier == 1 << 31:
+        multiplier //= 2
+        exponent += 1
+
+    return multiplier, exponent
+
+def hwc(shape):
+    # Pads a shape out to [height, width, channels], dropping the batch
+    shape = list(shape[1:])
+    while len(shape) < 3:
+        shape.insert(0, 1)
+    return shape
+
+def find_stride_and_padding(in_size, out_size, kernel):
+    # The interpreter doesn't expose the op options, so find the stride
+    # and padding that give the output size, trying SAME padding first
+    for stride in range(1, 5):
+        if (in_size + stride - 1) // stride == out_size:
+            total = max((out_size - 1) * stride + kernel - in_size, 0)
+            return stride, total // 2
+        if (in_size - kernel + stride) // stride == out_size:
+            return stride, 0
+
+    raise ValueError(f"No stride fits {in_size} -> {out_size} with kernel {kernel}")
+
+def flatten(values):
+    # numpy arrays and nested lists alike
+    if hasattr(values, 'flatten'):
+        return list(values.flatten())
+    if not isinstance(values, (list, tuple)):
+        return [values]
+    return [v for value in values for v in flatten(value)]
+
+def c_array(c_type, name, values):
+    values = ', '.join(str(int(v)) for v in flatten(values))
+    return f"static const {c_type} {name}[] = {{{values}}};"
+
+# A layer is a dict with the op name as 'type', 'in' and 'out' shapes as
+# [h, w, c], the 'kernel', 'stride' and 'pad' as (h, w), the input and
+# output zero points, and for anything but pooling its int8 'weights',
+# int32 'bias' and per output channel (multiplier, shift) 'requantize'
+def write_header(out, source, labels, keyword, layers, input_quantization, output_quantization):
+    arrays = []
+    entries = []
+    max_activations = 0
+
+    for index, layer in enumerate(layers):
+        in_h, in_w, in_c = layer['in']
+        out_h, out_w, out_c = layer['out']
+        kernel_h, kernel_w = layer['kernel']
+        stride_h, stride_w = layer['stride']
+        pad_h, pad_w = layer['pad']
+        max_activations = max(max_activations, out_h * out_w * out_c)
+
+        weights = bias = multiplier = shift = 'NULL'
+        if layer['type'] != 'AVERAGE_POOL_2D':
+            weights = f"kws_weights_{index}"
+            bias = f"kws_bias_{index}"
+            multiplier = f"kws_multiplier_{index}"
+            shift = f"kws_shift_{index}"
+            arrays.append(c_array('int8_t', weights, layer['weights']))
+            arrays.append(c_array('int32_t', bias, layer['bias']))
+            arrays.append(c_array('int32_t', multiplier, [m for m, _ in layer['requantize']]))
+            arrays.append(c_array('int8_t', shift, [s for _, s in layer['requantize']]))
+
+        # A fused ReLU shows up as the output range starting at zero, so the
+        # full int8 range is the right clamp either way
+        entries.append(f"    {{{LAYER_TYPES[layer['type']]}, {kernel_h}, {kernel_w}, {stride_h}, {stride_w}, {pad_h}, {pad_w}, "
+                       f"{in_h}, {in_w}, {in_c}, {out_h}, {out_w}, {out_c}, "
+                       f"{-int(layer['in_zero_point'])}, {int(layer['out_zero_point'])}, -128, 127, "
+                       f"{weights}, {bias}, {multiplier}, {shift}}},")
+
+    in_scale, in_zero_point = input_quantization
+    out_scale, out_zero_point = output_quantization
+
+    def line(text=''):
+        out.write(text + '\n')
+
+    line("#pragma once")
+    line()
+    line(f"// Generated by tools/export_kws_model.py from {source}")
+    line()
+    line('#include "ds_cnn.h"')
+    line()
+    line("#define KWS_MODEL_AVAILABLE 1")
+    line()
+    line(f"#define KWS_MODEL_CLASSES {len(labels)}")
+    line(f"#define KWS_MODEL_KEYWORD {keyword}")
+    line(f"#define KWS_MODEL_LAYER_COUNT {len(layers)}")
+    line(f"#define KWS_MODEL_MAX_ACTIVATIONS {max_activations}")
+    line()
+    line(f"#define KWS_MODEL_INPUT_SCALE {float(in_scale)!r}f")
+    line(f"#define KWS_MODEL_INPUT_ZERO_POINT {int(in_zero_point)}")
+    line(f"#define KWS_MODEL_OUTPUT_SCALE {float(out_scale)!r}f")
+    line(f"#define KWS_MODEL_OUTPUT_ZERO_POINT {int(out_zero_point)}")
+    line()
+    label_list = ', '.join(f'"{label}"' for label in labels)
+    line(f"static const char *const KWS_MODEL_LABELS[KWS_MODEL_CLASSES] = {{{label_list}}};")
+    line()
+    for array in arrays:
+        line(array)
+    line()
+    line("static const DsCnnLayer KWS_MODEL_LAYER_TABLE[KWS_MODEL_LAYER_COUNT] = {")
+    for entry in entries:
+        line(entry)
+    line("};")
+    line("static const DsCnnLayer *const KWS_MODEL_LAYERS = KWS_MODEL_LAYER_TABLE;")
+
+def main():
+    if len(sys.argv) != 4:
+        print("Usage: python export_kws_model.py <model.tflite> <keyword label> <labels.txt>", file=sys.stderr)
+        sys.exit(1)
+
+    import numpy as np
+    import tensorflow as tf
+
+    interpreter = tf.lite.Interpreter(model_path=sys.argv[1])
+    interpreter.allocate_tensors()
+    tensors = {t['index']: t for t in interpreter.get_tensor_details()}
+
+    with open(sys.argv[3]) as labels_file:
+        labels = [line.strip() for line in labels_file if line.strip()]
+    keyword = labels.index(sys.argv[2])
+
+    layers = []
+    model_input = None
+    model_output = None
+
+    for op in interpreter._get_ops_details():
+        name = op['op_name']
+        if name in SKIPPED_OPS:
+            continue
+        if name not in LAYER_TYPES:
+            raise ValueError(f"Unsupported op {name}")
+
+        input_tensor = tensors[op['inputs'][0]]
+        output_tensor = tensors[op['outputs'][0]]
+        if model_input is None:
+            model_input = input_tensor
+        model_output = output_tensor
+
+        in_scale, in_zero_point = input_tensor['quantization']
+        out_scale, out_zero_point = output_tensor['quantization']
+        in_h, in_w, in_c = hwc(input_tensor['shape'])
+        out_h, out_w, out_c = hwc(output_tensor['shape'])
+
+        layer = {
+            'type': name,
+            'in': [in_h, in_w, in_c],
+            'out': [out_h, out_w, out_c],
+            'kernel': (1, 1),
+            'stride': (1, 1),
+            'pad': (1, 1),
+            'in_zero_point': in_zero_point,
+            'out_zero_point': out_zero_point,
+        }
+
+        if name == 'AVERAGE_POOL_2D':
+            # Only global pooling, as DS-CNN uses
+            layer['kernel'] = (in_h, in_w)
+            layer['stride'] = (in_h, in_w)
+            layer['pad'] = (0, 0)
+        else:
+            weight_tensor = tensors[op['inputs'][1]]
+            weight_values = interpreter.get_tensor(weight_tensor['index'])
+            weight_scales = weight_tensor['quantization_parameters']['scales']
+
+            if name != 'FULLY_CONNECTED':
+                kernel_h, kernel_w = weight_values.shape[1], weight_values.shape[2]
+                stride_h, pad_h = find_stride_and_padding(in_h, out_h, kernel_h)
+                stride_w, pad_w = find_stride_and_padding(in_w, out_w, kernel_w)
+                layer['kernel'] = (kernel_h, kernel_w)
+                layer['stride'] = (stride_h, stride_w)
+                layer['pad'] = (pad_h, pad_w)
+
+            scales = np.broadcast_to(weight_scales, (out_c,))
+            layer['weights'] = weight_values
+            layer['bias'] = interpreter.get_tensor(tensors[op['inputs'][2]]['index'])
+            layer['requantize'] = [quantized_multiplier(in_scale * s / out_scale) for s in scales]
+
+        layers.append(layer)
+
+    write_header(sys.stdout, sys.argv[1].split('/')[-1], labels, keyword, layers,
+                 model_input['quantization'], model_output['quantization'])
+
+if __name__ == '__main__':
+    main()
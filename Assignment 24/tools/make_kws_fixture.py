@@ -0,0 +1,258 @@
+import os
+import sys
+
+from export_kws_model import find_stride_and_padding, quantized_multiplier, write_header
+
+# Writes a small DS-CNN with synthetic weights through export_kws_model's
+# write_header(), for the native tests to run on the device code, along
+# with inputs and the outputs the TensorFlow Lite int8 reference kernels
+# give for them. It checks the exporter's tables and the device's layers
+# agree with TensorFlow Lite bit for bit. It can't tell a keyword from
+# anything else. Pure Python, so it runs without TensorFlow.
+#   python make_kws_fixture.py ../test/fixtures
+
+INPUT_SHAPE = [49, 10, 1]
+INPUT_SCALE = 1.0
+INPUT_ZERO_POINT = 0
+LABELS = ['_unknown_', 'keyword']
+KEYWORD = 1
+OUTPUT_SCALE = 0.1
+REPLAY_INPUTS = 3
+KEYWORD_MARGIN = 40 # Output steps the keyword is favoured by
+
+
+class Random:
+    # An LCG, so the fixture comes out the same on any Python
+    def __init__(self, seed):
+        self.state = seed
+
+    def next(self):
+        self.state = (self.state * 1664525 + 1013904223) & 0xFFFFFFFF
+        return self.state
+
+    def int8(self, low=-127, high=127):
+        return low + (self.next() >> 8) % (high - low + 1)
+
+
+def c_div(a, b):
+    # Division that truncates towards zero, as in C
+    q = abs(a) // abs(b)
+    return q if (a >= 0) == (b > 0) else -q
+
+
+def multiply_by_quantized_multiplier(acc, multiplier, shift):
+    value = acc * (1 << max(shift, 0))
+    value = max(min(value, 2 ** 31 - 1), -2 ** 31)
+    product = value * multiplier
+    nudge = (1 << 30) if product >= 0 else 1 - (1 << 30)
+    high = c_div(product + nudge, 1 << 31)
+
+    right = max(-shift, 0)
+    if right > 0:
+        mask = (1 << right) - 1
+        remainder = high & mask
+        threshold = (mask >> 1) + (1 if high < 0 else 0)
+        high = (high >> right) + (1 if remainder > threshold else 0)
+    return high
+
+
+def clamp(value):
+    return max(min(value, 127), -128)
+
+
+def accumulators(layer, x):
+    # The int32 sums before requantizing, HWC
+    in_h, in_w, in_c = layer['in']
+    out_h, out_w, out_c = layer['out']
+    kernel_h, kernel_w = layer['kernel']
+    stride_h, stride_w = layer['stride']
+    pad_h, pad_w = layer['pad']
+    offset = -layer['in_zero_point']
+    weights = layer['weights']
+    out = []
+
+    if layer['type'] == 'FULLY_CONNECTED':
+        inputs = len(x)
+        for o in range(out_c):
+            row = weights[o * inputs:(o + 1) * inputs]
+            out.append(layer['bias'][o] + sum((v + offset) * w for v, w in zip(x, row)))
+        return out
+
+    for oy in range(out_h):
+        for ox in range(out_w):
+            for oc in range(out_c):
+                acc = layer['bias'][oc]
+                for ky in range(kernel_h):
+                    iy = oy * stride_h - pad_h + ky
+                    if iy < 0 or iy >= in_h:
+                        continue
+                    for kx in range(kernel_w):
+                        ix = ox * stride_w - pad_w + kx
+                        if ix < 0 or ix >= in_w:
+                            continue
+                        pixel = (iy * in_w + ix) * in_c
+                        if layer['type'] == 'DEPTHWISE_CONV_2D':
+                            acc += (x[pixel + oc] + offset) * weights[(ky * kernel_w + kx) * out_c + oc]
+                        else:
+                            kernel = ((oc * kernel_h + ky) * kernel_w + kx) * in_c
+                            for ic in range(in_c):
+                                acc += (x[pixel + ic] + offset) * weights[kernel + ic]
+                out.append(acc)
+    return out
+
+
+def run_layer(layer, x):
+    if layer['type'] == 'AVERAGE_POOL_2D':
+        in_h, in_w, in_c = layer['in']
+        count = in_h * in_w
+        out = []
+        for c in range(in_c):
+            total = sum(x[p * in_c + c] for p in range(count))
+            average = c_div(total + count // 2, count) if total > 0 else c_div(total - count // 2, count)
+            out.append(clamp(average))
+        return out
+
+    out_c = layer['out'][2]
+    return [clamp(multiply_by_quantized_multiplier(acc, *layer['requantize'][i % out_c]) + layer['out_zero_point'])
+            for i, acc in enumerate(accumulators(layer, x))]
+
+
+def spatial_layer(kind, in_shape, out_shape, kernel, weights_per_channel, random):
+    stride_h, pad_h = find_stride_and_padding(in_shape[0], out_shape[0], kernel[0])
+    stride_w, pad_w = find_stride_and_padding(in_shape[1], out_shape[1], kernel[1])
+    count = kernel[0] * kernel[1] * weights_per_channel * out_shape[2]
+    return {
+        'type': kind,
+        'in': in_shape,
+        'out': out_shape,
+        'kernel': kernel,
+        'stride': (stride_h, stride_w),
+        'pad': (pad_h, pad_w),
+        'weights': [random.int8() for _ in range(count)],
+        'bias': [random.int8() * 64 for _ in range(out_shape[2])],
+    }
+
+
+def calibrate(layer, inputs, in_scale, in_zero_point, random, relu=True, target=120):
+    # Per-channel weight scales, then the output scale that spreads the
+    # accumulators over the int8 range, as post-training quantization would
+    layer['in_zero_point'] = in_zero_point
+    layer['out_zero_point'] = -128 if relu else 0
+    layer['requantize'] = [(1 << 30, 0)] * layer['out'][2]
+
+    out_c = layer['out'][2]
+    weight_scales = [0.01 * (1 + (random.next() >> 24) / 256) for _ in range(out_c)]
+    largest = 1
+    for x in inputs:
+        for i, acc in enumerate(accumulators(layer, x)):
+            largest = max(largest, abs(acc) * weight_scales[i % out_c])
+    out_scale = in_scale * largest / target
+    layer['requantize'] = [quantized_multiplier(in_scale * s / out_scale) for s in weight_scales]
+    return out_scale
+
+
+def build_model(inputs, random):
+    layers = []
+    scale = INPUT_SCALE
+    zero_point = INPUT_ZERO_POINT
+    x = inputs
+
+    def add(layer, relu=True, target=120):
+        nonlocal scale, zero_point, x
+        scale = calibrate(layer, x, scale, zero_point, random, relu, target)
+        zero_point = layer['out_zero_point']
+        layers.append(layer)
+        x = [run_layer(layer, v) for v in x]
+
+    add(spatial_layer('CONV_2D', INPUT_SHAPE, [25, 5, 16], (10, 4), 1, random))
+    add(spatial_layer('DEPTHWISE_CONV_2D', [25, 5, 16], [25, 5, 16], (3, 3), 1, random))
+    add(spatial_layer('CONV_2D', [25, 5, 16], [25, 5, 16], (1, 1), 16, random))
+
+    pool = {
+        'type': 'AVERAGE_POOL_2D',
+        'in': [25, 5, 16],
+        'out': [1, 1, 16],
+        'kernel': (25, 5),
+        'stride': (25, 5),
+        'pad': (0, 0),
+        'in_zero_point': zero_point,
+        'out_zero_point': zero_point,
+    }
+    layers.append(pool)
+    x = [run_layer(pool, v) for v in x]
+
+    fc = {
+        'type': 'FULLY_CONNECTED',
+        'in': [1, 1, 16],
+        'out': [1, 1, len(LABELS)],
+        'kernel': (1, 1),
+        'stride': (1, 1),
+        'pad': (1, 1),
+        'weights': [random.int8() for _ in range(16 * len(LABELS))],
+        'bias': [0] * len(LABELS),
+    }
+    # One weight scale, picked so the logits come out in steps of
+    # OUTPUT_SCALE and spread over half the int8 range. That leaves room to
+    # push the keyword up so the spotter has something to detect.
+    fc['in_zero_point'] = zero_point
+    fc['out_zero_point'] = 0
+    fc['requantize'] = [(1 << 30, 0)] * len(LABELS)
+    largest = max(max(abs(acc) for acc in accumulators(fc, v)) for v in x)
+    output_scale = largest / 60
+    fc['requantize'] = [quantized_multiplier(1 / output_scale)] * len(LABELS)
+    fc['bias'][KEYWORD] = int(round(KEYWORD_MARGIN * output_scale))
+    layers.append(fc)
+
+    return layers
+
+
+def main():
+    if len(sys.argv) != 2:
+        print("Usage: python make_kws_fixture.py <fixtures directory>", file=sys.stderr)
+        sys.exit(1)
+
+    random = Random(2024)
+    size = INPUT_SHAPE[0] * INPUT_SHAPE[1] * INPUT_SHAPE[2]
+    inputs = [[random.int8(-100, 60) for _ in range(size)] for _ in range(REPLAY_INPUTS)]
+
+    layers = build_model(inputs, random)
+
+    outputs = []
+    first_layer_outputs = []
+    for n, x in enumerate(inputs):
+        for layer in layers:
+            x = run_layer(layer, x)
+            if n == 0:
+                first_layer_outputs.append(x)
+        outputs.append(x)
+        if max(x) >= 127 or x[KEYWORD] <= x[1 - KEYWORD]:
+            raise ValueError(f"Replay {n} gives {x}, tune the fixture")
+
+    with open(os.path.join(sys.argv[1], 'kws_fixture_model.h'), 'w') as out:
+        write_header(out, 'synthetic weights by tools/make_kws_fixture.py', LABELS, KEYWORD, layers,
+                     (INPUT_SCALE, INPUT_ZERO_POINT), (OUTPUT_SCALE, 0))
+
+    def array(name, values):
+        return f"static const int8_t {name}[] = {{{', '.join(str(v) for v in values)}}};\n"
+
+    with open(os.path.join(sys.argv[1], 'kws_fixture_replay.h'), 'w') as out:
+        out.write("#pragma once\n\n")
+        out.write("// Generated by tools/make_kws_fixture.py: inputs for kws_fixture_model.h and\n")
+        out.write("// what the TensorFlow Lite int8 reference kernels make of them\n\n")
+        out.write("#include <stdint.h>\n\n")
+        out.write(f"#define KWS_REPLAY_COUNT {REPLAY_INPUTS}\n\n")
+        for n in range(REPLAY_INPUTS):
+            out.write(array(f"kws_replay_input_{n}", inputs[n]))
+            out.write(array(f"kws_replay_output_{n}", outputs[n]))
+        out.write("\n// Every layer's output for input 0\n")
+        for i, values in enumerate(first_layer_outputs):
+            out.write(array(f"kws_replay_layer_{i}", values))
+        out.write("\nstatic const int8_t *const KWS_REPLAY_INPUTS[KWS_REPLAY_COUNT] = {"
+                  + ', '.join(f"kws_replay_input_{n}" for n in range(REPLAY_INPUTS)) + "};\n")
+        out.write("static const int8_t *const KWS_REPLAY_OUTPUTS[KWS_REPLAY_COUNT] = {"
+                  + ', '.join(f"kws_replay_output_{n}" for n in range(REPLAY_INPUTS)) + "};\n")
+        out.write(f"static const int8_t *const KWS_REPLAY_LAYERS[{len(layers)}] = {{"
+                  + ', '.join(f"kws_replay_layer_{i}" for i in range(len(layers))) + "};\n")
+
+if __name__ == '__main__':
+    main()